@@ -0,0 +1,452 @@
+/*
+ * Copyright (c) 2026, agent <agent@local>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+ * OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * \file
+ *         A CFS backend for the native platform that accesses host files
+ *         through shared memory mappings.
+ */
+
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "cfs/cfs.h"
+#include "cfs-mmap.h"
+
+/* An open host file. The mapping covers the whole host file, which is
+   extended in steps of CFS_MMAP_GROW_SIZE while it is written, so the
+   real size of the file is kept separately. */
+struct mapped_file {
+  dev_t dev;
+  ino_t ino;
+  int fd;
+  uint8_t writable;
+  uint8_t *map;
+  size_t mapped;
+  size_t size;
+  /* The range that has been modified since the last write-back */
+  size_t dirty_start;
+  size_t dirty_end;
+  unsigned refs;
+};
+
+struct descriptor {
+  struct mapped_file *file;
+  size_t offset;
+  int flags;
+};
+
+static struct mapped_file files[CFS_MMAP_FILES];
+static struct descriptor descriptors[CFS_MMAP_FILES];
+static uint8_t initialized;
+/*---------------------------------------------------------------------------*/
+static void
+init(void)
+{
+  int i;
+
+  for(i = 0; i < CFS_MMAP_FILES; i++) {
+    files[i].fd = -1;
+  }
+  initialized = 1;
+}
+/*---------------------------------------------------------------------------*/
+static struct descriptor *
+get_descriptor(int fd)
+{
+  if(fd < 0 || fd >= CFS_MMAP_FILES || descriptors[fd].file == NULL) {
+    return NULL;
+  }
+  return &descriptors[fd];
+}
+/*---------------------------------------------------------------------------*/
+static int
+remap(struct mapped_file *file, size_t length)
+{
+  void *map;
+
+  if(file->map != NULL) {
+    munmap(file->map, file->mapped);
+    file->map = NULL;
+    file->mapped = 0;
+  }
+  if(length == 0) {
+    return 0;
+  }
+
+  map = mmap(NULL, length,
+             file->writable ? PROT_READ | PROT_WRITE : PROT_READ,
+             MAP_SHARED, file->fd, 0);
+  if(map == MAP_FAILED) {
+    return -1;
+  }
+  file->map = map;
+  file->mapped = length;
+  return 0;
+}
+/*---------------------------------------------------------------------------*/
+static int
+grow(struct mapped_file *file, size_t end)
+{
+  size_t length;
+
+  length = (end + CFS_MMAP_GROW_SIZE - 1) / CFS_MMAP_GROW_SIZE *
+    CFS_MMAP_GROW_SIZE;
+  if(ftruncate(file->fd, length) < 0) {
+    return -1;
+  }
+  return remap(file, length);
+}
+/*---------------------------------------------------------------------------*/
+static void
+mark_dirty(struct mapped_file *file, size_t start, size_t end)
+{
+  if(file->dirty_start >= file->dirty_end) {
+    file->dirty_start = start;
+    file->dirty_end = end;
+  } else {
+    if(start < file->dirty_start) {
+      file->dirty_start = start;
+    }
+    if(end > file->dirty_end) {
+      file->dirty_end = end;
+    }
+  }
+}
+/*---------------------------------------------------------------------------*/
+static int
+write_back(struct mapped_file *file, int flags)
+{
+  size_t start;
+  size_t end;
+  int r;
+
+  if(file->dirty_start >= file->dirty_end || file->map == NULL) {
+    return 0;
+  }
+
+  /* msync() needs a page-aligned address. */
+  start = file->dirty_start & ~((size_t)sysconf(_SC_PAGESIZE) - 1);
+  end = file->dirty_end < file->mapped ? file->dirty_end : file->mapped;
+  r = msync(file->map + start, end - start, flags);
+
+  file->dirty_start = file->dirty_end = 0;
+  return r;
+}
+/*---------------------------------------------------------------------------*/
+static void
+release(struct mapped_file *file)
+{
+  if(CFS_MMAP_SYNC_ON_CLOSE) {
+    write_back(file, MS_SYNC);
+  }
+  remap(file, 0);
+  if(file->writable) {
+    /* Remove the unused part of the last step. */
+    if(ftruncate(file->fd, file->size) < 0) {
+      /* The file keeps some trailing zeros. */
+    }
+  }
+  close(file->fd);
+  file->fd = -1;
+}
+/*---------------------------------------------------------------------------*/
+static struct mapped_file *
+get_file(int fd, int writable)
+{
+  struct stat st;
+  struct mapped_file *file;
+  struct mapped_file *free_file;
+  int i;
+
+  if(fstat(fd, &st) < 0) {
+    return NULL;
+  }
+
+  /* Share the mapping with the other descriptors of the same file. */
+  free_file = NULL;
+  for(i = 0; i < CFS_MMAP_FILES; i++) {
+    file = &files[i];
+    if(file->fd < 0) {
+      if(free_file == NULL) {
+        free_file = file;
+      }
+    } else if(file->dev == st.st_dev && file->ino == st.st_ino) {
+      if(writable && !file->writable) {
+        /* Replace the read-only mapping with a writable one. */
+        i = file->fd;
+        file->fd = fd;
+        file->writable = 1;
+        if(remap(file, file->size) < 0) {
+          file->fd = i;
+          file->writable = 0;
+          remap(file, file->size);
+          return NULL;
+        }
+        close(i);
+      } else {
+        close(fd);
+      }
+      return file;
+    }
+  }
+
+  file = free_file;
+  if(file == NULL) {
+    return NULL;
+  }
+  memset(file, 0, sizeof(*file));
+  file->dev = st.st_dev;
+  file->ino = st.st_ino;
+  file->fd = fd;
+  file->writable = writable;
+  file->size = st.st_size;
+  if(remap(file, file->size) < 0) {
+    file->fd = -1;
+    return NULL;
+  }
+  return file;
+}
+/*---------------------------------------------------------------------------*/
+int
+cfs_open(const char *n, int f)
+{
+  struct mapped_file *file;
+  int fd;
+  int i;
+
+  if(!initialized) {
+    init();
+  }
+
+  for(i = 0; i < CFS_MMAP_FILES; i++) {
+    if(descriptors[i].file == NULL) {
+      break;
+    }
+  }
+  if(i == CFS_MMAP_FILES) {
+    return -1;
+  }
+
+  /* A writable shared mapping needs a descriptor that can be read. */
+  if(f == CFS_READ) {
+    fd = open(n, O_RDONLY);
+  } else if(f & CFS_WRITE) {
+    fd = open(n, O_RDWR | O_CREAT, 0600);
+  } else {
+    return -1;
+  }
+  if(fd < 0) {
+    return -1;
+  }
+
+  file = get_file(fd, f != CFS_READ);
+  if(file == NULL) {
+    close(fd);
+    return -1;
+  }
+
+  if((f & CFS_WRITE) && !(f & CFS_APPEND)) {
+    if(ftruncate(file->fd, 0) < 0 || remap(file, 0) < 0) {
+      if(file->refs == 0) {
+        release(file);
+      }
+      return -1;
+    }
+    file->size = 0;
+    file->dirty_start = file->dirty_end = 0;
+  }
+
+  file->refs++;
+  descriptors[i].file = file;
+  descriptors[i].offset = 0;
+  descriptors[i].flags = f;
+  return i;
+}
+/*---------------------------------------------------------------------------*/
+void
+cfs_close(int f)
+{
+  struct descriptor *desc;
+
+  desc = get_descriptor(f);
+  if(desc == NULL) {
+    return;
+  }
+
+  if(--desc->file->refs == 0) {
+    release(desc->file);
+  }
+  desc->file = NULL;
+}
+/*---------------------------------------------------------------------------*/
+int
+cfs_read(int f, void *b, unsigned int l)
+{
+  struct descriptor *desc;
+  struct mapped_file *file;
+
+  desc = get_descriptor(f);
+  if(desc == NULL || !(desc->flags & CFS_READ)) {
+    return -1;
+  }
+
+  file = desc->file;
+  if(desc->offset >= file->size) {
+    return 0;
+  }
+  if(l > file->size - desc->offset) {
+    l = file->size - desc->offset;
+  }
+
+  memcpy(b, file->map + desc->offset, l);
+  desc->offset += l;
+  return l;
+}
+/*---------------------------------------------------------------------------*/
+int
+cfs_write(int f, const void *b, unsigned int l)
+{
+  struct descriptor *desc;
+  struct mapped_file *file;
+  size_t end;
+
+  desc = get_descriptor(f);
+  if(desc == NULL || !(desc->flags & CFS_WRITE)) {
+    return -1;
+  }
+
+  file = desc->file;
+  if(desc->flags & CFS_APPEND) {
+    desc->offset = file->size;
+  }
+
+  end = desc->offset + l;
+  if(end > file->mapped && grow(file, end) < 0) {
+    return -1;
+  }
+
+  memcpy(file->map + desc->offset, b, l);
+  mark_dirty(file, desc->offset, end);
+  if(end > file->size) {
+    file->size = end;
+  }
+  desc->offset = end;
+
+  if(CFS_MMAP_SYNC_BYTES > 0 &&
+     file->dirty_end - file->dirty_start >= CFS_MMAP_SYNC_BYTES) {
+    write_back(file, MS_ASYNC);
+  }
+  return l;
+}
+/*---------------------------------------------------------------------------*/
+cfs_offset_t
+cfs_seek(int f, cfs_offset_t o, int w)
+{
+  struct descriptor *desc;
+  off_t offset;
+
+  desc = get_descriptor(f);
+  if(desc == NULL) {
+    return (cfs_offset_t)-1;
+  }
+
+  if(w == CFS_SEEK_SET) {
+    offset = o;
+  } else if(w == CFS_SEEK_CUR) {
+    offset = (off_t)desc->offset + o;
+  } else if(w == CFS_SEEK_END) {
+    offset = (off_t)desc->file->size + o;
+  } else {
+    return (cfs_offset_t)-1;
+  }
+
+  if(offset < 0) {
+    return (cfs_offset_t)-1;
+  }
+  desc->offset = offset;
+  return offset;
+}
+/*---------------------------------------------------------------------------*/
+int
+cfs_remove(const char *name)
+{
+  return remove(name);
+}
+/*---------------------------------------------------------------------------*/
+void *
+cfs_mmap_range(int fd, cfs_offset_t offset, unsigned len, int flags)
+{
+  struct descriptor *desc;
+  struct mapped_file *file;
+  size_t end;
+
+  desc = get_descriptor(fd);
+  if(desc == NULL || offset < 0 || !(desc->flags & flags)) {
+    return NULL;
+  }
+
+  file = desc->file;
+  end = (size_t)offset + len;
+  if(flags & CFS_WRITE) {
+    if(end > file->mapped && grow(file, end) < 0) {
+      return NULL;
+    }
+    mark_dirty(file, offset, end);
+    if(end > file->size) {
+      file->size = end;
+    }
+  } else if(end > file->size) {
+    return NULL;
+  }
+
+  if(file->map == NULL) {
+    return NULL;
+  }
+  return file->map + offset;
+}
+/*---------------------------------------------------------------------------*/
+int
+cfs_mmap_sync(int fd)
+{
+  struct descriptor *desc;
+
+  desc = get_descriptor(fd);
+  if(desc == NULL) {
+    return -1;
+  }
+  return write_back(desc->file, MS_SYNC);
+}
+/*---------------------------------------------------------------------------*/
@@ -0,0 +1,112 @@
+/*
+ * Copyright (c) 2026, agent <agent@local>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+ * OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * \file
+ *         Extensions of the memory-mapped CFS backend of the native
+ *         platform. The backend is selected with
+ *         MAKE_CFS = MAKE_CFS_MMAP.
+ *
+ *         Each open host file is mapped once into memory, and all the
+ *         descriptors of the file share the mapping. cfs_read() and
+ *         cfs_write() copy to and from the mapping without any system
+ *         calls, except when a write extends the file beyond the mapped
+ *         area.
+ */
+
+#ifndef CFS_MMAP_H_
+#define CFS_MMAP_H_
+
+#include "cfs/cfs.h"
+
+#ifdef CFS_MMAP_CONF_FILES
+#define CFS_MMAP_FILES CFS_MMAP_CONF_FILES
+#else
+/** The maximum number of open descriptors */
+#define CFS_MMAP_FILES 32
+#endif
+
+#ifdef CFS_MMAP_CONF_GROW_SIZE
+#define CFS_MMAP_GROW_SIZE CFS_MMAP_CONF_GROW_SIZE
+#else
+/** The granularity, in bytes, in which files are extended and mapped
+    while they are written. The host file is truncated to its real size
+    when the last descriptor is closed. */
+#define CFS_MMAP_GROW_SIZE (64 * 1024UL)
+#endif
+
+#ifdef CFS_MMAP_CONF_SYNC_BYTES
+#define CFS_MMAP_SYNC_BYTES CFS_MMAP_CONF_SYNC_BYTES
+#else
+/** The size of the modified range of a file after which an
+    asynchronous write-back of the range is started. 0 leaves the
+    write-back to the host OS. */
+#define CFS_MMAP_SYNC_BYTES (256 * 1024UL)
+#endif
+
+#ifdef CFS_MMAP_CONF_SYNC_ON_CLOSE
+#define CFS_MMAP_SYNC_ON_CLOSE CFS_MMAP_CONF_SYNC_ON_CLOSE
+#else
+/** Whether closing the last descriptor of a file waits until the
+    modified range has been written to the host storage. */
+#define CFS_MMAP_SYNC_ON_CLOSE 0
+#endif
+
+/**
+ * \brief Get a pointer to a range of an open file
+ * \param fd The file descriptor
+ * \param offset The offset of the range in the file
+ * \param len The length of the range
+ * \param flags CFS_READ to read the range, or CFS_WRITE to modify it
+ * \return A pointer to the range, or NULL on error
+ *
+ * With CFS_READ, the range must be inside the file. With CFS_WRITE,
+ * the descriptor must have been opened for writing. The file is then
+ * extended to cover the range, and the range is counted as modified.
+ * The file offset of the descriptor is not changed.
+ *
+ * The pointer stays valid until the file is extended beyond its
+ * mapped area, until the file is truncated by cfs_open(), until a file
+ * that is only open for reading is opened for writing, which replaces
+ * its read-only mapping, or until the last descriptor of the file is
+ * closed.
+ */
+void *cfs_mmap_range(int fd, cfs_offset_t offset, unsigned len, int flags);
+
+/**
+ * \brief Write the modified range of a file to the host storage
+ * \param fd The file descriptor
+ * \return 0 on success, -1 on error
+ *
+ * The function returns when the data has been written.
+ */
+int cfs_mmap_sync(int fd);
+
+#endif /* CFS_MMAP_H_ */
@@ -0,0 +1,189 @@
+/*
+ * Copyright (c) 2026, agent <agent@local>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+ * OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * \file
+ *         Benchmark: Antelope selections. A relation of sensor samples
+ *         is stored in Coffee, and a set of selections with different
+ *         predicates is run over it. The time per scanned tuple is
+ *         reported for each selection.
+ *
+ *         The number of tuples and the number of runs of each
+ *         selection can be set with the ANTELOPE_BENCH_TUPLES and
+ *         ANTELOPE_BENCH_RUNS environment variables. Build with
+ *         DEFINES=LVM_COMPILE_PREDICATES=0 to measure interpreted
+ *         predicates.
+ */
+
+#include "contiki.h"
+#include "antelope.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <inttypes.h>
+#include <time.h>
+
+#define BENCH_DEFAULT_TUPLES   4000UL
+#define BENCH_DEFAULT_RUNS     20UL
+#define BENCH_DEVICES          7
+
+static const char *queries[] = {
+  "SELECT id, val FROM samples WHERE val > 950;",
+  "SELECT id, dev, val FROM samples WHERE dev = 3 AND val < 100;",
+  "SELECT id, dev FROM samples WHERE dev = 1 OR dev = 4 OR dev = 6;",
+  "SELECT id, val FROM samples WHERE val - id * 2 > 900 OR id < 3;",
+  "SELECT COUNT(id), MAX(val) FROM samples WHERE dev = 3;"
+};
+/*---------------------------------------------------------------------------*/
+PROCESS(antelope_select_process, "Antelope select benchmark");
+AUTOSTART_PROCESSES(&antelope_select_process);
+/*---------------------------------------------------------------------------*/
+static uint64_t
+now_ns(void)
+{
+  struct timespec ts;
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t)ts.tv_sec * UINT64_C(1000000000) + ts.tv_nsec;
+}
+/*---------------------------------------------------------------------------*/
+static db_result_t
+run_query(const char *query, unsigned long *rows)
+{
+  static db_handle_t handle;
+  db_result_t result;
+
+  result = db_query(&handle, "%s", query);
+  if(DB_ERROR(result)) {
+    db_free(&handle);
+    return result;
+  }
+
+  while(db_processing(&handle)) {
+    result = db_process(&handle);
+    if(result == DB_GOT_ROW) {
+      (*rows)++;
+    } else if(result == DB_FINISHED) {
+      break;
+    } else if(DB_ERROR(result)) {
+      break;
+    }
+  }
+
+  db_free(&handle);
+  return DB_ERROR(result) ? result : DB_OK;
+}
+/*---------------------------------------------------------------------------*/
+static int
+setup(unsigned long tuples)
+{
+  static char query[64];
+  unsigned long rows;
+  unsigned long i;
+
+  rows = 0;
+  if(DB_ERROR(run_query("CREATE RELATION samples;", &rows)) ||
+     DB_ERROR(run_query("CREATE ATTRIBUTE id DOMAIN INT IN samples;",
+                        &rows)) ||
+     DB_ERROR(run_query("CREATE ATTRIBUTE dev DOMAIN INT IN samples;",
+                        &rows)) ||
+     DB_ERROR(run_query("CREATE ATTRIBUTE val DOMAIN LONG IN samples;",
+                        &rows))) {
+    return 0;
+  }
+
+  for(i = 0; i < tuples; i++) {
+    snprintf(query, sizeof(query), "INSERT (%lu, %lu, %lu) INTO samples;",
+             i, (i * 5) % BENCH_DEVICES, (i * 37) % 1000);
+    if(DB_ERROR(run_query(query, &rows))) {
+      return 0;
+    }
+  }
+
+  return 1;
+}
+/*---------------------------------------------------------------------------*/
+static int
+run(const char *query, unsigned long tuples, unsigned long runs)
+{
+  unsigned long i;
+  unsigned long rows;
+  uint64_t start, elapsed;
+  db_result_t result;
+
+  rows = 0;
+  start = now_ns();
+  for(i = 0; i < runs; i++) {
+    result = run_query(query, &rows);
+    if(DB_ERROR(result)) {
+      printf("antelope-select: \"%s\" failed: %s\n", query,
+             db_get_result_message(result));
+      return 0;
+    }
+  }
+  elapsed = now_ns() - start;
+
+  printf("antelope-select: %s\n", query);
+  printf("antelope-select: %lu rows/run, %" PRIu64 " ns/run, "
+         "%" PRIu64 " ns/tuple\n",
+         rows / runs, elapsed / runs, elapsed / ((uint64_t)runs * tuples));
+  return 1;
+}
+/*---------------------------------------------------------------------------*/
+PROCESS_THREAD(antelope_select_process, ev, data)
+{
+  unsigned long tuples;
+  unsigned long runs;
+  int i;
+  int ok;
+
+  PROCESS_BEGIN();
+
+  tuples = BENCH_DEFAULT_TUPLES;
+  if(getenv("ANTELOPE_BENCH_TUPLES") != NULL) {
+    tuples = strtoul(getenv("ANTELOPE_BENCH_TUPLES"), NULL, 10);
+  }
+  runs = BENCH_DEFAULT_RUNS;
+  if(getenv("ANTELOPE_BENCH_RUNS") != NULL) {
+    runs = strtoul(getenv("ANTELOPE_BENCH_RUNS"), NULL, 10);
+  }
+
+  db_init();
+
+  ok = tuples > 0 && runs > 0 && setup(tuples);
+  for(i = 0; ok && i < sizeof(queries) / sizeof(queries[0]); i++) {
+    ok = run(queries[i], tuples, runs);
+  }
+
+  exit(ok ? EXIT_SUCCESS : EXIT_FAILURE);
+
+  PROCESS_END();
+}
+/*---------------------------------------------------------------------------*/
@@ -0,0 +1,181 @@
+/*
+ * Copyright (c) 2026, agent <agent@local>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+ * OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * \file
+ *         Benchmark: CoAP request dispatching. GET requests are fed
+ *         directly to coap_receive() for a large set of resources, some
+ *         of them with sub-resources, and the time per request is
+ *         reported. Responses are addressed to the unspecified address
+ *         and dropped by the IP layer.
+ *
+ *         The number of requests can be set with the
+ *         COAP_BENCH_REQUESTS environment variable.
+ */
+
+#include "contiki.h"
+#include "coap-engine.h"
+#include "coap-transport.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <inttypes.h>
+#include <time.h>
+
+/* Log configuration */
+#include "sys/log.h"
+#define LOG_MODULE "App"
+#define LOG_LEVEL LOG_LEVEL_INFO
+
+#define BENCH_RESOURCES        200
+/* Every PARENT_INTERVAL'th resource has sub-resources */
+#define BENCH_PARENT_INTERVAL  20
+#define BENCH_DEFAULT_REQUESTS 100000UL
+#define BENCH_URL_LEN          24
+#define BENCH_REQUEST_LEN      64
+
+static coap_resource_t resources[BENCH_RESOURCES];
+static char urls[BENCH_RESOURCES][BENCH_URL_LEN];
+
+/* Serialized requests, one per resource */
+static uint8_t requests[BENCH_RESOURCES][BENCH_REQUEST_LEN];
+static uint16_t request_lens[BENCH_RESOURCES];
+
+static unsigned long handled;
+/*---------------------------------------------------------------------------*/
+PROCESS(coap_dispatch_process, "CoAP dispatch benchmark");
+AUTOSTART_PROCESSES(&coap_dispatch_process);
+/*---------------------------------------------------------------------------*/
+static void
+res_get_handler(coap_message_t *request, coap_message_t *response,
+                uint8_t *buffer, uint16_t preferred_size, int32_t *offset)
+{
+  handled++;
+  coap_set_header_content_format(response, TEXT_PLAIN);
+  coap_set_payload(response, "ok", 2);
+}
+/*---------------------------------------------------------------------------*/
+static uint64_t
+now_ns(void)
+{
+  struct timespec ts;
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t)ts.tv_sec * UINT64_C(1000000000) + ts.tv_nsec;
+}
+/*---------------------------------------------------------------------------*/
+static void
+setup(void)
+{
+  static char path[BENCH_URL_LEN + 8];
+  coap_message_t request[1];
+  int i;
+
+  for(i = 0; i < BENCH_RESOURCES; i++) {
+    memset(&resources[i], 0, sizeof(resources[i]));
+    resources[i].attributes = "";
+    resources[i].get_handler = res_get_handler;
+    if(i % BENCH_PARENT_INTERVAL == 0) {
+      /* Requests to parents go to one of their sub-resources */
+      resources[i].flags = HAS_SUB_RESOURCES;
+      snprintf(urls[i], sizeof(urls[i]), "parent/%d", i);
+      snprintf(path, sizeof(path), "%s/sub/%d", urls[i], i);
+    } else {
+      snprintf(urls[i], sizeof(urls[i]), "sensors/%d/value", i);
+      snprintf(path, sizeof(path), "%s", urls[i]);
+    }
+    coap_activate_resource(&resources[i], urls[i]);
+
+    coap_init_message(request, COAP_TYPE_CON, COAP_GET, 0);
+    coap_set_header_uri_path(request, path);
+    request_lens[i] = coap_serialize_message(request, requests[i]);
+  }
+}
+/*---------------------------------------------------------------------------*/
+static void
+run(unsigned long count)
+{
+  static uint8_t buffer[BENCH_REQUEST_LEN];
+  coap_endpoint_t endpoint;
+  unsigned long i;
+  uint64_t start, elapsed;
+  int r;
+
+  /* Responses to the unspecified address are dropped by uIP */
+  memset(&endpoint, 0, sizeof(endpoint));
+  endpoint.port = UIP_HTONS(COAP_DEFAULT_PORT);
+
+  handled = 0;
+  start = now_ns();
+  for(i = 0; i < count; i++) {
+    r = i % BENCH_RESOURCES;
+    memcpy(buffer, requests[r], request_lens[r]);
+    /* Use a fresh MID for each request */
+    buffer[2] = (uint8_t)(i >> 8);
+    buffer[3] = (uint8_t)i;
+    coap_receive(&endpoint, buffer, request_lens[r]);
+  }
+  elapsed = now_ns() - start;
+
+  printf("coap-dispatch: %d resources, %lu requests, %lu handled\n",
+         BENCH_RESOURCES, count, handled);
+  printf("coap-dispatch: %" PRIu64 " ns total, %" PRIu64 " ns/request, "
+         "%" PRIu64 " requests/s\n",
+         elapsed, elapsed / count,
+         elapsed > 0 ? (uint64_t)count * UINT64_C(1000000000) / elapsed : 0);
+}
+/*---------------------------------------------------------------------------*/
+PROCESS_THREAD(coap_dispatch_process, ev, data)
+{
+  unsigned long count;
+
+  PROCESS_BEGIN();
+
+  count = BENCH_DEFAULT_REQUESTS;
+  if(getenv("COAP_BENCH_REQUESTS") != NULL) {
+    count = strtoul(getenv("COAP_BENCH_REQUESTS"), NULL, 10);
+  }
+  if(count == 0) {
+    printf("coap-dispatch: COAP_BENCH_REQUESTS must be a positive number\n");
+    exit(EXIT_FAILURE);
+  }
+
+  setup();
+
+  /* Keep the stack quiet while measuring */
+  log_set_level("all", LOG_LEVEL_NONE);
+  run(count);
+
+  exit(handled == count ? EXIT_SUCCESS : EXIT_FAILURE);
+
+  PROCESS_END();
+}
+/*---------------------------------------------------------------------------*/
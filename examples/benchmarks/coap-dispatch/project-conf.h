@@ -0,0 +1,7 @@
+#ifndef PROJECT_CONF_H_
+#define PROJECT_CONF_H_
+
+/* Enough buckets for the benchmark resources */
+#define COAP_CONF_RESOURCE_HASH_SIZE 64
+
+#endif /* PROJECT_CONF_H_ */
@@ -0,0 +1,635 @@
+/*
+ * Copyright (c) 2026, agent <agent@local>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+ * OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * \file
+ *         A streaming CBOR (RFC 8949) encoder and decoder.
+ */
+
+#include "cbor.h"
+
+#include <string.h>
+
+/* Additional information values */
+#define INFO_UINT8          24
+#define INFO_UINT16         25
+#define INFO_UINT32         26
+#define INFO_UINT64         27
+#define INFO_INDEFINITE     31
+
+#define CBOR_BREAK          0xff
+/*---------------------------------------------------------------------------*/
+void
+cbor_writer_init(cbor_writer_t *writer, uint8_t *buffer, size_t size)
+{
+  writer->buffer = buffer;
+  writer->size = size;
+  writer->len = 0;
+  writer->overflow = 0;
+}
+/*---------------------------------------------------------------------------*/
+static size_t
+head_len(uint64_t arg)
+{
+  if(arg < INFO_UINT8) {
+    return 1;
+  } else if(arg <= 0xff) {
+    return 2;
+  } else if(arg <= 0xffff) {
+    return 3;
+  } else if(arg <= 0xffffffff) {
+    return 5;
+  }
+  return 9;
+}
+/*---------------------------------------------------------------------------*/
+/*
+ * Writes the initial byte and argument of an item, provided that the
+ * head and extra bytes of content fit into the buffer.
+ */
+static size_t
+write_head(cbor_writer_t *writer, uint8_t major, uint64_t arg, size_t extra)
+{
+  uint8_t *p;
+  size_t len;
+  size_t i;
+
+  len = head_len(arg);
+  if(writer->len + len + extra > writer->size ||
+     writer->len + len + extra < writer->len) {
+    writer->overflow = 1;
+    return 0;
+  }
+
+  p = &writer->buffer[writer->len];
+  if(len == 1) {
+    p[0] = (major << 5) | (uint8_t)arg;
+  } else {
+    p[0] = (major << 5) | (len == 2 ? INFO_UINT8 :
+                          len == 3 ? INFO_UINT16 :
+                          len == 5 ? INFO_UINT32 : INFO_UINT64);
+    /* Big-endian argument */
+    for(i = len - 1; i > 0; i--) {
+      p[i] = (uint8_t)arg;
+      arg >>= 8;
+    }
+  }
+
+  writer->len += len;
+  return len;
+}
+/*---------------------------------------------------------------------------*/
+static size_t
+write_byte(cbor_writer_t *writer, uint8_t byte)
+{
+  if(writer->len >= writer->size) {
+    writer->overflow = 1;
+    return 0;
+  }
+  writer->buffer[writer->len++] = byte;
+  return 1;
+}
+/*---------------------------------------------------------------------------*/
+size_t
+cbor_write_uint(cbor_writer_t *writer, uint64_t value)
+{
+  return write_head(writer, CBOR_MAJOR_UINT, value, 0);
+}
+/*---------------------------------------------------------------------------*/
+size_t
+cbor_write_int(cbor_writer_t *writer, int64_t value)
+{
+  if(value < 0) {
+    /* Negative integers are encoded as -1 - value */
+    return write_head(writer, CBOR_MAJOR_NINT, (uint64_t)(-(value + 1)), 0);
+  }
+  return write_head(writer, CBOR_MAJOR_UINT, (uint64_t)value, 0);
+}
+/*---------------------------------------------------------------------------*/
+size_t
+cbor_write_bool(cbor_writer_t *writer, int value)
+{
+  return write_head(writer, CBOR_MAJOR_SIMPLE,
+                    value ? CBOR_SIMPLE_TRUE : CBOR_SIMPLE_FALSE, 0);
+}
+/*---------------------------------------------------------------------------*/
+size_t
+cbor_write_null(cbor_writer_t *writer)
+{
+  return write_head(writer, CBOR_MAJOR_SIMPLE, CBOR_SIMPLE_NULL, 0);
+}
+/*---------------------------------------------------------------------------*/
+size_t
+cbor_write_float(cbor_writer_t *writer, float value)
+{
+  uint32_t bits;
+  uint8_t *p;
+
+  if(writer->len + 5 > writer->size) {
+    writer->overflow = 1;
+    return 0;
+  }
+
+  memcpy(&bits, &value, sizeof(bits));
+  p = &writer->buffer[writer->len];
+  p[0] = (CBOR_MAJOR_SIMPLE << 5) | INFO_UINT32;
+  p[1] = bits >> 24;
+  p[2] = bits >> 16;
+  p[3] = bits >> 8;
+  p[4] = bits;
+  writer->len += 5;
+  return 5;
+}
+/*---------------------------------------------------------------------------*/
+static size_t
+write_string(cbor_writer_t *writer, uint8_t major, const void *data,
+             size_t len)
+{
+  size_t head;
+
+  head = write_head(writer, major, len, len);
+  if(head == 0) {
+    return 0;
+  }
+  memcpy(&writer->buffer[writer->len], data, len);
+  writer->len += len;
+  return head + len;
+}
+/*---------------------------------------------------------------------------*/
+size_t
+cbor_write_text(cbor_writer_t *writer, const char *text, size_t len)
+{
+  return write_string(writer, CBOR_MAJOR_TEXT, text, len);
+}
+/*---------------------------------------------------------------------------*/
+size_t
+cbor_write_bytes(cbor_writer_t *writer, const uint8_t *data, size_t len)
+{
+  return write_string(writer, CBOR_MAJOR_BYTES, data, len);
+}
+/*---------------------------------------------------------------------------*/
+size_t
+cbor_write_tag(cbor_writer_t *writer, uint64_t tag)
+{
+  return write_head(writer, CBOR_MAJOR_TAG, tag, 0);
+}
+/*---------------------------------------------------------------------------*/
+size_t
+cbor_write_array(cbor_writer_t *writer, size_t count)
+{
+  if(count == CBOR_INDEFINITE) {
+    return write_byte(writer, (CBOR_MAJOR_ARRAY << 5) | INFO_INDEFINITE);
+  }
+  return write_head(writer, CBOR_MAJOR_ARRAY, count, 0);
+}
+/*---------------------------------------------------------------------------*/
+size_t
+cbor_write_map(cbor_writer_t *writer, size_t count)
+{
+  if(count == CBOR_INDEFINITE) {
+    return write_byte(writer, (CBOR_MAJOR_MAP << 5) | INFO_INDEFINITE);
+  }
+  return write_head(writer, CBOR_MAJOR_MAP, count, 0);
+}
+/*---------------------------------------------------------------------------*/
+size_t
+cbor_write_break(cbor_writer_t *writer)
+{
+  return write_byte(writer, CBOR_BREAK);
+}
+/*---------------------------------------------------------------------------*/
+void
+cbor_reader_init(cbor_reader_t *reader, const uint8_t *buffer, size_t size)
+{
+  reader->buffer = buffer;
+  reader->size = size;
+  reader->pos = 0;
+  reader->error = 0;
+}
+/*---------------------------------------------------------------------------*/
+/*
+ * Decodes the head of the item at *pos and advances *pos past it. For
+ * INFO_INDEFINITE the argument is CBOR_INDEFINITE. Sets the error flag
+ * and returns 0 on truncated or malformed data.
+ */
+static int
+read_head(cbor_reader_t *reader, size_t *pos, uint8_t *major, uint8_t *info,
+          uint64_t *arg)
+{
+  size_t len;
+  size_t i;
+
+  if(*pos >= reader->size) {
+    reader->error = 1;
+    return 0;
+  }
+
+  *major = reader->buffer[*pos] >> 5;
+  *info = reader->buffer[*pos] & 0x1f;
+  (*pos)++;
+
+  if(*info < INFO_UINT8) {
+    *arg = *info;
+    return 1;
+  }
+  if(*info == INFO_INDEFINITE) {
+    *arg = CBOR_INDEFINITE;
+    return 1;
+  }
+  if(*info > INFO_UINT64) {
+    /* Reserved */
+    reader->error = 1;
+    return 0;
+  }
+
+  len = (size_t)1 << (*info - INFO_UINT8);
+  if(reader->size - *pos < len) {
+    reader->error = 1;
+    return 0;
+  }
+  *arg = 0;
+  for(i = 0; i < len; i++) {
+    *arg = (*arg << 8) | reader->buffer[(*pos)++];
+  }
+  return 1;
+}
+/*---------------------------------------------------------------------------*/
+/* Decodes a head of the given major type and commits the position */
+static int
+read_typed_head(cbor_reader_t *reader, uint8_t major, uint8_t *info,
+                uint64_t *arg)
+{
+  size_t pos;
+  uint8_t item_major;
+
+  pos = reader->pos;
+  if(!read_head(reader, &pos, &item_major, info, arg) ||
+     item_major != major) {
+    return 0;
+  }
+  reader->pos = pos;
+  return 1;
+}
+/*---------------------------------------------------------------------------*/
+int
+cbor_read_type(const cbor_reader_t *reader)
+{
+  if(reader->pos >= reader->size ||
+     reader->buffer[reader->pos] == CBOR_BREAK) {
+    return -1;
+  }
+  return reader->buffer[reader->pos] >> 5;
+}
+/*---------------------------------------------------------------------------*/
+int
+cbor_read_break(cbor_reader_t *reader)
+{
+  if(reader->pos < reader->size &&
+     reader->buffer[reader->pos] == CBOR_BREAK) {
+    reader->pos++;
+    return 1;
+  }
+  return 0;
+}
+/*---------------------------------------------------------------------------*/
+int
+cbor_read_uint(cbor_reader_t *reader, uint64_t *value)
+{
+  uint8_t info;
+  size_t pos;
+
+  pos = reader->pos;
+  if(!read_typed_head(reader, CBOR_MAJOR_UINT, &info, value)) {
+    return 0;
+  }
+  if(info == INFO_INDEFINITE) {
+    reader->pos = pos;
+    reader->error = 1;
+    return 0;
+  }
+  return 1;
+}
+/*---------------------------------------------------------------------------*/
+int
+cbor_read_int(cbor_reader_t *reader, int64_t *value)
+{
+  uint8_t major;
+  uint8_t info;
+  uint64_t arg;
+  size_t pos;
+
+  pos = reader->pos;
+  if(!read_head(reader, &pos, &major, &info, &arg) ||
+     (major != CBOR_MAJOR_UINT && major != CBOR_MAJOR_NINT) ||
+     info == INFO_INDEFINITE || arg > INT64_MAX) {
+    return 0;
+  }
+
+  *value = major == CBOR_MAJOR_UINT ? (int64_t)arg : -1 - (int64_t)arg;
+  reader->pos = pos;
+  return 1;
+}
+/*---------------------------------------------------------------------------*/
+int
+cbor_read_bool(cbor_reader_t *reader, int *value)
+{
+  if(reader->pos >= reader->size) {
+    return 0;
+  }
+  switch(reader->buffer[reader->pos]) {
+  case (CBOR_MAJOR_SIMPLE << 5) | CBOR_SIMPLE_FALSE:
+    *value = 0;
+    break;
+  case (CBOR_MAJOR_SIMPLE << 5) | CBOR_SIMPLE_TRUE:
+    *value = 1;
+    break;
+  default:
+    return 0;
+  }
+  reader->pos++;
+  return 1;
+}
+/*---------------------------------------------------------------------------*/
+int
+cbor_read_null(cbor_reader_t *reader)
+{
+  if(reader->pos < reader->size &&
+     reader->buffer[reader->pos] ==
+     ((CBOR_MAJOR_SIMPLE << 5) | CBOR_SIMPLE_NULL)) {
+    reader->pos++;
+    return 1;
+  }
+  return 0;
+}
+/*---------------------------------------------------------------------------*/
+static float
+half_to_float(uint16_t half)
+{
+  uint32_t bits;
+  uint32_t exponent;
+  uint32_t mantissa;
+  float value;
+
+  bits = (uint32_t)(half & 0x8000) << 16;
+  exponent = (half >> 10) & 0x1f;
+  mantissa = half & 0x3ff;
+
+  if(exponent == 0x1f) {
+    /* Infinity or NaN */
+    bits |= 0x7f800000 | (mantissa << 13);
+  } else if(exponent != 0) {
+    bits |= ((exponent + 127 - 15) << 23) | (mantissa << 13);
+  } else if(mantissa != 0) {
+    /* Subnormal half, normal float */
+    exponent = 127 - 14;
+    while((mantissa & 0x400) == 0) {
+      mantissa <<= 1;
+      exponent--;
+    }
+    bits |= (exponent << 23) | ((mantissa & 0x3ff) << 13);
+  }
+
+  memcpy(&value, &bits, sizeof(value));
+  return value;
+}
+/*---------------------------------------------------------------------------*/
+int
+cbor_read_float(cbor_reader_t *reader, float *value)
+{
+  uint8_t info;
+  uint64_t arg;
+  uint32_t single;
+  double dbl;
+  size_t pos;
+
+  pos = reader->pos;
+  if(!read_typed_head(reader, CBOR_MAJOR_SIMPLE, &info, &arg)) {
+    return 0;
+  }
+
+  switch(info) {
+  case INFO_UINT16:
+    *value = half_to_float((uint16_t)arg);
+    break;
+  case INFO_UINT32:
+    single = (uint32_t)arg;
+    memcpy(value, &single, sizeof(*value));
+    break;
+  case INFO_UINT64:
+    memcpy(&dbl, &arg, sizeof(dbl));
+    *value = (float)dbl;
+    break;
+  default:
+    reader->pos = pos;
+    return 0;
+  }
+  return 1;
+}
+/*---------------------------------------------------------------------------*/
+static int
+read_string(cbor_reader_t *reader, uint8_t major, const void **data,
+            size_t *len)
+{
+  uint8_t info;
+  uint64_t arg;
+  size_t pos;
+
+  pos = reader->pos;
+  if(!read_typed_head(reader, major, &info, &arg)) {
+    return 0;
+  }
+  if(info == INFO_INDEFINITE) {
+    /* Chunked strings cannot be returned as one view */
+    reader->pos = pos;
+    return 0;
+  }
+  if(arg > reader->size - reader->pos) {
+    reader->pos = pos;
+    reader->error = 1;
+    return 0;
+  }
+
+  *data = &reader->buffer[reader->pos];
+  *len = (size_t)arg;
+  reader->pos += (size_t)arg;
+  return 1;
+}
+/*---------------------------------------------------------------------------*/
+int
+cbor_read_text(cbor_reader_t *reader, const char **text, size_t *len)
+{
+  return read_string(reader, CBOR_MAJOR_TEXT, (const void **)text, len);
+}
+/*---------------------------------------------------------------------------*/
+int
+cbor_read_bytes(cbor_reader_t *reader, const uint8_t **data, size_t *len)
+{
+  return read_string(reader, CBOR_MAJOR_BYTES, (const void **)data, len);
+}
+/*---------------------------------------------------------------------------*/
+int
+cbor_read_tag(cbor_reader_t *reader, uint64_t *tag)
+{
+  uint8_t info;
+  size_t pos;
+
+  pos = reader->pos;
+  if(!read_typed_head(reader, CBOR_MAJOR_TAG, &info, tag)) {
+    return 0;
+  }
+  if(info == INFO_INDEFINITE) {
+    reader->pos = pos;
+    reader->error = 1;
+    return 0;
+  }
+  return 1;
+}
+/*---------------------------------------------------------------------------*/
+static int
+read_container(cbor_reader_t *reader, uint8_t major, size_t *count)
+{
+  uint8_t info;
+  uint64_t arg;
+  size_t pos;
+
+  pos = reader->pos;
+  if(!read_typed_head(reader, major, &info, &arg)) {
+    return 0;
+  }
+  if(info != INFO_INDEFINITE && arg > reader->size - reader->pos) {
+    /* Every item takes at least one byte */
+    reader->pos = pos;
+    reader->error = 1;
+    return 0;
+  }
+  *count = info == INFO_INDEFINITE ? CBOR_INDEFINITE : (size_t)arg;
+  return 1;
+}
+/*---------------------------------------------------------------------------*/
+int
+cbor_read_array(cbor_reader_t *reader, size_t *count)
+{
+  return read_container(reader, CBOR_MAJOR_ARRAY, count);
+}
+/*---------------------------------------------------------------------------*/
+int
+cbor_read_map(cbor_reader_t *reader, size_t *count)
+{
+  return read_container(reader, CBOR_MAJOR_MAP, count);
+}
+/*---------------------------------------------------------------------------*/
+static int
+skip_item(cbor_reader_t *reader, uint8_t depth)
+{
+  uint8_t major;
+  uint8_t info;
+  uint64_t arg;
+  uint64_t i;
+
+  if(depth > CBOR_MAX_DEPTH ||
+     !read_head(reader, &reader->pos, &major, &info, &arg)) {
+    reader->error = 1;
+    return 0;
+  }
+
+  switch(major) {
+  case CBOR_MAJOR_UINT:
+  case CBOR_MAJOR_NINT:
+  case CBOR_MAJOR_SIMPLE:
+    /* A break outside an indefinite-length item is malformed */
+    if(info == INFO_INDEFINITE) {
+      reader->error = 1;
+      return 0;
+    }
+    return 1;
+  case CBOR_MAJOR_BYTES:
+  case CBOR_MAJOR_TEXT:
+    if(info == INFO_INDEFINITE) {
+      /* Chunks of the same major type, up to a break */
+      while(!cbor_read_break(reader)) {
+        if(cbor_read_type(reader) != major || !skip_item(reader, depth + 1)) {
+          reader->error = 1;
+          return 0;
+        }
+      }
+      return 1;
+    }
+    if(arg > reader->size - reader->pos) {
+      reader->error = 1;
+      return 0;
+    }
+    reader->pos += (size_t)arg;
+    return 1;
+  case CBOR_MAJOR_ARRAY:
+  case CBOR_MAJOR_MAP:
+    if(info == INFO_INDEFINITE) {
+      while(!cbor_read_break(reader)) {
+        if(!skip_item(reader, depth + 1)) {
+          return 0;
+        }
+      }
+      return 1;
+    }
+    if(arg > reader->size - reader->pos) {
+      reader->error = 1;
+      return 0;
+    }
+    if(major == CBOR_MAJOR_MAP) {
+      arg *= 2;
+    }
+    for(i = 0; i < arg; i++) {
+      if(!skip_item(reader, depth + 1)) {
+        return 0;
+      }
+    }
+    return 1;
+  case CBOR_MAJOR_TAG:
+    if(info == INFO_INDEFINITE) {
+      reader->error = 1;
+      return 0;
+    }
+    return skip_item(reader, depth + 1);
+  }
+  return 0;
+}
+/*---------------------------------------------------------------------------*/
+int
+cbor_read_skip(cbor_reader_t *reader)
+{
+  size_t pos;
+
+  pos = reader->pos;
+  if(!skip_item(reader, 0)) {
+    reader->pos = pos;
+    return 0;
+  }
+  return 1;
+}
+/*---------------------------------------------------------------------------*/
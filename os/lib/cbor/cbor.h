@@ -0,0 +1,171 @@
+/*
+ * Copyright (c) 2026, agent <agent@local>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+ * OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * \file
+ *         A streaming CBOR (RFC 8949) encoder and decoder.
+ *
+ *         The encoder writes each item directly into a caller-provided
+ *         buffer, such as a CoAP or MQTT payload buffer. The decoder
+ *         reads items one at a time from a buffer and returns strings
+ *         as pointers into it, without copying.
+ */
+
+#ifndef CBOR_H_
+#define CBOR_H_
+
+#include "contiki.h"
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef CBOR_CONF_MAX_DEPTH
+#define CBOR_MAX_DEPTH CBOR_CONF_MAX_DEPTH
+#else
+/** Maximum nesting of arrays and maps skipped by cbor_read_skip() */
+#define CBOR_MAX_DEPTH 8
+#endif
+
+/* Major types */
+#define CBOR_MAJOR_UINT     0
+#define CBOR_MAJOR_NINT     1
+#define CBOR_MAJOR_BYTES    2
+#define CBOR_MAJOR_TEXT     3
+#define CBOR_MAJOR_ARRAY    4
+#define CBOR_MAJOR_MAP      5
+#define CBOR_MAJOR_TAG      6
+#define CBOR_MAJOR_SIMPLE   7
+
+/* Simple values */
+#define CBOR_SIMPLE_FALSE   20
+#define CBOR_SIMPLE_TRUE    21
+#define CBOR_SIMPLE_NULL    22
+
+/** Item count of an indefinite-length array or map */
+#define CBOR_INDEFINITE     ((size_t)-1)
+
+typedef struct cbor_writer {
+  uint8_t *buffer;
+  size_t size;
+  size_t len;
+  /* Set when an item did not fit into the buffer */
+  uint8_t overflow;
+} cbor_writer_t;
+
+typedef struct cbor_reader {
+  const uint8_t *buffer;
+  size_t size;
+  size_t pos;
+  /* Set when malformed or truncated data was found */
+  uint8_t error;
+} cbor_reader_t;
+
+/**
+ * \brief Initialize an encoder that writes into a buffer
+ * \param writer The encoder
+ * \param buffer The buffer
+ * \param size The size of the buffer
+ */
+void cbor_writer_init(cbor_writer_t *writer, uint8_t *buffer, size_t size);
+
+/*
+ * The write functions append one item and return the number of bytes
+ * written. If the item does not fit, nothing is written, 0 is returned
+ * and the overflow flag of the writer is set.
+ */
+size_t cbor_write_uint(cbor_writer_t *writer, uint64_t value);
+size_t cbor_write_int(cbor_writer_t *writer, int64_t value);
+size_t cbor_write_bool(cbor_writer_t *writer, int value);
+size_t cbor_write_null(cbor_writer_t *writer);
+/** Writes a single-precision float */
+size_t cbor_write_float(cbor_writer_t *writer, float value);
+size_t cbor_write_text(cbor_writer_t *writer, const char *text, size_t len);
+size_t cbor_write_bytes(cbor_writer_t *writer, const uint8_t *data,
+                        size_t len);
+size_t cbor_write_tag(cbor_writer_t *writer, uint64_t tag);
+/** Writes an array header for count items, or CBOR_INDEFINITE */
+size_t cbor_write_array(cbor_writer_t *writer, size_t count);
+/** Writes a map header for count pairs, or CBOR_INDEFINITE */
+size_t cbor_write_map(cbor_writer_t *writer, size_t count);
+/** Ends an indefinite-length array or map */
+size_t cbor_write_break(cbor_writer_t *writer);
+
+/**
+ * \brief Initialize a decoder that reads from a buffer
+ * \param reader The decoder
+ * \param buffer The CBOR data
+ * \param size The length of the data
+ */
+void cbor_reader_init(cbor_reader_t *reader, const uint8_t *buffer,
+                      size_t size);
+
+/**
+ * \brief Get the major type of the next item
+ * \param reader The decoder
+ * \return The major type, or -1 at the end of the data or at a break
+ */
+int cbor_read_type(const cbor_reader_t *reader);
+
+/**
+ * \brief Check for the end of an indefinite-length array or map
+ * \param reader The decoder
+ * \return 1 and consumes the break if the next item is a break, else 0
+ */
+int cbor_read_break(cbor_reader_t *reader);
+
+/*
+ * The read functions decode the next item if it has the requested type
+ * and return 1. Otherwise they return 0 and leave the position as is.
+ */
+int cbor_read_uint(cbor_reader_t *reader, uint64_t *value);
+int cbor_read_int(cbor_reader_t *reader, int64_t *value);
+int cbor_read_bool(cbor_reader_t *reader, int *value);
+int cbor_read_null(cbor_reader_t *reader);
+/** Reads a half-, single- or double-precision float */
+int cbor_read_float(cbor_reader_t *reader, float *value);
+/** Reads a definite-length text string as a view into the buffer */
+int cbor_read_text(cbor_reader_t *reader, const char **text, size_t *len);
+/** Reads a definite-length byte string as a view into the buffer */
+int cbor_read_bytes(cbor_reader_t *reader, const uint8_t **data,
+                    size_t *len);
+int cbor_read_tag(cbor_reader_t *reader, uint64_t *tag);
+/** Reads an array header; count is CBOR_INDEFINITE for indefinite length */
+int cbor_read_array(cbor_reader_t *reader, size_t *count);
+/** Reads a map header; count is CBOR_INDEFINITE for indefinite length */
+int cbor_read_map(cbor_reader_t *reader, size_t *count);
+
+/**
+ * \brief Skip the next item, including nested items
+ * \param reader The decoder
+ * \return 1 on success, 0 on malformed data
+ */
+int cbor_read_skip(cbor_reader_t *reader);
+
+#endif /* CBOR_H_ */
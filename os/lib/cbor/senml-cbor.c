@@ -0,0 +1,220 @@
+/*
+ * Copyright (c) 2026, agent <agent@local>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+ * OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * \file
+ *         SenML (RFC 8428) records in the CBOR representation.
+ */
+
+#include "senml-cbor.h"
+
+#include <string.h>
+/*---------------------------------------------------------------------------*/
+size_t
+senml_cbor_start_pack(cbor_writer_t *writer)
+{
+  return cbor_write_array(writer, CBOR_INDEFINITE);
+}
+/*---------------------------------------------------------------------------*/
+size_t
+senml_cbor_end_pack(cbor_writer_t *writer)
+{
+  return cbor_write_break(writer);
+}
+/*---------------------------------------------------------------------------*/
+static int
+write_text_field(cbor_writer_t *writer, int label, const char *text,
+                 size_t len)
+{
+  return cbor_write_int(writer, label) &&
+    cbor_write_text(writer, text, len > 0 ? len : strlen(text));
+}
+/*---------------------------------------------------------------------------*/
+size_t
+senml_cbor_write_record(cbor_writer_t *writer, const senml_record_t *record)
+{
+  size_t start;
+  size_t count;
+  int ok;
+
+  start = writer->len;
+  count = (record->base_name != NULL) + (record->name != NULL) +
+    (record->unit != NULL) + (record->has_time != 0) +
+    (record->type != SENML_VALUE_NONE);
+
+  ok = cbor_write_map(writer, count);
+  if(ok && record->base_name != NULL) {
+    ok = write_text_field(writer, SENML_CBOR_BASE_NAME, record->base_name,
+                          record->base_name_len);
+  }
+  if(ok && record->name != NULL) {
+    ok = write_text_field(writer, SENML_CBOR_NAME, record->name,
+                          record->name_len);
+  }
+  if(ok && record->unit != NULL) {
+    ok = write_text_field(writer, SENML_CBOR_UNIT, record->unit,
+                          record->unit_len);
+  }
+  if(ok && record->has_time) {
+    ok = cbor_write_int(writer, SENML_CBOR_TIME) &&
+      cbor_write_int(writer, record->time);
+  }
+  if(ok) {
+    switch(record->type) {
+    case SENML_VALUE_INT:
+      ok = cbor_write_int(writer, SENML_CBOR_VALUE) &&
+        cbor_write_int(writer, record->value.integer);
+      break;
+    case SENML_VALUE_FLOAT:
+      ok = cbor_write_int(writer, SENML_CBOR_VALUE) &&
+        cbor_write_float(writer, record->value.number);
+      break;
+    case SENML_VALUE_STRING:
+      ok = cbor_write_int(writer, SENML_CBOR_STRING_VALUE) &&
+        cbor_write_text(writer, (const char *)record->value.string.data,
+                        record->value.string.len);
+      break;
+    case SENML_VALUE_BOOL:
+      ok = cbor_write_int(writer, SENML_CBOR_BOOL_VALUE) &&
+        cbor_write_bool(writer, record->value.boolean);
+      break;
+    case SENML_VALUE_DATA:
+      ok = cbor_write_int(writer, SENML_CBOR_DATA_VALUE) &&
+        cbor_write_bytes(writer, record->value.string.data,
+                         record->value.string.len);
+      break;
+    case SENML_VALUE_NONE:
+      break;
+    }
+  }
+
+  if(!ok) {
+    /* Do not leave a partial record behind */
+    writer->len = start;
+    return 0;
+  }
+  return writer->len - start;
+}
+/*---------------------------------------------------------------------------*/
+int
+senml_cbor_read_pack(cbor_reader_t *reader, size_t *remaining)
+{
+  return cbor_read_array(reader, remaining);
+}
+/*---------------------------------------------------------------------------*/
+static int
+read_field(cbor_reader_t *reader, int64_t label, senml_record_t *record)
+{
+  const char *text;
+  float number;
+
+  switch(label) {
+  case SENML_CBOR_BASE_NAME:
+    return cbor_read_text(reader, &record->base_name, &record->base_name_len);
+  case SENML_CBOR_NAME:
+    return cbor_read_text(reader, &record->name, &record->name_len);
+  case SENML_CBOR_UNIT:
+    return cbor_read_text(reader, &record->unit, &record->unit_len);
+  case SENML_CBOR_TIME:
+    record->has_time = 1;
+    if(cbor_read_float(reader, &number)) {
+      record->time = (int64_t)number;
+      return 1;
+    }
+    return cbor_read_int(reader, &record->time);
+  case SENML_CBOR_VALUE:
+    if(cbor_read_int(reader, &record->value.integer)) {
+      record->type = SENML_VALUE_INT;
+      return 1;
+    }
+    record->type = SENML_VALUE_FLOAT;
+    return cbor_read_float(reader, &record->value.number);
+  case SENML_CBOR_STRING_VALUE:
+    record->type = SENML_VALUE_STRING;
+    if(!cbor_read_text(reader, &text, &record->value.string.len)) {
+      return 0;
+    }
+    record->value.string.data = (const uint8_t *)text;
+    return 1;
+  case SENML_CBOR_BOOL_VALUE:
+    record->type = SENML_VALUE_BOOL;
+    return cbor_read_bool(reader, &record->value.boolean);
+  case SENML_CBOR_DATA_VALUE:
+    record->type = SENML_VALUE_DATA;
+    return cbor_read_bytes(reader, &record->value.string.data,
+                           &record->value.string.len);
+  }
+  /* Unknown label */
+  return cbor_read_skip(reader);
+}
+/*---------------------------------------------------------------------------*/
+int
+senml_cbor_read_record(cbor_reader_t *reader, size_t *remaining,
+                       senml_record_t *record)
+{
+  size_t count;
+  int64_t label;
+
+  if(*remaining == 0) {
+    return 0;
+  }
+  if(*remaining == CBOR_INDEFINITE && cbor_read_break(reader)) {
+    *remaining = 0;
+    return 0;
+  }
+
+  memset(record, 0, sizeof(*record));
+  if(!cbor_read_map(reader, &count)) {
+    reader->error = 1;
+    return 0;
+  }
+
+  while(count == CBOR_INDEFINITE ? !cbor_read_break(reader) : count > 0) {
+    if(!cbor_read_int(reader, &label)) {
+      /* Not a SenML label - skip the pair */
+      if(!cbor_read_skip(reader) || !cbor_read_skip(reader)) {
+        reader->error = 1;
+        return 0;
+      }
+    } else if(!read_field(reader, label, record)) {
+      reader->error = 1;
+      return 0;
+    }
+    if(count != CBOR_INDEFINITE) {
+      count--;
+    }
+  }
+
+  if(*remaining != CBOR_INDEFINITE) {
+    (*remaining)--;
+  }
+  return 1;
+}
+/*---------------------------------------------------------------------------*/
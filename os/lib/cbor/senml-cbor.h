@@ -0,0 +1,129 @@
+/*
+ * Copyright (c) 2026, agent <agent@local>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+ * OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * \file
+ *         SenML (RFC 8428) records in the CBOR representation.
+ *
+ *         A SenML pack is written as an indefinite-length array, so
+ *         records can be appended as they are produced. Each record is
+ *         a map with integer labels.
+ */
+
+#ifndef SENML_CBOR_H_
+#define SENML_CBOR_H_
+
+#include "cbor.h"
+
+/* SenML CBOR labels (RFC 8428, Section 6) */
+#define SENML_CBOR_BASE_NAME      -2
+#define SENML_CBOR_BASE_TIME      -3
+#define SENML_CBOR_BASE_UNIT      -4
+#define SENML_CBOR_NAME            0
+#define SENML_CBOR_UNIT            1
+#define SENML_CBOR_VALUE           2
+#define SENML_CBOR_STRING_VALUE    3
+#define SENML_CBOR_BOOL_VALUE      4
+#define SENML_CBOR_TIME            6
+#define SENML_CBOR_DATA_VALUE      8
+
+typedef enum {
+  SENML_VALUE_NONE,
+  SENML_VALUE_INT,
+  SENML_VALUE_FLOAT,
+  SENML_VALUE_STRING,
+  SENML_VALUE_BOOL,
+  SENML_VALUE_DATA
+} senml_value_type_t;
+
+/**
+ * A SenML record. Unused strings are NULL. When writing, a string with
+ * a zero length field is written up to its terminating NUL character.
+ * When reading, the strings point into the CBOR data and are not NUL
+ * terminated.
+ */
+typedef struct senml_record {
+  const char *base_name;
+  const char *name;
+  const char *unit;
+  size_t base_name_len;
+  size_t name_len;
+  size_t unit_len;
+  int64_t time;
+  uint8_t has_time;
+  senml_value_type_t type;
+  union {
+    int64_t integer;
+    float number;
+    int boolean;
+    struct {
+      const uint8_t *data;
+      size_t len;
+    } string;
+  } value;
+} senml_record_t;
+
+/** Starts a pack: writes the header of an indefinite-length array */
+size_t senml_cbor_start_pack(cbor_writer_t *writer);
+
+/** Ends a pack */
+size_t senml_cbor_end_pack(cbor_writer_t *writer);
+
+/**
+ * \brief Write a record
+ * \param writer The CBOR encoder
+ * \param record The record
+ * \return The number of bytes written, or 0 if the record did not fit.
+ *         A record is either written completely or not at all.
+ */
+size_t senml_cbor_write_record(cbor_writer_t *writer,
+                               const senml_record_t *record);
+
+/**
+ * \brief Start reading a pack
+ * \param reader The CBOR decoder
+ * \param remaining Set to the number of records, or CBOR_INDEFINITE. It
+ *        is updated by senml_cbor_read_record().
+ * \return 1 if a SenML pack starts here, else 0
+ */
+int senml_cbor_read_pack(cbor_reader_t *reader, size_t *remaining);
+
+/**
+ * \brief Read the next record of a pack
+ * \param reader The CBOR decoder
+ * \param remaining The record count from senml_cbor_read_pack()
+ * \param record The record. Unknown labels are skipped.
+ * \return 1 if a record was read, 0 at the end of the pack or on error
+ *         (see the error flag of the reader)
+ */
+int senml_cbor_read_record(cbor_reader_t *reader, size_t *remaining,
+                           senml_record_t *record);
+
+#endif /* SENML_CBOR_H_ */
@@ -61,7 +61,8 @@ struct jsonparse_state {
  * \param len  The length of the string to parse
  *
  *             This function initializes a JSON parser state for
- *             parsing a string as JSON.
+ *             parsing a string as JSON. The whole document must be in
+ *             memory; see jsonsax.h for documents that arrive in parts.
  */
 void jsonparse_setup(struct jsonparse_state *state, const char *json,
                      int len);
@@ -0,0 +1,618 @@
+/*
+ * Copyright (c) 2026, agent <agent@local>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+ * OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * \file
+ *         An incremental JSON tokenizer with SAX-style callbacks.
+ */
+
+#include "jsonsax.h"
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+
+/* Parser states */
+enum {
+  STATE_VALUE,          /* expecting a value */
+  STATE_ARRAY_FIRST,    /* expecting a value or ']' */
+  STATE_OBJECT_FIRST,   /* expecting a name or '}' */
+  STATE_NAME,           /* expecting a name */
+  STATE_COLON,
+  STATE_NEXT,           /* expecting ',' or the end of the container */
+  STATE_DONE,
+  STATE_STRING,
+  STATE_ESCAPE,
+  STATE_UNICODE,
+  STATE_NUMBER,
+  STATE_LITERAL
+};
+
+/* Number states, following the grammar in RFC 8259 */
+enum {
+  NUMBER_MINUS,
+  NUMBER_ZERO,
+  NUMBER_INT,
+  NUMBER_POINT,
+  NUMBER_FRAC,
+  NUMBER_EXP,
+  NUMBER_EXP_SIGN,
+  NUMBER_EXP_DIGITS
+};
+/*--------------------------------------------------------------------*/
+static bool
+emit(struct jsonsax_state *state, int type, const char *value, int len,
+     uint8_t partial)
+{
+  state->partial = partial;
+  if(state->callback(state, type, value, len)) {
+    state->error = JSON_ERROR_ABORTED;
+    return false;
+  }
+  return true;
+}
+/*--------------------------------------------------------------------*/
+static int
+string_type(struct jsonsax_state *state)
+{
+  return state->is_key ? JSON_TYPE_PAIR_NAME : JSON_TYPE_STRING;
+}
+/*--------------------------------------------------------------------*/
+static const char *
+literal_text(char type)
+{
+  switch(type) {
+  case JSON_TYPE_TRUE:  return "true";
+  case JSON_TYPE_FALSE: return "false";
+  default:              return "null";
+  }
+}
+/*--------------------------------------------------------------------*/
+static void
+end_value(struct jsonsax_state *state)
+{
+  state->state = state->depth == 0 ? STATE_DONE : STATE_NEXT;
+}
+/*--------------------------------------------------------------------*/
+static bool
+is_ws(char c)
+{
+  return c == ' ' || c == '\n' || c == '\r' || c == '\t';
+}
+/*--------------------------------------------------------------------*/
+static int
+hex_value(char c)
+{
+  if(c >= '0' && c <= '9') {
+    return c - '0';
+  } else if(c >= 'a' && c <= 'f') {
+    return c - 'a' + 10;
+  } else if(c >= 'A' && c <= 'F') {
+    return c - 'A' + 10;
+  }
+  return -1;
+}
+/*--------------------------------------------------------------------*/
+/* advance the number state; returns false if c does not continue it */
+static bool
+number_char(struct jsonsax_state *state, char c)
+{
+  bool digit = c >= '0' && c <= '9';
+
+  switch(state->number_state) {
+  case NUMBER_MINUS:
+    if(digit) {
+      state->number_state = c == '0' ? NUMBER_ZERO : NUMBER_INT;
+      return true;
+    }
+    return false;
+  case NUMBER_INT:
+    if(digit) {
+      return true;
+    }
+    /* fall through */
+  case NUMBER_ZERO:
+    if(c == '.') {
+      state->number_state = NUMBER_POINT;
+      return true;
+    }
+    if(c == 'e' || c == 'E') {
+      state->number_state = NUMBER_EXP;
+      return true;
+    }
+    return false;
+  case NUMBER_POINT:
+    if(digit) {
+      state->number_state = NUMBER_FRAC;
+      return true;
+    }
+    return false;
+  case NUMBER_FRAC:
+    if(digit) {
+      return true;
+    }
+    if(c == 'e' || c == 'E') {
+      state->number_state = NUMBER_EXP;
+      return true;
+    }
+    return false;
+  case NUMBER_EXP:
+    if(c == '+' || c == '-') {
+      state->number_state = NUMBER_EXP_SIGN;
+      return true;
+    }
+    /* fall through */
+  case NUMBER_EXP_SIGN:
+    if(digit) {
+      state->number_state = NUMBER_EXP_DIGITS;
+      return true;
+    }
+    return false;
+  case NUMBER_EXP_DIGITS:
+    return digit;
+  }
+  return false;
+}
+/*--------------------------------------------------------------------*/
+/* save the part of a number that is in the current chunk */
+static bool
+save_number(struct jsonsax_state *state, const char *start, const char *end)
+{
+  int len = end - start;
+
+  if(state->number_len + len > JSONSAX_NUMBER_LEN) {
+    state->error = JSON_ERROR_SYNTAX;
+    return false;
+  }
+  if(len == 0) {
+    return true;
+  }
+  memcpy(&state->number[state->number_len], start, len);
+  state->number_len += len;
+  return true;
+}
+/*--------------------------------------------------------------------*/
+static bool
+end_number(struct jsonsax_state *state, const char *start, const char *end)
+{
+  uint8_t ns = state->number_state;
+
+  if(ns != NUMBER_ZERO && ns != NUMBER_INT && ns != NUMBER_FRAC &&
+     ns != NUMBER_EXP_DIGITS) {
+    state->error = JSON_ERROR_SYNTAX;
+    return false;
+  }
+  end_value(state);
+  if(state->number_len == 0) {
+    /* The whole number is in the current chunk */
+    return emit(state, JSON_TYPE_NUMBER, start, end - start, 0);
+  }
+  if(!save_number(state, start, end)) {
+    return false;
+  }
+  return emit(state, JSON_TYPE_NUMBER, state->number, state->number_len, 0);
+}
+/*--------------------------------------------------------------------*/
+/* pass a character decoded from an escape sequence as UTF-8 */
+static bool
+emit_code_point(struct jsonsax_state *state, uint32_t cp)
+{
+  char buf[4];
+  int len;
+
+  if(cp < 0x80) {
+    buf[0] = cp;
+    len = 1;
+  } else if(cp < 0x800) {
+    buf[0] = 0xc0 | (cp >> 6);
+    buf[1] = 0x80 | (cp & 0x3f);
+    len = 2;
+  } else if(cp < 0x10000) {
+    buf[0] = 0xe0 | (cp >> 12);
+    buf[1] = 0x80 | ((cp >> 6) & 0x3f);
+    buf[2] = 0x80 | (cp & 0x3f);
+    len = 3;
+  } else {
+    buf[0] = 0xf0 | (cp >> 18);
+    buf[1] = 0x80 | ((cp >> 12) & 0x3f);
+    buf[2] = 0x80 | ((cp >> 6) & 0x3f);
+    buf[3] = 0x80 | (cp & 0x3f);
+    len = 4;
+  }
+  return emit(state, string_type(state), buf, len, 1);
+}
+/*--------------------------------------------------------------------*/
+static bool
+unicode_escape(struct jsonsax_state *state)
+{
+  uint16_t code = state->code;
+
+  if(code >= 0xd800 && code <= 0xdbff) {
+    /* High surrogate: wait for the low one */
+    if(state->surrogate != 0) {
+      state->error = JSON_ERROR_SYNTAX;
+      return false;
+    }
+    state->surrogate = code;
+    return true;
+  }
+  if(code >= 0xdc00 && code <= 0xdfff) {
+    if(state->surrogate == 0) {
+      state->error = JSON_ERROR_SYNTAX;
+      return false;
+    }
+    code = state->surrogate;
+    state->surrogate = 0;
+    return emit_code_point(state, 0x10000 +
+                           ((uint32_t)(code - 0xd800) << 10) +
+                           (state->code - 0xdc00));
+  }
+  if(state->surrogate != 0) {
+    state->error = JSON_ERROR_SYNTAX;
+    return false;
+  }
+  return emit_code_point(state, code);
+}
+/*--------------------------------------------------------------------*/
+static bool
+push(struct jsonsax_state *state, char c)
+{
+  if(state->depth >= JSONSAX_MAX_DEPTH) {
+    state->error = c == '{' ? JSON_ERROR_UNEXPECTED_OBJECT
+      : JSON_ERROR_UNEXPECTED_ARRAY;
+    return false;
+  }
+  state->stack[state->depth++] = c;
+  state->state = c == '{' ? STATE_OBJECT_FIRST : STATE_ARRAY_FIRST;
+  return emit(state, c, NULL, 0, 0);
+}
+/*--------------------------------------------------------------------*/
+static bool
+pop(struct jsonsax_state *state, char c)
+{
+  char open = c == '}' ? '{' : '[';
+
+  if(jsonsax_get_type(state) != open) {
+    state->error = c == '}' ? JSON_ERROR_UNEXPECTED_END_OF_OBJECT
+      : JSON_ERROR_UNEXPECTED_END_OF_ARRAY;
+    return false;
+  }
+  state->depth--;
+  end_value(state);
+  return emit(state, c, NULL, 0, 0);
+}
+/*--------------------------------------------------------------------*/
+static bool
+start_value(struct jsonsax_state *state, char c)
+{
+  switch(c) {
+  case '{':
+  case '[':
+    return push(state, c);
+  case '"':
+    state->is_key = 0;
+    state->state = STATE_STRING;
+    return true;
+  case 't':
+  case 'f':
+  case 'n':
+    state->literal = c;
+    state->count = 1;
+    state->state = STATE_LITERAL;
+    return true;
+  }
+  if(c == '-' || (c >= '0' && c <= '9')) {
+    state->number_state = c == '-' ? NUMBER_MINUS
+      : c == '0' ? NUMBER_ZERO : NUMBER_INT;
+    state->number_len = 0;
+    state->count = 1;
+    state->state = STATE_NUMBER;
+    return true;
+  }
+  state->error = c == '}' ? JSON_ERROR_UNEXPECTED_END_OF_OBJECT
+    : c == ']' ? JSON_ERROR_UNEXPECTED_END_OF_ARRAY : JSON_ERROR_SYNTAX;
+  return false;
+}
+/*--------------------------------------------------------------------*/
+void
+jsonsax_init(struct jsonsax_state *state, jsonsax_callback_t callback,
+             void *user)
+{
+  memset(state, 0, sizeof(*state));
+  state->callback = callback;
+  state->user = user;
+  state->state = STATE_VALUE;
+}
+/*--------------------------------------------------------------------*/
+int
+jsonsax_feed(struct jsonsax_state *state, const char *data, int len)
+{
+  const char *run;
+  const char *literal;
+  uint8_t prev;
+  char c;
+  int i;
+  int v;
+
+  if(state->error) {
+    return JSONSAX_ERROR;
+  }
+
+  /* Start of the pending string fragment or number in this chunk */
+  run = data;
+
+  for(i = 0; i < len; i++) {
+    c = data[i];
+
+    if(state->state == STATE_NUMBER) {
+      if(number_char(state, c)) {
+        if(++state->count > JSONSAX_NUMBER_LEN) {
+          state->error = JSON_ERROR_SYNTAX;
+          goto error;
+        }
+        continue;
+      }
+      if(!end_number(state, run, &data[i])) {
+        goto error;
+      }
+      /* The character after the number is handled below */
+    }
+
+    prev = state->state;
+    switch(state->state) {
+    case STATE_STRING:
+      if(c == '"' || c == '\\') {
+        if(state->surrogate != 0 && c == '"') {
+          state->error = JSON_ERROR_SYNTAX;
+          goto error;
+        }
+        if(c == '"') {
+          if(state->is_key) {
+            state->state = STATE_COLON;
+          } else {
+            end_value(state);
+          }
+          if(!emit(state, string_type(state), run, &data[i] - run, 0)) {
+            goto error;
+          }
+        } else {
+          if(&data[i] > run &&
+             !emit(state, string_type(state), run, &data[i] - run, 1)) {
+            goto error;
+          }
+          state->state = STATE_ESCAPE;
+        }
+      } else if((unsigned char)c < 0x20 || state->surrogate != 0) {
+        state->error = JSON_ERROR_SYNTAX;
+        goto error;
+      }
+      break;
+    case STATE_ESCAPE:
+      if(c == 'u') {
+        state->code = 0;
+        state->count = 0;
+        state->state = STATE_UNICODE;
+        break;
+      }
+      switch(c) {
+      case '"':
+      case '\\':
+      case '/':
+        break;
+      case 'b': c = '\b'; break;
+      case 'f': c = '\f'; break;
+      case 'n': c = '\n'; break;
+      case 'r': c = '\r'; break;
+      case 't': c = '\t'; break;
+      default:
+        state->error = JSON_ERROR_SYNTAX;
+        goto error;
+      }
+      if(state->surrogate != 0) {
+        state->error = JSON_ERROR_SYNTAX;
+        goto error;
+      }
+      if(!emit(state, string_type(state), &c, 1, 1)) {
+        goto error;
+      }
+      state->state = STATE_STRING;
+      run = &data[i + 1];
+      break;
+    case STATE_UNICODE:
+      v = hex_value(c);
+      if(v < 0) {
+        state->error = JSON_ERROR_SYNTAX;
+        goto error;
+      }
+      state->code = (state->code << 4) | v;
+      if(++state->count == 4) {
+        if(!unicode_escape(state)) {
+          goto error;
+        }
+        state->state = STATE_STRING;
+        run = &data[i + 1];
+      }
+      break;
+    case STATE_LITERAL:
+      literal = literal_text(state->literal);
+      if(c != literal[state->count]) {
+        state->error = JSON_ERROR_SYNTAX;
+        goto error;
+      }
+      if(literal[++state->count] == '\0') {
+        end_value(state);
+        if(!emit(state, state->literal, NULL, 0, 0)) {
+          goto error;
+        }
+      }
+      break;
+    default:
+      if(is_ws(c)) {
+        break;
+      }
+      switch(state->state) {
+      case STATE_ARRAY_FIRST:
+        if(c == ']') {
+          if(!pop(state, c)) {
+            goto error;
+          }
+          break;
+        }
+        /* fall through */
+      case STATE_VALUE:
+        if(!start_value(state, c)) {
+          goto error;
+        }
+        break;
+      case STATE_OBJECT_FIRST:
+        if(c == '}') {
+          if(!pop(state, c)) {
+            goto error;
+          }
+          break;
+        }
+        /* fall through */
+      case STATE_NAME:
+        if(c != '"') {
+          state->error = c == '}' ? JSON_ERROR_UNEXPECTED_END_OF_OBJECT
+            : JSON_ERROR_SYNTAX;
+          goto error;
+        }
+        state->is_key = 1;
+        state->state = STATE_STRING;
+        break;
+      case STATE_COLON:
+        if(c != ':') {
+          state->error = JSON_ERROR_SYNTAX;
+          goto error;
+        }
+        state->state = STATE_VALUE;
+        break;
+      case STATE_NEXT:
+        if(c == ',') {
+          state->state = jsonsax_get_type(state) == '{'
+            ? STATE_NAME : STATE_VALUE;
+        } else if(c == '}' || c == ']') {
+          if(!pop(state, c)) {
+            goto error;
+          }
+        } else {
+          state->error = JSON_ERROR_SYNTAX;
+          goto error;
+        }
+        break;
+      default:
+        /* Only whitespace may follow the document */
+        state->error = JSON_ERROR_SYNTAX;
+        goto error;
+      }
+    }
+
+    if(state->state != prev) {
+      if(state->state == STATE_STRING) {
+        run = &data[i + 1];
+      } else if(state->state == STATE_NUMBER) {
+        run = &data[i];
+      }
+    }
+  }
+
+  /* Pass or save what is left of the current string or number */
+  if(state->state == STATE_STRING && &data[len] > run) {
+    if(!emit(state, string_type(state), run, &data[len] - run, 1)) {
+      i = len;
+      goto error;
+    }
+  } else if(state->state == STATE_NUMBER) {
+    if(!save_number(state, run, &data[len])) {
+      i = len;
+      goto error;
+    }
+  }
+
+  state->offset += len;
+  return JSONSAX_OK;
+
+error:
+  state->offset += i;
+  return JSONSAX_ERROR;
+}
+/*--------------------------------------------------------------------*/
+int
+jsonsax_finish(struct jsonsax_state *state)
+{
+  if(state->error) {
+    return JSONSAX_ERROR;
+  }
+  if(state->state == STATE_NUMBER && state->depth == 0) {
+    if(!end_number(state, NULL, NULL)) {
+      return JSONSAX_ERROR;
+    }
+  }
+  if(state->state != STATE_DONE) {
+    state->error = JSON_ERROR_SYNTAX;
+    return JSONSAX_ERROR;
+  }
+  return JSONSAX_OK;
+}
+/*--------------------------------------------------------------------*/
+int
+jsonsax_is_done(const struct jsonsax_state *state)
+{
+  return state->state == STATE_DONE && !state->error;
+}
+/*--------------------------------------------------------------------*/
+int
+jsonsax_get_depth(const struct jsonsax_state *state)
+{
+  return state->depth;
+}
+/*--------------------------------------------------------------------*/
+int
+jsonsax_get_type(const struct jsonsax_state *state)
+{
+  if(state->depth == 0) {
+    return 0;
+  }
+  return state->stack[state->depth - 1];
+}
+/*--------------------------------------------------------------------*/
+long
+jsonsax_value_as_long(const char *value, int len)
+{
+  char buf[JSONSAX_NUMBER_LEN + 1];
+
+  if(len > JSONSAX_NUMBER_LEN) {
+    len = JSONSAX_NUMBER_LEN;
+  }
+  memcpy(buf, value, len);
+  buf[len] = '\0';
+  return strtol(buf, NULL, 10);
+}
+/*--------------------------------------------------------------------*/
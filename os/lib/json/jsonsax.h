@@ -0,0 +1,148 @@
+/*
+ * Copyright (c) 2026, agent <agent@local>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+ * OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * \file
+ *         An incremental JSON tokenizer with SAX-style callbacks.
+ *
+ *         The document is fed in chunks of any size, e.g. as CoAP blocks
+ *         or MQTT/HTTP segments arrive, and parsed with constant memory.
+ *         Values are passed to the callback as views into the fed chunk.
+ *         Strings that span chunks or contain escapes are passed in
+ *         several fragments; the partial flag of the state is set for
+ *         all fragments but the last one. Numbers are always passed
+ *         whole, and are copied into the state only when they span chunks.
+ */
+
+#ifndef JSONSAX_H_
+#define JSONSAX_H_
+
+#include "contiki.h"
+#include "json.h"
+
+#ifdef JSONSAX_CONF_MAX_DEPTH
+#define JSONSAX_MAX_DEPTH JSONSAX_CONF_MAX_DEPTH
+#else
+#define JSONSAX_MAX_DEPTH 10
+#endif
+
+#ifdef JSONSAX_CONF_NUMBER_LEN
+#define JSONSAX_NUMBER_LEN JSONSAX_CONF_NUMBER_LEN
+#else
+/* Maximum length of a number */
+#define JSONSAX_NUMBER_LEN 24
+#endif
+
+#define JSONSAX_OK     0
+#define JSONSAX_ERROR -1
+
+struct jsonsax_state;
+
+/**
+ * \brief The SAX callback
+ * \param state The parser state
+ * \param type  JSON_TYPE_OBJECT, JSON_TYPE_ARRAY, '}' and ']' for the
+ *              start and end of objects and arrays, JSON_TYPE_PAIR_NAME
+ *              for a member name, JSON_TYPE_STRING, JSON_TYPE_NUMBER,
+ *              JSON_TYPE_TRUE, JSON_TYPE_FALSE or JSON_TYPE_NULL
+ * \param value The (unescaped) string fragment or the number, else NULL.
+ *              It is not NUL terminated.
+ * \param len   The length of the value
+ * \return 0 to continue parsing, or non-zero to stop with
+ *         JSON_ERROR_ABORTED
+ */
+typedef int (*jsonsax_callback_t)(struct jsonsax_state *state, int type,
+                                  const char *value, int len);
+
+struct jsonsax_state {
+  jsonsax_callback_t callback;
+  void *user;
+  /* Number of bytes consumed, or the offset of the error */
+  unsigned long offset;
+  uint8_t state;
+  uint8_t depth;
+  /* Set while more fragments of the current string follow */
+  uint8_t partial;
+  uint8_t is_key;
+  uint8_t count;
+  uint8_t number_state;
+  uint8_t number_len;
+  char literal;
+  char error;
+  uint16_t code;
+  uint16_t surrogate;
+  char stack[JSONSAX_MAX_DEPTH];
+  char number[JSONSAX_NUMBER_LEN];
+};
+
+/**
+ * \brief Initialize a parser
+ * \param state    The parser state
+ * \param callback The callback for parsed elements
+ * \param user     Application data, available to the callback as
+ *                 state->user
+ */
+void jsonsax_init(struct jsonsax_state *state, jsonsax_callback_t callback,
+                  void *user);
+
+/**
+ * \brief Parse the next chunk of a document
+ * \param state The parser state
+ * \param data  The chunk. It is not accessed after the function returns.
+ * \param len   The length of the chunk
+ * \return JSONSAX_OK, or JSONSAX_ERROR with the error and offset fields
+ *         of the state set
+ */
+int jsonsax_feed(struct jsonsax_state *state, const char *data, int len);
+
+/**
+ * \brief Signal the end of the document
+ * \param state The parser state
+ * \return JSONSAX_OK if a complete document was parsed, else JSONSAX_ERROR
+ */
+int jsonsax_finish(struct jsonsax_state *state);
+
+/**
+ * \brief Check if a complete document has been parsed
+ *
+ *        A top-level number is only complete after jsonsax_finish().
+ */
+int jsonsax_is_done(const struct jsonsax_state *state);
+
+/* get the current nesting depth */
+int jsonsax_get_depth(const struct jsonsax_state *state);
+
+/* get the type of the innermost object or array, or 0 at the top level */
+int jsonsax_get_type(const struct jsonsax_state *state);
+
+/* parse a number value passed to the callback as a long */
+long jsonsax_value_as_long(const char *value, int len);
+
+#endif /* JSONSAX_H_ */
@@ -104,7 +104,7 @@ coap_block1_handler(coap_message_t *request, coap_message_t *response,
     *len = request->block1_offset + pay_len;
   }
 
-  if(coap_is_option(request, COAP_OPTION_BLOCK1)) {
+  if(coap_get_header_block1(request, NULL, NULL, NULL, NULL)) {
     LOG_DBG("Blockwise: block 1 request: Num: %"PRIu32
             ", More: %u, Size: %u, Offset: %"PRIu32"\n",
             request->block1_num,
@@ -112,8 +112,19 @@ coap_block1_handler(coap_message_t *request, coap_message_t *response,
             request->block1_size,
             request->block1_offset);
 
-    coap_set_header_block1(response, request->block1_num,
-			   request->block1_more, request->block1_size);
+    if(coap_is_option(request, COAP_OPTION_Q_BLOCK1)) {
+      coap_set_header_q_block1(response, request->block1_num,
+                               request->block1_more, request->block1_size);
+      /* NON Q-Block1 requests are only answered at the end of each
+         set of MAX_PAYLOADS blocks (RFC 9177) */
+      if(request->block1_more && request->type == COAP_TYPE_NON
+         && (request->block1_num + 1) % COAP_QBLOCK_MAX_PAYLOADS != 0) {
+        coap_status_code = MANUAL_RESPONSE;
+      }
+    } else {
+      coap_set_header_block1(response, request->block1_num,
+                             request->block1_more, request->block1_size);
+    }
     if(request->block1_more) {
       coap_set_status_code(response, CONTINUE_2_31);
       return 1;
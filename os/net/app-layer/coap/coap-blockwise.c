@@ -0,0 +1,463 @@
+/*
+ * Copyright (c) 2026, agent <agent@local>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+ * OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * \file
+ *      CoAP block-wise transfers (RFC 7959) and Q-Block2 bursts (RFC 9177)
+ */
+
+/**
+ * \addtogroup coap
+ * @{
+ */
+
+#include "coap-blockwise.h"
+#include "coap-transport.h"
+#include "sys/cc.h"
+#include <string.h>
+#include <inttypes.h>
+
+/* Log configuration */
+#include "coap-log.h"
+#define LOG_MODULE "coap-blk"
+#define LOG_LEVEL  LOG_LEVEL_COAP
+
+#if COAP_BLOCKWISE_BUFFER_SIZE > 0
+/* A representation generated for a GET request */
+typedef struct {
+  coap_endpoint_t endpoint;
+  uint64_t expires;
+  /* Hash of the URI path, the query and the Accept option */
+  uint32_t key;
+  /* 0 if unused */
+  uint16_t len;
+  uint16_t content_format;
+  uint8_t has_content_format;
+  uint8_t etag_len;
+  uint8_t etag[COAP_ETAG_LEN];
+  uint8_t data[COAP_BLOCKWISE_BUFFER_SIZE];
+} representation_t;
+
+static representation_t representations[COAP_BLOCKWISE_BUFFERS];
+
+/* The blocks to send after the response to a Q-Block2 request */
+static struct {
+  representation_t *representation;
+  uint32_t num;
+  uint16_t size;
+  uint8_t count;
+  uint8_t token_len;
+  uint8_t token[COAP_TOKEN_LEN];
+} burst;
+#endif /* COAP_BLOCKWISE_BUFFER_SIZE > 0 */
+/*---------------------------------------------------------------------------*/
+static void
+set_block2(coap_message_t *response, uint8_t q, uint32_t num, uint8_t more,
+           uint16_t size)
+{
+  if(q) {
+    coap_set_header_q_block2(response, num, more, size);
+  } else {
+    coap_set_header_block2(response, num, more, size);
+  }
+}
+/*---------------------------------------------------------------------------*/
+#if COAP_BLOCKWISE_BUFFER_SIZE > 0
+/* FNV-1a */
+static uint32_t
+hash_update(uint32_t hash, const uint8_t *data, size_t len)
+{
+  while(len-- > 0) {
+    hash = (hash ^ *data++) * 16777619UL;
+  }
+  return hash;
+}
+/*---------------------------------------------------------------------------*/
+static uint32_t
+request_key(coap_message_t *request)
+{
+  uint32_t hash = 2166136261UL;
+  const char *str;
+  unsigned int accept = 0;
+  uint8_t a[2];
+  int len;
+
+  len = coap_get_header_uri_path(request, &str);
+  hash = hash_update(hash, (const uint8_t *)str, len);
+  len = coap_get_header_uri_query(request, &str);
+  hash = hash_update(hash, (const uint8_t *)"?", 1);
+  hash = hash_update(hash, (const uint8_t *)str, len);
+  coap_get_header_accept(request, &accept);
+  a[0] = accept >> 8;
+  a[1] = accept;
+  return hash_update(hash, a, sizeof(a));
+}
+/*---------------------------------------------------------------------------*/
+static representation_t *
+find_representation(coap_message_t *request)
+{
+  uint64_t now = coap_timer_uptime();
+  uint32_t key = request_key(request);
+  int i;
+
+  for(i = 0; i < COAP_BLOCKWISE_BUFFERS; i++) {
+    if(representations[i].len > 0 && representations[i].expires > now &&
+       representations[i].key == key &&
+       coap_endpoint_cmp(&representations[i].endpoint, request->src_ep)) {
+      return &representations[i];
+    }
+  }
+  return NULL;
+}
+/*---------------------------------------------------------------------------*/
+/* Get a buffer for a new representation: an unused or expired one, the
+   previous representation for the same request, or the oldest one */
+static representation_t *
+allocate_representation(coap_message_t *request)
+{
+  representation_t *r;
+  representation_t *oldest = &representations[0];
+  uint64_t now = coap_timer_uptime();
+  int i;
+
+  r = find_representation(request);
+  if(r != NULL) {
+    return r;
+  }
+  for(i = 0; i < COAP_BLOCKWISE_BUFFERS; i++) {
+    r = &representations[i];
+    if(r->len == 0 || r->expires <= now) {
+      return r;
+    }
+    if(r->expires < oldest->expires) {
+      oldest = r;
+    }
+  }
+  return oldest;
+}
+/*---------------------------------------------------------------------------*/
+/*
+ * Generate the complete representation for a GET request. The first
+ * block has already been generated into the response. Block-wise
+ * resources are called again for the following blocks, reusing the
+ * payload buffer.
+ */
+static representation_t *
+store_representation(coap_message_t *request, coap_message_t *response,
+                     uint8_t *buffer, uint16_t block_size,
+                     int32_t new_offset, coap_blockwise_service_t service)
+{
+  static coap_message_t chunk[1];
+  representation_t *r;
+  uint16_t first;
+  uint16_t len;
+  int32_t offset;
+  uint32_t hash;
+  const uint8_t *etag;
+  uint32_t block2_num = request->block2_num;
+  uint32_t block2_offset = request->block2_offset;
+  uint16_t block2_size = request->block2_size;
+
+  if(new_offset == 0) {
+    /* Resource unaware of blocks: the response holds everything */
+    if(response->payload_len > COAP_BLOCKWISE_BUFFER_SIZE) {
+      return NULL;
+    }
+    first = response->payload_len;
+  } else {
+    first = MIN(response->payload_len, block_size);
+  }
+
+  r = allocate_representation(request);
+  r->len = 0;
+  memcpy(r->data, response->payload, first);
+  len = first;
+
+  while(new_offset > 0) {
+    if(new_offset != len || len + block_size > COAP_BLOCKWISE_BUFFER_SIZE) {
+      LOG_DBG("Blockwise: representation does not fit (%"PRId32")\n",
+              new_offset);
+      goto fail;
+    }
+    coap_init_message(chunk, response->type, CONTENT_2_05, response->mid);
+    /* Resources may look at the block option of the request, which is
+       restored before returning */
+    request->block2_num = len / block_size;
+    request->block2_offset = len;
+    request->block2_size = block_size;
+    offset = len;
+    if(service(request, chunk, buffer, block_size, &offset)
+       == COAP_HANDLER_STATUS_CONTINUE
+       || coap_status_code != NO_ERROR || chunk->code != CONTENT_2_05
+       || (offset != -1 && offset <= len)) {
+      goto fail;
+    }
+    memcpy(&r->data[len], chunk->payload, MIN(chunk->payload_len, block_size));
+    len += MIN(chunk->payload_len, block_size);
+    new_offset = offset;
+  }
+  request->block2_num = block2_num;
+  request->block2_offset = block2_offset;
+  request->block2_size = block2_size;
+
+  coap_endpoint_copy(&r->endpoint, request->src_ep);
+  r->key = request_key(request);
+  r->len = len;
+  r->expires = coap_timer_uptime() + COAP_BLOCKWISE_LIFETIME * 1000;
+  r->has_content_format = coap_is_option(response,
+                                         COAP_OPTION_CONTENT_FORMAT);
+  r->content_format = response->content_format;
+  r->etag_len = coap_get_header_etag(response, &etag);
+  if(r->etag_len > 0) {
+    memcpy(r->etag, etag, r->etag_len);
+  } else {
+    /* Lets clients detect that the representation changed between
+       transfers */
+    hash = hash_update(2166136261UL, r->data, r->len);
+    memcpy(r->etag, &hash, sizeof(hash));
+    r->etag_len = sizeof(hash);
+  }
+  LOG_DBG("Blockwise: buffered %u bytes\n", len);
+  return r;
+
+fail:
+  request->block2_num = block2_num;
+  request->block2_offset = block2_offset;
+  request->block2_size = block2_size;
+  /* Restore the first block, which has been overwritten */
+  coap_status_code = NO_ERROR;
+  memcpy(buffer, r->data, first);
+  coap_set_payload(response, buffer, first);
+  return NULL;
+}
+/*---------------------------------------------------------------------------*/
+static void
+serve_representation(representation_t *r, coap_message_t *request,
+                     coap_message_t *response, uint32_t block_num,
+                     uint16_t block_size)
+{
+  uint32_t offset = block_num * block_size;
+  uint8_t q = coap_is_option(request, COAP_OPTION_Q_BLOCK2);
+
+  if(offset >= r->len) {
+    response->code = BAD_OPTION_4_02;
+    coap_set_payload(response, "BlockOutOfScope", 15);
+    return;
+  }
+
+  response->code = CONTENT_2_05;
+  if(r->has_content_format) {
+    coap_set_header_content_format(response, r->content_format);
+  }
+  coap_set_header_etag(response, r->etag, r->etag_len);
+  set_block2(response, q, block_num, r->len - offset > block_size,
+             block_size);
+  coap_set_payload(response, &r->data[offset],
+                   MIN(r->len - offset, block_size));
+
+  if(q && request->block2_more && r->len - offset > block_size) {
+    /* The client asked for the following blocks as well */
+    burst.representation = r;
+    burst.num = block_num + 1;
+    burst.size = block_size;
+    burst.count = COAP_QBLOCK_MAX_PAYLOADS - 1;
+    burst.token_len = request->token_len;
+    memcpy(burst.token, request->token, request->token_len);
+  }
+}
+#endif /* COAP_BLOCKWISE_BUFFER_SIZE > 0 */
+/*---------------------------------------------------------------------------*/
+coap_handler_status_t
+coap_blockwise_handle_request(coap_message_t *request,
+                              coap_message_t *response, uint8_t *buffer,
+                              coap_blockwise_service_t service)
+{
+  uint32_t block_num = 0;
+  uint16_t block_size = COAP_MAX_BLOCK_SIZE;
+  uint32_t block_offset = 0;
+  int32_t new_offset = 0;
+  uint8_t block2;
+  uint8_t q;
+  coap_handler_status_t status;
+#if COAP_BLOCKWISE_BUFFER_SIZE > 0
+  representation_t *r;
+
+  burst.count = 0;
+#endif /* COAP_BLOCKWISE_BUFFER_SIZE > 0 */
+
+  q = coap_is_option(request, COAP_OPTION_Q_BLOCK2);
+  block2 = coap_get_header_block2(request, &block_num, NULL, &block_size,
+                                  &block_offset);
+  if(block2) {
+    LOG_DBG("Blockwise: block request %"PRIu32" (%u/%u) @ %"PRIu32" bytes\n",
+            block_num, block_size, COAP_MAX_BLOCK_SIZE, block_offset);
+    if(block_size > COAP_MAX_BLOCK_SIZE) {
+      /* Continue at the same offset with smaller blocks */
+      block_size = COAP_MAX_BLOCK_SIZE;
+      block_num = block_offset / block_size;
+    }
+    new_offset = block_offset;
+  }
+
+  if(new_offset < 0) {
+    LOG_DBG("Blockwise: block request offset overflow\n");
+    coap_status_code = BAD_OPTION_4_02;
+    coap_error_message = "BlockOutOfScope";
+    return COAP_HANDLER_STATUS_CONTINUE;
+  }
+
+#if COAP_BLOCKWISE_BUFFER_SIZE > 0
+  if(request->code == COAP_GET && block_num > 0) {
+    r = find_representation(request);
+    if(r != NULL) {
+      LOG_DBG("Blockwise: block %"PRIu32" from buffer\n", block_num);
+      serve_representation(r, request, response, block_num, block_size);
+      return COAP_HANDLER_STATUS_PROCESSED;
+    }
+  }
+#endif /* COAP_BLOCKWISE_BUFFER_SIZE > 0 */
+
+  /* call CoAP framework and check if found and allowed */
+  status = service(request, response, buffer, block_size, &new_offset);
+  if(status == COAP_HANDLER_STATUS_CONTINUE || coap_status_code != NO_ERROR) {
+    return status;
+  }
+
+  /* resource is unaware of Block1 */
+  if(coap_get_header_block1(request, NULL, NULL, NULL, NULL)
+     && response->code < BAD_REQUEST_4_00
+     && !coap_get_header_block1(response, NULL, NULL, NULL, NULL)) {
+    LOG_DBG("Block1 NOT IMPLEMENTED\n");
+
+    coap_status_code = NOT_IMPLEMENTED_5_01;
+    coap_error_message = "NoBlock1Support";
+    return status;
+  }
+
+#if COAP_BLOCKWISE_BUFFER_SIZE > 0
+  if(request->code == COAP_GET && response->code == CONTENT_2_05
+     && block_offset == 0
+     && !coap_is_option(request, COAP_OPTION_OBSERVE)
+     && ((block2 && new_offset == 0 && response->payload_len > block_size)
+         || new_offset > 0)) {
+    r = store_representation(request, response, buffer, block_size,
+                             new_offset, service);
+    if(r != NULL) {
+      serve_representation(r, request, response, block_num, block_size);
+      return status;
+    }
+  }
+#endif /* COAP_BLOCKWISE_BUFFER_SIZE > 0 */
+
+  if(block2) {
+    /* client requested Block2 transfer */
+
+    /* unchanged new_offset indicates that resource is unaware of blockwise transfer */
+    if(new_offset == block_offset) {
+      LOG_DBG("Blockwise: unaware resource with payload length %u/%u\n",
+              response->payload_len, block_size);
+      if(block_offset >= response->payload_len) {
+        LOG_DBG("handle_incoming_data(): block_offset >= response->payload_len\n");
+
+        response->code = BAD_OPTION_4_02;
+        coap_set_payload(response, "BlockOutOfScope", 15); /* a const char str[] and sizeof(str) produces larger code size */
+      } else {
+        set_block2(response, q, block_num,
+                   response->payload_len - block_offset > block_size,
+                   block_size);
+        coap_set_payload(response,
+                         response->payload + block_offset,
+                         MIN(response->payload_len - block_offset,
+                             block_size));
+      } /* if(valid offset) */
+
+      /* resource provides chunk-wise data */
+    } else {
+      LOG_DBG("Blockwise: blockwise resource, new offset %"PRId32"\n",
+              new_offset);
+      set_block2(response, q, block_num,
+                 new_offset != -1 || response->payload_len > block_size,
+                 block_size);
+
+      if(response->payload_len > block_size) {
+        coap_set_payload(response, response->payload, block_size);
+      }
+    } /* if(resource aware of blockwise) */
+
+    /* Resource requested Block2 transfer */
+  } else if(new_offset != 0) {
+    LOG_DBG("Blockwise: no block option for blockwise resource, using block size %u\n",
+            COAP_MAX_BLOCK_SIZE);
+
+    coap_set_header_block2(response, 0, new_offset != -1,
+                           COAP_MAX_BLOCK_SIZE);
+    coap_set_payload(response, response->payload,
+                     MIN(response->payload_len, COAP_MAX_BLOCK_SIZE));
+  } /* blockwise transfer handling */
+
+  return status;
+}
+/*---------------------------------------------------------------------------*/
+void
+coap_blockwise_send_burst(void)
+{
+#if COAP_BLOCKWISE_BUFFER_SIZE > 0
+  static coap_message_t message[1];
+  static uint8_t packet[COAP_MAX_PACKET_SIZE];
+  representation_t *r = burst.representation;
+  uint32_t offset;
+  size_t len;
+
+  for(; burst.count > 0; burst.count--, burst.num++) {
+    offset = burst.num * burst.size;
+    if(offset >= r->len) {
+      break;
+    }
+    LOG_DBG("Blockwise: sending Q-Block2 %"PRIu32"\n", burst.num);
+    coap_init_message(message, COAP_TYPE_NON, CONTENT_2_05, coap_get_mid());
+    coap_set_token(message, burst.token, burst.token_len);
+    if(r->has_content_format) {
+      coap_set_header_content_format(message, r->content_format);
+    }
+    coap_set_header_etag(message, r->etag, r->etag_len);
+    coap_set_header_q_block2(message, burst.num,
+                             r->len - offset > burst.size, burst.size);
+    coap_set_payload(message, &r->data[offset],
+                     MIN(r->len - offset, burst.size));
+    len = coap_serialize_message(message, packet);
+    if(len > 0) {
+      coap_sendto(&r->endpoint, packet, len);
+    }
+  }
+  burst.count = 0;
+#endif /* COAP_BLOCKWISE_BUFFER_SIZE > 0 */
+}
+/*---------------------------------------------------------------------------*/
+/** @} */
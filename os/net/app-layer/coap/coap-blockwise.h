@@ -0,0 +1,82 @@
+/*
+ * Copyright (c) 2026, agent <agent@local>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+ * OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * \file
+ *      CoAP block-wise transfers (RFC 7959) and Q-Block2 bursts (RFC 9177)
+ */
+
+/**
+ * \addtogroup coap
+ * @{
+ */
+
+#ifndef COAP_BLOCKWISE_H_
+#define COAP_BLOCKWISE_H_
+
+#include "coap-engine.h"
+
+/* Calls the handlers and resources for a request */
+typedef coap_handler_status_t
+(* coap_blockwise_service_t)(coap_message_t *request,
+                             coap_message_t *response,
+                             uint8_t *buffer, uint16_t buffer_size,
+                             int32_t *offset);
+
+/**
+ * \brief Serve a request, handling the Block options
+ * \param request  The request
+ * \param response The response
+ * \param buffer   The buffer for the response payload
+ * \param service  The function that calls the resources
+ * \return The status of the service
+ *
+ *         The Block2 or Q-Block2 option of the request selects the
+ *         part of the representation that is returned. Representations
+ *         of GET requests that span several blocks are buffered, if
+ *         enabled by COAP_CONF_BLOCKWISE_BUFFER_SIZE, so that the
+ *         following blocks are served without calling the resource
+ *         again.
+ */
+coap_handler_status_t
+coap_blockwise_handle_request(coap_message_t *request,
+                              coap_message_t *response, uint8_t *buffer,
+                              coap_blockwise_service_t service);
+
+/**
+ * \brief Send the blocks that follow the response to a Q-Block2 request
+ *
+ *        Must be called after the response to the last request passed
+ *        to coap_blockwise_handle_request() has been sent.
+ */
+void coap_blockwise_send_burst(void);
+
+#endif /* COAP_BLOCKWISE_H_ */
+/** @} */
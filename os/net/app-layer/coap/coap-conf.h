@@ -112,5 +112,48 @@
 #define COAP_OBSERVER_URL_LEN 20
 #endif
 
+/* Number of hash buckets used to dispatch requests to resources */
+#ifdef COAP_CONF_RESOURCE_HASH_SIZE
+#define COAP_RESOURCE_HASH_SIZE COAP_CONF_RESOURCE_HASH_SIZE
+#else
+#define COAP_RESOURCE_HASH_SIZE 16
+#endif
+
+/*
+ * Number of blocks sent in response to one Q-Block2 request
+ * (MAX_PAYLOADS in RFC 9177). Bursts are sent from buffered
+ * representations only.
+ */
+#ifdef COAP_CONF_QBLOCK_MAX_PAYLOADS
+#define COAP_QBLOCK_MAX_PAYLOADS COAP_CONF_QBLOCK_MAX_PAYLOADS
+#else
+#define COAP_QBLOCK_MAX_PAYLOADS 4
+#endif
+
+/*
+ * Size of the buffers that keep representations generated for GET
+ * requests, so that the following blocks of a block-wise transfer are
+ * served without calling the resource again. 0 disables buffering.
+ */
+#ifdef COAP_CONF_BLOCKWISE_BUFFER_SIZE
+#define COAP_BLOCKWISE_BUFFER_SIZE COAP_CONF_BLOCKWISE_BUFFER_SIZE
+#else
+#define COAP_BLOCKWISE_BUFFER_SIZE 0
+#endif
+
+/* Number of buffered representations */
+#ifdef COAP_CONF_BLOCKWISE_BUFFERS
+#define COAP_BLOCKWISE_BUFFERS COAP_CONF_BLOCKWISE_BUFFERS
+#else
+#define COAP_BLOCKWISE_BUFFERS 1
+#endif
+
+/* Lifetime of a buffered representation in seconds */
+#ifdef COAP_CONF_BLOCKWISE_LIFETIME
+#define COAP_BLOCKWISE_LIFETIME COAP_CONF_BLOCKWISE_LIFETIME
+#else
+#define COAP_BLOCKWISE_LIFETIME 60
+#endif
+
 #endif /* COAP_CONF_H_ */
 /** @} */
@@ -134,10 +134,12 @@ typedef enum {
   COAP_OPTION_MAX_AGE = 14,     /* 0-4 B */
   COAP_OPTION_URI_QUERY = 15,   /* 0-255 B */
   COAP_OPTION_ACCEPT = 17,      /* 0-2 B */
+  COAP_OPTION_Q_BLOCK1 = 19,    /* 0-3 B */
   COAP_OPTION_LOCATION_QUERY = 20,      /* 0-255 B */
   COAP_OPTION_BLOCK2 = 23,      /* 1-3 B */
   COAP_OPTION_BLOCK1 = 27,      /* 1-3 B */
   COAP_OPTION_SIZE2 = 28,       /* 0-4 B */
+  COAP_OPTION_Q_BLOCK2 = 31,    /* 0-3 B */
   COAP_OPTION_PROXY_URI = 35,   /* 1-1034 B */
   COAP_OPTION_PROXY_SCHEME = 39,        /* 1-255 B */
   COAP_OPTION_SIZE1 = 60,       /* 0-4 B */
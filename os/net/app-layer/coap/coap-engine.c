@@ -42,6 +42,7 @@
  */
 
 #include "coap-engine.h"
+#include "coap-blockwise.h"
 #include "sys/cc.h"
 #include "lib/list.h"
 #include <stdio.h>
@@ -72,6 +73,10 @@ LIST(coap_handlers);
 LIST(coap_resource_services);
 static uint8_t is_initialized = 0;
 
+/* Resources by hash of their URL */
+static coap_resource_t *resource_hash[COAP_RESOURCE_HASH_SIZE];
+static uint16_t resource_order;
+
 /*---------------------------------------------------------------------------*/
 /*- CoAP service handlers---------------------------------------------------*/
 /*---------------------------------------------------------------------------*/
@@ -148,7 +153,6 @@ coap_receive(const coap_endpoint_t *src,
   static coap_message_t message[1]; /* this way the message can be treated as pointer as usual */
   static coap_message_t response[1];
   coap_transaction_t *transaction = NULL;
-  coap_handler_status_t status;
 
   coap_status_code = coap_parse_message(message, payload, payload_length);
   coap_set_src_endpoint(message, src);
@@ -171,10 +175,6 @@ coap_receive(const coap_endpoint_t *src,
 
       /* use transaction buffer for response to confirmable request */
       if((transaction = coap_new_transaction(message->mid, src))) {
-        uint32_t block_num = 0;
-        uint16_t block_size = COAP_MAX_BLOCK_SIZE;
-        uint32_t block_offset = 0;
-        int32_t new_offset = 0;
 
         /* prepare response */
         if(message->type == COAP_TYPE_CON) {
@@ -189,96 +189,14 @@ coap_receive(const coap_endpoint_t *src,
         }
         if(message->token_len) {
           coap_set_token(response, message->token, message->token_len);
-          /* get offset for blockwise transfers */
-        }
-        if(coap_get_header_block2
-           (message, &block_num, NULL, &block_size, &block_offset)) {
-          LOG_DBG("Blockwise: block request %"PRIu32" (%u/%u) @ %"PRIu32" bytes\n",
-                  block_num, block_size, COAP_MAX_BLOCK_SIZE, block_offset);
-          block_size = MIN(block_size, COAP_MAX_BLOCK_SIZE);
-          new_offset = block_offset;
         }
 
-        if(new_offset < 0) {
-          LOG_DBG("Blockwise: block request offset overflow\n");
-          coap_status_code = BAD_OPTION_4_02;
-          coap_error_message = "BlockOutOfScope";
-          status = COAP_HANDLER_STATUS_CONTINUE;
-        } else {
-          /* call CoAP framework and check if found and allowed */
-          status = call_service(message, response,
-                                transaction->message + COAP_MAX_HEADER_SIZE,
-                                block_size, &new_offset);
-        }
+        /* call CoAP framework and handle blockwise transfers */
+        coap_blockwise_handle_request(message, response,
+                                      transaction->message +
+                                      COAP_MAX_HEADER_SIZE,
+                                      call_service);
 
-        if(status != COAP_HANDLER_STATUS_CONTINUE) {
-
-            if(coap_status_code == NO_ERROR) {
-
-              /* TODO coap_handle_blockwise(request, response, start_offset, end_offset); */
-
-              /* resource is unaware of Block1 */
-              if(coap_is_option(message, COAP_OPTION_BLOCK1)
-                 && response->code < BAD_REQUEST_4_00
-                 && !coap_is_option(response, COAP_OPTION_BLOCK1)) {
-                LOG_DBG("Block1 NOT IMPLEMENTED\n");
-
-                coap_status_code = NOT_IMPLEMENTED_5_01;
-                coap_error_message = "NoBlock1Support";
-
-                /* client requested Block2 transfer */
-              } else if(coap_is_option(message, COAP_OPTION_BLOCK2)) {
-
-                /* unchanged new_offset indicates that resource is unaware of blockwise transfer */
-                if(new_offset == block_offset) {
-                  LOG_DBG("Blockwise: unaware resource with payload length %u/%u\n",
-                          response->payload_len, block_size);
-                  if(block_offset >= response->payload_len) {
-                    LOG_DBG("handle_incoming_data(): block_offset >= response->payload_len\n");
-
-                    response->code = BAD_OPTION_4_02;
-                    coap_set_payload(response, "BlockOutOfScope", 15); /* a const char str[] and sizeof(str) produces larger code size */
-                  } else {
-                    coap_set_header_block2(response, block_num,
-                                           response->payload_len -
-                                           block_offset > block_size,
-                                           block_size);
-                    coap_set_payload(response,
-                                     response->payload + block_offset,
-                                     MIN(response->payload_len -
-                                         block_offset, block_size));
-                  } /* if(valid offset) */
-
-                  /* resource provides chunk-wise data */
-                } else {
-                  LOG_DBG("Blockwise: blockwise resource, new offset %"PRId32"\n",
-                          new_offset);
-                  coap_set_header_block2(response, block_num,
-                                         new_offset != -1
-                                         || response->payload_len >
-                                         block_size, block_size);
-
-                  if(response->payload_len > block_size) {
-                    coap_set_payload(response, response->payload,
-                                     block_size);
-                  }
-                } /* if(resource aware of blockwise) */
-
-                /* Resource requested Block2 transfer */
-              } else if(new_offset != 0) {
-                LOG_DBG("Blockwise: no block option for blockwise resource, using block size %u\n",
-                        COAP_MAX_BLOCK_SIZE);
-
-                coap_set_header_block2(response, 0, new_offset != -1,
-                                       COAP_MAX_BLOCK_SIZE);
-                coap_set_payload(response, response->payload,
-                                 MIN(response->payload_len,
-                                     COAP_MAX_BLOCK_SIZE));
-              } /* blockwise transfer handling */
-            } /* no errors/hooks */
-            /* successful service callback */
-            /* serialize response */
-        }
           if(coap_status_code == NO_ERROR) {
             if((transaction->message_len = coap_serialize_message(response,
                                                                  transaction->
@@ -337,6 +255,8 @@ coap_receive(const coap_endpoint_t *src,
   if(coap_status_code == NO_ERROR) {
     if(transaction) {
       coap_send_transaction(transaction);
+      /* further blocks requested with Q-Block2 */
+      coap_blockwise_send_burst();
     }
   } else if(coap_status_code == MANUAL_RESPONSE) {
     LOG_DBG("Clearing transaction for manual response");
@@ -379,6 +299,8 @@ coap_engine_init(void)
 
   list_init(coap_handlers);
   list_init(coap_resource_services);
+  memset(resource_hash, 0, sizeof(resource_hash));
+  resource_order = 0;
 
   coap_activate_resource(&res_well_known_core, ".well-known/core");
 
@@ -386,6 +308,49 @@ coap_engine_init(void)
   coap_init_connection();
 }
 /*---------------------------------------------------------------------------*/
+/* FNV-1a, computed incrementally over the URI path */
+#define URL_HASH_INIT 2166136261UL
+
+static inline uint32_t
+url_hash_update(uint32_t hash, char c)
+{
+  return (hash ^ (uint8_t)c) * 16777619UL;
+}
+/*---------------------------------------------------------------------------*/
+static void
+resource_hash_remove(coap_resource_t *resource)
+{
+  coap_resource_t **r;
+
+  for(r = &resource_hash[resource->url_hash % COAP_RESOURCE_HASH_SIZE];
+      *r != NULL; r = &(*r)->hash_next) {
+    if(*r == resource) {
+      *r = resource->hash_next;
+      return;
+    }
+  }
+}
+/*---------------------------------------------------------------------------*/
+/* Find the earliest activated resource with the given URL. If sub is
+   set, only resources with sub-resources are considered. */
+static coap_resource_t *
+resource_hash_lookup(const char *url, int url_len, uint32_t hash,
+                     uint8_t sub, coap_resource_t *best)
+{
+  coap_resource_t *r;
+
+  for(r = resource_hash[hash % COAP_RESOURCE_HASH_SIZE]; r != NULL;
+      r = r->hash_next) {
+    if(r->url_hash == hash && r->url_len == url_len
+       && (!sub || (r->flags & HAS_SUB_RESOURCES))
+       && (best == NULL || r->order < best->order)
+       && memcmp(r->url, url, url_len) == 0) {
+      best = r;
+    }
+  }
+  return best;
+}
+/*---------------------------------------------------------------------------*/
 /**
  * \brief Makes a resource available under the given URI path
  *
@@ -397,9 +362,23 @@ void
 coap_activate_resource(coap_resource_t *resource, const char *path)
 {
   coap_periodic_resource_t *periodic;
+  const char *c;
+
+  /* The resource may be activated again, under another path */
+  resource_hash_remove(resource);
+
   resource->url = path;
   list_add(coap_resource_services, resource);
 
+  resource->url_hash = URL_HASH_INIT;
+  for(c = path; *c != '\0'; c++) {
+    resource->url_hash = url_hash_update(resource->url_hash, *c);
+  }
+  resource->url_len = c - path;
+  resource->order = resource_order++;
+  resource->hash_next = resource_hash[resource->url_hash % COAP_RESOURCE_HASH_SIZE];
+  resource_hash[resource->url_hash % COAP_RESOURCE_HASH_SIZE] = resource;
+
   LOG_INFO("Activating: %s\n", resource->url);
 
   /* Only add periodic resources with a periodic_handler and a period > 0. */
@@ -440,44 +419,46 @@ invoke_coap_resource_service(coap_message_t *request, coap_message_t *response,
 
   coap_resource_t *resource = NULL;
   const char *url = NULL;
-  int url_len, res_url_len;
+  int url_len, i;
+  uint32_t hash = URL_HASH_INIT;
 
   url_len = coap_get_header_uri_path(request, &url);
-  for(resource = list_head(coap_resource_services);
-      resource; resource = resource->next) {
-
-    /* if the web service handles that kind of requests and urls matches */
-    res_url_len = strlen(resource->url);
-    if((url_len == res_url_len
-        || (url_len > res_url_len
-            && (resource->flags & HAS_SUB_RESOURCES)
-            && url[res_url_len] == '/'))
-       && strncmp(resource->url, url, res_url_len) == 0) {
-      coap_resource_flags_t method = coap_get_method_type(request);
-      found = 1;
-
-      LOG_INFO("/%s, method %u, resource->flags %u\n", resource->url,
-               (uint16_t)method, resource->flags);
-
-      if((method & METHOD_GET) && resource->get_handler != NULL) {
-        /* call handler function */
-        resource->get_handler(request, response, buffer, buffer_size, offset);
-      } else if((method & METHOD_POST) && resource->post_handler != NULL) {
-        /* call handler function */
-        resource->post_handler(request, response, buffer, buffer_size,
+
+  /* A resource matches if its URL is the request path, or a parent of
+     it for resources with sub-resources. Every candidate is looked up
+     in a single pass over the path. */
+  for(i = 0; i < url_len; i++) {
+    if(url[i] == '/') {
+      resource = resource_hash_lookup(url, i, hash, 1, resource);
+    }
+    hash = url_hash_update(hash, url[i]);
+  }
+  resource = resource_hash_lookup(url, url_len, hash, 0, resource);
+
+  if(resource != NULL) {
+    coap_resource_flags_t method = coap_get_method_type(request);
+    found = 1;
+
+    LOG_INFO("/%s, method %u, resource->flags %u\n", resource->url,
+             (uint16_t)method, resource->flags);
+
+    if((method & METHOD_GET) && resource->get_handler != NULL) {
+      /* call handler function */
+      resource->get_handler(request, response, buffer, buffer_size, offset);
+    } else if((method & METHOD_POST) && resource->post_handler != NULL) {
+      /* call handler function */
+      resource->post_handler(request, response, buffer, buffer_size,
+                             offset);
+    } else if((method & METHOD_PUT) && resource->put_handler != NULL) {
+      /* call handler function */
+      resource->put_handler(request, response, buffer, buffer_size, offset);
+    } else if((method & METHOD_DELETE) && resource->delete_handler != NULL) {
+      /* call handler function */
+      resource->delete_handler(request, response, buffer, buffer_size,
                                offset);
-      } else if((method & METHOD_PUT) && resource->put_handler != NULL) {
-        /* call handler function */
-        resource->put_handler(request, response, buffer, buffer_size, offset);
-      } else if((method & METHOD_DELETE) && resource->delete_handler != NULL) {
-        /* call handler function */
-        resource->delete_handler(request, response, buffer, buffer_size,
-                                 offset);
-      } else {
-        allowed = 0;
-        coap_set_status_code(response, METHOD_NOT_ALLOWED_4_05);
-      }
-      break;
+    } else {
+      allowed = 0;
+      coap_set_status_code(response, METHOD_NOT_ALLOWED_4_05);
     }
   }
   if(!found) {
@@ -111,6 +111,10 @@ struct coap_resource_s {
     coap_resource_trigger_handler_t trigger;
     coap_resource_trigger_handler_t resume;
   };
+  coap_resource_t *hash_next;       /* next resource in the same hash bucket */
+  uint32_t url_hash;                /* hash of the URL, for dispatching */
+  uint16_t url_len;
+  uint16_t order;                   /* activation order, earlier resources take precedence */
 };
 
 struct coap_periodic_resource_s {
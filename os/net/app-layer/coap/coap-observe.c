@@ -60,7 +60,8 @@ LIST(observers_list);
 /*- Internal API ------------------------------------------------------------*/
 /*---------------------------------------------------------------------------*/
 static coap_observer_t *
-add_observer(const coap_endpoint_t *endpoint, const uint8_t *token,
+add_observer(const coap_resource_t *resource,
+             const coap_endpoint_t *endpoint, const uint8_t *token,
              size_t token_len, const char *uri, int uri_len)
 {
   /* Remove existing observe relationship, if any. */
@@ -75,6 +76,8 @@ add_observer(const coap_endpoint_t *endpoint, const uint8_t *token,
     }
     memcpy(o->url, uri, max);
     o->url[max] = 0;
+    o->url_len = max;
+    o->resource = resource;
     coap_endpoint_copy(&o->endpoint, endpoint);
     o->token_len = token_len;
     memcpy(o->token, token, token_len);
@@ -152,7 +155,7 @@ coap_remove_observer_by_uri(const coap_endpoint_t *endpoint,
     LOG_DBG("Remove check URL %p\n", uri);
     if((endpoint == NULL
         || (coap_endpoint_cmp(&obs->endpoint, endpoint)))
-       && (obs->url == uri || memcmp(obs->url, uri, strlen(obs->url)) == 0)) {
+       && (obs->url == uri || memcmp(obs->url, uri, obs->url_len) == 0)) {
       coap_remove_observer(obs);
       removed++;
     }
@@ -185,6 +188,40 @@ coap_notify_observers(coap_resource_t *resource)
 {
   coap_notify_observers_sub(resource, NULL);
 }
+/* Render the representation of the observed resource into the shared
+   notification */
+static void
+render_notification(coap_resource_t *resource, coap_message_t *request,
+                    coap_message_t *notification, uint8_t *buffer)
+{
+  int32_t new_offset = 0;
+
+  /* Either old style get_handler or the full handler */
+  if(coap_call_handlers(request, notification, buffer, COAP_MAX_CHUNK_SIZE,
+                        &new_offset) > 0) {
+    LOG_DBG("Notification on new handlers\n");
+  } else {
+    if(resource != NULL) {
+      resource->get_handler(request, notification, buffer,
+                            COAP_MAX_CHUNK_SIZE, &new_offset);
+    } else {
+      /* What to do here? */
+      notification->code = BAD_REQUEST_4_00;
+    }
+  }
+
+  if(new_offset != 0) {
+    coap_set_header_block2(notification,
+                           0,
+                           new_offset != -1,
+                           COAP_MAX_BLOCK_SIZE);
+    coap_set_payload(notification,
+                     notification->payload,
+                     MIN(notification->payload_len,
+                         COAP_MAX_BLOCK_SIZE));
+  }
+}
+/*---------------------------------------------------------------------------*/
 /* Can be used either for sub - or when there is not resource - just
    a handler */
 void
@@ -193,8 +230,12 @@ coap_notify_observers_sub(coap_resource_t *resource, const char *subpath)
   /* build notification */
   coap_message_t notification[1]; /* this way the message can be treated as pointer as usual */
   coap_message_t request[1]; /* this way the message can be treated as pointer as usual */
+  coap_message_t message[1];
+  /* The transaction of the first observer, which holds the rendered
+     representation until the other observers have copied it */
+  coap_transaction_t *first = NULL;
   coap_observer_t *obs = NULL;
-  int url_len, obs_url_len;
+  int url_len;
   char url[COAP_OBSERVER_URL_LEN];
   uint8_t sub_ok = 0;
 
@@ -227,28 +268,44 @@ coap_notify_observers_sub(coap_resource_t *resource, const char *subpath)
   sub_ok = (resource == NULL) || (resource->flags & HAS_SUB_RESOURCES);
   for(obs = (coap_observer_t *)list_head(observers_list); obs;
       obs = obs->next) {
-    obs_url_len = strlen(obs->url);
+    /* Observers of other resources are skipped without looking at
+       their URL */
+    if(resource != NULL && obs->resource != NULL && obs->resource != resource) {
+      continue;
+    }
 
     /* Do a match based on the parent/sub-resource match so that it is
        possible to do parent-node observe */
-
-    /***** TODO fix here so that we handle the notofication correctly ******/
-    /* All the new-style ... is assuming that the URL might be within */
-    if((obs_url_len == url_len
-        || (obs_url_len > url_len
+    if((obs->url_len == url_len
+        || (obs->url_len > url_len
             && sub_ok
             && obs->url[url_len] == '/'))
-       && strncmp(url, obs->url, url_len) == 0) {
+       && memcmp(url, obs->url, url_len) == 0) {
       coap_transaction_t *transaction = NULL;
 
       /*TODO implement special transaction for CON, sharing the same buffer to allow for more observers */
 
       if((transaction = coap_new_transaction(coap_get_mid(), &obs->endpoint))) {
+        /* The handlers are called for the first observer only */
+        if(first == NULL) {
+          notification->mid = transaction->mid;
+          render_notification(resource, request, notification,
+                              transaction->message + COAP_MAX_HEADER_SIZE);
+        }
+
+        /* Only the type, MID, token and observe option differ */
+        memcpy(message, notification, sizeof(message));
+        if(first != NULL) {
+          memcpy(transaction->message + COAP_MAX_HEADER_SIZE,
+                 notification->payload, notification->payload_len);
+          message->payload = transaction->message + COAP_MAX_HEADER_SIZE;
+        }
+
         /* if COAP_OBSERVE_REFRESH_INTERVAL is zero, never send observations as confirmable messages */
         if(COAP_OBSERVE_REFRESH_INTERVAL != 0
             && (obs->obs_counter % COAP_OBSERVE_REFRESH_INTERVAL == 0)) {
           LOG_DBG("           Force Confirmable for\n");
-          notification->type = COAP_TYPE_CON;
+          message->type = COAP_TYPE_CON;
         }
 
         LOG_DBG("           Observer ");
@@ -259,51 +316,36 @@ coap_notify_observers_sub(coap_resource_t *resource, const char *subpath)
         obs->last_mid = transaction->mid;
 
         /* prepare response */
-        notification->mid = transaction->mid;
-
-	int32_t new_offset = 0;
-
-        /* Either old style get_handler or the full handler */
-        if(coap_call_handlers(request, notification, transaction->message +
-                              COAP_MAX_HEADER_SIZE, COAP_MAX_CHUNK_SIZE,
-                              &new_offset) > 0) {
-          LOG_DBG("Notification on new handlers\n");
-        } else {
-          if(resource != NULL) {
-            resource->get_handler(request, notification,
-                                  transaction->message + COAP_MAX_HEADER_SIZE,
-                                  COAP_MAX_CHUNK_SIZE, &new_offset);
-          } else {
-            /* What to do here? */
-            notification->code = BAD_REQUEST_4_00;
-          }
-        }
+        message->mid = transaction->mid;
 
-        if(notification->code < BAD_REQUEST_4_00) {
-          coap_set_header_observe(notification, (obs->obs_counter)++);
+        if(message->code < BAD_REQUEST_4_00) {
+          coap_set_header_observe(message, (obs->obs_counter)++);
           /* mask out to keep the CoAP observe option length <= 3 bytes */
           obs->obs_counter &= 0xffffff;
         }
-        coap_set_token(notification, obs->token, obs->token_len);
-
-	if(new_offset != 0) {
-	  coap_set_header_block2(notification,
-				 0,
-				 new_offset != -1,
-				 COAP_MAX_BLOCK_SIZE);
-	  coap_set_payload(notification,
-			   notification->payload,
-			   MIN(notification->payload_len,
-			       COAP_MAX_BLOCK_SIZE));
-	}
+        coap_set_token(message, obs->token, obs->token_len);
 
         transaction->message_len =
-          coap_serialize_message(notification, transaction->message);
+          coap_serialize_message(message, transaction->message);
 
-        coap_send_transaction(transaction);
+        if(first == NULL) {
+          /* The payload now follows the header of the first message */
+          first = transaction;
+          if(transaction->message_len < notification->payload_len) {
+            notification->payload_len = 0;
+          }
+          notification->payload = transaction->message +
+            transaction->message_len - notification->payload_len;
+        } else {
+          coap_send_transaction(transaction);
+        }
       }
     }
   }
+
+  if(first != NULL) {
+    coap_send_transaction(first);
+  }
 }
 /*---------------------------------------------------------------------------*/
 void
@@ -321,7 +363,7 @@ coap_observe_handler(const coap_resource_t *resource, coap_message_t *coap_req,
       if(src_ep == NULL) {
         /* No source endpoint, can not add */
       } else if(coap_req->observe == 0) {
-        obs = add_observer(src_ep,
+        obs = add_observer(resource, src_ep,
                            coap_req->token, coap_req->token_len,
                            coap_req->uri_path, coap_req->uri_path_len);
         if(obs) {
@@ -52,6 +52,8 @@ typedef struct coap_observer {
   struct coap_observer *next;   /* for LIST */
 
   char url[COAP_OBSERVER_URL_LEN];
+  uint8_t url_len;
+  const coap_resource_t *resource; /* observed resource, NULL if none */
   coap_endpoint_t endpoint;
   uint8_t token_len;
   uint8_t token[COAP_TOKEN_LEN];
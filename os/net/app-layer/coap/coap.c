@@ -372,11 +372,13 @@ coap_serialize_message(coap_message_t *coap_pkt, uint8_t *buffer)
   COAP_SERIALIZE_STRING_OPTION(COAP_OPTION_URI_QUERY, uri_query, '&',
                                "Uri-Query");
   COAP_SERIALIZE_INT_OPTION(COAP_OPTION_ACCEPT, accept, "Accept");
+  COAP_SERIALIZE_BLOCK_OPTION(COAP_OPTION_Q_BLOCK1, block1, "Q-Block1");
   COAP_SERIALIZE_STRING_OPTION(COAP_OPTION_LOCATION_QUERY, location_query,
                                '&', "Location-Query");
   COAP_SERIALIZE_BLOCK_OPTION(COAP_OPTION_BLOCK2, block2, "Block2");
   COAP_SERIALIZE_BLOCK_OPTION(COAP_OPTION_BLOCK1, block1, "Block1");
   COAP_SERIALIZE_INT_OPTION(COAP_OPTION_SIZE2, size2, "Size2");
+  COAP_SERIALIZE_BLOCK_OPTION(COAP_OPTION_Q_BLOCK2, block2, "Q-Block2");
   COAP_SERIALIZE_STRING_OPTION(COAP_OPTION_PROXY_URI, proxy_uri, '\0',
                                "Proxy-Uri");
   COAP_SERIALIZE_STRING_OPTION(COAP_OPTION_PROXY_SCHEME, proxy_scheme, '\0',
@@ -489,7 +491,9 @@ coap_parse_message(coap_message_t *coap_pkt, uint8_t *data, uint16_t data_len)
     option_delta = current_option[0] >> 4;
     option_length = current_option[0] & 0x0F;
     ++current_option;
-    if(current_option >= data + data_len) {
+    /* a zero-length option may end the message */
+    if((option_delta >= 13 || option_length >= 13)
+       && current_option >= data + data_len) {
       /* Malformed CoAP - out of bounds */
       LOG_WARN("BAD REQUEST: option delta outside message buffer\n");
       return BAD_REQUEST_4_00;
@@ -511,7 +515,7 @@ coap_parse_message(coap_message_t *coap_pkt, uint8_t *data, uint16_t data_len)
       ++current_option;
     }
 
-    if(current_option >= data + data_len) {
+    if(option_length >= 13 && current_option >= data + data_len) {
       /* Malformed CoAP - out of bounds */
       LOG_WARN("BAD REQUEST: option delta outside message buffer\n");
       return BAD_REQUEST_4_00;
@@ -674,7 +678,14 @@ coap_parse_message(coap_message_t *coap_pkt, uint8_t *data, uint16_t data_len)
                                                 option_length);
       LOG_DBG_("Observe [%"PRId32"]\n", coap_pkt->observe);
       break;
+    case COAP_OPTION_Q_BLOCK2:
     case COAP_OPTION_BLOCK2:
+      /* Block2 and Q-Block2 share the fields and must not be mixed */
+      if(coap_is_option(coap_pkt, COAP_OPTION_BLOCK2)
+         && coap_is_option(coap_pkt, COAP_OPTION_Q_BLOCK2)) {
+        coap_error_message = "Block2 and Q-Block2";
+        return BAD_OPTION_4_02;
+      }
       coap_pkt->block2_num = coap_parse_int_option(current_option,
                                                    option_length);
       coap_pkt->block2_more = (coap_pkt->block2_num & 0x08) >> 3;
@@ -682,11 +693,18 @@ coap_parse_message(coap_message_t *coap_pkt, uint8_t *data, uint16_t data_len)
       coap_pkt->block2_offset = (coap_pkt->block2_num & ~0x0000000F)
         << (coap_pkt->block2_num & 0x07);
       coap_pkt->block2_num >>= 4;
-      LOG_DBG_("Block2 [%lu%s (%u B/blk)]\n",
+      LOG_DBG_("%s [%lu%s (%u B/blk)]\n",
+               option_number == COAP_OPTION_BLOCK2 ? "Block2" : "Q-Block2",
                (unsigned long)coap_pkt->block2_num,
                coap_pkt->block2_more ? "+" : "", coap_pkt->block2_size);
       break;
+    case COAP_OPTION_Q_BLOCK1:
     case COAP_OPTION_BLOCK1:
+      if(coap_is_option(coap_pkt, COAP_OPTION_BLOCK1)
+         && coap_is_option(coap_pkt, COAP_OPTION_Q_BLOCK1)) {
+        coap_error_message = "Block1 and Q-Block1";
+        return BAD_OPTION_4_02;
+      }
       coap_pkt->block1_num = coap_parse_int_option(current_option,
                                                    option_length);
       coap_pkt->block1_more = (coap_pkt->block1_num & 0x08) >> 3;
@@ -694,7 +712,8 @@ coap_parse_message(coap_message_t *coap_pkt, uint8_t *data, uint16_t data_len)
       coap_pkt->block1_offset = (coap_pkt->block1_num & ~0x0000000F)
         << (coap_pkt->block1_num & 0x07);
       coap_pkt->block1_num >>= 4;
-      LOG_DBG_("Block1 [%lu%s (%u B/blk)]\n",
+      LOG_DBG_("%s [%lu%s (%u B/blk)]\n",
+               option_number == COAP_OPTION_BLOCK1 ? "Block1" : "Q-Block1",
                (unsigned long)coap_pkt->block1_num,
                coap_pkt->block1_more ? "+" : "", coap_pkt->block1_size);
       break;
@@ -1030,7 +1049,8 @@ int
 coap_get_header_block2(coap_message_t *coap_pkt, uint32_t *num, uint8_t *more,
                        uint16_t *size, uint32_t *offset)
 {
-  if(!coap_is_option(coap_pkt, COAP_OPTION_BLOCK2)) {
+  if(!coap_is_option(coap_pkt, COAP_OPTION_BLOCK2)
+     && !coap_is_option(coap_pkt, COAP_OPTION_Q_BLOCK2)) {
     return 0;
   }
   /* pointers may be NULL to get only specific block parameters */
@@ -1073,7 +1093,8 @@ int
 coap_get_header_block1(coap_message_t *coap_pkt, uint32_t *num, uint8_t *more,
                        uint16_t *size, uint32_t *offset)
 {
-  if(!coap_is_option(coap_pkt, COAP_OPTION_BLOCK1)) {
+  if(!coap_is_option(coap_pkt, COAP_OPTION_BLOCK1)
+     && !coap_is_option(coap_pkt, COAP_OPTION_Q_BLOCK1)) {
     return 0;
   }
   /* pointers may be NULL to get only specific block parameters */
@@ -1113,6 +1134,32 @@ coap_set_header_block1(coap_message_t *coap_pkt, uint32_t num, uint8_t more,
 }
 /*---------------------------------------------------------------------------*/
 int
+coap_set_header_q_block2(coap_message_t *coap_pkt, uint32_t num, uint8_t more,
+                         uint16_t size)
+{
+  if(!coap_set_header_block2(coap_pkt, num, more, size)) {
+    return 0;
+  }
+  coap_pkt->options[COAP_OPTION_BLOCK2 / COAP_OPTION_MAP_SIZE] &=
+    ~(1 << (COAP_OPTION_BLOCK2 % COAP_OPTION_MAP_SIZE));
+  coap_set_option(coap_pkt, COAP_OPTION_Q_BLOCK2);
+  return 1;
+}
+/*---------------------------------------------------------------------------*/
+int
+coap_set_header_q_block1(coap_message_t *coap_pkt, uint32_t num, uint8_t more,
+                         uint16_t size)
+{
+  if(!coap_set_header_block1(coap_pkt, num, more, size)) {
+    return 0;
+  }
+  coap_pkt->options[COAP_OPTION_BLOCK1 / COAP_OPTION_MAP_SIZE] &=
+    ~(1 << (COAP_OPTION_BLOCK1 % COAP_OPTION_MAP_SIZE));
+  coap_set_option(coap_pkt, COAP_OPTION_Q_BLOCK1);
+  return 1;
+}
+/*---------------------------------------------------------------------------*/
+int
 coap_get_header_size2(coap_message_t *coap_pkt, uint32_t *size)
 {
   if(!coap_is_option(coap_pkt, COAP_OPTION_SIZE2)) {
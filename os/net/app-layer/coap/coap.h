@@ -290,6 +290,16 @@ int coap_get_header_block1(coap_message_t *message, uint32_t *num, uint8_t *more
 int coap_set_header_block1(coap_message_t *message, uint32_t num, uint8_t more,
                            uint16_t size);
 
+/*
+ * The Q-Block options (RFC 9177) share the fields of the Block options,
+ * which are returned by coap_get_header_block1/2() for either option.
+ * Use coap_is_option() to tell them apart.
+ */
+int coap_set_header_q_block2(coap_message_t *message, uint32_t num,
+                             uint8_t more, uint16_t size);
+int coap_set_header_q_block1(coap_message_t *message, uint32_t num,
+                             uint8_t more, uint16_t size);
+
 int coap_get_header_size2(coap_message_t *message, uint32_t *size);
 int coap_set_header_size2(coap_message_t *message, uint32_t size);
 
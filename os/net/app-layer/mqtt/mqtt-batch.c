@@ -0,0 +1,260 @@
+/*
+ * Copyright (c) 2026, agent <agent@local>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+ * OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+/*---------------------------------------------------------------------------*/
+/**
+ * \addtogroup mqtt-engine
+ * @{
+ */
+/**
+ * \file
+ *    Implementation of MQTT publish batching
+ */
+/*---------------------------------------------------------------------------*/
+#include "contiki.h"
+#include "mqtt.h"
+#include "mqtt-prop.h"
+#include "mqtt-batch.h"
+
+#include <stdio.h>
+#include <string.h>
+/*---------------------------------------------------------------------------*/
+#define CBOR_MAJOR_UINT         0x00
+#define CBOR_MAJOR_NINT         0x20
+#define CBOR_ARRAY_INDEFINITE   0x9F
+#define CBOR_BREAK              0xFF
+/*---------------------------------------------------------------------------*/
+static void timer_callback(void *ptr);
+/*---------------------------------------------------------------------------*/
+/* The number of bytes that open, and that close, a message */
+static uint8_t
+delimiter_len(struct mqtt_batch *batch)
+{
+  return batch->format == MQTT_BATCH_FORMAT_RAW ? 0 : 1;
+}
+/*---------------------------------------------------------------------------*/
+static uint8_t
+separator_len(struct mqtt_batch *batch)
+{
+  return batch->format == MQTT_BATCH_FORMAT_JSON && batch->count > 0 ? 1 : 0;
+}
+/*---------------------------------------------------------------------------*/
+static uint8_t
+fits(struct mqtt_batch *batch, uint16_t len)
+{
+  uint16_t used;
+
+  used = batch->count > 0 ? batch->len : delimiter_len(batch);
+  return used + separator_len(batch) + len + delimiter_len(batch) <=
+    batch->max_bytes;
+}
+/*---------------------------------------------------------------------------*/
+static void
+open_message(struct mqtt_batch *batch)
+{
+  uint8_t *buf = batch->buf[batch->active];
+
+  batch->len = 0;
+  if(batch->format == MQTT_BATCH_FORMAT_JSON) {
+    buf[batch->len++] = '[';
+  } else if(batch->format == MQTT_BATCH_FORMAT_CBOR) {
+    buf[batch->len++] = CBOR_ARRAY_INDEFINITE;
+  }
+}
+/*---------------------------------------------------------------------------*/
+static void
+close_message(struct mqtt_batch *batch)
+{
+  uint8_t *buf = batch->buf[batch->active];
+
+  if(batch->format == MQTT_BATCH_FORMAT_JSON) {
+    buf[batch->len++] = ']';
+  } else if(batch->format == MQTT_BATCH_FORMAT_CBOR) {
+    buf[batch->len++] = CBOR_BREAK;
+  }
+}
+/*---------------------------------------------------------------------------*/
+void
+mqtt_batch_init(struct mqtt_batch *batch, struct mqtt_connection *conn,
+                char *topic, mqtt_qos_level_t qos, mqtt_batch_format_t format,
+                uint16_t max_bytes, clock_time_t max_latency)
+{
+  memset(batch, 0, sizeof(struct mqtt_batch));
+  batch->conn = conn;
+  batch->topic = topic;
+  batch->qos = qos;
+  batch->format = format;
+  batch->max_latency = max_latency;
+  if(max_bytes == 0 || max_bytes > MQTT_BATCH_BUF_SIZE) {
+    max_bytes = MQTT_BATCH_BUF_SIZE;
+  }
+  batch->max_bytes = max_bytes;
+}
+/*---------------------------------------------------------------------------*/
+mqtt_status_t
+mqtt_batch_flush(struct mqtt_batch *batch)
+{
+  mqtt_status_t status;
+
+  if(batch->count == 0) {
+    return MQTT_STATUS_OK;
+  }
+
+  if(!mqtt_connected(batch->conn)) {
+    return MQTT_STATUS_NOT_CONNECTED_ERROR;
+  }
+
+  /* The other buffer is needed for the next readings */
+  if(batch->publishing) {
+    if(mqtt_publish_pending(batch->conn, batch->mid)) {
+      DBG("MQTT batch - previous message still pending\n");
+      return MQTT_STATUS_OUT_QUEUE_FULL;
+    }
+    batch->publishing = 0;
+  }
+
+  close_message(batch);
+#if MQTT_5
+  status = mqtt_publish(batch->conn, &batch->mid, batch->topic,
+                        batch->buf[batch->active], batch->len, batch->qos,
+                        MQTT_RETAIN_OFF, 0, MQTT_TOPIC_ALIAS_OFF,
+                        MQTT_PROP_LIST_NONE);
+#else
+  status = mqtt_publish(batch->conn, &batch->mid, batch->topic,
+                        batch->buf[batch->active], batch->len, batch->qos,
+                        MQTT_RETAIN_OFF);
+#endif
+  if(status != MQTT_STATUS_OK) {
+    /* Keep collecting; the closing byte is written again next time */
+    batch->len -= delimiter_len(batch);
+    return status;
+  }
+
+  DBG("MQTT batch - published %u readings in %u bytes\n",
+      batch->count, batch->len);
+
+  batch->publishing = 1;
+  batch->active ^= 1;
+  batch->count = 0;
+  batch->len = 0;
+  ctimer_stop(&batch->timer);
+
+  return MQTT_STATUS_OK;
+}
+/*---------------------------------------------------------------------------*/
+static void
+timer_callback(void *ptr)
+{
+  struct mqtt_batch *batch = ptr;
+
+  if(mqtt_batch_flush(batch) != MQTT_STATUS_OK) {
+    ctimer_set(&batch->timer, MQTT_BATCH_RETRY_INTERVAL,
+               timer_callback, batch);
+  }
+}
+/*---------------------------------------------------------------------------*/
+mqtt_status_t
+mqtt_batch_add(struct mqtt_batch *batch, const uint8_t *data, uint16_t len)
+{
+  mqtt_status_t status;
+
+  if(!fits(batch, len)) {
+    if(batch->count == 0) {
+      return MQTT_STATUS_INVALID_ARGS_ERROR;
+    }
+    status = mqtt_batch_flush(batch);
+    if(status != MQTT_STATUS_OK) {
+      return status;
+    }
+    if(!fits(batch, len)) {
+      return MQTT_STATUS_INVALID_ARGS_ERROR;
+    }
+  }
+
+  if(batch->count == 0) {
+    open_message(batch);
+    ctimer_set(&batch->timer, batch->max_latency, timer_callback, batch);
+  } else if(separator_len(batch) > 0) {
+    batch->buf[batch->active][batch->len++] = ',';
+  }
+
+  memcpy(&batch->buf[batch->active][batch->len], data, len);
+  batch->len += len;
+  batch->count++;
+
+  return MQTT_STATUS_OK;
+}
+/*---------------------------------------------------------------------------*/
+mqtt_status_t
+mqtt_batch_add_int(struct mqtt_batch *batch, int32_t value)
+{
+  uint8_t item[12];
+  uint32_t arg;
+  uint8_t major;
+  int len;
+
+  if(batch->format != MQTT_BATCH_FORMAT_CBOR) {
+    len = snprintf((char *)item, sizeof(item), "%ld", (long)value);
+    return mqtt_batch_add(batch, item, len);
+  }
+
+  /* CBOR encodes negative integers as -1 - arg */
+  if(value < 0) {
+    major = CBOR_MAJOR_NINT;
+    arg = (uint32_t)(-1 - value);
+  } else {
+    major = CBOR_MAJOR_UINT;
+    arg = (uint32_t)value;
+  }
+
+  if(arg < 24) {
+    item[0] = major | arg;
+    len = 1;
+  } else if(arg <= 0xFF) {
+    item[0] = major | 24;
+    item[1] = arg;
+    len = 2;
+  } else if(arg <= 0xFFFF) {
+    item[0] = major | 25;
+    item[1] = arg >> 8;
+    item[2] = arg & 0xFF;
+    len = 3;
+  } else {
+    item[0] = major | 26;
+    item[1] = arg >> 24;
+    item[2] = (arg >> 16) & 0xFF;
+    item[3] = (arg >> 8) & 0xFF;
+    item[4] = arg & 0xFF;
+    len = 5;
+  }
+
+  return mqtt_batch_add(batch, item, len);
+}
+/*---------------------------------------------------------------------------*/
+/** @} */
@@ -0,0 +1,155 @@
+/*
+ * Copyright (c) 2026, agent <agent@local>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+ * OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+/*---------------------------------------------------------------------------*/
+/**
+ * \addtogroup mqtt-engine
+ * @{
+ */
+/**
+ * \file
+ *    Header file for MQTT publish batching.
+ *
+ *    A batch collects the readings published on one topic and sends them
+ *    as a single PUBLISH, once it has been open for a maximum time or
+ *    when the next reading would make the message too large. This cuts
+ *    the per-message MQTT, TCP and IPv6 header overhead for high-rate
+ *    telemetry.
+ *
+ *    The readings are sent as they were added (MQTT_BATCH_FORMAT_RAW), as
+ *    a JSON array or as a CBOR indefinite-length array.
+ */
+/*---------------------------------------------------------------------------*/
+#ifndef MQTT_BATCH_H_
+#define MQTT_BATCH_H_
+/*---------------------------------------------------------------------------*/
+#include "contiki.h"
+#include "sys/ctimer.h"
+#include "mqtt.h"
+/*---------------------------------------------------------------------------*/
+/* The size of each of the two message buffers in a batch */
+#ifdef MQTT_BATCH_CONF_BUF_SIZE
+#define MQTT_BATCH_BUF_SIZE MQTT_BATCH_CONF_BUF_SIZE
+#else
+#define MQTT_BATCH_BUF_SIZE 128
+#endif
+
+/* How soon to retry a flush that could not be published */
+#ifdef MQTT_BATCH_CONF_RETRY_INTERVAL
+#define MQTT_BATCH_RETRY_INTERVAL MQTT_BATCH_CONF_RETRY_INTERVAL
+#else
+#define MQTT_BATCH_RETRY_INTERVAL (CLOCK_SECOND / 4)
+#endif
+/*---------------------------------------------------------------------------*/
+typedef enum {
+  /* Readings are concatenated as they are */
+  MQTT_BATCH_FORMAT_RAW,
+  /* Readings are JSON values, sent as a JSON array */
+  MQTT_BATCH_FORMAT_JSON,
+  /* Readings are CBOR data items, sent as an indefinite-length array */
+  MQTT_BATCH_FORMAT_CBOR,
+} mqtt_batch_format_t;
+
+struct mqtt_batch {
+  struct mqtt_connection *conn;
+  char *topic;
+  mqtt_qos_level_t qos;
+  mqtt_batch_format_t format;
+  uint16_t max_bytes;
+  clock_time_t max_latency;
+  struct ctimer timer;
+
+  /*
+   * Readings are added to buf[active] while the message in the other
+   * buffer, with message ID mid, may still be being published.
+   */
+  uint8_t active;
+  uint8_t publishing;
+  uint16_t mid;
+  uint16_t len;
+  uint16_t count;
+  uint8_t buf[2][MQTT_BATCH_BUF_SIZE];
+};
+/*---------------------------------------------------------------------------*/
+/**
+ * \brief Initialize a batch of readings for a topic.
+ * \param batch A pointer to the batch.
+ * \param conn The MQTT connection to publish on.
+ * \param topic The topic to publish to. Must stay valid while in use.
+ * \param qos The QoS level of the batched messages.
+ * \param format How the readings are encoded in the messages.
+ * \param max_bytes The maximum message payload size, at most
+ *        MQTT_BATCH_BUF_SIZE. Zero selects MQTT_BATCH_BUF_SIZE.
+ * \param max_latency The maximum time a reading is held back.
+ */
+void mqtt_batch_init(struct mqtt_batch *batch,
+                     struct mqtt_connection *conn,
+                     char *topic,
+                     mqtt_qos_level_t qos,
+                     mqtt_batch_format_t format,
+                     uint16_t max_bytes,
+                     clock_time_t max_latency);
+/*---------------------------------------------------------------------------*/
+/**
+ * \brief Add an encoded reading to a batch.
+ * \param batch A pointer to the batch.
+ * \param data The reading, encoded according to the batch format.
+ * \param len The length of the reading.
+ * \return MQTT_STATUS_OK, or an error status if the reading was not added
+ *
+ * If the reading does not fit, the batch is published first. This fails
+ * with MQTT_STATUS_OUT_QUEUE_FULL while the previous message of the batch
+ * is still being published, or with the status of mqtt_publish().
+ * MQTT_STATUS_INVALID_ARGS_ERROR is returned for readings that can never
+ * fit.
+ */
+mqtt_status_t mqtt_batch_add(struct mqtt_batch *batch,
+                             const uint8_t *data, uint16_t len);
+/*---------------------------------------------------------------------------*/
+/**
+ * \brief Add an integer reading to a batch.
+ * \param batch A pointer to the batch.
+ * \param value The reading.
+ * \return See mqtt_batch_add()
+ *
+ * The value is encoded as a CBOR integer in MQTT_BATCH_FORMAT_CBOR
+ * batches and as a decimal number otherwise.
+ */
+mqtt_status_t mqtt_batch_add_int(struct mqtt_batch *batch, int32_t value);
+/*---------------------------------------------------------------------------*/
+/**
+ * \brief Publish the readings collected in a batch now.
+ * \param batch A pointer to the batch.
+ * \return MQTT_STATUS_OK, or an error status as for mqtt_batch_add()
+ */
+mqtt_status_t mqtt_batch_flush(struct mqtt_batch *batch);
+/*---------------------------------------------------------------------------*/
+#endif /* MQTT_BATCH_H_ */
+/*---------------------------------------------------------------------------*/
+/** @} */
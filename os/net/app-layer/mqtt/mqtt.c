@@ -167,17 +167,24 @@ typedef enum {
 /*---------------------------------------------------------------------------*/
 #define INCREMENT_MID(conn)   (conn)->mid_counter += 2
 #define MQTT_STRING_LENGTH(s) (((s)->length) == 0 ? 0 : (MQTT_STRING_LEN_SIZE + (s)->length))
+#define OUT_BUFFER_SPACE(conn) \
+  (&(conn)->out_buffer[MQTT_TCP_OUTPUT_BUFF_SIZE] - (conn)->out_buffer_ptr)
 /*---------------------------------------------------------------------------*/
-/* Protothread send macros */
+/*
+ * Protothread send macros
+ *
+ * When the output buffer is full, these wait until the TCP acknowledgement
+ * of earlier data makes room, not until all of it has been acknowledged.
+ */
 #define PT_MQTT_WRITE_BYTES(conn, data, len)                                   \
   conn->out_write_pos = 0;                                                     \
   while(write_bytes(conn, data, len)) {                                        \
-    PT_WAIT_UNTIL(pt, (conn)->out_buffer_sent);                                \
+    PT_WAIT_UNTIL(pt, OUT_BUFFER_SPACE(conn) > 0);                             \
   }
 
 #define PT_MQTT_WRITE_BYTE(conn, data)                                         \
   while(write_byte(conn, data)) {                                              \
-    PT_WAIT_UNTIL(pt, (conn)->out_buffer_sent);                                \
+    PT_WAIT_UNTIL(pt, OUT_BUFFER_SPACE(conn) > 0);                             \
   }
 /*---------------------------------------------------------------------------*/
 /*
@@ -258,11 +265,22 @@ reset_defaults(struct mqtt_connection *conn)
 }
 /*---------------------------------------------------------------------------*/
 static void
+reset_inflight(struct mqtt_connection *conn)
+{
+  ctimer_stop(&conn->publish_timer);
+  memset(conn->inflight, 0, sizeof(conn->inflight));
+  LIST_STRUCT_INIT(conn, out_queue);
+}
+/*---------------------------------------------------------------------------*/
+static void
 abort_connection(struct mqtt_connection *conn)
 {
   conn->out_buffer_ptr = conn->out_buffer;
   conn->out_queue_full = 0;
 
+  /* Publishes not yet acknowledged are dropped */
+  reset_inflight(conn);
+
   /* Reset outgoing packet */
   memset(&conn->out_packet, 0, sizeof(conn->out_packet));
 
@@ -301,11 +319,22 @@ disconnect_tcp(struct mqtt_connection *conn)
   memset(&conn->socket, 0, sizeof(conn->socket));
 }
 /*---------------------------------------------------------------------------*/
+/*
+ * The output buffer is also the output buffer of the TCP socket. The first
+ * socket.output_data_len bytes of it have been handed over to the socket,
+ * the bytes written after them up to out_buffer_ptr are handed over here.
+ * The socket moves its data down as it gets acknowledged, which is why
+ * everything written must be handed over before the protothreads yield.
+ */
 static void
 send_out_buffer(struct mqtt_connection *conn)
 {
-  if(conn->out_buffer_ptr - conn->out_buffer == 0) {
-    conn->out_buffer_sent = 1;
+  uint8_t *queued = &conn->out_buffer[conn->socket.output_data_len];
+
+  if(conn->out_buffer_ptr == queued) {
+    if(tcp_socket_queuelen(&conn->socket) == 0) {
+      conn->out_buffer_sent = 1;
+    }
     return;
   }
   conn->out_buffer_sent = 0;
@@ -313,8 +342,7 @@ send_out_buffer(struct mqtt_connection *conn)
   DBG("MQTT - (send_out_buffer) Space used in buffer: %i\n",
       conn->out_buffer_ptr - conn->out_buffer);
 
-  tcp_socket_send(&conn->socket, conn->out_buffer,
-                  conn->out_buffer_ptr - conn->out_buffer);
+  tcp_socket_send(&conn->socket, queued, conn->out_buffer_ptr - queued);
 }
 /*---------------------------------------------------------------------------*/
 static void
@@ -456,6 +484,17 @@ keep_alive_callback(void *ptr)
 }
 /*---------------------------------------------------------------------------*/
 static void
+publish_timer_callback(void *ptr)
+{
+  struct mqtt_connection *conn = ptr;
+
+  DBG("MQTT - (publish_timer_callback) Called!\n");
+
+  /* The MQTT process checks for overdue PUBACKs before it sends */
+  process_post(&mqtt_process, mqtt_do_publish_event, conn);
+}
+/*---------------------------------------------------------------------------*/
+static void
 reset_packet(struct mqtt_in_packet *packet)
 {
   memset(packet, 0, sizeof(struct mqtt_in_packet));
@@ -828,111 +867,211 @@ PT_THREAD(unsubscribe_pt(struct pt *pt, struct mqtt_connection *conn))
 }
 /*---------------------------------------------------------------------------*/
 static
-PT_THREAD(publish_pt(struct pt *pt, struct mqtt_connection *conn))
+PT_THREAD(publish_pt(struct pt *pt, struct mqtt_connection *conn,
+                     struct mqtt_inflight *pub))
 {
   PT_BEGIN(pt);
 
   DBG("MQTT - Sending publish message! topic %s topic_length %i\n",
-      conn->out_packet.topic,
-      conn->out_packet.topic_length);
-  DBG("MQTT - Buffer space is %i \n",
-      &conn->out_buffer[MQTT_TCP_OUTPUT_BUFF_SIZE] - conn->out_buffer_ptr);
+      pub->packet.topic,
+      pub->packet.topic_length);
+  DBG("MQTT - Buffer space is %i \n", OUT_BUFFER_SPACE(conn));
 
   /* Set up FHDR */
-  conn->out_packet.fhdr = MQTT_FHDR_MSG_TYPE_PUBLISH |
-    conn->out_packet.qos << 1;
-  if(conn->out_packet.retain == MQTT_RETAIN_ON) {
-    conn->out_packet.fhdr |= MQTT_FHDR_RETAIN_FLAG;
+  pub->packet.fhdr = MQTT_FHDR_MSG_TYPE_PUBLISH |
+    pub->packet.qos << 1;
+  if(pub->packet.retain == MQTT_RETAIN_ON) {
+    pub->packet.fhdr |= MQTT_FHDR_RETAIN_FLAG;
   }
-  conn->out_packet.remaining_length = MQTT_STRING_LEN_SIZE +
-    conn->out_packet.topic_length +
-    conn->out_packet.payload_size;
-  if(conn->out_packet.qos > MQTT_QOS_LEVEL_0) {
-    conn->out_packet.remaining_length += MQTT_MID_SIZE;
+  if(pub->retries > 0) {
+    pub->packet.fhdr |= MQTT_FHDR_DUP_FLAG;
+  }
+  pub->packet.remaining_length = MQTT_STRING_LEN_SIZE +
+    pub->packet.topic_length +
+    pub->packet.payload_size;
+  if(pub->packet.qos > MQTT_QOS_LEVEL_0) {
+    pub->packet.remaining_length += MQTT_MID_SIZE;
   }
 
 #if MQTT_5
-  conn->out_packet.remaining_length +=
-    conn->out_props ? (conn->out_props->properties_len + conn->out_props->properties_len_enc_bytes)
+  pub->packet.remaining_length +=
+    pub->props ? (pub->props->properties_len + pub->props->properties_len_enc_bytes)
     : 1;
 #endif
 
-  mqtt_encode_var_byte_int(conn->out_packet.remaining_length_enc,
-                           &conn->out_packet.remaining_length_enc_bytes,
-                           conn->out_packet.remaining_length);
-  if(conn->out_packet.remaining_length_enc_bytes > 4) {
+  mqtt_encode_var_byte_int(pub->packet.remaining_length_enc,
+                           &pub->packet.remaining_length_enc_bytes,
+                           pub->packet.remaining_length);
+  if(pub->packet.remaining_length_enc_bytes > 4) {
     call_event(conn, MQTT_EVENT_PROTOCOL_ERROR, NULL);
     PRINTF("MQTT - Error, remaining length > 4 bytes\n");
+    pub->state = MQTT_INFLIGHT_FREE;
     PT_EXIT(pt);
   }
 
   /* The DUP flag MUST be set to 0 for all QoS 0 messages */
-  if(conn->out_packet.qos == MQTT_QOS_LEVEL_0) {
-    conn->out_packet.fhdr &= ~MQTT_FHDR_DUP_FLAG;
+  if(pub->packet.qos == MQTT_QOS_LEVEL_0) {
+    pub->packet.fhdr &= ~MQTT_FHDR_DUP_FLAG;
   }
 
   /* Write Fixed Header */
-  PT_MQTT_WRITE_BYTE(conn, conn->out_packet.fhdr);
-  PT_MQTT_WRITE_BYTES(conn, (uint8_t *)conn->out_packet.remaining_length_enc,
-                      conn->out_packet.remaining_length_enc_bytes);
+  PT_MQTT_WRITE_BYTE(conn, pub->packet.fhdr);
+  PT_MQTT_WRITE_BYTES(conn, (uint8_t *)pub->packet.remaining_length_enc,
+                      pub->packet.remaining_length_enc_bytes);
   /* Write Variable Header */
-  PT_MQTT_WRITE_BYTE(conn, (conn->out_packet.topic_length >> 8));
-  PT_MQTT_WRITE_BYTE(conn, (conn->out_packet.topic_length & 0x00FF));
-  PT_MQTT_WRITE_BYTES(conn, (uint8_t *)conn->out_packet.topic,
-                      conn->out_packet.topic_length);
-  if(conn->out_packet.qos > MQTT_QOS_LEVEL_0) {
-    PT_MQTT_WRITE_BYTE(conn, (conn->out_packet.mid >> 8));
-    PT_MQTT_WRITE_BYTE(conn, (conn->out_packet.mid & 0x00FF));
+  PT_MQTT_WRITE_BYTE(conn, (pub->packet.topic_length >> 8));
+  PT_MQTT_WRITE_BYTE(conn, (pub->packet.topic_length & 0x00FF));
+  PT_MQTT_WRITE_BYTES(conn, (uint8_t *)pub->packet.topic,
+                      pub->packet.topic_length);
+  if(pub->packet.qos > MQTT_QOS_LEVEL_0) {
+    PT_MQTT_WRITE_BYTE(conn, (pub->packet.mid >> 8));
+    PT_MQTT_WRITE_BYTE(conn, (pub->packet.mid & 0x00FF));
   }
 
 #if MQTT_5
   /* Write Properties */
-  write_out_props(pt, conn, conn->out_props);
+  write_out_props(pt, conn, pub->props);
 #endif
 
   /* Write Payload */
+#if TCP_SOCKET_MAX_REFS > 0
+  /*
+   * Large payloads are queued on the socket by reference, behind the
+   * headers, and gathered into the TCP segments from the caller's buffer.
+   */
+  if(pub->packet.payload_size >= MQTT_ZERO_COPY_MIN_LEN) {
+    send_out_buffer(conn);
+    if(tcp_socket_send_ref(&conn->socket, pub->packet.payload,
+                           pub->packet.payload_size) > 0) {
+      pub->zero_copy = 1;
+      conn->out_buffer_sent = 0;
+    }
+  }
+  if(!pub->zero_copy) {
+    PT_MQTT_WRITE_BYTES(conn,
+                        pub->packet.payload,
+                        pub->packet.payload_size);
+  }
+#else /* TCP_SOCKET_MAX_REFS > 0 */
   PT_MQTT_WRITE_BYTES(conn,
-                      conn->out_packet.payload,
-                      conn->out_packet.payload_size);
+                      pub->packet.payload,
+                      pub->packet.payload_size);
+#endif /* TCP_SOCKET_MAX_REFS > 0 */
 
   send_out_buffer(conn);
-  timer_set(&conn->t, RESPONSE_WAIT_TIMEOUT);
 
   /*
-   * If QoS is zero then wait until the message has been sent, since there is
-   * no ACK to wait for.
-   *
-   * Also notify the app will not be notified via PUBACK or PUBCOMP
+   * The message is not waited for here, so that the next one can be sent
+   * right away. A QoS 1 message stays in the in-flight window until its
+   * PUBACK arrives. The app will not be notified via PUBACK or PUBCOMP for
+   * QoS 0.
    */
-  if(conn->out_packet.qos == 0) {
+  if(pub->packet.qos == MQTT_QOS_LEVEL_0) {
     process_post(conn->app_process, mqtt_update_event, NULL);
-  } else if(conn->out_packet.qos == 1) {
-    /* Wait for PUBACK */
-    reset_packet(&conn->in_packet);
-    PT_WAIT_UNTIL(pt, conn->out_packet.qos_state == MQTT_QOS_STATE_GOT_ACK ||
-                  timer_expired(&conn->t));
-    if(timer_expired(&conn->t)) {
-      DBG("Timeout waiting for PUBACK\n");
-    }
-    if(conn->in_packet.mid != conn->out_packet.mid) {
-      DBG("MQTT - Warning, got PUBACK with none matching MID. Currently there "
-          "is no support for several concurrent PUBLISH messages.\n");
-    }
-  } else if(conn->out_packet.qos == 2) {
+  } else if(pub->packet.qos == MQTT_QOS_LEVEL_2) {
     DBG("MQTT - QoS not implemented yet.\n");
     /* Should wait for PUBREC, send PUBREL and then wait for PUBCOMP */
   }
 
-  reset_packet(&conn->in_packet);
-
-  /* This is clear after the entire transaction is complete */
-  conn->out_queue_full = 0;
-
   DBG("MQTT - Publish Enqueued\n");
 
   PT_END(pt);
 }
 /*---------------------------------------------------------------------------*/
+static void
+publish_sent(struct mqtt_connection *conn, struct mqtt_inflight *pub)
+{
+  if(pub->state != MQTT_INFLIGHT_QUEUED) {
+    /* Aborted or failed */
+    return;
+  }
+
+  if(pub->packet.qos == MQTT_QOS_LEVEL_1 || pub->zero_copy) {
+    pub->state = MQTT_INFLIGHT_SENT;
+    pub->sent = clock_time();
+  } else {
+    pub->state = MQTT_INFLIGHT_FREE;
+  }
+
+  if(pub->packet.qos == MQTT_QOS_LEVEL_1 &&
+     ctimer_expired(&conn->publish_timer)) {
+    ctimer_set(&conn->publish_timer, RESPONSE_WAIT_TIMEOUT,
+               publish_timer_callback, conn);
+  }
+}
+/*---------------------------------------------------------------------------*/
+/*
+ * Called by the MQTT process before it sends the queued messages. QoS 1
+ * messages whose PUBACK is overdue are queued again, or dropped once they
+ * have used up their retransmissions.
+ */
+static void
+publish_retry(struct mqtt_connection *conn)
+{
+  struct mqtt_inflight *pub;
+  clock_time_t now;
+  clock_time_t wait;
+  clock_time_t elapsed;
+
+  now = clock_time();
+  wait = 0;
+  for(pub = conn->inflight; pub < &conn->inflight[MQTT_MAX_INFLIGHT]; pub++) {
+    if(pub->state != MQTT_INFLIGHT_SENT ||
+       pub->packet.qos != MQTT_QOS_LEVEL_1) {
+      continue;
+    }
+
+    /* The wait starts over as long as TCP has not delivered the payload */
+    if(pub->zero_copy &&
+       tcp_socket_ref_queued(&conn->socket, pub->packet.payload,
+                             pub->packet.payload_size)) {
+      pub->sent = now;
+    }
+
+    elapsed = now - pub->sent;
+    if(elapsed < RESPONSE_WAIT_TIMEOUT) {
+      if(wait == 0 || RESPONSE_WAIT_TIMEOUT - elapsed < wait) {
+        wait = RESPONSE_WAIT_TIMEOUT - elapsed;
+      }
+      continue;
+    }
+
+    if(pub->retries < MQTT_PUBLISH_RETRIES) {
+      DBG("MQTT - Timeout waiting for PUBACK for MID %u, retransmitting\n",
+          pub->packet.mid);
+      pub->retries++;
+      pub->zero_copy = 0;
+      pub->state = MQTT_INFLIGHT_QUEUED;
+      list_add(conn->out_queue, pub);
+    } else {
+      PRINTF("MQTT - No PUBACK for MID %u, dropping the message\n",
+             pub->packet.mid);
+      pub->state = MQTT_INFLIGHT_FREE;
+      call_event(conn, MQTT_EVENT_PUBLISH_TIMEOUT, &pub->packet.mid);
+    }
+  }
+
+  if(wait > 0) {
+    ctimer_set(&conn->publish_timer, wait, publish_timer_callback, conn);
+  }
+}
+/*---------------------------------------------------------------------------*/
+static void
+publish_release_acked(struct mqtt_connection *conn)
+{
+  struct mqtt_inflight *pub;
+
+  /* QoS 0 messages sent zero-copy are done once TCP has delivered them */
+  for(pub = conn->inflight; pub < &conn->inflight[MQTT_MAX_INFLIGHT]; pub++) {
+    if(pub->state == MQTT_INFLIGHT_SENT && pub->zero_copy &&
+       pub->packet.qos != MQTT_QOS_LEVEL_1 &&
+       !tcp_socket_ref_queued(&conn->socket, pub->packet.payload,
+                              pub->packet.payload_size)) {
+      pub->state = MQTT_INFLIGHT_FREE;
+    }
+  }
+}
+/*---------------------------------------------------------------------------*/
 static
 PT_THREAD(pingreq_pt(struct pt *pt, struct mqtt_connection *conn))
 {
@@ -1144,9 +1283,22 @@ handle_unsuback(struct mqtt_connection *conn)
 static void
 handle_puback(struct mqtt_connection *conn)
 {
+  struct mqtt_inflight *pub;
+
   DBG("MQTT - Got PUBACK\n");
 
-  conn->out_packet.qos_state = MQTT_QOS_STATE_GOT_ACK;
+  for(pub = conn->inflight; pub < &conn->inflight[MQTT_MAX_INFLIGHT]; pub++) {
+    if(pub->state == MQTT_INFLIGHT_SENT &&
+       pub->packet.qos == MQTT_QOS_LEVEL_1 &&
+       pub->packet.mid == conn->in_packet.mid) {
+      pub->state = MQTT_INFLIGHT_FREE;
+      break;
+    }
+  }
+  if(pub == &conn->inflight[MQTT_MAX_INFLIGHT]) {
+    DBG("MQTT - Warning, got PUBACK with unknown MID %u\n",
+        conn->in_packet.mid);
+  }
 
   call_event(conn, MQTT_EVENT_PUBACK, &conn->in_packet.mid);
 }
@@ -1605,10 +1757,12 @@ tcp_event(struct tcp_socket *s, void *ptr, tcp_socket_event_t event)
   case TCP_SOCKET_DATA_SENT: {
     DBG("MQTT - Got TCP_DATA_SENT\n");
 
-    if(conn->socket.output_data_len == 0) {
+    /* The socket has moved its remaining data to the start of the buffer */
+    conn->out_buffer_ptr = &conn->out_buffer[conn->socket.output_data_len];
+    if(tcp_socket_queuelen(&conn->socket) == 0) {
       conn->out_buffer_sent = 1;
-      conn->out_buffer_ptr = conn->out_buffer;
     }
+    publish_release_acked(conn);
 
     ctimer_restart(&conn->keep_alive_timer);
     break;
@@ -1624,6 +1778,7 @@ tcp_event(struct tcp_socket *s, void *ptr, tcp_socket_event_t event)
 PROCESS_THREAD(mqtt_process, ev, data)
 {
   static struct mqtt_connection *conn;
+  static struct mqtt_inflight *pub;
 
   PROCESS_BEGIN();
 
@@ -1678,8 +1833,8 @@ PROCESS_THREAD(mqtt_process, ev, data)
       conn = data;
       DBG("MQTT - Got mqtt_do_pingreq_event!\n");
 
-      if(conn->out_buffer_sent == 1 &&
-         conn->state == MQTT_CONN_STATE_CONNECTED_TO_BROKER) {
+      /* New data is queued behind any data not yet acknowledged */
+      if(conn->state == MQTT_CONN_STATE_CONNECTED_TO_BROKER) {
         PT_INIT(&conn->out_proto_thread);
         while(conn->state == MQTT_CONN_STATE_CONNECTED_TO_BROKER &&
               pingreq_pt(&conn->out_proto_thread, conn) < PT_EXITED) {
@@ -1691,8 +1846,8 @@ PROCESS_THREAD(mqtt_process, ev, data)
       conn = data;
       DBG("MQTT - Got mqtt_do_subscribe_mqtt_event!\n");
 
-      if(conn->out_buffer_sent == 1 &&
-         conn->state == MQTT_CONN_STATE_CONNECTED_TO_BROKER) {
+      /* New data is queued behind any data not yet acknowledged */
+      if(conn->state == MQTT_CONN_STATE_CONNECTED_TO_BROKER) {
         PT_INIT(&conn->out_proto_thread);
         while(conn->state == MQTT_CONN_STATE_CONNECTED_TO_BROKER &&
               subscribe_pt(&conn->out_proto_thread, conn) < PT_EXITED) {
@@ -1704,8 +1859,8 @@ PROCESS_THREAD(mqtt_process, ev, data)
       conn = data;
       DBG("MQTT - Got mqtt_do_unsubscribe_mqtt_event!\n");
 
-      if(conn->out_buffer_sent == 1 &&
-         conn->state == MQTT_CONN_STATE_CONNECTED_TO_BROKER) {
+      /* New data is queued behind any data not yet acknowledged */
+      if(conn->state == MQTT_CONN_STATE_CONNECTED_TO_BROKER) {
         PT_INIT(&conn->out_proto_thread);
         while(conn->state == MQTT_CONN_STATE_CONNECTED_TO_BROKER &&
               unsubscribe_pt(&conn->out_proto_thread, conn) < PT_EXITED) {
@@ -1717,13 +1872,16 @@ PROCESS_THREAD(mqtt_process, ev, data)
       conn = data;
       DBG("MQTT - Got mqtt_do_publish_mqtt_event!\n");
 
-      if(conn->out_buffer_sent == 1 &&
-         conn->state == MQTT_CONN_STATE_CONNECTED_TO_BROKER) {
+      /* Send all queued messages, without waiting for acknowledgements */
+      publish_retry(conn);
+      while(conn->state == MQTT_CONN_STATE_CONNECTED_TO_BROKER &&
+            (pub = list_pop(conn->out_queue)) != NULL) {
         PT_INIT(&conn->out_proto_thread);
         while(conn->state == MQTT_CONN_STATE_CONNECTED_TO_BROKER &&
-              publish_pt(&conn->out_proto_thread, conn) < PT_EXITED) {
+              publish_pt(&conn->out_proto_thread, conn, pub) < PT_EXITED) {
           PT_MQTT_WAIT_SEND();
         }
+        publish_sent(conn, pub);
       }
     }
 #if MQTT_5
@@ -1790,6 +1948,7 @@ mqtt_register(struct mqtt_connection *conn, struct process *app_process,
   /* Server capabilities have non-zero defaults */
   conn->srv_feature_en = -1;
 #endif
+  reset_inflight(conn);
   string_to_mqtt_string(&conn->client_id, client_id);
   conn->event_callback = event_callback;
   conn->app_process = app_process;
@@ -1975,6 +2134,34 @@ mqtt_unsubscribe(struct mqtt_connection *conn, uint16_t *mid,
   return MQTT_STATUS_OK;
 }
 /*----------------------------------------------------------------------------*/
+uint8_t
+mqtt_publish_slots(struct mqtt_connection *conn)
+{
+  struct mqtt_inflight *pub;
+  uint8_t slots;
+
+  slots = 0;
+  for(pub = conn->inflight; pub < &conn->inflight[MQTT_MAX_INFLIGHT]; pub++) {
+    if(pub->state == MQTT_INFLIGHT_FREE) {
+      slots++;
+    }
+  }
+  return slots;
+}
+/*----------------------------------------------------------------------------*/
+uint8_t
+mqtt_publish_pending(struct mqtt_connection *conn, uint16_t mid)
+{
+  struct mqtt_inflight *pub;
+
+  for(pub = conn->inflight; pub < &conn->inflight[MQTT_MAX_INFLIGHT]; pub++) {
+    if(pub->state != MQTT_INFLIGHT_FREE && pub->packet.mid == mid) {
+      return 1;
+    }
+  }
+  return 0;
+}
+/*----------------------------------------------------------------------------*/
 mqtt_status_t
 mqtt_publish(struct mqtt_connection *conn, uint16_t *mid, char *topic,
              uint8_t *payload, uint32_t payload_size,
@@ -1987,53 +2174,64 @@ mqtt_publish(struct mqtt_connection *conn, uint16_t *mid, char *topic,
              mqtt_retain_t retain)
 #endif
 {
+  struct mqtt_inflight *pub;
+
   if(conn->state != MQTT_CONN_STATE_CONNECTED_TO_BROKER) {
     return MQTT_STATUS_NOT_CONNECTED_ERROR;
   }
 
   DBG("MQTT - Call to mqtt_publish...\n");
 
-  /* Currently don't have a queue, so only one item at a time */
-  if(conn->out_queue_full) {
+  /* Take a free slot in the in-flight window */
+  if(mqtt_publish_slots(conn) == 0) {
     DBG("MQTT - Not accepted!\n");
     return MQTT_STATUS_OUT_QUEUE_FULL;
   }
-  conn->out_queue_full = 1;
+  pub = conn->inflight;
+  while(pub->state != MQTT_INFLIGHT_FREE) {
+    pub++;
+  }
   DBG("MQTT - Accepted!\n");
 
-  conn->out_packet.mid = INCREMENT_MID(conn);
-  conn->out_packet.retain = retain;
+  memset(pub, 0, sizeof(*pub));
+  pub->packet.mid = INCREMENT_MID(conn);
+  pub->packet.retain = retain;
 #if MQTT_5
   if(topic_alias_en == MQTT_TOPIC_ALIAS_ON) {
-    conn->out_packet.topic = "";
-    conn->out_packet.topic_length = 0;
-    conn->out_packet.topic_alias = topic_alias;
+    pub->packet.topic = "";
+    pub->packet.topic_length = 0;
+    pub->packet.topic_alias = topic_alias;
     if(topic_alias == 0) {
       DBG("MQTT - Error, a topic alias of 0 is not permitted! It won't be sent.\n");
     }
   } else {
-    conn->out_packet.topic = topic;
-    conn->out_packet.topic_length = strlen(topic);
-    conn->out_packet.topic_alias = 0;
+    pub->packet.topic = topic;
+    pub->packet.topic_length = strlen(topic);
+    pub->packet.topic_alias = 0;
   }
+  pub->props = prop_list;
 #else
-  conn->out_packet.topic = topic;
-  conn->out_packet.topic_length = strlen(topic);
+  pub->packet.topic = topic;
+  pub->packet.topic_length = strlen(topic);
 #endif
-  conn->out_packet.payload = payload;
-  conn->out_packet.payload_size = payload_size;
-  conn->out_packet.qos = qos_level;
-  conn->out_packet.qos_state = MQTT_QOS_STATE_NO_ACK;
+  pub->packet.payload = payload;
+  pub->packet.payload_size = payload_size;
+  pub->packet.qos = qos_level;
+  pub->packet.qos_state = MQTT_QOS_STATE_NO_ACK;
 
   if(mid) {
-    *mid = conn->out_packet.mid;
+    *mid = pub->packet.mid;
   }
 
-#if MQTT_5
-  conn->out_props = prop_list;
-#endif
+  /* If the queue is not empty, the MQTT process will get to this one too */
+  if(list_head(conn->out_queue) == NULL &&
+     process_post(&mqtt_process, mqtt_do_publish_event, conn) != PROCESS_ERR_OK) {
+    return MQTT_STATUS_ERROR;
+  }
+
+  pub->state = MQTT_INFLIGHT_QUEUED;
+  list_add(conn->out_queue, pub);
 
-  process_post(&mqtt_process, mqtt_do_publish_event, conn);
   return MQTT_STATUS_OK;
 }
 /*----------------------------------------------------------------------------*/
@@ -139,6 +139,39 @@
 
 #define MQTT_TOPIC_MAX_LENGTH 128
 
+/*
+ * The number of PUBLISH messages that may be outstanding at a time: queued
+ * for sending, waiting for PUBACK (QoS 1) or, when sent zero-copy, waiting
+ * for the TCP acknowledgement of the payload.
+ */
+#ifdef MQTT_CONF_MAX_INFLIGHT
+#define MQTT_MAX_INFLIGHT MQTT_CONF_MAX_INFLIGHT
+#else
+#define MQTT_MAX_INFLIGHT 1
+#endif
+
+/*
+ * The number of times a QoS 1 PUBLISH is sent again, with the DUP flag set,
+ * when its PUBACK does not arrive in time. When the last attempt times out
+ * too, the message is dropped and MQTT_EVENT_PUBLISH_TIMEOUT is raised.
+ */
+#ifdef MQTT_CONF_PUBLISH_RETRIES
+#define MQTT_PUBLISH_RETRIES MQTT_CONF_PUBLISH_RETRIES
+#else
+#define MQTT_PUBLISH_RETRIES 2
+#endif
+
+/*
+ * PUBLISH payloads of at least this many bytes are sent directly from the
+ * caller's buffer instead of being copied to the output buffer. Requires
+ * TCP_SOCKET_CONF_MAX_REFS > 0.
+ */
+#ifdef MQTT_CONF_ZERO_COPY_MIN_LEN
+#define MQTT_ZERO_COPY_MIN_LEN MQTT_CONF_ZERO_COPY_MIN_LEN
+#else
+#define MQTT_ZERO_COPY_MIN_LEN 64
+#endif
+
 #if MQTT_PROTOCOL_VERSION >= MQTT_PROTOCOL_VERSION_3_1_1
 #ifdef MQTT_CONF_SUPPORTS_EMPTY_CLIENT_ID
 #define MQTT_SRV_SUPPORTS_EMPTY_CLIENT_ID MQTT_CONF_SUPPORTS_EMPTY_CLIENT_ID
@@ -223,6 +256,7 @@ typedef enum {
   MQTT_EVENT_UNSUBACK,
   MQTT_EVENT_PUBLISH,
   MQTT_EVENT_PUBACK,
+  MQTT_EVENT_PUBLISH_TIMEOUT,
 
   /* Errors */
   MQTT_EVENT_ERROR = 0x80,
@@ -260,6 +294,12 @@ typedef enum {
   /* Expand for QoS 2 */
 } mqtt_qos_state_t;
 
+typedef enum {
+  MQTT_INFLIGHT_FREE,
+  MQTT_INFLIGHT_QUEUED,
+  MQTT_INFLIGHT_SENT,
+} mqtt_inflight_state_t;
+
 typedef enum {
   MQTT_PUBLISH_OK,
   MQTT_PUBLISH_ERR,
@@ -485,6 +525,19 @@ struct mqtt_out_packet {
   uint8_t auth_reason_code;
 #endif
 };
+
+/* An outgoing PUBLISH, from mqtt_publish() until it has been delivered. */
+struct mqtt_inflight {
+  struct mqtt_inflight *next;
+  struct mqtt_out_packet packet;
+  mqtt_inflight_state_t state;
+  uint8_t zero_copy;
+  uint8_t retries;
+  clock_time_t sent;
+#if MQTT_5
+  struct mqtt_prop_list *props;
+#endif
+};
 /*---------------------------------------------------------------------------*/
 /**
  * \brief           MQTT event callback function
@@ -549,6 +602,9 @@ struct mqtt_connection {
   uint8_t out_buffer[MQTT_TCP_OUTPUT_BUFF_SIZE];
   uint8_t out_buffer_sent;
   struct mqtt_out_packet out_packet;
+  struct mqtt_inflight inflight[MQTT_MAX_INFLIGHT];
+  LIST_STRUCT(out_queue);
+  struct ctimer publish_timer;
   struct pt out_proto_thread;
   uint32_t out_write_pos;
   uint16_t max_segment_size;
@@ -697,7 +753,11 @@ mqtt_status_t mqtt_unsubscribe(struct mqtt_connection *conn,
  * \param prop_list Output properties (MQTTv5-only).
  * \return MQTT_STATUS_OK or some error status
  *
- * This function publishes to a topic on a MQTT broker.
+ * This function publishes to a topic on a MQTT broker. The message is
+ * queued and sent in the background, so several publishes can be pipelined
+ * on one connection (see MQTT_MAX_INFLIGHT). The topic and payload are not
+ * copied: they must be left untouched as long as mqtt_publish_pending()
+ * reports the message as pending.
  */
 mqtt_status_t mqtt_publish(struct mqtt_connection *conn,
                            uint16_t *mid,
@@ -714,6 +774,27 @@ mqtt_status_t mqtt_publish(struct mqtt_connection *conn,
                            mqtt_retain_t retain);
 #endif
 /*---------------------------------------------------------------------------*/
+/**
+ * \brief Get the number of PUBLISH messages that can currently be accepted.
+ * \param conn A pointer to the MQTT connection.
+ * \return The number of free slots in the in-flight window
+ *
+ * Up to MQTT_MAX_INFLIGHT publishes can be outstanding on a connection.
+ * QoS 1 messages occupy a slot until their PUBACK is received. Without a
+ * PUBACK, they are retransmitted up to MQTT_PUBLISH_RETRIES times before the
+ * slot is given back and MQTT_EVENT_PUBLISH_TIMEOUT is raised with the
+ * message ID.
+ */
+uint8_t mqtt_publish_slots(struct mqtt_connection *conn);
+/*---------------------------------------------------------------------------*/
+/**
+ * \brief Check whether a PUBLISH message still uses its payload buffer.
+ * \param conn A pointer to the MQTT connection.
+ * \param mid The message ID returned by mqtt_publish().
+ * \return Non-zero as long as the payload must be left untouched
+ */
+uint8_t mqtt_publish_pending(struct mqtt_connection *conn, uint16_t mid);
+/*---------------------------------------------------------------------------*/
 /**
  * \brief Set the user name and password for a MQTT client.
  * \param conn A pointer to the MQTT connection.
@@ -759,7 +840,8 @@ void mqtt_set_last_will(struct mqtt_connection *conn,
   ((conn)->state == MQTT_CONN_STATE_CONNECTED_TO_BROKER ? 1 : 0)
 
 #define mqtt_ready(conn) \
-  (!(conn)->out_queue_full && mqtt_connected((conn)))
+  (!(conn)->out_queue_full && mqtt_connected((conn)) && \
+   mqtt_publish_slots((conn)) > 0)
 /*---------------------------------------------------------------------------*/
 void mqtt_encode_var_byte_int(uint8_t *vbi_out,
                               uint8_t *vbi_bytes,
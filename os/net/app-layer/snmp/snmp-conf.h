@@ -101,6 +101,20 @@
 #define SNMP_MAX_NR_VALUES 2
 #endif
 
+#ifdef SNMP_CONF_MIB_INDEX_SIZE
+/**
+ * \brief Configurable number of MIB resources in the sorted search index
+ */
+#define SNMP_MIB_INDEX_SIZE SNMP_CONF_MIB_INDEX_SIZE
+#else
+/**
+ * \brief Default number of MIB resources in the sorted search index
+ *
+ * Lookups fall back to a linear search when more resources are added.
+ */
+#define SNMP_MIB_INDEX_SIZE 32
+#endif
+
 #ifdef SNMP_CONF_MAX_PACKET_SIZE
 #error "SNMP_CONF_MAX_PACKET_SIZE is obsolete. Use UIP_CONF_BUFFER_SIZE"
 #endif /* SNMP_CONF_MAX_PACKET_SIZE */
@@ -122,6 +122,7 @@ static inline int
 snmp_engine_get_bulk(snmp_header_t *header, snmp_varbind_t *varbinds)
 {
   snmp_mib_resource_t *resource;
+  snmp_mib_resource_t *resources[SNMP_MAX_NR_VALUES];
   snmp_oid_t oids[SNMP_MAX_NR_VALUES];
   uint32_t j, original_varbinds_length;
   uint8_t repeater;
@@ -171,10 +172,18 @@ snmp_engine_get_bulk(snmp_header_t *header, snmp_varbind_t *varbinds)
     }
   }
 
+  /*
+   * The MIB is sorted, so only the first repetition has to be searched
+   * for. The following ones continue with the next resource.
+   */
+  for(j = header->non_repeaters; j < original_varbinds_length; j++) {
+    resources[j] = snmp_mib_find_next(&oids[j]);
+  }
+
   for(i = 0; i < header->max_repetitions; i++) {
     repeater = 0;
     for(j = header->non_repeaters; j < original_varbinds_length; j++) {
-      resource = snmp_mib_find_next(&oids[j]);
+      resource = resources[j];
       if(!resource) {
         switch(header->version) {
         case SNMP_VERSION_1:
@@ -190,7 +199,8 @@ snmp_engine_get_bulk(snmp_header_t *header, snmp_varbind_t *varbinds)
             memcpy(&varbinds[varbinds_length].oid, &oids[j], sizeof(snmp_oid_t));
             (varbinds_length)++;
           } else {
-            return -1;
+            /* The response is full, send the repetitions that fit */
+            return 0;
           }
           break;
         default:
@@ -202,9 +212,11 @@ snmp_engine_get_bulk(snmp_header_t *header, snmp_varbind_t *varbinds)
           resource->handler(&varbinds[varbinds_length], &resource->oid);
           (varbinds_length)++;
           memcpy(&oids[j], &resource->oid, sizeof(snmp_oid_t));
+          resources[j] = resource->next;
           repeater++;
         } else {
-          return -1;
+          /* The response is full, send the repetitions that fit */
+          return 0;
         }
       }
     }
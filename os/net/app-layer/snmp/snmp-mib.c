@@ -42,11 +42,23 @@
 #include "snmp-mib.h"
 #include "lib/list.h"
 
+#include <string.h>
+
 #define LOG_MODULE "SNMP [mib]"
 #define LOG_LEVEL LOG_LEVEL_SNMP
 
 LIST(snmp_mib);
 
+#if SNMP_MIB_INDEX_SIZE > 0
+/*
+ * The resources sorted by OID, for binary search. The index is not used
+ * once more resources have been added than it can hold.
+ */
+static snmp_mib_resource_t *snmp_mib_index[SNMP_MIB_INDEX_SIZE];
+static uint16_t snmp_mib_index_len;
+static uint8_t snmp_mib_index_valid;
+#endif /* SNMP_MIB_INDEX_SIZE > 0 */
+
 /*---------------------------------------------------------------------------*/
 /**
  * @brief Compares to oids
@@ -85,11 +97,57 @@ snmp_mib_cmp_oid(snmp_oid_t *oid1, snmp_oid_t *oid2)
   return 0;
 }
 /*---------------------------------------------------------------------------*/
+#if SNMP_MIB_INDEX_SIZE > 0
+/**
+ * @brief Finds the position of the first resource in the index that is
+ *        greater than (or equal to) the oid
+ *
+ * @param oid The oid
+ * @param equal If set, the first resource that is greater than or equal
+ *        to the oid is searched for
+ *
+ * @return The position in the index
+ */
+static uint16_t
+snmp_mib_index_search(snmp_oid_t *oid, uint8_t equal)
+{
+  uint16_t low, high, mid;
+  int cmp;
+
+  low = 0;
+  high = snmp_mib_index_len;
+  while(low < high) {
+    mid = (low + high) / 2;
+    cmp = snmp_mib_cmp_oid(&snmp_mib_index[mid]->oid, oid);
+    if(cmp < 0 || (cmp == 0 && !equal)) {
+      low = mid + 1;
+    } else {
+      high = mid;
+    }
+  }
+
+  return low;
+}
+#endif /* SNMP_MIB_INDEX_SIZE > 0 */
+/*---------------------------------------------------------------------------*/
 snmp_mib_resource_t *
 snmp_mib_find(snmp_oid_t *oid)
 {
   snmp_mib_resource_t *resource;
 
+#if SNMP_MIB_INDEX_SIZE > 0
+  uint16_t i;
+
+  if(snmp_mib_index_valid) {
+    i = snmp_mib_index_search(oid, 1);
+    if(i < snmp_mib_index_len &&
+       !snmp_mib_cmp_oid(oid, &snmp_mib_index[i]->oid)) {
+      return snmp_mib_index[i];
+    }
+    return NULL;
+  }
+#endif /* SNMP_MIB_INDEX_SIZE > 0 */
+
   resource = NULL;
   for(resource = list_head(snmp_mib);
       resource; resource = resource->next) {
@@ -107,6 +165,15 @@ snmp_mib_find_next(snmp_oid_t *oid)
 {
   snmp_mib_resource_t *resource;
 
+#if SNMP_MIB_INDEX_SIZE > 0
+  uint16_t i;
+
+  if(snmp_mib_index_valid) {
+    i = snmp_mib_index_search(oid, 0);
+    return i < snmp_mib_index_len ? snmp_mib_index[i] : NULL;
+  }
+#endif /* SNMP_MIB_INDEX_SIZE > 0 */
+
   resource = NULL;
   for(resource = list_head(snmp_mib);
       resource; resource = resource->next) {
@@ -122,21 +189,37 @@ snmp_mib_find_next(snmp_oid_t *oid)
 void
 snmp_mib_add(snmp_mib_resource_t *new_resource)
 {
-  snmp_mib_resource_t *resource;
+  snmp_mib_resource_t *resource, *previous;
   uint8_t i;
+#if SNMP_MIB_INDEX_SIZE > 0
+  uint16_t j;
+#endif /* SNMP_MIB_INDEX_SIZE > 0 */
 
+  previous = NULL;
   for(resource = list_head(snmp_mib);
       resource; resource = resource->next) {
 
     if(snmp_mib_cmp_oid(&resource->oid, &new_resource->oid) > 0) {
       break;
     }
+    previous = resource;
   }
-  if(resource == NULL) {
-    list_add(snmp_mib, new_resource);
-  } else {
-    list_insert(snmp_mib, new_resource, resource);
+  /* Inserts at the head if there is no previous resource */
+  list_insert(snmp_mib, previous, new_resource);
+
+#if SNMP_MIB_INDEX_SIZE > 0
+  if(snmp_mib_index_len < SNMP_MIB_INDEX_SIZE) {
+    /* Keep the same order as the list: after resources with an equal OID */
+    j = snmp_mib_index_search(&new_resource->oid, 0);
+    memmove(&snmp_mib_index[j + 1], &snmp_mib_index[j],
+            (snmp_mib_index_len - j) * sizeof(snmp_mib_index[0]));
+    snmp_mib_index[j] = new_resource;
+    snmp_mib_index_len++;
+  } else if(snmp_mib_index_valid) {
+    LOG_WARN("MIB index full, using linear search\n");
+    snmp_mib_index_valid = 0;
   }
+#endif /* SNMP_MIB_INDEX_SIZE > 0 */
 
   if(LOG_DBG_ENABLED) {
     /*
@@ -164,4 +247,8 @@ void
 snmp_mib_init(void)
 {
   list_init(snmp_mib);
+#if SNMP_MIB_INDEX_SIZE > 0
+  snmp_mib_index_len = 0;
+  snmp_mib_index_valid = 1;
+#endif /* SNMP_MIB_INDEX_SIZE > 0 */
 }
@@ -239,6 +239,46 @@ static uint16_t my_tag;
 /* Assuming that the worst growth for uncompression is 38 bytes */
 #define SICSLOWPAN_FIRST_FRAGMENT_SIZE (SICSLOWPAN_FRAGMENT_SIZE + 38)
 
+/* Relay fragments of packets that are not for us hop by hop through
+   virtual reassembly buffers (RFC 8930) instead of reassembling them. */
+#ifdef SICSLOWPAN_CONF_FRAG_FORWARDING
+#define SICSLOWPAN_FRAG_FORWARDING SICSLOWPAN_CONF_FRAG_FORWARDING
+#else
+#define SICSLOWPAN_FRAG_FORWARDING 0
+#endif
+
+/* Number of packets that can be relayed concurrently */
+#ifdef SICSLOWPAN_CONF_VRB_ENTRIES
+#define SICSLOWPAN_VRB_ENTRIES SICSLOWPAN_CONF_VRB_ENTRIES
+#else
+#define SICSLOWPAN_VRB_ENTRIES 4
+#endif
+
+/* Number of hash buckets used to look up reassembly contexts by
+   (sender, tag). */
+#ifdef SICSLOWPAN_CONF_REASS_HASH_SIZE
+#define SICSLOWPAN_REASS_HASH_SIZE SICSLOWPAN_CONF_REASS_HASH_SIZE
+#else
+#define SICSLOWPAN_REASS_HASH_SIZE SICSLOWPAN_REASS_CONTEXTS
+#endif
+
+/* Contexts and fragment buffers are linked by 8-bit indices. */
+#if SICSLOWPAN_REASS_CONTEXTS > 127
+#error Too many SICSLOWPAN_REASS_CONTEXTS set.
+#endif
+#if SICSLOWPAN_FRAGMENT_BUFFERS > 255
+#error Too many SICSLOWPAN_FRAGMENT_BUFFERS set.
+#endif
+
+/*
+ * Links between contexts and fragment buffers are stored as index + 1,
+ * so that 0 marks the end of a list and the zero-initialized state is a
+ * set of empty lists.
+ */
+#define FRAG_LINK(index)  ((uint8_t)((index) + 1))
+#define FRAG_INDEX(link)  ((link) - 1)
+#define FRAG_LINK_NONE    0
+
 /* all information needed for reassembly */
 struct sicslowpan_frag_info {
   /** When reassembling, the source address of the fragments being merged */
@@ -251,6 +291,12 @@ struct sicslowpan_frag_info {
   uint16_t reassembled_len;
   /** Reassembly %process %timer. */
   struct timer reass_timer;
+  /** Time of the last received fragment, used for LRU eviction */
+  clock_time_t last_update;
+  /** Next context in the same hash bucket */
+  uint8_t hash_next;
+  /** List of fragment buffers stored for this context */
+  uint8_t bufs;
 
   /** Fragment size of first fragment */
   uint16_t first_frag_len;
@@ -260,10 +306,11 @@ struct sicslowpan_frag_info {
 };
 
 static struct sicslowpan_frag_info frag_info[SICSLOWPAN_REASS_CONTEXTS];
+static uint8_t frag_hash[SICSLOWPAN_REASS_HASH_SIZE];
 
 struct sicslowpan_frag_buf {
-  /* the index of the frag_info */
-  uint8_t index;
+  /* Next buffer of the same context, or in the free list */
+  uint8_t next;
   /* Fragment offset */
   uint8_t offset;
   /* Length of this fragment (if zero this buffer is not allocated) */
@@ -272,20 +319,73 @@ struct sicslowpan_frag_buf {
 };
 
 static struct sicslowpan_frag_buf frag_buf[SICSLOWPAN_FRAGMENT_BUFFERS];
+/* Buffers that have been released, and the number of buffers that
+   have never been handed out. Together they form the free pool. */
+static uint8_t frag_buf_free;
+static uint8_t frag_buf_unused = SICSLOWPAN_FRAGMENT_BUFFERS;
 
+/*---------------------------------------------------------------------------*/
+static uint8_t
+frag_hash_bucket(uint16_t tag, const linkaddr_t *sender)
+{
+  return (tag ^ sender->u8[LINKADDR_SIZE - 1] ^
+          (sender->u8[LINKADDR_SIZE - 2] << 8)) % SICSLOWPAN_REASS_HASH_SIZE;
+}
+/*---------------------------------------------------------------------------*/
+static int8_t
+frag_lookup(uint16_t tag, const linkaddr_t *sender)
+{
+  uint8_t link;
+
+  for(link = frag_hash[frag_hash_bucket(tag, sender)];
+      link != FRAG_LINK_NONE;
+      link = frag_info[FRAG_INDEX(link)].hash_next) {
+    struct sicslowpan_frag_info *info = &frag_info[FRAG_INDEX(link)];
+    if(info->tag == tag && linkaddr_cmp(&info->sender, sender)) {
+      return FRAG_INDEX(link);
+    }
+  }
+  return -1;
+}
+/*---------------------------------------------------------------------------*/
+static void
+frag_hash_remove(uint8_t frag_info_index)
+{
+  uint8_t *link;
+
+  link = &frag_hash[frag_hash_bucket(frag_info[frag_info_index].tag,
+                                     &frag_info[frag_info_index].sender)];
+  while(*link != FRAG_LINK_NONE) {
+    if(*link == FRAG_LINK(frag_info_index)) {
+      *link = frag_info[frag_info_index].hash_next;
+      break;
+    }
+    link = &frag_info[FRAG_INDEX(*link)].hash_next;
+  }
+  frag_info[frag_info_index].hash_next = FRAG_LINK_NONE;
+}
 /*---------------------------------------------------------------------------*/
 static int
 clear_fragments(uint8_t frag_info_index)
 {
-  int i, clear_count;
+  int clear_count;
+  uint8_t link;
+
   clear_count = 0;
+  if(frag_info[frag_info_index].len > 0) {
+    frag_hash_remove(frag_info_index);
+  }
   frag_info[frag_info_index].len = 0;
-  for(i = 0; i < SICSLOWPAN_FRAGMENT_BUFFERS; i++) {
-    if(frag_buf[i].len > 0 && frag_buf[i].index == frag_info_index) {
-      /* deallocate the buffer */
-      frag_buf[i].len = 0;
-      clear_count++;
-    }
+
+  /* Move the buffers of this context to the free list */
+  while((link = frag_info[frag_info_index].bufs) != FRAG_LINK_NONE) {
+    struct sicslowpan_frag_buf *buf = &frag_buf[FRAG_INDEX(link)];
+    frag_info[frag_info_index].bufs = buf->next;
+    /* deallocate the buffer */
+    buf->len = 0;
+    buf->next = frag_buf_free;
+    frag_buf_free = link;
+    clear_count++;
   }
   return clear_count;
 }
@@ -305,10 +405,35 @@ timeout_fragments(int not_context)
   return count;
 }
 /*---------------------------------------------------------------------------*/
+/* Drop the reassembly that has been idle for the longest time */
+static int8_t
+evict_fragments(int not_context)
+{
+  int i;
+  int8_t lru = -1;
+  clock_time_t now = clock_time();
+  clock_time_t max_idle = 0;
+
+  for(i = 0; i < SICSLOWPAN_REASS_CONTEXTS; i++) {
+    if(frag_info[i].len > 0 && i != not_context &&
+       (lru < 0 || (clock_time_t)(now - frag_info[i].last_update) > max_idle)) {
+      lru = i;
+      max_idle = now - frag_info[i].last_update;
+    }
+  }
+
+  if(lru >= 0) {
+    LOG_WARN("reassembly: evicting session - tag: %d\n", frag_info[lru].tag);
+    clear_fragments(lru);
+  }
+  return lru;
+}
+/*---------------------------------------------------------------------------*/
 static int
 store_fragment(uint8_t index, uint8_t offset)
 {
-  int i;
+  uint8_t link;
+  struct sicslowpan_frag_buf *buf;
   int len;
 
   len = packetbuf_datalen() - packetbuf_hdr_len;
@@ -318,20 +443,27 @@ store_fragment(uint8_t index, uint8_t offset)
     return -1;
   }
 
-  for(i = 0; i < SICSLOWPAN_FRAGMENT_BUFFERS; i++) {
-    if(frag_buf[i].len == 0) {
-      /* copy over the data from packetbuf into the fragment buffer,
-         and store offset and len */
-      frag_buf[i].offset = offset; /* frag offset */
-      frag_buf[i].len = len;
-      frag_buf[i].index = index;
-      memcpy(frag_buf[i].data, packetbuf_ptr + packetbuf_hdr_len, len);
-      /* return the length of the stored fragment */
-      return len;
-    }
+  if(frag_buf_free != FRAG_LINK_NONE) {
+    link = frag_buf_free;
+    frag_buf_free = frag_buf[FRAG_INDEX(link)].next;
+  } else if(frag_buf_unused > 0) {
+    link = FRAG_LINK(SICSLOWPAN_FRAGMENT_BUFFERS - frag_buf_unused);
+    frag_buf_unused--;
+  } else {
+    /* failed */
+    return -1;
   }
-  /* failed */
-  return -1;
+
+  /* copy over the data from packetbuf into the fragment buffer,
+     and store offset and len */
+  buf = &frag_buf[FRAG_INDEX(link)];
+  buf->offset = offset; /* frag offset */
+  buf->len = len;
+  memcpy(buf->data, packetbuf_ptr + packetbuf_hdr_len, len);
+  buf->next = frag_info[index].bufs;
+  frag_info[index].bufs = link;
+  /* return the length of the stored fragment */
+  return len;
 }
 /*---------------------------------------------------------------------------*/
 /* add a new fragment to the buffer */
@@ -341,8 +473,15 @@ add_fragment(uint16_t tag, uint16_t frag_size, uint8_t offset)
   int i;
   int len;
   int8_t found = -1;
+  const linkaddr_t *sender = packetbuf_addr(PACKETBUF_ADDR_SENDER);
 
   if(offset == 0) {
+    /* A retransmitted first fragment restarts its reassembly */
+    found = frag_lookup(tag, sender);
+    if(found >= 0) {
+      clear_fragments(found);
+    }
+
     /* This is a first fragment - check if we can add this */
     for(i = 0; i < SICSLOWPAN_REASS_CONTEXTS; i++) {
       /* clear all fragment info with expired timer to free all fragment buffers */
@@ -358,6 +497,11 @@ add_fragment(uint16_t tag, uint16_t frag_size, uint8_t offset)
       }
     }
 
+    if(found < 0) {
+      /* All contexts are busy: give up the least recently used one */
+      found = evict_fragments(-1);
+    }
+
     if(found < 0) {
       LOG_WARN("reassembly: failed to store new fragment session - tag: %d\n", tag);
       return -1;
@@ -366,35 +510,42 @@ add_fragment(uint16_t tag, uint16_t frag_size, uint8_t offset)
     /* Found a free fragment info to store data in */
     frag_info[found].len = frag_size;
     frag_info[found].tag = tag;
-    linkaddr_copy(&frag_info[found].sender,
-                  packetbuf_addr(PACKETBUF_ADDR_SENDER));
+    frag_info[found].last_update = clock_time();
+    linkaddr_copy(&frag_info[found].sender, sender);
     timer_set(&frag_info[found].reass_timer, SICSLOWPAN_REASS_MAXAGE * CLOCK_SECOND / 16);
+    frag_info[found].hash_next = frag_hash[frag_hash_bucket(tag, sender)];
+    frag_hash[frag_hash_bucket(tag, sender)] = FRAG_LINK(found);
     /* first fragment can not be stored immediately but is moved into
        the buffer while uncompressing */
     return found;
   }
 
   /* This is a N-fragment - should find the info */
-  for(i = 0; i < SICSLOWPAN_REASS_CONTEXTS; i++) {
-    if(frag_info[i].tag == tag && frag_info[i].len > 0 &&
-       linkaddr_cmp(&frag_info[i].sender, packetbuf_addr(PACKETBUF_ADDR_SENDER))) {
-      /* Tag and Sender match - this must be the correct info to store in */
-      found = i;
-      break;
-    }
-  }
-
+  found = frag_lookup(tag, sender);
   if(found < 0) {
     /* no entry found for storing the new fragment */
     LOG_WARN("reassembly: failed to store N-fragment - could not find session - tag: %d offset: %d\n", tag, offset);
     return -1;
   }
+  i = found;
+  frag_info[i].last_update = clock_time();
+
+  len = packetbuf_datalen() - packetbuf_hdr_len;
+  if(len > 0 && frag_info[i].reassembled_len + len >= frag_size) {
+    /* This fragment completes the packet: it is not stored but copied
+       straight into uip_buf along with the stored fragments. */
+    frag_info[i].reassembled_len += len;
+    return i;
+  }
 
   /* i is the index of the reassembly context */
   len = store_fragment(i, offset);
   if(len < 0 && timeout_fragments(i) > 0) {
     len = store_fragment(i, offset);
   }
+  if(len < 0 && evict_fragments(i) >= 0) {
+    len = store_fragment(i, offset);
+  }
   if(len > 0) {
     frag_info[i].reassembled_len += len;
     return i;
@@ -407,15 +558,18 @@ add_fragment(uint16_t tag, uint16_t frag_size, uint8_t offset)
 }
 /*---------------------------------------------------------------------------*/
 /* Copy all the fragments that are associated with a specific context
-   into uip */
+   into uip, then place the payload of the last fragment, which is still
+   in packetbuf, directly at its offset. */
 static bool
-copy_frags2uip(int context)
+copy_frags2uip(int context, uint8_t last_offset, const uint8_t *last_data,
+               uint16_t last_len)
 {
-  int i;
+  uint8_t link;
 
   /* Check length fields before proceeding. */
   if(frag_info[context].len < frag_info[context].first_frag_len ||
-     frag_info[context].len > sizeof(uip_buf)) {
+     frag_info[context].len > sizeof(uip_buf) ||
+     ((size_t)last_offset << 3) + last_len > sizeof(uip_buf)) {
     LOG_WARN("input: invalid total size of fragments\n");
     clear_fragments(context);
     return false;
@@ -429,18 +583,20 @@ copy_frags2uip(int context)
   memset((uint8_t *)UIP_IP_BUF + frag_info[context].first_frag_len, 0,
          frag_info[context].len - frag_info[context].first_frag_len);
 
-  for(i = 0; i < SICSLOWPAN_FRAGMENT_BUFFERS; i++) {
-    /* And also copy all matching fragments */
-    if(frag_buf[i].len > 0 && frag_buf[i].index == context) {
-      if(((size_t)frag_buf[i].offset << 3) + frag_buf[i].len > sizeof(uip_buf)) {
-        LOG_WARN("input: invalid fragment offset\n");
-        clear_fragments(context);
-        return false;
-      }
-      memcpy((uint8_t *)UIP_IP_BUF + (uint16_t)(frag_buf[i].offset << 3),
-             (uint8_t *)frag_buf[i].data, frag_buf[i].len);
+  /* And also copy all fragments stored for this context */
+  for(link = frag_info[context].bufs; link != FRAG_LINK_NONE;
+      link = frag_buf[FRAG_INDEX(link)].next) {
+    struct sicslowpan_frag_buf *buf = &frag_buf[FRAG_INDEX(link)];
+    if(((size_t)buf->offset << 3) + buf->len > sizeof(uip_buf)) {
+      LOG_WARN("input: invalid fragment offset\n");
+      clear_fragments(context);
+      return false;
     }
+    memcpy((uint8_t *)UIP_IP_BUF + (uint16_t)(buf->offset << 3),
+           buf->data, buf->len);
   }
+  memcpy((uint8_t *)UIP_IP_BUF + (uint16_t)(last_offset << 3),
+         last_data, last_len);
   /* deallocate all the fragments for this context */
   clear_fragments(context);
 
@@ -508,8 +664,78 @@ set_packet_attrs(void)
 #if SICSLOWPAN_CONF_MAX_ADDR_CONTEXTS > 0
 static struct sicslowpan_addr_context
 addr_contexts[SICSLOWPAN_CONF_MAX_ADDR_CONTEXTS];
+
+#if SICSLOWPAN_CONF_MAX_ADDR_CONTEXTS > 16
+#error IPHC supports at most 16 address contexts.
+#endif
+
+/* Number of hash buckets used to look up contexts by prefix */
+#ifdef SICSLOWPAN_CONF_ADDR_CONTEXT_HASH_SIZE
+#define SICSLOWPAN_ADDR_CONTEXT_HASH_SIZE SICSLOWPAN_CONF_ADDR_CONTEXT_HASH_SIZE
+#else
+#define SICSLOWPAN_ADDR_CONTEXT_HASH_SIZE SICSLOWPAN_CONF_MAX_ADDR_CONTEXTS
+#endif
+
+/* Contexts by prefix hash, and by number (index + 1, 0 for none) */
+static uint8_t addr_context_hash[SICSLOWPAN_ADDR_CONTEXT_HASH_SIZE];
+static uint8_t addr_context_index[16];
+
+/* Let this node (typically the border router) assign contexts to the
+   prefixes that are most often sent inline. The contexts are then
+   advertised in the 6CO option of Router Advertisements. Neighbors only
+   learn them from these RAs, so every node of the network must be built
+   with UIP_CONF_ND6_RA_6CO, and routers also with UIP_CONF_ND6_SEND_RA
+   (which is off by default with RPL) to pass the contexts on. */
+#ifdef SICSLOWPAN_CONF_CONTEXT_LEARNING
+#define SICSLOWPAN_CONTEXT_LEARNING SICSLOWPAN_CONF_CONTEXT_LEARNING
+#else
+#define SICSLOWPAN_CONTEXT_LEARNING 0
 #endif
 
+#if SICSLOWPAN_CONTEXT_LEARNING
+#if !UIP_CONF_ROUTER || !UIP_ND6_SEND_RA || !UIP_ND6_RA_6CO
+#error Context learning needs a router that sends RAs with 6CO options.
+#endif
+
+/* Number of candidate prefixes tracked */
+#ifdef SICSLOWPAN_CONF_CONTEXT_CANDIDATES
+#define SICSLOWPAN_CONTEXT_CANDIDATES SICSLOWPAN_CONF_CONTEXT_CANDIDATES
+#else
+#define SICSLOWPAN_CONTEXT_CANDIDATES 4
+#endif
+
+/* Number of inline addresses after which a prefix gets a context */
+#ifdef SICSLOWPAN_CONF_CONTEXT_LEARN_THRESHOLD
+#define SICSLOWPAN_CONTEXT_LEARN_THRESHOLD SICSLOWPAN_CONF_CONTEXT_LEARN_THRESHOLD
+#else
+#define SICSLOWPAN_CONTEXT_LEARN_THRESHOLD 16
+#endif
+
+/* Valid lifetime of learned contexts, in minutes. It is renewed as long
+   as the context is in use. */
+#ifdef SICSLOWPAN_CONF_CONTEXT_LIFETIME
+#define SICSLOWPAN_CONTEXT_LIFETIME SICSLOWPAN_CONF_CONTEXT_LIFETIME
+#else
+#define SICSLOWPAN_CONTEXT_LIFETIME 60
+#endif
+
+/* Delay, in seconds, between the first advertisement of a learned
+   context and its use for compression (RFC 6775, section 7.2) */
+#ifdef SICSLOWPAN_CONF_CONTEXT_COMPRESS_DELAY
+#define SICSLOWPAN_CONTEXT_COMPRESS_DELAY SICSLOWPAN_CONF_CONTEXT_COMPRESS_DELAY
+#else
+#define SICSLOWPAN_CONTEXT_COMPRESS_DELAY (2 * UIP_ND6_MAX_RA_INTERVAL)
+#endif
+
+struct context_candidate {
+  uint8_t prefix[8];
+  uint16_t count;
+};
+
+static struct context_candidate context_candidates[SICSLOWPAN_CONTEXT_CANDIDATES];
+#endif /* SICSLOWPAN_CONTEXT_LEARNING */
+#endif /* SICSLOWPAN_CONF_MAX_ADDR_CONTEXTS > 0 */
+
 /** pointer to the byte where to write next inline field. */
 static uint8_t *iphc_ptr;
 
@@ -547,17 +773,129 @@ static const uint8_t ttl_values[] = {0, 1, 64, 255};
 /** \name IPHC related functions
  * @{                                                                 */
 /*--------------------------------------------------------------------*/
-/** \brief find the context corresponding to prefix ipaddr */
+#if SICSLOWPAN_CONF_MAX_ADDR_CONTEXTS > 0
+static uint8_t
+addr_context_hash_bucket(const uint8_t *prefix)
+{
+  uint8_t h = 0;
+  int i;
+
+  for(i = 0; i < 8; i++) {
+    h = (h << 1 | h >> 7) ^ prefix[i];
+  }
+  return h % SICSLOWPAN_ADDR_CONTEXT_HASH_SIZE;
+}
+/*--------------------------------------------------------------------*/
+/* Rebuild the lookup tables after a context was added or removed */
+static void
+addr_context_reindex(void)
+{
+  uint8_t bucket;
+  int i;
+
+  memset(addr_context_hash, 0, sizeof(addr_context_hash));
+  memset(addr_context_index, 0, sizeof(addr_context_index));
+  for(i = 0; i < SICSLOWPAN_CONF_MAX_ADDR_CONTEXTS; i++) {
+    addr_contexts[i].hash_next = 0;
+    if(addr_contexts[i].used == 1 && addr_contexts[i].number < 16) {
+      bucket = addr_context_hash_bucket(addr_contexts[i].prefix);
+      addr_contexts[i].hash_next = addr_context_hash[bucket];
+      addr_context_hash[bucket] = i + 1;
+      addr_context_index[addr_contexts[i].number] = i + 1;
+    }
+  }
+}
+/*--------------------------------------------------------------------*/
+static void
+addr_context_log(const struct sicslowpan_addr_context *context)
+{
+  uip_ipaddr_t prefix;
+
+  memset(&prefix, 0, sizeof(prefix));
+  memcpy(&prefix, context->prefix, sizeof(context->prefix));
+  LOG_INFO_6ADDR(&prefix);
+  LOG_INFO_("/%u", context->length);
+}
+/*--------------------------------------------------------------------*/
+static int
+addr_context_expired(const struct sicslowpan_addr_context *context)
+{
+  return context->valid_until != 0 &&
+    (long)(clock_seconds() - context->valid_until) >= 0;
+}
+/*--------------------------------------------------------------------*/
+/* Check if a context covers the 64-bit prefix of an address. The first
+   length bits must match the context. IPHC sets the remaining bits of
+   the prefix to zero (RFC 6282, section 3.1.1), so the address must
+   have zeros there. */
+static int
+addr_context_match(const struct sicslowpan_addr_context *context,
+                   const uint8_t *prefix)
+{
+  uint8_t bytes = (context->length + 7) / 8;
+  int i;
+
+  /* The context prefix is stored with zeros after its length. */
+  if(memcmp(context->prefix, prefix, bytes) != 0) {
+    return 0;
+  }
+  for(i = bytes; i < 8; i++) {
+    if(prefix[i] != 0) {
+      return 0;
+    }
+  }
+  return 1;
+}
+#if SICSLOWPAN_CONTEXT_LEARNING
+/*--------------------------------------------------------------------*/
+/* Find the context that covers a prefix, whether it is used for
+   compression or not */
+static struct sicslowpan_addr_context *
+addr_context_find(const uint8_t *prefix)
+{
+  uint8_t link;
+
+  for(link = addr_context_hash[addr_context_hash_bucket(prefix)];
+      link != 0; link = addr_contexts[link - 1].hash_next) {
+    if(addr_context_match(&addr_contexts[link - 1], prefix)) {
+      return &addr_contexts[link - 1];
+    }
+  }
+  return NULL;
+}
+#endif /* SICSLOWPAN_CONTEXT_LEARNING */
+#endif /* SICSLOWPAN_CONF_MAX_ADDR_CONTEXTS > 0 */
+/*--------------------------------------------------------------------*/
+/** \brief find the context to compress the prefix of ipaddr with */
 static struct sicslowpan_addr_context*
 addr_context_lookup_by_prefix(uip_ipaddr_t *ipaddr)
 {
 /* Remove code to avoid warnings and save flash if no context is used */
 #if SICSLOWPAN_CONF_MAX_ADDR_CONTEXTS > 0
-  int i;
-  for(i = 0; i < SICSLOWPAN_CONF_MAX_ADDR_CONTEXTS; i++) {
-    if((addr_contexts[i].used == 1) &&
-       uip_ipaddr_prefixcmp(&addr_contexts[i].prefix, ipaddr, 64)) {
-      return &addr_contexts[i];
+  struct sicslowpan_addr_context *context;
+  uint8_t link;
+
+  for(link = addr_context_hash[addr_context_hash_bucket(ipaddr->u8)];
+      link != 0; link = context->hash_next) {
+    context = &addr_contexts[link - 1];
+    if(!addr_context_match(context, ipaddr->u8)) {
+      continue;
+    }
+#if SICSLOWPAN_CONTEXT_LEARNING
+    if(context->learned) {
+      /* Keep the context alive for as long as it is in use */
+      if(!context->compress &&
+         (long)(clock_seconds() - context->compress_from) >= 0) {
+        context->compress = 1;
+      }
+      if(context->compress) {
+        context->valid_until = clock_seconds() + SICSLOWPAN_CONTEXT_LIFETIME * 60UL;
+      }
+    }
+#endif /* SICSLOWPAN_CONTEXT_LEARNING */
+    /* Contexts past their valid lifetime are kept for uncompression only */
+    if(context->compress && !addr_context_expired(context)) {
+      return context;
     }
   }
 #endif /* SICSLOWPAN_CONF_MAX_ADDR_CONTEXTS > 0 */
@@ -570,16 +908,105 @@ addr_context_lookup_by_number(uint8_t number)
 {
 /* Remove code to avoid warnings and save flash if no context is used */
 #if SICSLOWPAN_CONF_MAX_ADDR_CONTEXTS > 0
+  if(number < 16 && addr_context_index[number] != 0) {
+    return &addr_contexts[addr_context_index[number] - 1];
+  }
+#endif /* SICSLOWPAN_CONF_MAX_ADDR_CONTEXTS > 0 */
+  return NULL;
+}
+/*--------------------------------------------------------------------*/
+#if SICSLOWPAN_CONTEXT_LEARNING && SICSLOWPAN_CONF_MAX_ADDR_CONTEXTS > 0
+/* Assign a context to the prefix of a candidate */
+static void
+context_assign(const struct context_candidate *candidate)
+{
+  struct sicslowpan_addr_context *context = NULL;
+  uint8_t number;
   int i;
+
+  /* Take a free slot, or else a context that has expired */
   for(i = 0; i < SICSLOWPAN_CONF_MAX_ADDR_CONTEXTS; i++) {
-    if((addr_contexts[i].used == 1) &&
-       addr_contexts[i].number == number) {
-      return &addr_contexts[i];
+    if(addr_contexts[i].used != 1) {
+      context = &addr_contexts[i];
+      break;
+    }
+    if(context == NULL && addr_context_expired(&addr_contexts[i])) {
+      context = &addr_contexts[i];
     }
   }
-#endif /* SICSLOWPAN_CONF_MAX_ADDR_CONTEXTS > 0 */
-  return NULL;
+  if(context == NULL) {
+    return;
+  }
+
+  if(context->used == 1) {
+    number = context->number;
+  } else {
+    /* Lowest free number. Number 0 is the default context. */
+    for(number = 1; number < 16; number++) {
+      if(addr_context_index[number] == 0) {
+        break;
+      }
+    }
+    if(number == 16) {
+      return;
+    }
+  }
+
+  memset(context, 0, sizeof(*context));
+  context->used = 1;
+  context->number = number;
+  memcpy(context->prefix, candidate->prefix, 8);
+  context->length = 64;
+  context->learned = 1;
+  context->valid_until = clock_seconds() + SICSLOWPAN_CONTEXT_LIFETIME * 60UL;
+  context->compress_from = clock_seconds() + SICSLOWPAN_CONTEXT_COMPRESS_DELAY;
+  addr_context_reindex();
+
+  LOG_INFO("context: assigned context %u to ", number);
+  addr_context_log(context);
+  LOG_INFO_("\n");
+}
+/*--------------------------------------------------------------------*/
+/* Count an address whose prefix had to be sent inline. The most
+   frequent prefixes are tracked with the Space-Saving algorithm. */
+static void
+context_learn(uip_ipaddr_t *ipaddr)
+{
+  struct context_candidate *candidate = NULL;
+  int i;
+
+  if(uip_is_addr_unspecified(ipaddr) || uip_is_addr_linklocal(ipaddr) ||
+     uip_is_addr_mcast(ipaddr) || uip_is_addr_loopback(ipaddr)) {
+    return;
+  }
+
+  for(i = 0; i < SICSLOWPAN_CONTEXT_CANDIDATES; i++) {
+    if(memcmp(context_candidates[i].prefix, ipaddr->u8, 8) == 0) {
+      candidate = &context_candidates[i];
+      break;
+    }
+    if(candidate == NULL ||
+       context_candidates[i].count < candidate->count) {
+      candidate = &context_candidates[i];
+    }
+  }
+
+  if(memcmp(candidate->prefix, ipaddr->u8, 8) != 0) {
+    /* Replace the least frequent candidate */
+    memcpy(candidate->prefix, ipaddr->u8, 8);
+  }
+  if(candidate->count < 0xffff) {
+    candidate->count++;
+  }
+
+  if(candidate->count >= SICSLOWPAN_CONTEXT_LEARN_THRESHOLD) {
+    if(addr_context_find(ipaddr->u8) == NULL) {
+      context_assign(candidate);
+    }
+    candidate->count = 0;
+  }
 }
+#endif /* SICSLOWPAN_CONTEXT_LEARNING && SICSLOWPAN_CONF_MAX_ADDR_CONTEXTS > 0 */
 /*--------------------------------------------------------------------*/
 static uint8_t
 compress_addr_64(uint8_t bitpos, uip_ipaddr_t *ipaddr,
@@ -739,6 +1166,14 @@ compress_hdr_iphc(void)
       addr_context_lookup_by_prefix(&UIP_IP_BUF->srcipaddr);
   struct sicslowpan_addr_context *destination_context =
       addr_context_lookup_by_prefix(&UIP_IP_BUF->destipaddr);
+#if SICSLOWPAN_CONTEXT_LEARNING && SICSLOWPAN_CONF_MAX_ADDR_CONTEXTS > 0
+  if(source_context == NULL) {
+    context_learn(&UIP_IP_BUF->srcipaddr);
+  }
+  if(destination_context == NULL) {
+    context_learn(&UIP_IP_BUF->destipaddr);
+  }
+#endif /* SICSLOWPAN_CONTEXT_LEARNING && SICSLOWPAN_CONF_MAX_ADDR_CONTEXTS > 0 */
   if(source_context || destination_context) {
     /* set context flag and increase iphc_ptr */
     LOG_DBG("compression: dest or src ipaddr - setting CID\n");
@@ -1257,6 +1692,15 @@ uncompress_hdr_iphc(uint8_t *buf, uint16_t buf_size, uint16_t ip_len)
       }
     }
   }
+#if SICSLOWPAN_CONTEXT_LEARNING && SICSLOWPAN_CONF_MAX_ADDR_CONTEXTS > 0
+  /* Prefixes sent inline are candidates for a context */
+  if((iphc1 & SICSLOWPAN_IPHC_SAC) == 0) {
+    context_learn(&SICSLOWPAN_IP_BUF(buf)->srcipaddr);
+  }
+  if((iphc1 & (SICSLOWPAN_IPHC_M | SICSLOWPAN_IPHC_DAC)) == 0) {
+    context_learn(&SICSLOWPAN_IP_BUF(buf)->destipaddr);
+  }
+#endif /* SICSLOWPAN_CONTEXT_LEARNING && SICSLOWPAN_CONF_MAX_ADDR_CONTEXTS > 0 */
   uncomp_hdr_len += UIP_IPH_LEN;
 
   /* Next header processing - continued */
@@ -1837,6 +2281,271 @@ output(const linkaddr_t *localdest)
   return 1;
 }
 
+#if SICSLOWPAN_CONF_FRAG && SICSLOWPAN_FRAG_FORWARDING
+/*--------------------------------------------------------------------*/
+/* Virtual reassembly buffer: where to relay the fragments of a packet */
+struct sicslowpan_vrb {
+  /** Previous hop and tag of the incoming fragments */
+  linkaddr_t sender;
+  uint16_t tag;
+  /** Next hop and tag of the outgoing fragments */
+  linkaddr_t nexthop;
+  uint16_t out_tag;
+  /** Datagram size (0 if the entry is unused) */
+  uint16_t size;
+  /** Number of bytes of the datagram relayed so far */
+  uint16_t forwarded;
+  struct timer timer;
+};
+
+static struct sicslowpan_vrb vrb_table[SICSLOWPAN_VRB_ENTRIES];
+/*--------------------------------------------------------------------*/
+static struct sicslowpan_vrb *
+vrb_lookup(uint16_t tag, const linkaddr_t *sender)
+{
+  int i;
+
+  for(i = 0; i < SICSLOWPAN_VRB_ENTRIES; i++) {
+    if(vrb_table[i].size > 0 && timer_expired(&vrb_table[i].timer)) {
+      vrb_table[i].size = 0;
+    }
+    if(vrb_table[i].size > 0 && vrb_table[i].tag == tag &&
+       linkaddr_cmp(&vrb_table[i].sender, sender)) {
+      return &vrb_table[i];
+    }
+  }
+  return NULL;
+}
+/*--------------------------------------------------------------------*/
+static struct sicslowpan_vrb *
+vrb_alloc(void)
+{
+  int i;
+
+  for(i = 0; i < SICSLOWPAN_VRB_ENTRIES; i++) {
+    if(vrb_table[i].size == 0 || timer_expired(&vrb_table[i].timer)) {
+      return &vrb_table[i];
+    }
+  }
+  return NULL;
+}
+/*--------------------------------------------------------------------*/
+/* Find the link-layer next hop of the packet in uip_buf, the same way
+   as tcpip does for packets without a source routing header. */
+static const linkaddr_t *
+vrb_nexthop(void)
+{
+  const uip_ipaddr_t *nexthop;
+  uip_ds6_route_t *route;
+
+  if(uip_ds6_is_addr_onlink(&UIP_IP_BUF->destipaddr)) {
+    nexthop = &UIP_IP_BUF->destipaddr;
+  } else if((route = uip_ds6_route_lookup(&UIP_IP_BUF->destipaddr)) != NULL) {
+    nexthop = uip_ds6_route_nexthop(route);
+  } else {
+    nexthop = uip_ds6_defrt_choose();
+  }
+
+  if(nexthop == NULL) {
+    return NULL;
+  }
+  return (const linkaddr_t *)uip_ds6_nbr_lladdr_from_ipaddr(nexthop);
+}
+/*--------------------------------------------------------------------*/
+/**
+ * \brief Relay the first fragment of a packet that is not for us
+ * \param context The reassembly context holding the uncompressed fragment
+ * \param tag The tag of the incoming fragments
+ * \param size The datagram size of the packet
+ * \return 1 if the fragment was relayed, 0 if the packet has to be
+ *         reassembled locally
+ *
+ * The first fragment is recompressed for the next hop with a decremented
+ * hop limit, and a virtual reassembly buffer is created so that the
+ * following fragments are relayed as soon as they arrive.
+ */
+static int
+vrb_forward_first(int8_t context, uint16_t tag, uint16_t size)
+{
+  struct sicslowpan_frag_info *info = &frag_info[context];
+  struct sicslowpan_vrb *vrb;
+  const linkaddr_t *nexthop;
+  int payload_len;
+#if LLSEC802154_USES_AUX_HEADER
+  uint8_t security_level = packetbuf_attr(PACKETBUF_ATTR_SECURITY_LEVEL);
+#endif /* LLSEC802154_USES_AUX_HEADER */
+
+  /* Fragments received ahead of the first one are already stored, and
+     the root is the end of the route anyway */
+  if(NETSTACK_ROUTING.node_is_root() ||
+     info->bufs != FRAG_LINK_NONE ||
+     info->first_frag_len < UIP_IPH_LEN ||
+     info->first_frag_len > size ||
+     info->first_frag_len > sizeof(uip_buf)) {
+    return 0;
+  }
+
+  /* uip_buf is unused while we are in the middle of a reassembly */
+  memcpy(UIP_IP_BUF, info->first_frag, info->first_frag_len);
+
+  if(uip_is_addr_mcast(&UIP_IP_BUF->destipaddr) ||
+     uip_ds6_is_my_addr(&UIP_IP_BUF->destipaddr) ||
+     uip_ds6_is_my_aaddr(&UIP_IP_BUF->destipaddr) ||
+     UIP_IP_BUF->ttl <= 1) {
+    return 0;
+  }
+
+  /* Packets with extension headers go through the IP layer: a RPL
+     hop-by-hop option has to be checked and updated by every router,
+     and a source routing header selects the next hop, neither of which
+     can be done on the first fragment alone. */
+  if(UIP_IP_BUF->proto != UIP_PROTO_UDP &&
+     UIP_IP_BUF->proto != UIP_PROTO_TCP &&
+     UIP_IP_BUF->proto != UIP_PROTO_ICMP6) {
+    return 0;
+  }
+
+  nexthop = vrb_nexthop();
+  vrb = vrb_alloc();
+  if(nexthop == NULL || vrb == NULL) {
+    return 0;
+  }
+
+  UIP_IP_BUF->ttl--;
+
+  /* Build the outgoing first fragment, as output() does */
+  uncomp_hdr_len = 0;
+  packetbuf_hdr_len = 0;
+  packetbuf_clear();
+  packetbuf_ptr = packetbuf_dataptr();
+  packetbuf_set_addr(PACKETBUF_ADDR_RECEIVER, nexthop);
+#if LLSEC802154_USES_AUX_HEADER
+  packetbuf_set_attr(PACKETBUF_ATTR_SECURITY_LEVEL, security_level);
+#endif /* LLSEC802154_USES_AUX_HEADER */
+
+  mac_max_payload = NETSTACK_MAC.max_payload();
+  if(mac_max_payload <= 0) {
+    return 0;
+  }
+#if SICSLOWPAN_COMPRESSION == SICSLOWPAN_COMPRESSION_IPV6
+  compress_hdr_ipv6();
+#endif /* SICSLOWPAN_COMPRESSION == SICSLOWPAN_COMPRESSION_IPV6 */
+#if SICSLOWPAN_COMPRESSION == SICSLOWPAN_COMPRESSION_6LORH
+  if(!uip_is_addr_linklocal(&UIP_IP_BUF->destipaddr)) {
+    add_paging_dispatch(1);
+    add_6lorh_hdr();
+  }
+#endif /* SICSLOWPAN_COMPRESSION == SICSLOWPAN_COMPRESSION_6LORH */
+#if SICSLOWPAN_COMPRESSION >= SICSLOWPAN_COMPRESSION_IPHC
+  if(compress_hdr_iphc() == 0) {
+    return 0;
+  }
+#endif /* SICSLOWPAN_COMPRESSION >= SICSLOWPAN_COMPRESSION_IPHC */
+
+  /* The fragment keeps its payload, so the offsets of the following
+     fragments remain valid. */
+  payload_len = info->first_frag_len - uncomp_hdr_len;
+  if(payload_len < 0 ||
+     packetbuf_hdr_len + SICSLOWPAN_FRAG1_HDR_LEN + payload_len > mac_max_payload) {
+    LOG_WARN("forward: first fragment does not fit, reassembling (tag %d)\n",
+             tag);
+    return 0;
+  }
+
+  memmove(packetbuf_ptr + SICSLOWPAN_FRAG1_HDR_LEN, packetbuf_ptr, packetbuf_hdr_len);
+  packetbuf_hdr_len += SICSLOWPAN_FRAG1_HDR_LEN;
+  SET16(PACKETBUF_FRAG_PTR, PACKETBUF_FRAG_DISPATCH_SIZE,
+        ((SICSLOWPAN_DISPATCH_FRAG1 << 8) | size));
+  SET16(PACKETBUF_FRAG_PTR, PACKETBUF_FRAG_TAG, my_tag);
+  memcpy(packetbuf_ptr + packetbuf_hdr_len,
+         (uint8_t *)UIP_IP_BUF + uncomp_hdr_len, payload_len);
+  packetbuf_set_datalen(packetbuf_hdr_len + payload_len);
+
+  linkaddr_copy(&vrb->sender, &info->sender);
+  vrb->tag = tag;
+  linkaddr_copy(&vrb->nexthop, nexthop);
+  vrb->out_tag = my_tag++;
+  vrb->size = size;
+  vrb->forwarded = info->first_frag_len;
+  timer_set(&vrb->timer, SICSLOWPAN_REASS_MAXAGE * CLOCK_SECOND / 16);
+
+  LOG_INFO("forward: first fragment (tag %d -> %d, len %d) to ",
+           tag, vrb->out_tag, size);
+  LOG_INFO_LLADDR(nexthop);
+  LOG_INFO_("\n");
+
+  /* Nothing is reassembled locally for this packet */
+  clear_fragments(context);
+  uipbuf_clear();
+
+  send_packet();
+  return 1;
+}
+/*--------------------------------------------------------------------*/
+/**
+ * \brief Relay a subsequent fragment through its virtual reassembly buffer
+ * \param tag The tag of the incoming fragment
+ * \return 1 if the fragment was relayed, 0 if it belongs to no VRB
+ */
+static int
+vrb_forward_fragn(uint16_t tag)
+{
+  struct sicslowpan_vrb *vrb;
+  uint16_t len;
+#if LLSEC802154_USES_AUX_HEADER
+  uint8_t security_level;
+#endif /* LLSEC802154_USES_AUX_HEADER */
+
+  vrb = vrb_lookup(tag, packetbuf_addr(PACKETBUF_ADDR_SENDER));
+  if(vrb == NULL) {
+    return 0;
+  }
+
+  len = packetbuf_datalen();
+  if(len <= SICSLOWPAN_FRAGN_HDR_LEN) {
+    /* Nothing to relay, drop it */
+    return 1;
+  }
+
+  if((GET16(PACKETBUF_FRAG_PTR, PACKETBUF_FRAG_DISPATCH_SIZE) & 0x07ff) != vrb->size ||
+     (PACKETBUF_FRAG_PTR[PACKETBUF_FRAG_OFFSET] << 3) +
+     len - SICSLOWPAN_FRAGN_HDR_LEN > vrb->size) {
+    /* The fragment does not fit in the datagram: stop relaying it */
+    LOG_WARN("forward: fragment out of bounds, dropping packet (tag %d)\n",
+             tag);
+    vrb->size = 0;
+    return 1;
+  }
+
+#if LLSEC802154_USES_AUX_HEADER
+  security_level = packetbuf_attr(PACKETBUF_ATTR_SECURITY_LEVEL);
+#endif /* LLSEC802154_USES_AUX_HEADER */
+
+  /* Reuse the fragment as is, except for the tag: move it to the start
+     of packetbuf to make room for the new MAC header. */
+  memmove(packetbuf_hdrptr(), packetbuf_dataptr(), len);
+  packetbuf_clear();
+  packetbuf_set_datalen(len);
+  packetbuf_ptr = packetbuf_dataptr();
+  SET16(PACKETBUF_FRAG_PTR, PACKETBUF_FRAG_TAG, vrb->out_tag);
+  packetbuf_set_addr(PACKETBUF_ADDR_RECEIVER, &vrb->nexthop);
+#if LLSEC802154_USES_AUX_HEADER
+  packetbuf_set_attr(PACKETBUF_ATTR_SECURITY_LEVEL, security_level);
+#endif /* LLSEC802154_USES_AUX_HEADER */
+
+  LOG_INFO("forward: fragment (tag %d -> %d, offset %d)\n",
+           tag, vrb->out_tag, PACKETBUF_FRAG_PTR[PACKETBUF_FRAG_OFFSET] << 3);
+
+  vrb->forwarded += len - SICSLOWPAN_FRAGN_HDR_LEN;
+  if(vrb->forwarded >= vrb->size) {
+    /* All of the datagram has been relayed */
+    vrb->size = 0;
+  }
+
+  send_packet();
+  return 1;
+}
+#endif /* SICSLOWPAN_CONF_FRAG && SICSLOWPAN_FRAG_FORWARDING */
 /*--------------------------------------------------------------------*/
 /** \brief Process a received 6lowpan packet.
  *
@@ -1935,8 +2644,15 @@ input(void)
       frag_size = GET16(PACKETBUF_FRAG_PTR, PACKETBUF_FRAG_DISPATCH_SIZE) & 0x07ff;
       packetbuf_hdr_len += SICSLOWPAN_FRAGN_HDR_LEN;
 
+#if SICSLOWPAN_FRAG_FORWARDING
+      /* Fragments of packets that we relay are not reassembled */
+      if(vrb_forward_fragn(frag_tag)) {
+        return;
+      }
+#endif /* SICSLOWPAN_FRAG_FORWARDING */
+
       /* Add the fragment to the fragmentation context (this will also
-         copy the payload) */
+         copy the payload, unless the fragment completes the packet) */
       frag_context = add_fragment(frag_tag, frag_size, frag_offset);
 
       if(frag_context == -1) {
@@ -2064,12 +2780,21 @@ input(void)
     if(last_fragment != 0) {
       frag_info[frag_context].reassembled_len = frag_size;
       /* copy to uip */
-      if(!copy_frags2uip(frag_context)) {
+      if(!copy_frags2uip(frag_context, frag_offset,
+                         packetbuf_ptr + packetbuf_hdr_len,
+                         packetbuf_payload_len)) {
         return;
       }
     }
   }
 
+#if SICSLOWPAN_FRAG_FORWARDING
+  if(first_fragment && !last_fragment &&
+     vrb_forward_first(frag_context, frag_tag, frag_size)) {
+    return;
+  }
+#endif /* SICSLOWPAN_FRAG_FORWARDING */
+
   /*
    * If we have a full IP packet in sicslowpan_buf, deliver it to
    * the IP stack
@@ -2123,6 +2848,90 @@ input(void)
 }
 /** @} */
 
+/*--------------------------------------------------------------------*/
+int
+sicslowpan_context_set(uint8_t number, const uint8_t *prefix,
+                       uint8_t length, uint8_t compress, uint16_t lifetime)
+{
+#if SICSLOWPAN_COMPRESSION >= SICSLOWPAN_COMPRESSION_IPHC && SICSLOWPAN_CONF_MAX_ADDR_CONTEXTS > 0
+  struct sicslowpan_addr_context *context;
+  int i;
+
+  if(number >= 16 || length > 64) {
+    return 0;
+  }
+
+  context = addr_context_lookup_by_number(number);
+  if(lifetime == 0) {
+    if(context != NULL) {
+      LOG_INFO("context: removing context %u\n", number);
+      context->used = 0;
+      addr_context_reindex();
+    }
+    return 1;
+  }
+
+  if(context == NULL) {
+    for(i = 0; i < SICSLOWPAN_CONF_MAX_ADDR_CONTEXTS; i++) {
+      if(addr_contexts[i].used != 1) {
+        context = &addr_contexts[i];
+        break;
+      }
+    }
+    if(context == NULL) {
+      LOG_WARN("context: no room for context %u\n", number);
+      return 0;
+    }
+  }
+
+  memset(context, 0, sizeof(*context));
+  context->used = 1;
+  context->number = number;
+  memcpy(context->prefix, prefix, (length + 7) / 8);
+  if(length % 8) {
+    context->prefix[length / 8] &= 0xff << (8 - length % 8);
+  }
+  context->length = length;
+  context->compress = compress;
+  if(lifetime != 0xffff) {
+    context->valid_until = clock_seconds() + lifetime * 60UL;
+  }
+  addr_context_reindex();
+
+  LOG_INFO("context: context %u set to ", number);
+  addr_context_log(context);
+  LOG_INFO_(", compress %u, lifetime %u min\n", compress, lifetime);
+  return 1;
+#else
+  return 0;
+#endif
+}
+/*--------------------------------------------------------------------*/
+const struct sicslowpan_addr_context *
+sicslowpan_context_get(uint8_t number)
+{
+#if SICSLOWPAN_COMPRESSION >= SICSLOWPAN_COMPRESSION_IPHC
+  return addr_context_lookup_by_number(number);
+#else
+  return NULL;
+#endif
+}
+/*--------------------------------------------------------------------*/
+uint16_t
+sicslowpan_context_lifetime(const struct sicslowpan_addr_context *context)
+{
+  unsigned long now;
+
+  if(context->valid_until == 0) {
+    return 0xffff;
+  }
+  now = clock_seconds();
+  if((long)(now - context->valid_until) >= 0) {
+    return 0;
+  }
+  /* Round up so that an advertised context does not expire early */
+  return MIN((context->valid_until - now + 59) / 60, 0xfffe);
+}
 /*--------------------------------------------------------------------*/
 /* \brief 6lowpan init function (called by the MAC layer)             */
 /*--------------------------------------------------------------------*/
@@ -2139,6 +2948,8 @@ sicslowpan_init(void)
 #if SICSLOWPAN_CONF_MAX_ADDR_CONTEXTS > 0
   addr_contexts[0].used   = 1;
   addr_contexts[0].number = 0;
+  addr_contexts[0].length = 64;
+  addr_contexts[0].compress = 1;
 #ifdef SICSLOWPAN_CONF_ADDR_CONTEXT_0
   SICSLOWPAN_CONF_ADDR_CONTEXT_0;
 #else
@@ -2155,11 +2966,15 @@ sicslowpan_init(void)
       if (i==1) {
         addr_contexts[1].used   = 1;
         addr_contexts[1].number = 1;
+        addr_contexts[1].length = 64;
+        addr_contexts[1].compress = 1;
         SICSLOWPAN_CONF_ADDR_CONTEXT_1;
 #ifdef SICSLOWPAN_CONF_ADDR_CONTEXT_2
       } else if (i==2) {
         addr_contexts[2].used   = 1;
         addr_contexts[2].number = 2;
+        addr_contexts[2].length = 64;
+        addr_contexts[2].compress = 1;
         SICSLOWPAN_CONF_ADDR_CONTEXT_2;
 #endif
       } else {
@@ -2172,6 +2987,10 @@ sicslowpan_init(void)
   }
 #endif /* SICSLOWPAN_CONF_MAX_ADDR_CONTEXTS > 1 */
 
+#if SICSLOWPAN_CONF_MAX_ADDR_CONTEXTS > 0
+  addr_context_reindex();
+#endif /* SICSLOWPAN_CONF_MAX_ADDR_CONTEXTS > 0 */
+
 #endif /* SICSLOWPAN_COMPRESSION == SICSLOWPAN_COMPRESSION_IPHC */
 }
 /*--------------------------------------------------------------------*/
@@ -198,6 +198,18 @@ struct sicslowpan_addr_context {
   uint8_t used; /* possibly use as prefix-length */
   uint8_t number;
   uint8_t prefix[8];
+  /** Prefix length in bits, as carried in the 6CO option */
+  uint8_t length;
+  /** Non-zero if the context may be used for compression (6CO C flag) */
+  uint8_t compress;
+  /** Non-zero if the context was assigned by this node */
+  uint8_t learned;
+  /** Next context in the same hash bucket (index + 1, 0 for none) */
+  uint8_t hash_next;
+  /** End of the valid lifetime in clock_seconds(), 0 if infinite */
+  unsigned long valid_until;
+  /** For learned contexts, when compression starts being used */
+  unsigned long compress_from;
 };
 
 /**
@@ -296,5 +308,37 @@ struct sicslowpan_nh_compressor {
 
 extern const struct network_driver sicslowpan_driver;
 
+/**
+ * \brief Install, update or remove an IPHC address context
+ * \param number The context identifier (0-15)
+ * \param prefix The context prefix, up to 8 bytes
+ * \param length The prefix length in bits (at most 64)
+ * \param compress Non-zero if the context may be used for compression
+ * \param lifetime The valid lifetime in minutes, 0 to remove the context
+ *        and 0xffff for an infinite lifetime
+ * \return 1 on success, 0 if no context could be allocated
+ *
+ * This is typically called when receiving a 6LoWPAN Context Option
+ * (RFC 6775) in a Router Advertisement.
+ */
+int sicslowpan_context_set(uint8_t number, const uint8_t *prefix,
+                           uint8_t length, uint8_t compress,
+                           uint16_t lifetime);
+
+/**
+ * \brief Get the IPHC address context with a given identifier
+ * \param number The context identifier (0-15)
+ * \return The context, or NULL if none is in use with this identifier
+ */
+const struct sicslowpan_addr_context *sicslowpan_context_get(uint8_t number);
+
+/**
+ * \brief Get the remaining valid lifetime of an address context
+ * \param context The context
+ * \return The remaining lifetime in minutes as carried in the 6CO
+ *         option: 0xffff if infinite and 0 if expired
+ */
+uint16_t sicslowpan_context_lifetime(const struct sicslowpan_addr_context *context);
+
 #endif /* SICSLOWPAN_H_ */
 /** @} */
@@ -58,6 +58,90 @@ call_event(struct tcp_socket *s, tcp_socket_event_t event)
   }
 }
 /*---------------------------------------------------------------------------*/
+/* The number of bytes queued, in the output buffer and as references */
+static uint16_t
+queuelen(struct tcp_socket *s)
+{
+#if TCP_SOCKET_MAX_REFS > 0
+  uint16_t len;
+  uint8_t i;
+
+  len = s->output_data_len;
+  for(i = 0; i < s->refs_len; i++) {
+    len += s->refs[i].len;
+  }
+  return len;
+#else
+  return s->output_data_len;
+#endif
+}
+/*---------------------------------------------------------------------------*/
+#if TCP_SOCKET_MAX_REFS > 0
+/*
+ * The output stream consists of the buffered data, with each reference
+ * inserted after the first pos bytes of it. gather() copies the first len
+ * bytes of the stream to dst, consume() drops them once acknowledged.
+ */
+static void
+gather(struct tcp_socket *s, uint8_t *dst, uint16_t len)
+{
+  uint16_t pos, n;
+  uint8_t i;
+
+  pos = 0;
+  for(i = 0; i <= s->refs_len && len > 0; i++) {
+    n = (i < s->refs_len ? s->refs[i].pos : s->output_data_len) - pos;
+    n = MIN(n, len);
+    memcpy(dst, &s->output_data_ptr[pos], n);
+    dst += n;
+    pos += n;
+    len -= n;
+    if(i < s->refs_len) {
+      n = MIN(s->refs[i].len, len);
+      memcpy(dst, s->refs[i].ptr, n);
+      dst += n;
+      len -= n;
+    }
+  }
+}
+/*---------------------------------------------------------------------------*/
+static void
+consume(struct tcp_socket *s, uint16_t len)
+{
+  uint16_t pos, n;
+  uint8_t i;
+
+  pos = 0;
+  for(i = 0; i <= s->refs_len && len > 0; i++) {
+    n = (i < s->refs_len ? s->refs[i].pos : s->output_data_len) - pos;
+    n = MIN(n, len);
+    pos += n;
+    len -= n;
+    if(i < s->refs_len) {
+      n = MIN(s->refs[i].len, len);
+      s->refs[i].ptr += n;
+      s->refs[i].len -= n;
+      len -= n;
+    }
+  }
+
+  /* Fully acknowledged references are always at the head */
+  i = 0;
+  while(i < s->refs_len && s->refs[i].len == 0) {
+    i++;
+  }
+  s->refs_len -= i;
+  memmove(&s->refs[0], &s->refs[i], s->refs_len * sizeof(s->refs[0]));
+  for(i = 0; i < s->refs_len; i++) {
+    s->refs[i].pos -= pos;
+  }
+
+  memmove(&s->output_data_ptr[0], &s->output_data_ptr[pos],
+          s->output_data_len - pos);
+  s->output_data_len -= pos;
+}
+#endif /* TCP_SOCKET_MAX_REFS > 0 */
+/*---------------------------------------------------------------------------*/
 static void
 senddata(struct tcp_socket *s)
 {
@@ -66,6 +150,17 @@ senddata(struct tcp_socket *s)
   if(s->output_senddata_len > 0) {
     len = MIN(s->output_senddata_len, len);
     s->output_data_send_nxt = len;
+#if TCP_SOCKET_MAX_REFS > 0
+    if(s->refs_len > 0) {
+      /*
+       * Gather the segment where uip_process() expects the TCP payload
+       * (uip_sappdata), so that uip_send() need not copy it again.
+       */
+      gather(s, &uip_buf[UIP_IPTCPH_LEN], len);
+      uip_send(&uip_buf[UIP_IPTCPH_LEN], len);
+      return;
+    }
+#endif
     uip_send(s->output_data_ptr, len);
   }
 }
@@ -74,17 +169,9 @@ static void
 acked(struct tcp_socket *s)
 {
   if(s->output_senddata_len > 0) {
-    /* Copy the data in the outputbuf down and update outputbufptr and
-       outputbuf_lastsent */
-
-    if(s->output_data_send_nxt > 0) {
-      memmove(&s->output_data_ptr[0],
-              &s->output_data_ptr[s->output_data_send_nxt],
-              s->output_data_maxlen - s->output_data_send_nxt);
-    }
-    if(s->output_data_len < s->output_data_send_nxt) {
-      PRINTF("tcp: acked assertion failed s->output_data_len (%d) < s->output_data_send_nxt (%d)\n",
-             s->output_data_len,
+    if(queuelen(s) < s->output_data_send_nxt) {
+      PRINTF("tcp: acked assertion failed queuelen (%d) < s->output_data_send_nxt (%d)\n",
+             queuelen(s),
              s->output_data_send_nxt);
       tcp_markconn(uip_conn, NULL);
       uip_abort();
@@ -92,8 +179,23 @@ acked(struct tcp_socket *s)
       relisten(s);
       return;
     }
-    s->output_data_len -= s->output_data_send_nxt;
-    s->output_senddata_len = s->output_data_len;
+
+#if TCP_SOCKET_MAX_REFS > 0
+    if(s->refs_len > 0) {
+      consume(s, s->output_data_send_nxt);
+    } else
+#endif
+    {
+      /* Copy the data in the outputbuf down and update outputbufptr and
+         outputbuf_lastsent */
+      if(s->output_data_send_nxt > 0) {
+        memmove(&s->output_data_ptr[0],
+                &s->output_data_ptr[s->output_data_send_nxt],
+                s->output_data_maxlen - s->output_data_send_nxt);
+      }
+      s->output_data_len -= s->output_data_send_nxt;
+    }
+    s->output_senddata_len = queuelen(s);
     s->output_data_send_nxt = 0;
 
     call_event(s, TCP_SOCKET_DATA_SENT);
@@ -218,7 +320,7 @@ appcall(void *state)
     senddata(s);
   }
 
-  if(s->output_data_len == 0 && s->flags & TCP_SOCKET_FLAGS_CLOSING) {
+  if(queuelen(s) == 0 && s->flags & TCP_SOCKET_FLAGS_CLOSING) {
     s->flags &= ~TCP_SOCKET_FLAGS_CLOSING;
     uip_close();
     s->c = NULL;
@@ -276,6 +378,9 @@ tcp_socket_register(struct tcp_socket *s, void *ptr,
   s->input_data_ptr = input_databuf;
   s->input_data_maxlen = input_databuf_len;
   s->output_data_len = 0;
+#if TCP_SOCKET_MAX_REFS > 0
+  s->refs_len = 0;
+#endif
   s->output_data_ptr = output_databuf;
   s->output_data_maxlen = output_databuf_len;
   s->input_callback = input_callback;
@@ -355,7 +460,7 @@ tcp_socket_send(struct tcp_socket *s,
   s->output_data_len += len;
 
   if(s->output_senddata_len == 0) {
-    s->output_senddata_len = s->output_data_len;
+    s->output_senddata_len = queuelen(s);
   }
 
   tcpip_poll_tcp(s->c);
@@ -364,6 +469,54 @@ tcp_socket_send(struct tcp_socket *s,
 }
 /*---------------------------------------------------------------------------*/
 int
+tcp_socket_send_ref(struct tcp_socket *s,
+                    const uint8_t *data, int datalen)
+{
+  if(s == NULL) {
+    return -1;
+  }
+
+#if TCP_SOCKET_MAX_REFS > 0
+  if(datalen <= 0 || s->refs_len == TCP_SOCKET_MAX_REFS ||
+     queuelen(s) + (uint32_t)datalen > UINT16_MAX) {
+    return 0;
+  }
+
+  s->refs[s->refs_len].ptr = data;
+  s->refs[s->refs_len].len = datalen;
+  s->refs[s->refs_len].pos = s->output_data_len;
+  s->refs_len++;
+
+  if(s->output_senddata_len == 0) {
+    s->output_senddata_len = queuelen(s);
+  }
+
+  tcpip_poll_tcp(s->c);
+
+  return datalen;
+#else /* TCP_SOCKET_MAX_REFS > 0 */
+  return 0;
+#endif /* TCP_SOCKET_MAX_REFS > 0 */
+}
+/*---------------------------------------------------------------------------*/
+int
+tcp_socket_ref_queued(struct tcp_socket *s,
+                      const uint8_t *data, int datalen)
+{
+#if TCP_SOCKET_MAX_REFS > 0
+  uint8_t i;
+
+  /* Acknowledged bytes are dropped from the start of a reference */
+  for(i = 0; i < s->refs_len; i++) {
+    if(s->refs[i].ptr >= data && s->refs[i].ptr < data + datalen) {
+      return 1;
+    }
+  }
+#endif /* TCP_SOCKET_MAX_REFS > 0 */
+  return 0;
+}
+/*---------------------------------------------------------------------------*/
+int
 tcp_socket_send_str(struct tcp_socket *s,
              const char *str)
 {
@@ -405,7 +558,7 @@ tcp_socket_max_sendlen(struct tcp_socket *s)
 int
 tcp_socket_queuelen(struct tcp_socket *s)
 {
-  return s->output_data_len;
+  return queuelen(s);
 }
 /*---------------------------------------------------------------------------*/
 #endif /* UIP_TCP */
@@ -34,6 +34,16 @@
 
 #include "uip.h"
 
+/*
+ * The number of caller-owned buffers that can be queued on a socket with
+ * tcp_socket_send_ref(), in addition to the data in its output buffer.
+ */
+#ifdef TCP_SOCKET_CONF_MAX_REFS
+#define TCP_SOCKET_MAX_REFS TCP_SOCKET_CONF_MAX_REFS
+#else
+#define TCP_SOCKET_MAX_REFS 0
+#endif
+
 struct tcp_socket;
 
 typedef enum {
@@ -80,6 +90,13 @@ typedef void (* tcp_socket_event_callback_t)(struct tcp_socket *s,
                                              void *ptr,
                                              tcp_socket_event_t event);
 
+struct tcp_socket_ref {
+  const uint8_t *ptr;
+  uint16_t len;
+  /* The number of bytes in the output buffer that precede this data */
+  uint16_t pos;
+};
+
 struct tcp_socket {
   struct tcp_socket *next;
 
@@ -100,6 +117,11 @@ struct tcp_socket {
   uint16_t output_senddata_len;
   uint16_t output_data_max_seg;
 
+#if TCP_SOCKET_MAX_REFS > 0
+  struct tcp_socket_ref refs[TCP_SOCKET_MAX_REFS];
+  uint8_t refs_len;
+#endif
+
   uint8_t flags;
   uint16_t listen_port;
   struct uip_conn *c;
@@ -229,6 +251,38 @@ int tcp_socket_send(struct tcp_socket *s,
                     const uint8_t *dataptr,
                     int datalen);
 
+/**
+ * \brief      Send caller-owned data on a connected TCP socket
+ * \param s    A pointer to a TCP socket that must have been previously registered with tcp_socket_register()
+ * \param dataptr A pointer to the data to be sent
+ * \param datalen The length of the data to be sent
+ * \retval -1  If an error occurs
+ * \return     The number of bytes that were queued: datalen or zero
+ *
+ *             This function queues data for sending without
+ *             copying it into the output buffer. The data is
+ *             instead gathered directly into outgoing segments, after
+ *             the data sent before it, so it must not be modified
+ *             until it has been acknowledged by the remote host (see
+ *             tcp_socket_ref_queued()). Zero is returned if all
+ *             TCP_SOCKET_MAX_REFS references are in use, in which case
+ *             the caller should fall back to tcp_socket_send().
+ */
+int tcp_socket_send_ref(struct tcp_socket *s,
+                        const uint8_t *dataptr,
+                        int datalen);
+
+/**
+ * \brief      Check whether caller-owned data is still queued on a socket
+ * \param s    A pointer to a TCP socket
+ * \param dataptr A pointer to data passed to tcp_socket_send_ref()
+ * \param datalen The length of the data
+ * \return     Non-zero if any part of the data has not yet been acknowledged
+ */
+int tcp_socket_ref_queued(struct tcp_socket *s,
+                          const uint8_t *dataptr,
+                          int datalen);
+
 /**
  * \brief      Send a string on a connected TCP socket
  * \param s    A pointer to a TCP socket that must have been previously registered with tcp_socket_register()
@@ -74,6 +74,9 @@
 #include "net/ipv6/uip-nd6.h"
 #include "net/ipv6/uip-ds6.h"
 #include "net/ipv6/uip-nameserver.h"
+#if UIP_ND6_RA_6CO
+#include "net/ipv6/sicslowpan.h"
+#endif /* UIP_ND6_RA_6CO */
 #include "lib/random.h"
 
 /* Log configuration */
@@ -98,6 +101,7 @@
 #define ND6_OPT_PREFIX_BUF(opt)    ((uip_nd6_opt_prefix_info *)ND6_OPT(opt))
 #define ND6_OPT_MTU_BUF(opt)               ((uip_nd6_opt_mtu *)ND6_OPT(opt))
 #define ND6_OPT_RDNSS_BUF(opt)             ((uip_nd6_opt_dns *)ND6_OPT(opt))
+#define ND6_OPT_6CO_BUF(opt)               ((uip_nd6_opt_6co *)ND6_OPT(opt))
 /** @} */
 
 #if UIP_ND6_SEND_NS || UIP_ND6_SEND_NA || UIP_ND6_SEND_RA || !UIP_CONF_ROUTER
@@ -107,9 +111,9 @@ static uip_ds6_nbr_t *nbr; /**  Pointer to a nbr cache entry*/
 static uip_ds6_addr_t *addr; /**  Pointer to an interface address */
 #endif /* UIP_ND6_SEND_NS || UIP_ND6_SEND_NA || UIP_ND6_SEND_RA || !UIP_CONF_ROUTER */
 
-#if UIP_ND6_SEND_NS || UIP_ND6_SEND_RA || !UIP_CONF_ROUTER
+#if UIP_ND6_SEND_NS || !UIP_CONF_ROUTER
 static uip_ds6_defrt_t *defrt; /**  Pointer to a router list entry */
-#endif /* UIP_ND6_SEND_NS || UIP_ND6_SEND_RA || !UIP_CONF_ROUTER */
+#endif /* UIP_ND6_SEND_NS || !UIP_CONF_ROUTER */
 
 #if !UIP_CONF_ROUTER            // TBD see if we move it to ra_input
 static uip_nd6_opt_prefix_info *nd6_opt_prefix_info; /**  Pointer to prefix information option in uip_buf */
@@ -787,6 +791,32 @@ uip_nd6_ra_output(const uip_ipaddr_t * dest)
   }
 #endif /* UIP_ND6_RA_RDNSS */
 
+#if UIP_ND6_RA_6CO
+  {
+    const struct sicslowpan_addr_context *context;
+    uint16_t lifetime;
+    uint8_t cid;
+
+    for(cid = 0; cid < 16; cid++) {
+      context = sicslowpan_context_get(cid);
+      if(context == NULL ||
+         (lifetime = sicslowpan_context_lifetime(context)) == 0) {
+        continue;
+      }
+      ND6_OPT_6CO_BUF(nd6_opt_offset)->type = UIP_ND6_OPT_6CO;
+      ND6_OPT_6CO_BUF(nd6_opt_offset)->len = UIP_ND6_OPT_6CO_LEN >> 3;
+      ND6_OPT_6CO_BUF(nd6_opt_offset)->ctxlen = context->length;
+      ND6_OPT_6CO_BUF(nd6_opt_offset)->flags_cid =
+        (context->compress ? UIP_ND6_OPT_6CO_FLAG_C : 0) | cid;
+      ND6_OPT_6CO_BUF(nd6_opt_offset)->reserved = 0;
+      ND6_OPT_6CO_BUF(nd6_opt_offset)->lifetime = uip_htons(lifetime);
+      memcpy(ND6_OPT_6CO_BUF(nd6_opt_offset)->prefix, context->prefix, 8);
+      uip_len += UIP_ND6_OPT_6CO_LEN;
+      nd6_opt_offset += UIP_ND6_OPT_6CO_LEN;
+    }
+  }
+#endif /* UIP_ND6_RA_6CO */
+
   uipbuf_set_len_field(UIP_IP_BUF, uip_len - UIP_IPH_LEN);
 
   /*ICMP checksum */
@@ -804,6 +834,72 @@ uip_nd6_ra_output(const uip_ipaddr_t * dest)
 #endif /* UIP_ND6_SEND_RA */
 #endif /* UIP_CONF_ROUTER */
 
+#if UIP_ND6_RA_6CO
+/*---------------------------------------------------------------------------*/
+/* Install the context of a 6CO option of a RA */
+static void
+ra_6co_input(uint16_t offset)
+{
+  LOG_DBG("Processing 6CO option in RA\n");
+  /* Only contexts of up to 64 bits are supported by IPHC here */
+  if(ND6_OPT_6CO_BUF(offset)->len >= UIP_ND6_OPT_6CO_LEN >> 3 &&
+     ND6_OPT_6CO_BUF(offset)->ctxlen <= 64 &&
+     uip_l3_icmp_hdr_len + offset + UIP_ND6_OPT_6CO_LEN <= uip_len) {
+    sicslowpan_context_set(ND6_OPT_6CO_BUF(offset)->flags_cid &
+                           UIP_ND6_OPT_6CO_CID_MASK,
+                           ND6_OPT_6CO_BUF(offset)->prefix,
+                           ND6_OPT_6CO_BUF(offset)->ctxlen,
+                           (ND6_OPT_6CO_BUF(offset)->flags_cid &
+                            UIP_ND6_OPT_6CO_FLAG_C) != 0,
+                           uip_ntohs(ND6_OPT_6CO_BUF(offset)->lifetime));
+  }
+}
+#if UIP_CONF_ROUTER
+/*---------------------------------------------------------------------------*/
+/**
+ * Process a Router Advertisement on a router
+ *
+ * Routers do not configure themselves from RAs, but they take the
+ * 6LoWPAN contexts from them (RFC 6775), so that the contexts of the
+ * border router reach every node of a mesh.
+ */
+static void
+ra_router_input(void)
+{
+  uint16_t offset;
+
+  LOG_INFO("Received RA from ");
+  LOG_INFO_6ADDR(&UIP_IP_BUF->srcipaddr);
+  LOG_INFO_(" on a router\n");
+  UIP_STAT(++uip_stat.nd6.recv);
+
+#if UIP_CONF_IPV6_CHECKS
+  if((UIP_IP_BUF->ttl != UIP_ND6_HOP_LIMIT) ||
+     (!uip_is_addr_linklocal(&UIP_IP_BUF->srcipaddr)) ||
+     (UIP_ICMP_BUF->icode != 0)) {
+    LOG_ERR("RA received is bad");
+    goto discard;
+  }
+#endif /*UIP_CONF_IPV6_CHECKS */
+
+  offset = UIP_ND6_RA_LEN;
+  while(uip_l3_icmp_hdr_len + offset < uip_len) {
+    if(ND6_OPT_HDR_BUF(offset)->len == 0) {
+      LOG_ERR("RA received is bad");
+      goto discard;
+    }
+    if(ND6_OPT_HDR_BUF(offset)->type == UIP_ND6_OPT_6CO) {
+      ra_6co_input(offset);
+    }
+    offset += ND6_OPT_HDR_BUF(offset)->len << 3;
+  }
+
+discard:
+  uipbuf_clear();
+}
+#endif /* UIP_CONF_ROUTER */
+#endif /* UIP_ND6_RA_6CO */
+
 #if !UIP_CONF_ROUTER
 /*---------------------------------------------------------------------------*/
 void
@@ -1034,6 +1130,11 @@ ra_input(void)
       }
       break;
 #endif /* UIP_ND6_RA_RDNSS */
+#if UIP_ND6_RA_6CO
+    case UIP_ND6_OPT_6CO:
+      ra_6co_input(nd6_opt_offset);
+      break;
+#endif /* UIP_ND6_RA_6CO */
     default:
       LOG_ERR("ND option not supported in RA\n");
       break;
@@ -1102,6 +1203,9 @@ UIP_ICMP6_HANDLER(rs_input_handler, ICMP6_RS, UIP_ICMP6_HANDLER_CODE_ANY,
 #if !UIP_CONF_ROUTER
 UIP_ICMP6_HANDLER(ra_input_handler, ICMP6_RA, UIP_ICMP6_HANDLER_CODE_ANY,
                   ra_input);
+#elif UIP_ND6_RA_6CO
+UIP_ICMP6_HANDLER(ra_input_handler, ICMP6_RA, UIP_ICMP6_HANDLER_CODE_ANY,
+                  ra_router_input);
 #endif
 /*---------------------------------------------------------------------------*/
 void
@@ -1123,8 +1227,9 @@ uip_nd6_init()
   uip_icmp6_register_input_handler(&rs_input_handler);
 #endif
 
-#if !UIP_CONF_ROUTER
-  /* Only process RAs if we are not a router */
+#if !UIP_CONF_ROUTER || UIP_ND6_RA_6CO
+  /* Only process RAs if we are not a router, or for their 6LoWPAN
+     contexts */
   uip_icmp6_register_input_handler(&ra_input_handler);
 #endif
 }
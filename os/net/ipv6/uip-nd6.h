@@ -190,6 +190,18 @@ be added regardless of their reachability and liveness.  */
 #endif
 /** @} */
 
+/** \name RFC 6775 6LoWPAN Context Option Constants  */
+/** @{ */
+#ifndef UIP_CONF_ND6_RA_6CO
+#define UIP_ND6_RA_6CO                  0
+#else
+#define UIP_ND6_RA_6CO                  UIP_CONF_ND6_RA_6CO
+#endif
+
+#define UIP_ND6_OPT_6CO_FLAG_C          0x10
+#define UIP_ND6_OPT_6CO_CID_MASK        0x0f
+/** @} */
+
 
 /** \name ND6 option types */
 /** @{ */
@@ -200,6 +212,7 @@ be added regardless of their reachability and liveness.  */
 #define UIP_ND6_OPT_MTU                 5
 #define UIP_ND6_OPT_RDNSS               25
 #define UIP_ND6_OPT_DNSSL               31
+#define UIP_ND6_OPT_6CO                 34
 /** @} */
 
 /** \name ND6 option types */
@@ -224,6 +237,7 @@ be added regardless of their reachability and liveness.  */
 #define UIP_ND6_OPT_MTU_LEN            8
 #define UIP_ND6_OPT_RDNSS_LEN          1
 #define UIP_ND6_OPT_DNSSL_LEN          1
+#define UIP_ND6_OPT_6CO_LEN            16
 
 
 /* Length of TLLAO and SLLAO options, it is L2 dependant */
@@ -355,6 +369,17 @@ typedef struct uip_nd6_opt_dns {
   uip_ipaddr_t ip;
 } uip_nd6_opt_dns;
 
+/** \brief ND option 6LoWPAN Context (RFC 6775), for prefixes up to 64 bits */
+typedef struct uip_nd6_opt_6co {
+  uint8_t type;
+  uint8_t len;
+  uint8_t ctxlen;
+  uint8_t flags_cid;
+  uint16_t reserved;
+  uint16_t lifetime;
+  uint8_t prefix[8];
+} uip_nd6_opt_6co;
+
 /** \struct Redirected header option */
 typedef struct uip_nd6_opt_redirected_hdr {
   uint8_t type;
@@ -47,6 +47,28 @@ void framer_802154_setup_params(packetbuf_attr_t (*get_attr)(uint8_t type),
                                 uint8_t dest_is_broadcast,
                                 frame802154_t *params);
 
+/**
+ * \brief Get the parsed header of the 802.15.4 frame held in packetbuf
+ * \return The frame descriptor filled in by framer_802154.parse(), or NULL
+ *         if packetbuf no longer holds a parsed frame
+ *
+ * The descriptor is parsed once per received frame and shared by all
+ * layers above the framer, so that they do not need to parse the header
+ * again. Its payload pointer refers to packetbuf itself.
+ */
+const frame802154_t *framer_802154_get_rx_frame(void);
+
+/**
+ * \brief Hand over a frame that the MAC layer already parsed
+ * \param frame The parsed frame, as returned by frame802154_parse()
+ * \param hdr_len The header length returned by frame802154_parse()
+ *
+ * Must be called right after the same frame was copied into packetbuf.
+ * The next framer_802154.parse() will then reuse the descriptor instead
+ * of parsing the header a second time.
+ */
+void framer_802154_set_rx_frame(const frame802154_t *frame, int hdr_len);
+
 extern const struct framer framer_802154;
 
 #endif /* FRAMER_802154_H_ */
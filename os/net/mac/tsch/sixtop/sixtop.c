@@ -45,6 +45,7 @@
 #include "net/packetbuf.h"
 #include "net/mac/framer/frame802154.h"
 #include "net/mac/framer/frame802154e-ie.h"
+#include "net/mac/framer/framer-802154.h"
 
 #include "sixtop.h"
 #include "sixtop-conf.h"
@@ -206,7 +207,8 @@ sixtop_input(void)
   uint8_t *hdr_ptr, *payload_ptr;
   uint16_t hdr_len, payload_len;
 
-  frame802154_t frame;
+  frame802154_t parsed_frame;
+  const frame802154_t *frame;
   struct ieee802154_ies ies;
   linkaddr_t src_addr;
 
@@ -224,10 +226,15 @@ sixtop_input(void)
 
   memcpy(&src_addr, packetbuf_addr(PACKETBUF_ADDR_SENDER), sizeof(src_addr));
 
-  if(frame802154_parse(hdr_ptr, hdr_len, &frame) == 0) {
-    /* parse error; should not occur, anyway */
-    LOG_ERR("6top: frame802154_parse error\n");
-    return;
+  /* Reuse the header parsed by the framer when it is still available */
+  frame = framer_802154_get_rx_frame();
+  if(frame == NULL) {
+    if(frame802154_parse(hdr_ptr, hdr_len, &parsed_frame) == 0) {
+      /* parse error; should not occur, anyway */
+      LOG_ERR("6top: frame802154_parse error\n");
+      return;
+    }
+    frame = &parsed_frame;
   }
 
   /*
@@ -235,10 +242,10 @@ sixtop_input(void)
    * is turned out to be 0b10 automatically if the frame has a IE list. The
    * frame type is supposed to be DATA as mentioned above.
    */
-  assert(frame.fcf.frame_version == FRAME802154_IEEE802154_2015);
-  assert(frame.fcf.frame_type == FRAME802154_DATAFRAME);
+  assert(frame->fcf.frame_version == FRAME802154_IEEE802154_2015);
+  assert(frame->fcf.frame_type == FRAME802154_DATAFRAME);
   memset(&ies, 0, sizeof(ies));
-  if(frame.fcf.ie_list_present &&
+  if(frame->fcf.ie_list_present &&
      frame802154e_parse_information_elements(payload_ptr,
                                              payload_len, &ies) >= 0 &&
      ies.sixtop_ie_content_ptr != NULL &&
@@ -499,7 +499,7 @@ tsch_rx_process_pending()
   while((input_index = ringbufindex_peek_get(&input_ringbuf)) != -1) {
     struct input_packet *current_input = &input_array[input_index];
     frame802154_t frame;
-    uint8_t ret = frame802154_parse(current_input->payload, current_input->len, &frame);
+    int ret = frame802154_parse(current_input->payload, current_input->len, &frame);
     int is_data = ret && frame.fcf.frame_type == FRAME802154_DATAFRAME;
     int is_eb = ret
       && frame.fcf.frame_version == FRAME802154_IEEE802154_2015
@@ -508,6 +508,7 @@ tsch_rx_process_pending()
     if(is_data) {
       /* Copy payload to packetbuf for processing */
       packetbuf_copyfrom(current_input->payload, current_input->len);
+      framer_802154_set_rx_frame(&frame, ret);
       packetbuf_set_attr(PACKETBUF_ATTR_RSSI, current_input->rssi);
       packetbuf_set_attr(PACKETBUF_ATTR_CHANNEL, current_input->channel);
 
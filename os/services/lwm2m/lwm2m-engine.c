@@ -47,6 +47,7 @@
 #include "lwm2m-device.h"
 #include "lwm2m-plain-text.h"
 #include "lwm2m-json.h"
+#include "lwm2m-senml-cbor.h"
 #include "coap-constants.h"
 #include "coap-engine.h"
 #include "lwm2m-tlv.h"
@@ -80,6 +81,26 @@
 #define USE_RD_CLIENT 1
 #endif /* LWM2M_ENGINE_CONF_USE_RD_CLIENT */
 
+/*
+ * Number of entries in the sorted object/instance index. Each simple
+ * object instance and each generic object takes one entry. When more
+ * are registered the engine falls back to walking the object lists.
+ */
+#ifdef LWM2M_ENGINE_CONF_INDEX_SIZE
+#define LWM2M_ENGINE_INDEX_SIZE LWM2M_ENGINE_CONF_INDEX_SIZE
+#else
+#define LWM2M_ENGINE_INDEX_SIZE 16
+#endif /* LWM2M_ENGINE_CONF_INDEX_SIZE */
+
+/*
+ * Size of the cached registration (link-format) text for the simple
+ * object instances. Set to 0 to always generate the text.
+ */
+#ifdef LWM2M_ENGINE_CONF_RD_CACHE_SIZE
+#define LWM2M_ENGINE_RD_CACHE_SIZE LWM2M_ENGINE_CONF_RD_CACHE_SIZE
+#else
+#define LWM2M_ENGINE_RD_CACHE_SIZE 128
+#endif /* LWM2M_ENGINE_CONF_RD_CACHE_SIZE */
 
 #if LWM2M_QUEUE_MODE_ENABLED
  /* Queue Mode is handled using the RD Client and the Q-Mode object */
@@ -147,11 +168,202 @@ COAP_HANDLER(lwm2m_handler, lwm2m_handler_callback);
 LIST(object_list);
 LIST(generic_object_list);
 
+/*
+ * Index of all registered simple object instances and generic objects,
+ * sorted by object id and instance id. Generic objects use instance id
+ * LWM2M_OBJECT_INSTANCE_NONE. The index is rebuilt on the first lookup
+ * after an object has been added or removed.
+ */
+typedef struct {
+  uint16_t object_id;
+  uint16_t instance_id;
+  lwm2m_object_instance_t *instance;
+  lwm2m_object_t *object;
+} index_entry_t;
+
+static index_entry_t object_index[LWM2M_ENGINE_INDEX_SIZE];
+static uint16_t object_index_len;
+static uint8_t object_index_dirty = 1;
+static uint8_t object_index_valid;
+
+#if LWM2M_ENGINE_RD_CACHE_SIZE > 0
+/* Registration text for the simple object instances */
+static char rd_cache[LWM2M_ENGINE_RD_CACHE_SIZE];
+static uint16_t rd_cache_len;
+static uint16_t rd_cache_pos;
+static uint8_t rd_cache_valid;
+#define RD_CACHE_PENDING() (rd_cache_valid && rd_cache_pos < rd_cache_len)
+#else /* LWM2M_ENGINE_RD_CACHE_SIZE > 0 */
+#define RD_CACHE_PENDING() 0
+#endif /* LWM2M_ENGINE_RD_CACHE_SIZE > 0 */
+
+/*---------------------------------------------------------------------------*/
+static void
+index_invalidate(void)
+{
+  object_index_dirty = 1;
+#if LWM2M_ENGINE_RD_CACHE_SIZE > 0
+  rd_cache_valid = 0;
+#endif /* LWM2M_ENGINE_RD_CACHE_SIZE > 0 */
+}
+/*---------------------------------------------------------------------------*/
+static int
+index_compare(uint16_t object_id, uint16_t instance_id,
+              const index_entry_t *entry)
+{
+  if(object_id != entry->object_id) {
+    return object_id < entry->object_id ? -1 : 1;
+  }
+  if(instance_id != entry->instance_id) {
+    return instance_id < entry->instance_id ? -1 : 1;
+  }
+  return 0;
+}
+/*---------------------------------------------------------------------------*/
+static int
+index_insert(uint16_t object_id, uint16_t instance_id,
+             lwm2m_object_instance_t *instance, lwm2m_object_t *object)
+{
+  int i;
+
+  if(object_index_len >= LWM2M_ENGINE_INDEX_SIZE) {
+    return 0;
+  }
+
+  /* Insertion sort - the index is small and rebuilt only on changes */
+  for(i = object_index_len;
+      i > 0 && index_compare(object_id, instance_id, &object_index[i - 1]) < 0;
+      i--) {
+    object_index[i] = object_index[i - 1];
+  }
+  object_index[i].object_id = object_id;
+  object_index[i].instance_id = instance_id;
+  object_index[i].instance = instance;
+  object_index[i].object = object;
+  object_index_len++;
+  return 1;
+}
+/*---------------------------------------------------------------------------*/
+/* Returns non-zero if the index is up to date and can be used */
+static int
+index_update(void)
+{
+  lwm2m_object_instance_t *instance;
+  lwm2m_object_t *object;
+
+  if(!object_index_dirty) {
+    return object_index_valid;
+  }
+
+  object_index_dirty = 0;
+  object_index_valid = 0;
+  object_index_len = 0;
+
+  for(instance = list_head(object_list);
+      instance != NULL;
+      instance = instance->next) {
+    if(!index_insert(instance->object_id, instance->instance_id,
+                     instance, NULL)) {
+      LOG_DBG("object index full - using object lists\n");
+      return 0;
+    }
+  }
+  for(object = list_head(generic_object_list);
+      object != NULL;
+      object = object->next) {
+    if(object->impl != NULL &&
+       !index_insert(object->impl->object_id, LWM2M_OBJECT_INSTANCE_NONE,
+                     NULL, object)) {
+      LOG_DBG("object index full - using object lists\n");
+      return 0;
+    }
+  }
+
+  object_index_valid = 1;
+  return 1;
+}
+/*---------------------------------------------------------------------------*/
+/* Returns the position of the first entry not less than the given key */
+static int
+index_lower_bound(uint16_t object_id, uint16_t instance_id)
+{
+  int low = 0;
+  int high = object_index_len;
+  int mid;
+
+  while(low < high) {
+    mid = (low + high) / 2;
+    if(index_compare(object_id, instance_id, &object_index[mid]) > 0) {
+      low = mid + 1;
+    } else {
+      high = mid;
+    }
+  }
+  return low;
+}
+/*---------------------------------------------------------------------------*/
+/* Returns the first index entry for the object, or NULL */
+static const index_entry_t *
+index_find_object(uint16_t object_id)
+{
+  int pos;
+
+  pos = index_lower_bound(object_id, 0);
+  if(pos < object_index_len && object_index[pos].object_id == object_id) {
+    return &object_index[pos];
+  }
+  return NULL;
+}
+/*---------------------------------------------------------------------------*/
+/* Returns the simple object instance following last in the index */
+static lwm2m_object_instance_t *
+index_next_instance(lwm2m_object_instance_t *last, int same_object)
+{
+  int pos;
+
+  pos = index_lower_bound(last->object_id, last->instance_id);
+  if(pos < object_index_len && object_index[pos].instance == last) {
+    pos++;
+  }
+
+  for(; pos < object_index_len; pos++) {
+    if(same_object && object_index[pos].object_id != last->object_id) {
+      return NULL;
+    }
+    if(object_index[pos].instance != NULL) {
+      return object_index[pos].instance;
+    }
+  }
+  return NULL;
+}
+/*---------------------------------------------------------------------------*/
+static lwm2m_object_instance_t *
+first_simple_instance(void)
+{
+  int i;
+
+  if(!index_update()) {
+    return list_head(object_list);
+  }
+  for(i = 0; i < object_index_len; i++) {
+    if(object_index[i].instance != NULL) {
+      return object_index[i].instance;
+    }
+  }
+  return NULL;
+}
 /*---------------------------------------------------------------------------*/
 static lwm2m_object_t *
 get_object(uint16_t object_id)
 {
   lwm2m_object_t *object;
+  const index_entry_t *entry;
+
+  if(index_update()) {
+    entry = index_find_object(object_id);
+    return entry != NULL ? entry->object : NULL;
+  }
+
   for(object = list_head(generic_object_list);
       object != NULL;
       object = object->next) {
@@ -166,6 +378,13 @@ static int
 has_non_generic_object(uint16_t object_id)
 {
   lwm2m_object_instance_t *instance;
+  const index_entry_t *entry;
+
+  if(index_update()) {
+    entry = index_find_object(object_id);
+    return entry != NULL && entry->instance != NULL;
+  }
+
   for(instance = list_head(object_list);
       instance != NULL;
       instance = instance->next) {
@@ -182,11 +401,37 @@ get_instance(uint16_t object_id, uint16_t instance_id, lwm2m_object_t **o)
 {
   lwm2m_object_instance_t *instance;
   lwm2m_object_t *object;
+  const index_entry_t *entry;
+  int pos;
 
   if(o) {
     *o = NULL;
   }
 
+  if(index_update()) {
+    pos = index_lower_bound(object_id,
+                            instance_id == LWM2M_OBJECT_INSTANCE_NONE ?
+                            0 : instance_id);
+    if(pos >= object_index_len || object_index[pos].object_id != object_id) {
+      return NULL;
+    }
+    entry = &object_index[pos];
+    if(entry->instance != NULL) {
+      if(instance_id == LWM2M_OBJECT_INSTANCE_NONE ||
+         entry->instance_id == instance_id) {
+        return entry->instance;
+      }
+      return NULL;
+    }
+    if(o) {
+      *o = entry->object;
+    }
+    if(instance_id == LWM2M_OBJECT_INSTANCE_NONE) {
+      return entry->object->impl->get_first(NULL);
+    }
+    return entry->object->impl->get_by_id(instance_id, NULL);
+  }
+
   for(instance = list_head(object_list);
       instance != NULL;
       instance = instance->next) {
@@ -391,6 +636,31 @@ void lwm2m_engine_set_opaque_callback(lwm2m_context_t *ctx, lwm2m_write_opaque_c
   current_opaque_callback = cb;
 }
 /*---------------------------------------------------------------------------*/
+#if LWM2M_ENGINE_RD_CACHE_SIZE > 0
+static void
+rd_cache_update(void)
+{
+  lwm2m_object_instance_t *instance;
+  int len;
+
+  rd_cache_len = 0;
+  for(instance = first_simple_instance();
+      instance != NULL;
+      instance = next_object_instance(NULL, NULL, instance)) {
+    len = snprintf(&rd_cache[rd_cache_len], sizeof(rd_cache) - rd_cache_len,
+                   rd_cache_len > 0 ? ",</%d/%d>" : "</%d/%d>",
+                   instance->object_id, instance->instance_id);
+    if(len < 0 || len >= sizeof(rd_cache) - rd_cache_len) {
+      LOG_DBG("RD cache too small - generating RD data\n");
+      rd_cache_len = 0;
+      return;
+    }
+    rd_cache_len += len;
+  }
+  rd_cache_valid = 1;
+}
+#endif /* LWM2M_ENGINE_RD_CACHE_SIZE > 0 */
+/*---------------------------------------------------------------------------*/
 int
 lwm2m_engine_set_rd_data(lwm2m_buffer_t *outbuf, int block)
 {
@@ -413,17 +683,29 @@ lwm2m_engine_set_rd_data(lwm2m_buffer_t *outbuf, int block)
   if(block == 0) {
     LOG_DBG("Starting RD generation\n");
     /* start with simple object instances */
-    instance = list_head(object_list);
+    instance = first_simple_instance();
     object = NULL;
 
+#if LWM2M_ENGINE_RD_CACHE_SIZE > 0
+    rd_cache_pos = 0;
+    if(!rd_cache_valid) {
+      rd_cache_update();
+    }
+    if(rd_cache_valid) {
+      /* The simple object instances are sent from the cache */
+      LOG_DBG("Using cached RD data: %u bytes\n", rd_cache_len);
+      instance = NULL;
+    }
+#endif /* LWM2M_ENGINE_RD_CACHE_SIZE > 0 */
+
     if(instance == NULL) {
-      /* No simple object instances available */
+      /* No simple object instances to generate */
       object = list_head(generic_object_list);
-      if(object == NULL) {
+      if(object == NULL && !RD_CACHE_PENDING()) {
         /* No objects of any kind available */
         return 0;
       }
-      if(object->impl != NULL) {
+      if(object != NULL && object->impl != NULL) {
         instance = object->impl->get_first(NULL);
       }
     }
@@ -438,6 +720,21 @@ lwm2m_engine_set_rd_data(lwm2m_buffer_t *outbuf, int block)
 
   lwm2m_buf_lock_timeout = coap_timer_uptime() + 1000;
 
+#if LWM2M_ENGINE_RD_CACHE_SIZE > 0
+  while(RD_CACHE_PENDING()) {
+    if(lwm2m_buf.len >= maxsize || lwm2m_buf.len >= lwm2m_buf.size) {
+      double_buffer_flush(&lwm2m_buf, outbuf, maxsize);
+      /* there will be more - keep lock! */
+      return 1;
+    }
+    len = MIN(rd_cache_len - rd_cache_pos,
+              MIN(maxsize, lwm2m_buf.size) - lwm2m_buf.len);
+    memcpy(&lwm2m_buf.buffer[lwm2m_buf.len], &rd_cache[rd_cache_pos], len);
+    lwm2m_buf.len += len;
+    rd_cache_pos += len;
+  }
+#endif /* LWM2M_ENGINE_RD_CACHE_SIZE > 0 */
+
   LOG_DBG("Generating RD list:");
   while(instance != NULL || object != NULL) {
     int pos = lwm2m_buf.len;
@@ -508,6 +805,7 @@ lwm2m_engine_init(void)
 {
   list_init(object_list);
   list_init(generic_object_list);
+  index_invalidate();
 
 #ifdef LWM2M_ENGINE_CLIENT_ENDPOINT_NAME
   const char *endpoint = LWM2M_ENGINE_CLIENT_ENDPOINT_NAME;
@@ -598,6 +896,9 @@ lwm2m_engine_select_writer(lwm2m_context_t *context, unsigned int accept)
     case APPLICATION_JSON:
       context->writer = &lwm2m_json_writer;
       break;
+    case LWM2M_SENML_CBOR:
+      context->writer = &lwm2m_senml_cbor_writer;
+      break;
     default:
       LOG_WARN("Unknown Accept type %u, using LWM2M plain text\n", accept);
       context->writer = &lwm2m_plain_text_writer;
@@ -1266,6 +1567,7 @@ lwm2m_engine_add_object(lwm2m_object_instance_t *object)
     }
   }
   list_add(object_list, object);
+  index_invalidate();
 #if USE_RD_CLIENT
   lwm2m_rd_client_set_update_rd();
 #endif
@@ -1276,6 +1578,7 @@ void
 lwm2m_engine_remove_object(lwm2m_object_instance_t *object)
 {
   list_remove(object_list, object);
+  index_invalidate();
 #if USE_RD_CLIENT
   lwm2m_rd_client_set_update_rd();
 #endif
@@ -1304,6 +1607,7 @@ lwm2m_engine_add_generic_object(lwm2m_object_t *object)
     return 0;
   }
   list_add(generic_object_list, object);
+  index_invalidate();
 
 #if USE_RD_CLIENT
   lwm2m_rd_client_set_update_rd();
@@ -1316,6 +1620,7 @@ void
 lwm2m_engine_remove_generic_object(lwm2m_object_t *object)
 {
   list_remove(generic_object_list, object);
+  index_invalidate();
 #if USE_RD_CLIENT
   lwm2m_rd_client_set_update_rd();
 #endif
@@ -1336,6 +1641,9 @@ next_object_instance(const lwm2m_context_t *context, lwm2m_object_t *object,
   }
 
   if(object == NULL) {
+    if(index_update()) {
+      return index_next_instance(last, context != NULL);
+    }
     for(last = last->next; last != NULL; last = last->next) {
       /* if no context is given - this will just give the next object */
       if(context == NULL || last->object_id == context->object_id) {
@@ -58,7 +58,8 @@ typedef enum {
   LWM2M_JSON       = 11543,
   LWM2M_OLD_TLV    = 1542,
   LWM2M_OLD_JSON   = 1543,
-  LWM2M_OLD_OPAQUE  = 1544
+  LWM2M_OLD_OPAQUE  = 1544,
+  LWM2M_SENML_CBOR = 112
 } lwm2m_content_format_t;
 
 void lwm2m_engine_init(void);
@@ -0,0 +1,187 @@
+/*
+ * Copyright (c) 2026, agent <agent@local>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+ * OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * \addtogroup lwm2m
+ * @{
+ */
+
+/**
+ * \file
+ *         Implementation of the Contiki OMA LWM2M SenML-CBOR writer.
+ *
+ *         The resources are written as an indefinite-length SenML pack.
+ *         The first record carries the base name /object/instance/ and
+ *         each record is named after its resource (and resource instance).
+ */
+
+#include "lwm2m-object.h"
+#include "lwm2m-senml-cbor.h"
+#include "senml-cbor.h"
+#include <stdio.h>
+#include <string.h>
+#include <inttypes.h>
+
+/* Log configuration */
+#include "coap-log.h"
+#define LOG_MODULE "lwm2m-cbor"
+#define LOG_LEVEL  LOG_LEVEL_NONE
+
+/*---------------------------------------------------------------------------*/
+static size_t
+init_write(lwm2m_context_t *ctx)
+{
+  cbor_writer_t writer;
+
+  ctx->writer_flags = 0; /* set flags to zero */
+  cbor_writer_init(&writer, &ctx->outbuf->buffer[ctx->outbuf->len],
+                   ctx->outbuf->size - ctx->outbuf->len);
+  return senml_cbor_start_pack(&writer);
+}
+/*---------------------------------------------------------------------------*/
+static size_t
+end_write(lwm2m_context_t *ctx)
+{
+  cbor_writer_t writer;
+
+  cbor_writer_init(&writer, &ctx->outbuf->buffer[ctx->outbuf->len],
+                   ctx->outbuf->size - ctx->outbuf->len);
+  return senml_cbor_end_pack(&writer);
+}
+/*---------------------------------------------------------------------------*/
+static size_t
+enter_sub(lwm2m_context_t *ctx)
+{
+  LOG_DBG("Enter sub-resource rsc=%d\n", ctx->resource_id);
+  ctx->writer_flags |= WRITER_RESOURCE_INSTANCE;
+  return 0;
+}
+/*---------------------------------------------------------------------------*/
+static size_t
+exit_sub(lwm2m_context_t *ctx)
+{
+  LOG_DBG("Exit sub-resource rsc=%d\n", ctx->resource_id);
+  ctx->writer_flags &= ~WRITER_RESOURCE_INSTANCE;
+  return 0;
+}
+/*---------------------------------------------------------------------------*/
+/* Fills in the names of the record and writes it */
+static size_t
+write_record(lwm2m_context_t *ctx, uint8_t *outbuf, size_t outlen,
+             senml_record_t *record)
+{
+  char base_name[20]; /* /60000/60000/ */
+  char name[12]; /* 60000/60000 */
+  cbor_writer_t writer;
+  size_t len;
+
+  if((ctx->writer_flags & WRITER_OUTPUT_VALUE) == 0) {
+    snprintf(base_name, sizeof(base_name), "/%u/%u/",
+             ctx->object_id, ctx->object_instance_id);
+    record->base_name = base_name;
+  }
+  if(ctx->writer_flags & WRITER_RESOURCE_INSTANCE) {
+    snprintf(name, sizeof(name), "%u/%u",
+             ctx->resource_id, ctx->resource_instance_id);
+  } else {
+    snprintf(name, sizeof(name), "%u", ctx->resource_id);
+  }
+  record->name = name;
+
+  cbor_writer_init(&writer, outbuf, outlen);
+  len = senml_cbor_write_record(&writer, record);
+  if(len > 0) {
+    ctx->writer_flags |= WRITER_OUTPUT_VALUE;
+  }
+  return len;
+}
+/*---------------------------------------------------------------------------*/
+static size_t
+write_boolean(lwm2m_context_t *ctx, uint8_t *outbuf, size_t outlen,
+              int value)
+{
+  senml_record_t record;
+
+  memset(&record, 0, sizeof(record));
+  record.type = SENML_VALUE_BOOL;
+  record.value.boolean = value;
+  return write_record(ctx, outbuf, outlen, &record);
+}
+/*---------------------------------------------------------------------------*/
+static size_t
+write_int(lwm2m_context_t *ctx, uint8_t *outbuf, size_t outlen,
+          int32_t value)
+{
+  senml_record_t record;
+
+  LOG_DBG("Write int:%"PRId32"\n", value);
+  memset(&record, 0, sizeof(record));
+  record.type = SENML_VALUE_INT;
+  record.value.integer = value;
+  return write_record(ctx, outbuf, outlen, &record);
+}
+/*---------------------------------------------------------------------------*/
+static size_t
+write_float32fix(lwm2m_context_t *ctx, uint8_t *outbuf, size_t outlen,
+                 int32_t value, int bits)
+{
+  senml_record_t record;
+
+  memset(&record, 0, sizeof(record));
+  record.type = SENML_VALUE_FLOAT;
+  record.value.number = (float)value / (float)(1L << bits);
+  return write_record(ctx, outbuf, outlen, &record);
+}
+/*---------------------------------------------------------------------------*/
+static size_t
+write_string(lwm2m_context_t *ctx, uint8_t *outbuf, size_t outlen,
+             const char *value, size_t stringlen)
+{
+  senml_record_t record;
+
+  memset(&record, 0, sizeof(record));
+  record.type = SENML_VALUE_STRING;
+  record.value.string.data = (const uint8_t *)value;
+  record.value.string.len = stringlen;
+  return write_record(ctx, outbuf, outlen, &record);
+}
+/*---------------------------------------------------------------------------*/
+const lwm2m_writer_t lwm2m_senml_cbor_writer = {
+  init_write,
+  end_write,
+  enter_sub,
+  exit_sub,
+  write_int,
+  write_string,
+  write_float32fix,
+  write_boolean
+};
+/*---------------------------------------------------------------------------*/
+/** @} */
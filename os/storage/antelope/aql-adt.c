@@ -162,3 +162,33 @@ aql_add_value(aql_adt_t *adt, domain_t domain, void *value_ptr)
 
   return DB_OK;
 }
+
+db_result_t
+aql_set_group(aql_adt_t *adt, char *name)
+{
+  int i;
+
+  if(strlen(name) + 1 > sizeof(adt->group_attribute)) {
+    return DB_LIMIT_ERROR;
+  }
+
+  strcpy(adt->group_attribute, name);
+  adt->group_width = 0;
+  AQL_SET_FLAG(adt, AQL_FLAG_AGGREGATE | AQL_FLAG_GROUP);
+
+  /* The values of the grouping attribute are needed for each tuple,
+     even if the attribute is not projected into the result. */
+  for(i = 0; i < AQL_ATTRIBUTE_COUNT(adt); i++) {
+    if(adt->aggregators[i] == AQL_NONE &&
+       strcmp(adt->attributes[i].name, name) == 0) {
+      return DB_OK;
+    }
+  }
+
+  if(DB_ERROR(aql_add_attribute(adt, name, DOMAIN_UNSPECIFIED, 0, 0))) {
+    return DB_LIMIT_ERROR;
+  }
+  adt->attributes[AQL_ATTRIBUTE_COUNT(adt) - 1].flags = ATTRIBUTE_FLAG_NO_STORE;
+
+  return DB_OK;
+}
@@ -489,6 +489,35 @@ PARSER(join)
   RETURN(OK);
 }
 
+PARSER(group)
+{
+  long width;
+
+  /* GROUP BY attribute [/ width] */
+  CONSUME(BY);
+  CONSUME(IDENTIFIER);
+
+  if(DB_ERROR(AQL_SET_GROUP(adt, VALUE))) {
+    RETURN(SYNTAX_ERROR);
+  }
+  PRINTF("group by: %s\n", VALUE);
+
+  NEXT;
+  if(TOKEN == DIV) {
+    /* Group the values into buckets of a fixed width. */
+    CONSUME(INTEGER_VALUE);
+    width = *(long *)lexer->value;
+    if(width <= 0) {
+      RETURN(SYNTAX_ERROR);
+    }
+    AQL_SET_GROUP_WIDTH(adt, width);
+  } else {
+    REWIND;
+  }
+
+  RETURN(OK);
+}
+
 PARSER(select)
 {
   AQL_SET_TYPE(adt, AQL_TYPE_SELECT);
@@ -512,11 +541,20 @@ PARSER(select)
     }
 
     AQL_SET_CONDITION(adt, &p);
-  } else {
+    NEXT;
+  } else if(TOKEN != GROUP) {
     REWIND;
     RETURN(OK);
   }
 
+  if(TOKEN == GROUP) {
+    if(!PARSE(group)) {
+      RETURN(SYNTAX_ERROR);
+    }
+  } else {
+    REWIND;
+  }
+
   CONSUME(END);
 
   return OK;
@@ -655,6 +693,9 @@ PARSER_TOKEN(index_type)
   case MEMHASH:
     type = INDEX_MEMHASH;
     break;
+  case BTREE:
+    type = INDEX_BTREE;
+    break;
   default:
     return NONE;
   };
@@ -104,6 +104,40 @@
 #define DB_MAX_ELEMENT_SIZE		16
 #endif /* DB_MAX_ELEMENT_SIZE */
 
+/* The number of block buffers used to read rows from the tuple files.
+   Each buffer is filled with as many consecutive rows as fit in one
+   read, so that scans do not need one file system call per row.
+   The buffers are disabled by default, so that rows are read one at a
+   time, because they take DB_ROW_BUFFER_LIMIT * DB_ROW_BUFFER_SIZE
+   bytes of RAM. */
+#ifndef DB_ROW_BUFFER_LIMIT
+#define DB_ROW_BUFFER_LIMIT		0
+#endif /* DB_ROW_BUFFER_LIMIT */
+
+/* The size of each row block buffer. It must hold at least one row
+   of the largest relation. */
+#ifndef DB_ROW_BUFFER_SIZE
+#define DB_ROW_BUFFER_SIZE		(4 * DB_MAX_ATTRIBUTES_PER_RELATION * \
+					 DB_MAX_ELEMENT_SIZE)
+#endif /* DB_ROW_BUFFER_SIZE */
+
+/* The number of tuples that a join can keep in its hash table. Each
+   tuple takes a key, a tuple ID and a link. Joins in which the smaller
+   relation is larger than this are made in several passes, unless the
+   larger relation is indexed. Set to 0 to disable hash joins. */
+#ifndef DB_JOIN_HASH_LIMIT
+#define DB_JOIN_HASH_LIMIT		16
+#endif /* DB_JOIN_HASH_LIMIT */
+
+/* The number of groups that an aggregating selection can keep at the
+   same time. When a selection with GROUP BY finds more groups than
+   this, the group with the smallest key is returned early. This works
+   for data that arrive in the order of the grouping attribute, such as
+   time-bucketed samples. The limit can be at most 255. */
+#ifndef DB_GROUP_LIMIT
+#define DB_GROUP_LIMIT			8
+#endif /* DB_GROUP_LIMIT */
+
 
 /* The maximum size of the LVM bytecode compiled from a
    single database query. */
@@ -215,6 +249,28 @@
 #define DB_HEAP_CACHE_LIMIT		1
 #endif /* DB_HEAP_CACHE_LIMIT */
 
+/* The maximum number of B+-tree indexes. */
+#ifndef DB_BTREE_INDEX_LIMIT
+#define DB_BTREE_INDEX_LIMIT		1
+#endif /* DB_BTREE_INDEX_LIMIT */
+
+/* The number of keys in each node of a B+-tree index. */
+#ifndef DB_BTREE_NODE_KEYS
+#define DB_BTREE_NODE_KEYS		16
+#endif /* DB_BTREE_NODE_KEYS */
+
+/* The maximum number of nodes in a B+-tree index. The file space for
+   all nodes is reserved when the index is created. */
+#ifndef DB_BTREE_NODE_LIMIT
+#define DB_BTREE_NODE_LIMIT		128
+#endif /* DB_BTREE_NODE_LIMIT */
+
+/* The number of nodes cached by the B+-tree indexes. At least two
+   nodes are needed to split a node. */
+#ifndef DB_BTREE_CACHE_LIMIT
+#define DB_BTREE_CACHE_LIMIT		4
+#endif /* DB_BTREE_CACHE_LIMIT */
+
 /*----------------------------------------------------------------------------*/
 
 /* LVM options. */
@@ -236,5 +292,25 @@
 #define LVM_USE_FLOATS			DB_FEATURE_FLOATS
 #endif /* LVM_USE_FLOATS */
 
+/* Compile predicates into a flat operation array that is evaluated
+   over batches of tuples, instead of interpreting the bytecode once
+   per tuple. */
+#ifndef LVM_COMPILE_PREDICATES
+#define LVM_COMPILE_PREDICATES		1
+#endif /* LVM_COMPILE_PREDICATES */
+
+/* The maximum number of operations in a compiled predicate. Larger
+   predicates are interpreted. */
+#ifndef LVM_MAX_COMPILED_NODES
+#define LVM_MAX_COMPILED_NODES		24
+#endif /* LVM_MAX_COMPILED_NODES */
+
+/* The number of tuples evaluated at a time by a compiled predicate.
+   The evaluation uses a few arrays of this many values on the stack
+   for each level of nesting in the predicate. */
+#ifndef LVM_BATCH_SIZE
+#define LVM_BATCH_SIZE			16
+#endif /* LVM_BATCH_SIZE */
+
 
 #endif /* !DB_OPTIONS_H */
@@ -0,0 +1,697 @@
+/*
+ * Copyright (c) 2026, agent <agent@local>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+ * OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * \file
+ *     A B+-tree index stored in a file.
+ *
+ *     The tree consists of fixed-size nodes in a single file, in which
+ *     the first node slot holds a header with the root and the number
+ *     of allocated nodes. Internal nodes hold separator keys and child
+ *     node numbers; leaves hold the (key, tuple id) pairs in key order
+ *     and are linked from left to right, so that a range query descends
+ *     once to the first key of the range and then scans the leaves.
+ *
+ *     Keys may be inserted in any order and may have duplicates. When
+ *     keys are appended at the right edge of the tree, as with time
+ *     stamps, a full node is split by starting a new empty node instead
+ *     of moving half of its entries. The nodes are then completely
+ *     filled, and each insertion rewrites only one leaf.
+ *
+ *     Deletions do not merge nodes, so the tree never shrinks.
+ */
+
+#include <string.h>
+
+#include "cfs/cfs.h"
+#include "lib/memb.h"
+
+#include "db-options.h"
+#include "index.h"
+#include "result.h"
+#include "storage.h"
+
+#define DEBUG DEBUG_NONE
+#include "net/ipv6/uip-debug.h"
+
+#if DB_BTREE_CACHE_LIMIT < 2
+#error "The B+-tree index needs a cache of at least two nodes."
+#endif
+
+#if DB_BTREE_NODE_KEYS < 3 || DB_BTREE_NODE_KEYS > 255
+#error "DB_BTREE_NODE_KEYS must be between 3 and 255."
+#endif
+
+/* Node numbers start at 1, as the first node slot holds the header. */
+#define NO_NODE		0
+#define MAX_DEPTH	8
+
+typedef uint16_t btree_node_id_t;
+
+struct btree_header {
+  btree_node_id_t root;
+  btree_node_id_t node_count;
+  uint8_t height;
+};
+
+struct btree_node {
+  uint8_t leaf;
+  uint8_t count;
+  btree_node_id_t next;
+  long keys[DB_BTREE_NODE_KEYS];
+  union {
+    tuple_id_t values[DB_BTREE_NODE_KEYS];
+    btree_node_id_t children[DB_BTREE_NODE_KEYS + 1];
+  } u;
+};
+typedef struct btree_node btree_node_t;
+
+struct btree {
+  db_storage_id_t storage;
+  struct btree_header header;
+};
+typedef struct btree btree_t;
+
+struct node_cache {
+  btree_t *tree;
+  btree_node_id_t id;
+  unsigned long last_use;
+  btree_node_t node;
+};
+
+/* Keep a cache of nodes read from storage. Nodes are written through
+   the cache as soon as they are modified. */
+static struct node_cache node_cache[DB_BTREE_CACHE_LIMIT];
+static unsigned long cache_clock;
+MEMB(btrees, btree_t, DB_BTREE_INDEX_LIMIT);
+
+static db_result_t create(index_t *);
+static db_result_t destroy(index_t *);
+static db_result_t load(index_t *);
+static db_result_t release(index_t *);
+static db_result_t insert(index_t *, attribute_value_t *, tuple_id_t);
+static db_result_t delete(index_t *, attribute_value_t *);
+static tuple_id_t get_next(index_iterator_t *);
+
+index_api_t index_btree = {
+  INDEX_BTREE,
+  INDEX_API_EXTERNAL | INDEX_API_RANGE_QUERIES,
+  create,
+  destroy,
+  load,
+  release,
+  insert,
+  delete,
+  get_next
+};
+
+static void
+invalidate_cache(btree_t *tree)
+{
+  int i;
+
+  for(i = 0; i < DB_BTREE_CACHE_LIMIT; i++) {
+    if(node_cache[i].tree == tree) {
+      node_cache[i].tree = NULL;
+    }
+  }
+}
+
+static struct node_cache *
+get_cache(btree_t *tree, btree_node_id_t id)
+{
+  struct node_cache *cache;
+  struct node_cache *victim;
+  int i;
+
+  victim = &node_cache[0];
+  for(i = 0; i < DB_BTREE_CACHE_LIMIT; i++) {
+    cache = &node_cache[i];
+    if(cache->tree == tree && cache->id == id) {
+      cache->last_use = ++cache_clock;
+      return cache;
+    }
+    if(cache->tree == NULL) {
+      victim = cache;
+      victim->last_use = 0;
+    } else if(cache->last_use < victim->last_use) {
+      victim = cache;
+    }
+  }
+
+  victim->tree = NULL;
+  victim->id = id;
+  victim->last_use = ++cache_clock;
+  return victim;
+}
+
+static btree_node_t *
+node_read(btree_t *tree, btree_node_id_t id)
+{
+  struct node_cache *cache;
+
+  cache = get_cache(tree, id);
+  if(cache->tree == NULL) {
+    if(DB_ERROR(storage_read(tree->storage, &cache->node,
+                             (unsigned long)id * sizeof(btree_node_t),
+                             sizeof(btree_node_t)))) {
+      PRINTF("DB: Failed to read B+-tree node %u\n", (unsigned)id);
+      return NULL;
+    }
+    cache->tree = tree;
+  }
+
+  return &cache->node;
+}
+
+static int
+node_write(btree_t *tree, btree_node_id_t id, btree_node_t *node)
+{
+  if(DB_ERROR(storage_write(tree->storage, node,
+                            (unsigned long)id * sizeof(btree_node_t),
+                            sizeof(btree_node_t)))) {
+    PRINTF("DB: Failed to write B+-tree node %u\n", (unsigned)id);
+    return 0;
+  }
+
+  return 1;
+}
+
+static int
+header_write(btree_t *tree)
+{
+  return !DB_ERROR(storage_write(tree->storage, &tree->header, 0,
+                                 sizeof(tree->header)));
+}
+
+/* Allocate a node in the cache without reading it from storage. */
+static btree_node_t *
+node_allocate(btree_t *tree, btree_node_id_t *id, int leaf)
+{
+  struct node_cache *cache;
+
+  if(tree->header.node_count >= DB_BTREE_NODE_LIMIT) {
+    PRINTF("DB: The B+-tree has no more nodes available\n");
+    return NULL;
+  }
+
+  *id = tree->header.node_count++;
+
+  cache = get_cache(tree, *id);
+  memset(&cache->node, 0, sizeof(cache->node));
+  cache->node.leaf = leaf;
+  cache->tree = tree;
+
+  return &cache->node;
+}
+
+/* Find the first position whose key is not smaller than the given key. */
+static unsigned
+lower_bound(btree_node_t *node, long key)
+{
+  unsigned i;
+
+  for(i = 0; i < node->count && node->keys[i] < key; i++);
+  return i;
+}
+
+/* Find the first position whose key is larger than the given key. */
+static unsigned
+upper_bound(btree_node_t *node, long key)
+{
+  unsigned i;
+
+  for(i = 0; i < node->count && node->keys[i] <= key; i++);
+  return i;
+}
+
+/* Find the leftmost leaf that may contain the key. */
+static btree_node_id_t
+find_leaf(btree_t *tree, long key)
+{
+  btree_node_t *node;
+  btree_node_id_t id;
+
+  for(id = tree->header.root;;) {
+    node = node_read(tree, id);
+    if(node == NULL) {
+      return NO_NODE;
+    }
+    if(node->leaf) {
+      return id;
+    }
+    id = node->u.children[lower_bound(node, key)];
+  }
+}
+
+static int
+insert_into_parent(btree_t *tree, btree_node_id_t *path, unsigned *slots,
+                   int level, int append, long key, btree_node_id_t child)
+{
+  long keys[DB_BTREE_NODE_KEYS + 1];
+  btree_node_id_t children[DB_BTREE_NODE_KEYS + 2];
+  btree_node_t *node;
+  btree_node_t *right;
+  btree_node_id_t id;
+  btree_node_id_t right_id;
+  unsigned slot;
+  unsigned split;
+  unsigned total;
+
+  for(; level >= 0; level--) {
+    id = path[level];
+    slot = slots[level];
+    node = node_read(tree, id);
+    if(node == NULL) {
+      return 0;
+    }
+
+    if(node->count < DB_BTREE_NODE_KEYS) {
+      memmove(&node->keys[slot + 1], &node->keys[slot],
+              (node->count - slot) * sizeof(node->keys[0]));
+      memmove(&node->u.children[slot + 2], &node->u.children[slot + 1],
+              (node->count - slot) * sizeof(node->u.children[0]));
+      node->keys[slot] = key;
+      node->u.children[slot + 1] = child;
+      node->count++;
+      return node_write(tree, id, node);
+    }
+
+    /* Split a full internal node. The middle key moves up. */
+    total = node->count + 1;
+    memcpy(keys, node->keys, slot * sizeof(keys[0]));
+    keys[slot] = key;
+    memcpy(&keys[slot + 1], &node->keys[slot],
+           (node->count - slot) * sizeof(keys[0]));
+    memcpy(children, node->u.children, (slot + 1) * sizeof(children[0]));
+    children[slot + 1] = child;
+    memcpy(&children[slot + 2], &node->u.children[slot + 1],
+           (node->count - slot) * sizeof(children[0]));
+
+    split = append ? total - 1 : total / 2;
+
+    right = node_allocate(tree, &right_id, 0);
+    if(right == NULL) {
+      return 0;
+    }
+    right->count = total - split - 1;
+    memcpy(right->keys, &keys[split + 1], right->count * sizeof(keys[0]));
+    memcpy(right->u.children, &children[split + 1],
+           (right->count + 1) * sizeof(children[0]));
+    if(!node_write(tree, right_id, right)) {
+      return 0;
+    }
+
+    node = node_read(tree, id);
+    if(node == NULL) {
+      return 0;
+    }
+    node->count = split;
+    memcpy(node->keys, keys, split * sizeof(keys[0]));
+    memcpy(node->u.children, children, (split + 1) * sizeof(children[0]));
+    if(!node_write(tree, id, node)) {
+      return 0;
+    }
+
+    key = keys[split];
+    child = right_id;
+  }
+
+  /* The root was split; grow the tree by one level. */
+  node = node_allocate(tree, &id, 0);
+  if(node == NULL) {
+    return 0;
+  }
+  node->count = 1;
+  node->keys[0] = key;
+  node->u.children[0] = tree->header.root;
+  node->u.children[1] = child;
+  if(!node_write(tree, id, node)) {
+    return 0;
+  }
+
+  tree->header.root = id;
+  tree->header.height++;
+
+  return 1;
+}
+
+static int
+insert_item(btree_t *tree, long key, tuple_id_t value)
+{
+  btree_node_id_t path[MAX_DEPTH];
+  unsigned slots[MAX_DEPTH];
+  btree_node_t *node;
+  btree_node_t *right;
+  btree_node_id_t id;
+  btree_node_id_t right_id;
+  btree_node_id_t node_count;
+  int level;
+  int append;
+  unsigned pos;
+  unsigned split;
+  int result;
+
+  /* Descend to the rightmost leaf that may hold the key, so that
+     duplicates are kept in insertion order. */
+  append = 1;
+  for(level = 0, id = tree->header.root;; level++) {
+    node = node_read(tree, id);
+    if(node == NULL) {
+      return 0;
+    }
+    if(node->leaf) {
+      break;
+    }
+    if(level >= MAX_DEPTH) {
+      return 0;
+    }
+    path[level] = id;
+    slots[level] = upper_bound(node, key);
+    append = append && slots[level] == node->count;
+    id = node->u.children[slots[level]];
+  }
+
+  pos = upper_bound(node, key);
+  append = append && pos == node->count;
+
+  if(node->count < DB_BTREE_NODE_KEYS) {
+    memmove(&node->keys[pos + 1], &node->keys[pos],
+            (node->count - pos) * sizeof(node->keys[0]));
+    memmove(&node->u.values[pos + 1], &node->u.values[pos],
+            (node->count - pos) * sizeof(node->u.values[0]));
+    node->keys[pos] = key;
+    node->u.values[pos] = value;
+    node->count++;
+    return node_write(tree, id, node);
+  }
+
+  /* Splitting may propagate up to the root, so make sure that there
+     are nodes for every level before the tree is modified. */
+  if(tree->header.height >= MAX_DEPTH ||
+     tree->header.node_count + tree->header.height >= DB_BTREE_NODE_LIMIT) {
+    PRINTF("DB: The B+-tree is full\n");
+    return 0;
+  }
+
+  /* Split the full leaf. Appended keys start a new leaf, and other
+     keys split the leaf in half. */
+  node_count = tree->header.node_count;
+  split = append ? node->count : node->count / 2;
+
+  right = node_allocate(tree, &right_id, 1);
+  if(right == NULL) {
+    return 0;
+  }
+  node = node_read(tree, id);
+  if(node == NULL) {
+    return 0;
+  }
+
+  right->count = node->count - split;
+  memcpy(right->keys, &node->keys[split], right->count * sizeof(node->keys[0]));
+  memcpy(right->u.values, &node->u.values[split],
+         right->count * sizeof(node->u.values[0]));
+  right->next = node->next;
+  node->next = right_id;
+  node->count = split;
+
+  if(pos <= split && split < DB_BTREE_NODE_KEYS) {
+    memmove(&node->keys[pos + 1], &node->keys[pos],
+            (node->count - pos) * sizeof(node->keys[0]));
+    memmove(&node->u.values[pos + 1], &node->u.values[pos],
+            (node->count - pos) * sizeof(node->u.values[0]));
+    node->keys[pos] = key;
+    node->u.values[pos] = value;
+    node->count++;
+  } else {
+    pos -= split;
+    memmove(&right->keys[pos + 1], &right->keys[pos],
+            (right->count - pos) * sizeof(right->keys[0]));
+    memmove(&right->u.values[pos + 1], &right->u.values[pos],
+            (right->count - pos) * sizeof(right->u.values[0]));
+    right->keys[pos] = key;
+    right->u.values[pos] = value;
+    right->count++;
+  }
+
+  /* Write the new leaf before linking it from the old one. */
+  if(!node_write(tree, right_id, right) || !node_write(tree, id, node)) {
+    return 0;
+  }
+
+  result = insert_into_parent(tree, path, slots, level - 1, append,
+                              right->keys[0], right_id);
+  if(tree->header.node_count != node_count && !header_write(tree)) {
+    return 0;
+  }
+
+  return result;
+}
+
+static db_result_t
+create(index_t *index)
+{
+  char *filename;
+  btree_t *tree;
+  btree_node_t *root;
+
+  filename = storage_generate_file("btree",
+                                   (unsigned long)DB_BTREE_NODE_LIMIT *
+                                   sizeof(btree_node_t));
+  if(filename == NULL) {
+    PRINTF("DB: Failed to generate a B+-tree file\n");
+    return DB_INDEX_ERROR;
+  }
+
+  memcpy(index->descriptor_file, filename, sizeof(index->descriptor_file));
+
+  index->opaque_data = tree = memb_alloc(&btrees);
+  if(tree == NULL) {
+    PRINTF("DB: Failed to allocate a B+-tree\n");
+    cfs_remove(index->descriptor_file);
+    index->descriptor_file[0] = '\0';
+    return DB_ALLOCATION_ERROR;
+  }
+
+  tree->storage = storage_open(index->descriptor_file);
+  if(tree->storage < 0) {
+    goto error;
+  }
+
+  tree->header.root = NO_NODE;
+  tree->header.node_count = 1;
+  tree->header.height = 1;
+
+  root = node_allocate(tree, &tree->header.root, 1);
+  if(root == NULL ||
+     !node_write(tree, tree->header.root, root) ||
+     !header_write(tree)) {
+    goto error;
+  }
+
+  PRINTF("DB: Created a B+-tree index in the file %s\n",
+         index->descriptor_file);
+
+  return DB_OK;
+
+ error:
+  invalidate_cache(tree);
+  storage_close(tree->storage);
+  memb_free(&btrees, tree);
+  cfs_remove(index->descriptor_file);
+  index->descriptor_file[0] = '\0';
+  return DB_STORAGE_ERROR;
+}
+
+static db_result_t
+destroy(index_t *index)
+{
+  /* The tree has already been released. */
+  cfs_remove(index->descriptor_file);
+  return DB_OK;
+}
+
+static db_result_t
+load(index_t *index)
+{
+  btree_t *tree;
+
+  index->opaque_data = tree = memb_alloc(&btrees);
+  if(tree == NULL) {
+    PRINTF("DB: Failed to allocate a B+-tree\n");
+    return DB_ALLOCATION_ERROR;
+  }
+
+  tree->storage = storage_open(index->descriptor_file);
+  if(tree->storage < 0 ||
+     DB_ERROR(storage_read(tree->storage, &tree->header, 0,
+                           sizeof(tree->header))) ||
+     tree->header.root == NO_NODE) {
+    storage_close(tree->storage);
+    memb_free(&btrees, tree);
+    return DB_STORAGE_ERROR;
+  }
+
+  PRINTF("DB: Loaded a B+-tree index with %u nodes from the file %s\n",
+         (unsigned)tree->header.node_count, index->descriptor_file);
+
+  return DB_OK;
+}
+
+static db_result_t
+release(index_t *index)
+{
+  btree_t *tree;
+
+  tree = index->opaque_data;
+
+  invalidate_cache(tree);
+  storage_close(tree->storage);
+  memb_free(&btrees, tree);
+  return DB_OK;
+}
+
+static db_result_t
+insert(index_t *index, attribute_value_t *key, tuple_id_t value)
+{
+  long long_key;
+
+  long_key = db_value_to_long(key);
+
+  if(insert_item(index->opaque_data, long_key, value) == 0) {
+    PRINTF("DB: Failed to insert key %ld into a B+-tree index\n", long_key);
+    return DB_INDEX_ERROR;
+  }
+
+  return DB_OK;
+}
+
+static db_result_t
+delete(index_t *index, attribute_value_t *value)
+{
+  btree_t *tree;
+  btree_node_t *node;
+  btree_node_id_t id;
+  long key;
+  unsigned pos;
+
+  tree = index->opaque_data;
+  key = db_value_to_long(value);
+
+  /* Remove the first entry with the key. Nodes that become empty are
+     left in the tree. */
+  for(id = find_leaf(tree, key); id != NO_NODE; id = node->next) {
+    node = node_read(tree, id);
+    if(node == NULL) {
+      return DB_STORAGE_ERROR;
+    }
+
+    pos = lower_bound(node, key);
+    if(pos < node->count) {
+      if(node->keys[pos] != key) {
+        break;
+      }
+      node->count--;
+      memmove(&node->keys[pos], &node->keys[pos + 1],
+              (node->count - pos) * sizeof(node->keys[0]));
+      memmove(&node->u.values[pos], &node->u.values[pos + 1],
+              (node->count - pos) * sizeof(node->u.values[0]));
+      return node_write(tree, id, node) ? DB_OK : DB_STORAGE_ERROR;
+    }
+  }
+
+  return DB_INDEX_ERROR;
+}
+
+/*
+ * The position of an iteration is kept in the found_items field of the
+ * iterator, with the leaf number in the upper bits and the position in
+ * the leaf in the lower eight bits. Several iterations can thus be
+ * active at the same time, and an iteration can be resumed from a copy
+ * of its iterator.
+ */
+#define ITERATOR_LEAF(iterator)	((btree_node_id_t)((iterator)->found_items >> 8))
+#define ITERATOR_POS(iterator)	((unsigned)((iterator)->found_items & 0xff))
+#define ITERATOR_SET(iterator, leaf, pos) \
+  ((iterator)->found_items = (tuple_id_t)(leaf) << 8 | (pos))
+
+static tuple_id_t
+get_next(index_iterator_t *iterator)
+{
+  btree_t *tree;
+  btree_node_t *node;
+  btree_node_id_t leaf;
+  unsigned pos;
+  long min;
+  long max;
+
+  tree = iterator->index->opaque_data;
+  min = db_value_to_long(&iterator->min_value);
+  max = db_value_to_long(&iterator->max_value);
+
+  if(iterator->next_item_no == 0) {
+    /* Descend to the first key of the range. */
+    leaf = min <= max ? find_leaf(tree, min) : NO_NODE;
+    pos = 0;
+    if(leaf != NO_NODE) {
+      node = node_read(tree, leaf);
+      if(node == NULL) {
+        return INVALID_TUPLE;
+      }
+      pos = lower_bound(node, min);
+    }
+  } else {
+    leaf = ITERATOR_LEAF(iterator);
+    pos = ITERATOR_POS(iterator);
+  }
+
+  while(leaf != NO_NODE) {
+    node = node_read(tree, leaf);
+    if(node == NULL) {
+      break;
+    }
+
+    if(pos < node->count) {
+      if(node->keys[pos] > max) {
+        break;
+      }
+      iterator->next_item_no++;
+      ITERATOR_SET(iterator, leaf, pos + 1);
+      return node->u.values[pos];
+    }
+
+    leaf = node->next;
+    pos = 0;
+  }
+
+  ITERATOR_SET(iterator, NO_NODE, 0);
+  return INVALID_TUPLE;
+}
@@ -397,6 +397,506 @@ lvm_execute(lvm_instance_t *p)
   return status;
 }
 
+static operator_t
+mirror_compare(operator_t op)
+{
+  switch(op) {
+  case LVM_GE:
+    return LVM_LE;
+  case LVM_GEQ:
+    return LVM_LEQ;
+  case LVM_LE:
+    return LVM_GE;
+  case LVM_LEQ:
+    return LVM_GEQ;
+  default:
+    return op;
+  }
+}
+
+#if LVM_COMPILE_PREDICATES
+/*
+ * A compiled predicate is a flat array of nodes, in which operators
+ * refer to their operands by index and variables refer directly to a
+ * column of values. Constant subexpressions are folded when compiling.
+ *
+ * The predicate is evaluated for a batch of tuples at a time. The
+ * tuples for which a condition holds are kept in selection vectors of
+ * tuple positions in ascending order, so the second operand of a
+ * logical connective is only evaluated for the tuples whose result has
+ * not yet been decided by the first operand.
+ */
+#if LVM_BATCH_SIZE > 256
+#error LVM_BATCH_SIZE must not exceed 256.
+#endif
+
+#define NODE_CONSTANT	1
+#define NODE_VARIABLE	2
+
+#define IS_CONSTANT(index) (compiled_nodes[index].op == NODE_CONSTANT)
+
+struct compiled_node {
+  uint8_t op;
+  uint8_t left;
+  uint8_t right;
+  long value;
+};
+
+static struct compiled_node compiled_nodes[LVM_MAX_COMPILED_NODES];
+static int compiled_count;
+static int compiled_root;
+
+/* The values of the variables for each tuple in a batch. */
+static long columns[LVM_MAX_VARIABLE_ID][LVM_BATCH_SIZE];
+
+static int
+add_node(uint8_t op, int left, int right, long value)
+{
+  struct compiled_node *node;
+
+  if(compiled_count == LVM_MAX_COMPILED_NODES) {
+    return -1;
+  }
+
+  node = &compiled_nodes[compiled_count];
+  node->op = op;
+  node->left = left;
+  node->right = right;
+  node->value = value;
+
+  return compiled_count++;
+}
+
+static int
+fold(int start, long value)
+{
+  /* The nodes of a folded subexpression are the last ones added. */
+  compiled_count = start;
+  return add_node(NODE_CONSTANT, 0, 0, value);
+}
+
+static long
+apply_arith(operator_t op, long l1, long l2)
+{
+  switch(op) {
+  case LVM_ADD:
+    return l1 + l2;
+  case LVM_SUB:
+    return l1 - l2;
+  case LVM_MUL:
+    return l1 * l2;
+  default:
+    return l1 / l2;
+  }
+}
+
+static int
+apply_compare(operator_t op, long l1, long l2)
+{
+  switch(op) {
+  case LVM_EQ:
+    return l1 == l2;
+  case LVM_NEQ:
+    return l1 != l2;
+  case LVM_GE:
+    return l1 > l2;
+  case LVM_GEQ:
+    return l1 >= l2;
+  case LVM_LE:
+    return l1 < l2;
+  default:
+    return l1 <= l2;
+  }
+}
+
+static int
+compile_expr(lvm_instance_t *p)
+{
+  int start;
+  int left;
+  int right;
+  operator_t op;
+  operand_t operand;
+
+  start = compiled_count;
+
+  switch(get_type(p)) {
+  case LVM_ARITH_OP:
+    op = *get_operator(p);
+    left = compile_expr(p);
+    if(left < 0) {
+      return -1;
+    }
+    right = compile_expr(p);
+    if(right < 0) {
+      return -1;
+    }
+
+    switch(op) {
+    case LVM_ADD:
+    case LVM_SUB:
+    case LVM_MUL:
+      break;
+    case LVM_DIV:
+      /* A division by zero is an execution error for the tuple, so
+         only divisions by non-zero constants are compiled. */
+      if(!IS_CONSTANT(right) || compiled_nodes[right].value == 0) {
+        return -1;
+      }
+      break;
+    default:
+      return -1;
+    }
+
+    if(IS_CONSTANT(left) && IS_CONSTANT(right)) {
+      return fold(start, apply_arith(op, compiled_nodes[left].value,
+                                     compiled_nodes[right].value));
+    }
+    return add_node(op, left, right, 0);
+  case LVM_OPERAND:
+    get_operand(p, &operand);
+    if(operand.type == LVM_VARIABLE) {
+      if(operand.value.id >= LVM_MAX_VARIABLE_ID) {
+        return -1;
+      }
+      return add_node(NODE_VARIABLE, 0, 0, operand.value.id);
+    }
+    return add_node(NODE_CONSTANT, 0, 0, operand_to_long(&operand));
+  default:
+    return -1;
+  }
+}
+
+static int
+compile_logic(lvm_instance_t *p)
+{
+  int start;
+  int left;
+  int right;
+  int tmp;
+  operator_t op;
+
+  start = compiled_count;
+
+  if(get_type(p) != LVM_CMP_OP) {
+    return -1;
+  }
+  op = *get_operator(p);
+
+  if(IS_CONNECTIVE(op)) {
+    left = compile_logic(p);
+    if(left < 0) {
+      return -1;
+    }
+
+    if(op == LVM_NOT) {
+      if(IS_CONSTANT(left)) {
+        return fold(start, !compiled_nodes[left].value);
+      }
+      return add_node(op, left, 0, 0);
+    } else if(op != LVM_AND && op != LVM_OR) {
+      return -1;
+    }
+
+    right = compile_logic(p);
+    if(right < 0) {
+      return -1;
+    }
+
+    if(IS_CONSTANT(left) || IS_CONSTANT(right)) {
+      if(!IS_CONSTANT(left)) {
+        tmp = left;
+        left = right;
+        right = tmp;
+      }
+      /* A false conjunct or a true disjunct decides the result. */
+      if((op == LVM_AND) != (compiled_nodes[left].value != 0)) {
+        return fold(start, compiled_nodes[left].value);
+      }
+      return right;
+    }
+    return add_node(op, left, right, 0);
+  }
+
+  if(op < LVM_EQ || op > LVM_LEQ) {
+    return -1;
+  }
+
+  left = compile_expr(p);
+  if(left < 0) {
+    return -1;
+  }
+  right = compile_expr(p);
+  if(right < 0) {
+    return -1;
+  }
+
+  if(IS_CONSTANT(left) && IS_CONSTANT(right)) {
+    return fold(start, apply_compare(op, compiled_nodes[left].value,
+                                     compiled_nodes[right].value));
+  }
+
+  /* Keep constants on the right side of comparisons. */
+  if(IS_CONSTANT(left)) {
+    tmp = left;
+    left = right;
+    right = tmp;
+    op = mirror_compare(op);
+  }
+  return add_node(op, left, right, 0);
+}
+
+static void
+eval_expr_batch(struct compiled_node *node, const uint8_t *selection,
+                unsigned count, long *result)
+{
+  long operand[LVM_BATCH_SIZE];
+  long *column;
+  unsigned i;
+
+  switch(node->op) {
+  case NODE_CONSTANT:
+    for(i = 0; i < count; i++) {
+      result[i] = node->value;
+    }
+    return;
+  case NODE_VARIABLE:
+    column = columns[node->value];
+    for(i = 0; i < count; i++) {
+      result[i] = column[selection[i]];
+    }
+    return;
+  }
+
+  eval_expr_batch(&compiled_nodes[node->left], selection, count, result);
+  eval_expr_batch(&compiled_nodes[node->right], selection, count, operand);
+
+  switch(node->op) {
+  case LVM_ADD:
+    for(i = 0; i < count; i++) {
+      result[i] += operand[i];
+    }
+    break;
+  case LVM_SUB:
+    for(i = 0; i < count; i++) {
+      result[i] -= operand[i];
+    }
+    break;
+  case LVM_MUL:
+    for(i = 0; i < count; i++) {
+      result[i] *= operand[i];
+    }
+    break;
+  case LVM_DIV:
+    for(i = 0; i < count; i++) {
+      result[i] /= operand[i];
+    }
+    break;
+  }
+}
+
+/* Keeps the tuples for which the condition holds, without branching. */
+#define SELECT_WHERE(condition)                 \
+  for(i = 0; i < count; i++) {                  \
+    result[selected] = selection[i];            \
+    selected += (condition);                    \
+  }
+
+#define SELECT_COMPARE(op, l1, l2)              \
+  switch(op) {                                  \
+  case LVM_EQ:                                  \
+    SELECT_WHERE((l1) == (l2));                 \
+    break;                                      \
+  case LVM_NEQ:                                 \
+    SELECT_WHERE((l1) != (l2));                 \
+    break;                                      \
+  case LVM_GE:                                  \
+    SELECT_WHERE((l1) > (l2));                  \
+    break;                                      \
+  case LVM_GEQ:                                 \
+    SELECT_WHERE((l1) >= (l2));                 \
+    break;                                      \
+  case LVM_LE:                                  \
+    SELECT_WHERE((l1) < (l2));                  \
+    break;                                      \
+  case LVM_LEQ:                                 \
+    SELECT_WHERE((l1) <= (l2));                 \
+    break;                                      \
+  }
+
+static unsigned
+eval_compare_batch(struct compiled_node *node, const uint8_t *selection,
+                   unsigned count, uint8_t *result)
+{
+  struct compiled_node *left;
+  struct compiled_node *right;
+  long l1[LVM_BATCH_SIZE];
+  long l2[LVM_BATCH_SIZE];
+  long *column;
+  long constant;
+  unsigned i;
+  unsigned selected;
+
+  left = &compiled_nodes[node->left];
+  right = &compiled_nodes[node->right];
+  selected = 0;
+
+  if(left->op == NODE_VARIABLE && right->op == NODE_CONSTANT) {
+    /* The common case: compare an attribute with a constant. */
+    column = columns[left->value];
+    constant = right->value;
+    SELECT_COMPARE(node->op, column[selection[i]], constant);
+  } else {
+    eval_expr_batch(left, selection, count, l1);
+    eval_expr_batch(right, selection, count, l2);
+    SELECT_COMPARE(node->op, l1[i], l2[i]);
+  }
+
+  return selected;
+}
+
+/* Gets the tuples of a selection that are not in a subset of it. */
+static unsigned
+select_difference(const uint8_t *selection, unsigned count,
+                  const uint8_t *subset, unsigned subset_count,
+                  uint8_t *result)
+{
+  unsigned i;
+  unsigned j;
+  unsigned selected;
+
+  for(i = j = selected = 0; i < count; i++) {
+    if(j < subset_count && subset[j] == selection[i]) {
+      j++;
+    } else {
+      result[selected++] = selection[i];
+    }
+  }
+  return selected;
+}
+
+/* Merges two disjoint selections. */
+static unsigned
+select_union(const uint8_t *s1, unsigned count1,
+             const uint8_t *s2, unsigned count2, uint8_t *result)
+{
+  unsigned i;
+  unsigned j;
+  unsigned selected;
+
+  for(i = j = selected = 0; i < count1 || j < count2;) {
+    if(j == count2 || (i < count1 && s1[i] < s2[j])) {
+      result[selected++] = s1[i++];
+    } else {
+      result[selected++] = s2[j++];
+    }
+  }
+  return selected;
+}
+
+/* The result may be stored in the selection array. */
+static unsigned
+eval_logic_batch(struct compiled_node *node, uint8_t *selection,
+                 unsigned count, uint8_t *result)
+{
+  uint8_t first[LVM_BATCH_SIZE];
+  uint8_t rest[LVM_BATCH_SIZE];
+  unsigned first_count;
+  unsigned rest_count;
+
+  switch(node->op) {
+  case NODE_CONSTANT:
+    if(!node->value) {
+      return 0;
+    }
+    memmove(result, selection, count);
+    return count;
+  case LVM_AND:
+    first_count = eval_logic_batch(&compiled_nodes[node->left],
+                                   selection, count, first);
+    if(first_count == 0) {
+      return 0;
+    }
+    return eval_logic_batch(&compiled_nodes[node->right],
+                            first, first_count, result);
+  case LVM_OR:
+    first_count = eval_logic_batch(&compiled_nodes[node->left],
+                                   selection, count, first);
+    rest_count = select_difference(selection, count,
+                                   first, first_count, rest);
+    if(rest_count > 0) {
+      rest_count = eval_logic_batch(&compiled_nodes[node->right],
+                                    rest, rest_count, rest);
+    }
+    return select_union(first, first_count, rest, rest_count, result);
+  case LVM_NOT:
+    first_count = eval_logic_batch(&compiled_nodes[node->left],
+                                   selection, count, first);
+    return select_difference(selection, count, first, first_count, result);
+  default:
+    return eval_compare_batch(node, selection, count, result);
+  }
+}
+
+lvm_status_t
+lvm_compile(lvm_instance_t *p, int inverse)
+{
+  int root;
+
+  compiled_count = 0;
+  p->ip = 0;
+  root = compile_logic(p);
+  p->ip = 0;
+
+  if(root >= 0 && inverse) {
+    if(IS_CONSTANT(root)) {
+      compiled_nodes[root].value = !compiled_nodes[root].value;
+    } else {
+      root = add_node(LVM_NOT, root, 0, 0);
+    }
+  }
+
+  if(root < 0) {
+    PRINTF("The predicate cannot be compiled\n");
+    compiled_count = 0;
+    return LVM_SEMANTIC_ERROR;
+  }
+
+  PRINTF("Compiled the predicate into %d nodes\n", compiled_count);
+  compiled_root = root;
+  /* Variables whose values are not set are zero, as when interpreting. */
+  memset(columns, 0, sizeof(columns));
+
+  return LVM_TRUE;
+}
+
+long *
+lvm_get_column(char *name)
+{
+  variable_id_t id;
+
+  id = lookup(name);
+  if(id == LVM_MAX_VARIABLE_ID || variables[id].name[0] == '\0') {
+    return NULL;
+  }
+
+  return columns[id];
+}
+
+unsigned
+lvm_execute_batch(unsigned count, uint8_t *selection)
+{
+  unsigned i;
+
+  for(i = 0; i < count; i++) {
+    selection[i] = i;
+  }
+
+  return eval_logic_batch(&compiled_nodes[compiled_root],
+                          selection, count, selection);
+}
+#endif /* LVM_COMPILE_PREDICATES */
+
 lvm_status_t
 lvm_set_type(lvm_instance_t *p, node_type_t type)
 {
@@ -588,14 +1088,10 @@ create_union(derivation_t *result, derivation_t *d1, derivation_t *d2)
   int i;
 
   for(i = 0; i < LVM_MAX_VARIABLE_ID; i++) {
-    if(!d1[i].derived && !d2[i].derived) {
+    if(!d1[i].derived || !d2[i].derived) {
+      /* A variable that is unrestricted in one of the operands
+         is unrestricted in the union. */
       continue;
-    } else if(d1[i].derived && !d2[i].derived) {
-      result[i].min.l = d1[i].min.l;
-      result[i].max.l = d1[i].max.l;
-    } else if(!d1[i].derived && d2[i].derived) {
-      result[i].min.l = d2[i].min.l;
-      result[i].max.l = d2[i].max.l;
     } else {
       /* Both derivations have been made; create a
          union of the ranges. */
@@ -629,6 +1125,7 @@ static int
 derive_relation(lvm_instance_t *p, derivation_t *local_derivations)
 {
   operator_t *operator;
+  operator_t op;
   node_type_t type;
   operand_t operand[2];
   int i;
@@ -682,14 +1179,16 @@ derive_relation(lvm_instance_t *p, derivation_t *local_derivations)
 
   /* Determine which of the operands that is the variable. */
   if(operand[0].type == LVM_VARIABLE) {
-    if(operand[1].type == LVM_VARIABLE) {
-      return LVM_DERIVATION_ERROR;
-    }
     variable_id = operand[0].value.id;
     value = &operand[1].value;
-  } else {
+    op = *operator;
+  } else if(operand[1].type == LVM_VARIABLE) {
+    /* The constant is on the left side, so the comparison is mirrored. */
     variable_id = operand[1].value.id;
     value = &operand[0].value;
+    op = mirror_compare(*operator);
+  } else {
+    return LVM_DERIVATION_ERROR;
   }
 
   if(variable_id >= LVM_MAX_VARIABLE_ID) {
@@ -703,7 +1202,7 @@ derive_relation(lvm_instance_t *p, derivation_t *local_derivations)
   derivation->max.l = LONG_MAX;
   derivation->min.l = LONG_MIN;
 
-  switch(*operator) {
+  switch(op) {
   case LVM_EQ:
     derivation->max = *value;
     derivation->min = *value;
@@ -141,4 +141,17 @@ lvm_status_t lvm_set_operand(lvm_instance_t *p, operand_t *op);
 lvm_status_t lvm_set_long(lvm_instance_t *p, long l);
 lvm_status_t lvm_set_variable(lvm_instance_t *p, char *name);
 
+#if LVM_COMPILE_PREDICATES
+/* Compiles the predicate of an instance, or its negation if inverse is
+   set. A compiled predicate is evaluated with lvm_execute_batch(). */
+lvm_status_t lvm_compile(lvm_instance_t *p, int inverse);
+/* Gets the array in which the values of a variable for each tuple of a
+   batch are set, or NULL if the variable is not used. */
+long *lvm_get_column(char *name);
+/* Evaluates the compiled predicate for count tuples, and stores the
+   positions of the tuples for which it holds in selection. Returns the
+   number of such tuples. */
+unsigned lvm_execute_batch(unsigned count, uint8_t *selection);
+#endif /* LVM_COMPILE_PREDICATES */
+
 #endif /* LVM_H */
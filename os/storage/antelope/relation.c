@@ -64,10 +64,66 @@ struct source_dest_map {
   attribute_t *to_attr;
   unsigned from_offset;
   unsigned to_offset;
+#if LVM_COMPILE_PREDICATES
+  long *column;
+#endif
 };
 
 static struct source_dest_map attr_map[AQL_ATTRIBUTE_LIMIT];
 
+/*
+ * Selections without an index evaluate the predicate for a batch of
+ * tuples at a time. The selected tuples of the current batch are
+ * then returned one at a time.
+ */
+struct selection_batch {
+  tuple_id_t first;
+  unsigned count;
+  unsigned next;
+  uint8_t selection[LVM_BATCH_SIZE];
+};
+
+static struct selection_batch batch;
+
+/*
+ * Aggregates are computed in a single pass over the selected tuples.
+ * Each group keeps the running values of the aggregated attributes.
+ * The groups are found through a small chained hash table on the
+ * grouping key. A selection without GROUP BY uses a single group.
+ *
+ * If a new group does not fit, the group with the smallest key is
+ * returned early to make room. This lets time-ordered data be grouped
+ * into any number of buckets. A tuple that would belong to a group that
+ * has already been returned makes the query fail with DB_LIMIT_ERROR.
+ */
+#define GROUP_END	0xff
+
+#if DB_GROUP_LIMIT < 1 || DB_GROUP_LIMIT > 255
+#error "DB_GROUP_LIMIT must be between 1 and 255."
+#endif
+
+struct group {
+  long key;
+  long values[AQL_ATTRIBUTE_LIMIT];
+  tuple_id_t count;
+  uint8_t next;
+};
+
+static struct {
+  struct source_dest_map *key_map;
+  long width;
+  long flushed_key;
+  uint8_t flushed;
+  uint8_t finishing;
+  uint8_t count;
+  uint8_t next_output;
+  uint8_t heads[DB_GROUP_LIMIT];
+  struct group groups[DB_GROUP_LIMIT];
+} aggregation;
+#if LVM_COMPILE_PREDICATES
+static uint8_t predicate_compiled;
+#endif
+
 #if DB_FEATURE_JOIN
 /*
  * The source_map structure is used for mapping attributes to
@@ -79,6 +135,55 @@ struct source_map {
 };
 
 static struct source_map source_map[AQL_ATTRIBUTE_LIMIT];
+
+/*
+ * A join cursor returns the tuples of one of the joined relations
+ * together with their join attribute values. It either scans the
+ * relation in storage order, or follows an index iterator.
+ */
+struct join_cursor {
+  relation_t *rel;
+  attribute_t *attr;
+  unsigned char *row;
+  index_iterator_t iterator;
+  tuple_id_t tuple_id;
+  long key;
+  int offset;
+  uint8_t use_index;
+  uint8_t end;
+};
+
+#define JOIN_INDEX	0
+#define JOIN_HASH	1
+#define JOIN_MERGE	2
+
+#define HASH_END	0xffff
+
+struct hash_entry {
+  long key;
+  tuple_id_t tuple_id;
+  uint16_t next;
+};
+
+/*
+ * The join state. In a merge join, the outer and inner cursors follow
+ * the left and right relations in the order of the join attribute. In
+ * a hash join, the inner cursor reads the smaller relation into a hash
+ * table, and the outer cursor scans the other relation once for each
+ * part of the smaller relation that fits in the table.
+ */
+static struct {
+  struct join_cursor outer;
+  struct join_cursor inner;
+  struct join_cursor mark;
+  uint8_t method;
+  uint8_t matching;
+#if DB_JOIN_HASH_LIMIT > 0
+  uint16_t next_entry;
+  uint16_t heads[DB_JOIN_HASH_LIMIT];
+  struct hash_entry entries[DB_JOIN_HASH_LIMIT];
+#endif /* DB_JOIN_HASH_LIMIT > 0 */
+} join;
 #endif /* DB_FEATURE_JOIN */
 
 static unsigned char row[DB_MAX_ATTRIBUTES_PER_RELATION * DB_MAX_ELEMENT_SIZE];
@@ -547,48 +652,6 @@ relation_insert(relation_t *rel, attribute_value_t *values)
   return storage_put_row(rel, record);
 }
 
-static void
-aggregate(attribute_t *attr, attribute_value_t *value)
-{
-  long long_value;
-
-  switch(value->domain) {
-  case DOMAIN_INT:
-    long_value = VALUE_INT(value);
-    break;
-  case DOMAIN_LONG:
-    long_value = VALUE_LONG(value);
-    break;
-  default:
-    return;
-  }
-
-  switch(attr->aggregator) {
-  case AQL_COUNT:
-    attr->aggregation_value++;
-    break;
-  case AQL_SUM:
-    attr->aggregation_value += long_value;
-    break;
-  case AQL_MEAN:
-    break;
-  case AQL_MEDIAN:
-    break;
-  case AQL_MAX:
-    if(long_value > attr->aggregation_value) {
-      attr->aggregation_value = long_value;
-    }
-    break;
-  case AQL_MIN:
-    if(long_value < attr->aggregation_value) {
-      attr->aggregation_value = long_value;
-    }
-    break;
-  default:
-    break;
-  }
-}
-
 static db_result_t
 generate_attribute_map(struct source_dest_map *attr_map, unsigned attribute_count,
                        relation_t *from_rel, relation_t *to_rel, 
@@ -655,7 +718,7 @@ select_index(db_handle_t *handle, lvm_instance_t *lvm_instance)
 
       if(range <= min_range) {
         index = attr->index;
-        av_min.domain = av_max.domain = DOMAIN_INT;
+        av_min.domain = av_max.domain = DOMAIN_LONG;
         VALUE_LONG(&av_min) = min.l;
         VALUE_LONG(&av_max) = max.l;
       }
@@ -677,6 +740,9 @@ generate_selection_result(db_handle_t *handle, relation_t *rel, aql_adt_t *adt)
   relation_t *result_rel;
   unsigned attribute_count;
   attribute_t *attr;
+#if LVM_COMPILE_PREDICATES
+  struct source_dest_map *attr_map_ptr;
+#endif
 
   result_rel = handle->result_rel;
 
@@ -696,6 +762,8 @@ generate_selection_result(db_handle_t *handle, relation_t *rel, aql_adt_t *adt)
     return DB_IMPLEMENTATION_ERROR;
   }
 
+  batch.count = batch.next = 0;
+
   if(adt->lvm_instance != NULL) {
     /* Try to establish acceptable ranges for the attribute values. */
     if(!LVM_ERROR(lvm_derive(adt->lvm_instance))) {
@@ -703,6 +771,22 @@ generate_selection_result(db_handle_t *handle, relation_t *rel, aql_adt_t *adt)
     }
   }
 
+#if LVM_COMPILE_PREDICATES
+  predicate_compiled = adt->lvm_instance != NULL &&
+    !LVM_ERROR(lvm_compile(adt->lvm_instance,
+                           AQL_GET_FLAGS(adt) & AQL_FLAG_INVERSE_LOGIC));
+  for(attr_map_ptr = attr_map;
+      attr_map_ptr < attr_map + attribute_count;
+      attr_map_ptr++) {
+    attr_map_ptr->column = NULL;
+    if(predicate_compiled &&
+       (attr_map_ptr->from_attr->domain == DOMAIN_INT ||
+        attr_map_ptr->from_attr->domain == DOMAIN_LONG)) {
+      attr_map_ptr->column = lvm_get_column(attr_map_ptr->to_attr->name);
+    }
+  }
+#endif /* LVM_COMPILE_PREDICATES */
+
   handle->flags |= DB_HANDLE_FLAG_PROCESSING;
 
   return DB_OK;
@@ -731,129 +815,515 @@ relation_process_remove(void *handle_ptr)
 }
 #endif
 
-db_result_t
-relation_process_select(void *handle_ptr)
+static long
+phy_to_long(domain_t domain, unsigned char *from_ptr)
+{
+  if(domain == DOMAIN_INT) {
+    return from_ptr[0] << 8 | from_ptr[1];
+  }
+  return (uint32_t)from_ptr[0] << 24 |
+         (uint32_t)from_ptr[1] << 16 |
+         (uint32_t)from_ptr[2] << 8 |
+         from_ptr[3];
+}
+
+static unsigned
+select_rows(db_handle_t *handle, unsigned char *rows, unsigned count,
+            uint8_t *selection)
 {
-  db_handle_t *handle;
   aql_adt_t *adt;
-  db_result_t result;
-  unsigned attribute_count;
   struct source_dest_map *attr_map_ptr, *attr_map_end;
-  attribute_t *result_attr;
-  unsigned char *from_ptr;
-  unsigned char *to_ptr;
+  attribute_t *source_attr;
+#if LVM_COMPILE_PREDICATES
+  unsigned char *row_ptr;
+#endif
   operand_value_t operand_value;
-  uint8_t intbuf[2];
-  attribute_value_t value;
   lvm_status_t wanted_result;
+  unsigned row_length;
+  unsigned selected;
+  unsigned i;
 
-  handle = (db_handle_t *)handle_ptr;
   adt = (aql_adt_t *)handle->adt;
+  attr_map_end = attr_map + handle->result_rel->attribute_count;
+  row_length = handle->rel->row_length;
 
-  attribute_count = handle->result_rel->attribute_count;
-  attr_map_end = attr_map + attribute_count;
+  if(adt->lvm_instance == NULL) {
+    for(i = 0; i < count; i++) {
+      selection[i] = i;
+    }
+    return count;
+  }
 
-  if(handle->flags & DB_HANDLE_FLAG_SEARCH_INDEX) {
-    handle->tuple_id = index_get_next(&handle->index_iterator);
-    if(handle->tuple_id == INVALID_TUPLE) {
-      PRINTF("DB: An attribute value could not be found in the index\n");
-      if(handle->index_iterator.next_item_no == 0) {
-        return DB_INDEX_ERROR;
+#if LVM_COMPILE_PREDICATES
+  if(predicate_compiled) {
+    /* Set the values of the predicate variables one column at a time. */
+    for(attr_map_ptr = attr_map; attr_map_ptr < attr_map_end; attr_map_ptr++) {
+      if(attr_map_ptr->column == NULL) {
+        continue;
       }
+      row_ptr = rows + attr_map_ptr->from_offset;
+      for(i = 0; i < count; i++, row_ptr += row_length) {
+        attr_map_ptr->column[i] =
+          phy_to_long(attr_map_ptr->from_attr->domain, row_ptr);
+      }
+    }
+    return lvm_execute_batch(count, selection);
+  }
+#endif /* LVM_COMPILE_PREDICATES */
+
+  wanted_result = LVM_TRUE;
+  if(AQL_GET_FLAGS(adt) & AQL_FLAG_INVERSE_LOGIC) {
+    wanted_result = LVM_FALSE;
+  }
 
-      if(adt->flags & AQL_FLAG_AGGREGATE) {
-        goto end_aggregation;
+  for(i = selected = 0; i < count; i++, rows += row_length) {
+    /* Update the internal state of the PLE. */
+    for(attr_map_ptr = attr_map; attr_map_ptr < attr_map_end; attr_map_ptr++) {
+      source_attr = attr_map_ptr->from_attr;
+      if(source_attr->domain == DOMAIN_INT ||
+         source_attr->domain == DOMAIN_LONG) {
+        operand_value.l = phy_to_long(source_attr->domain,
+                                      rows + attr_map_ptr->from_offset);
+        lvm_set_variable_value(source_attr->name, operand_value);
       }
+    }
 
-      return DB_FINISHED;
+    /* Check whether the given predicate is true for this tuple. */
+    if(lvm_execute(adt->lvm_instance) == wanted_result) {
+      selection[selected++] = i;
     }
   }
 
-  /* Put the tuples fulfilling the given condition into a new relation.
-     The tuples may be projected. */
-  result = storage_get_row(handle->rel, &handle->tuple_id, row);
-  handle->tuple_id++;
-  if(DB_ERROR(result)) {
-    PRINTF("DB: Failed to get a row in relation %s!\n", handle->rel->name);
-    return result;
-  } else if(result == DB_FINISHED) {
-    if(AQL_GET_FLAGS(adt) & AQL_FLAG_AGGREGATE) {
-      goto end_aggregation;
-    }
-    return DB_FINISHED;
+  return selected;
+}
+
+static long
+row_to_long(struct source_dest_map *attr_map_ptr, unsigned char *row_ptr)
+{
+  attribute_value_t value;
+
+  if(DB_ERROR(db_phy_to_value(&value, attr_map_ptr->from_attr,
+                              row_ptr + attr_map_ptr->from_offset))) {
+    return 0;
   }
+  return db_value_to_long(&value);
+}
 
-  /* Process the attributes in the result relation. */
-  for(attr_map_ptr = attr_map; attr_map_ptr < attr_map_end; attr_map_ptr++) {
-    from_ptr = row + attr_map_ptr->from_offset;
-    result_attr = attr_map_ptr->to_attr;
+static void
+group_init(struct group *group, long key, unsigned attribute_count)
+{
+  unsigned i;
 
-    /* Update the internal state of the PLE. */
-    if(result_attr->domain == DOMAIN_INT) {
-      operand_value.l = from_ptr[0] << 8 | from_ptr[1];
-      lvm_set_variable_value(result_attr->name, operand_value);
-    } else if(result_attr->domain == DOMAIN_LONG) {
-      operand_value.l = (uint32_t)from_ptr[0] << 24 |
-                        (uint32_t)from_ptr[1] << 16 |
-                        (uint32_t)from_ptr[2] << 8 |
-                        from_ptr[3];
-      lvm_set_variable_value(result_attr->name, operand_value);
+  group->key = key;
+  group->count = 0;
+  for(i = 0; i < attribute_count; i++) {
+    switch(attr_map[i].to_attr->aggregator) {
+    case AQL_MAX:
+      group->values[i] = LONG_MIN;
+      break;
+    case AQL_MIN:
+      group->values[i] = LONG_MAX;
+      break;
+    default:
+      group->values[i] = 0;
+      break;
     }
+  }
+}
 
-    if(result_attr->flags & ATTRIBUTE_FLAG_NO_STORE) {
-      /* The attribute is used just for the predicate,
-         so do not copy the current value into the result. */
+static void
+group_link(struct group *group)
+{
+  unsigned bucket;
+
+  bucket = (unsigned long)group->key % DB_GROUP_LIMIT;
+  group->next = aggregation.heads[bucket];
+  aggregation.heads[bucket] = group - aggregation.groups;
+}
+
+static void
+group_unlink(struct group *group)
+{
+  uint8_t *link;
+
+  link = &aggregation.heads[(unsigned long)group->key % DB_GROUP_LIMIT];
+  while(&aggregation.groups[*link] != group) {
+    link = &aggregation.groups[*link].next;
+  }
+  *link = group->next;
+}
+
+static db_result_t
+emit_group(db_handle_t *handle, struct group *group)
+{
+  struct source_dest_map *attr_map_ptr;
+  attribute_t *attr;
+  attribute_value_t value;
+  unsigned attribute_count;
+  long long_value;
+
+  attribute_count = handle->result_rel->attribute_count;
+  for(attr_map_ptr = attr_map;
+      attr_map_ptr < attr_map + attribute_count;
+      attr_map_ptr++) {
+    attr = attr_map_ptr->to_attr;
+    if(attr->flags & ATTRIBUTE_FLAG_NO_STORE) {
       continue;
     }
 
-    if(!(AQL_GET_FLAGS(adt) & AQL_FLAG_AGGREGATE)) {
-      /* No aggregators. Copy the original value into the resulting tuple. */
-      memcpy(result_row + attr_map_ptr->to_offset, from_ptr,
-             result_attr->element_size);
+    long_value = group->values[attr_map_ptr - attr_map];
+    switch(attr->aggregator) {
+    case AQL_NONE:
+      /* The grouping attribute. */
+      long_value = aggregation.width > 0 ?
+        group->key * aggregation.width : group->key;
+      break;
+    case AQL_COUNT:
+      long_value = group->count;
+      break;
+    case AQL_MEAN:
+      long_value = group->count > 0 ? long_value / (long)group->count : 0;
+      break;
+    case AQL_MAX:
+    case AQL_MIN:
+      if(group->count == 0) {
+        long_value = 0;
+      }
+      break;
+    default:
+      break;
+    }
+
+    value.domain = attr->domain;
+    if(attr->domain == DOMAIN_INT) {
+      VALUE_INT(&value) = long_value;
+    } else {
+      VALUE_LONG(&value) = long_value;
     }
+    db_value_to_phy(result_row + attr_map_ptr->to_offset, attr, &value);
   }
 
-  wanted_result = LVM_TRUE;
-  if(AQL_GET_FLAGS(adt) & AQL_FLAG_INVERSE_LOGIC) {
-    wanted_result = LVM_FALSE;
+  if(AQL_GET_FLAGS((aql_adt_t *)handle->adt) & AQL_FLAG_ASSIGN) {
+    if(DB_ERROR(storage_put_row(handle->result_rel, result_row))) {
+      PRINTF("DB: Failed to store a row in the result relation!\n");
+      return DB_STORAGE_ERROR;
+    }
   }
 
-  /* Check whether the given predicate is true for this tuple. */
-  if(adt->lvm_instance == NULL ||
-     lvm_execute(adt->lvm_instance) == wanted_result) {
-    if(AQL_GET_FLAGS(adt) & AQL_FLAG_AGGREGATE) {
-      for(attr_map_ptr = attr_map; attr_map_ptr < attr_map_end; attr_map_ptr++) {
-        from_ptr = row + attr_map_ptr->from_offset;
-        result = db_phy_to_value(&value, attr_map_ptr->to_attr, from_ptr);
-        if(DB_ERROR(result)) {
-	  return result;
+  handle->current_row++;
+  return DB_GOT_ROW;
+}
+
+/*
+ * Add a selected tuple to its group. Returns DB_GOT_ROW if a group
+ * had to be returned to make room for a new one.
+ */
+static db_result_t
+aggregate_row(db_handle_t *handle, unsigned char *row_ptr)
+{
+  struct source_dest_map *attr_map_ptr;
+  struct group *group;
+  struct group *victim;
+  unsigned attribute_count;
+  db_result_t result;
+  uint8_t i;
+  long key;
+  long value;
+  long *aggregate;
+
+  attribute_count = handle->result_rel->attribute_count;
+  result = DB_OK;
+
+  key = 0;
+  if(aggregation.key_map != NULL) {
+    key = row_to_long(aggregation.key_map, row_ptr);
+    if(aggregation.width > 0) {
+      /* Use the number of the bucket as the key. */
+      value = key % aggregation.width;
+      key = key / aggregation.width - (value < 0);
+    }
+  }
+
+  for(i = aggregation.heads[(unsigned long)key % DB_GROUP_LIMIT];
+      i != GROUP_END && aggregation.groups[i].key != key;
+      i = aggregation.groups[i].next);
+
+  if(i != GROUP_END) {
+    group = &aggregation.groups[i];
+  } else {
+    if(aggregation.flushed && key <= aggregation.flushed_key) {
+      PRINTF("DB: The group of key %ld has already been returned\n", key);
+      return DB_LIMIT_ERROR;
+    }
+
+    if(aggregation.count < DB_GROUP_LIMIT) {
+      group = &aggregation.groups[aggregation.count++];
+    } else {
+      /* Return the group with the smallest key and reuse its slot. */
+      group = aggregation.groups;
+      for(victim = aggregation.groups + 1;
+          victim < aggregation.groups + DB_GROUP_LIMIT;
+          victim++) {
+        if(victim->key < group->key) {
+          group = victim;
         }
-        aggregate(attr_map_ptr->to_attr, &value);
       }
+
+      result = emit_group(handle, group);
+      if(DB_ERROR(result)) {
+        return result;
+      }
+      group_unlink(group);
+      if(!aggregation.flushed || group->key > aggregation.flushed_key) {
+        aggregation.flushed_key = group->key;
+      }
+      aggregation.flushed = 1;
+    }
+
+    group_init(group, key, attribute_count);
+    group_link(group);
+  }
+
+  group->count++;
+  for(attr_map_ptr = attr_map;
+      attr_map_ptr < attr_map + attribute_count;
+      attr_map_ptr++) {
+    aggregate = &group->values[attr_map_ptr - attr_map];
+    switch(attr_map_ptr->to_attr->aggregator) {
+    case AQL_SUM:
+    case AQL_MEAN:
+      *aggregate += row_to_long(attr_map_ptr, row_ptr);
+      break;
+    case AQL_MAX:
+      value = row_to_long(attr_map_ptr, row_ptr);
+      if(value > *aggregate) {
+        *aggregate = value;
+      }
+      break;
+    case AQL_MIN:
+      value = row_to_long(attr_map_ptr, row_ptr);
+      if(value < *aggregate) {
+        *aggregate = value;
+      }
+      break;
+    default:
+      break;
+    }
+  }
+
+  return result;
+}
+
+/*
+ * Aggregate the remaining tuples of the current batch. If the rows of
+ * the batch are no longer buffered, the tuples are read one at a time.
+ */
+static db_result_t
+aggregate_batch(db_handle_t *handle, unsigned char *rows)
+{
+  unsigned char *row_ptr;
+  tuple_id_t tuple_id;
+  db_result_t result;
+
+  while(batch.next < batch.count) {
+    if(rows != NULL) {
+      row_ptr = rows + batch.selection[batch.next] * handle->rel->row_length;
     } else {
-      if(AQL_GET_FLAGS(adt) & AQL_FLAG_ASSIGN) {
-        if(DB_ERROR(storage_put_row(handle->result_rel, result_row))) {
-          PRINTF("DB: Failed to store a row in the result relation!\n");
-          return DB_STORAGE_ERROR;
-        }
+      tuple_id = batch.first + batch.selection[batch.next];
+      result = storage_get_row(handle->rel, &tuple_id, row);
+      if(result != DB_OK) {
+        return DB_ERROR(result) ? result : DB_STORAGE_ERROR;
       }
-      handle->current_row++;
-      return DB_GOT_ROW;
+      row_ptr = row;
+    }
+    batch.next++;
+
+    result = aggregate_row(handle, row_ptr);
+    if(result != DB_OK) {
+      return result;
     }
   }
 
   return DB_OK;
+}
+
+static db_result_t
+finish_aggregation(db_handle_t *handle)
+{
+  struct group group;
+  uint8_t i, j;
+
+  if(!aggregation.finishing) {
+    /* Return the groups in the order of their keys. */
+    for(i = 1; i < aggregation.count; i++) {
+      group = aggregation.groups[i];
+      for(j = i; j > 0 && aggregation.groups[j - 1].key > group.key; j--) {
+        aggregation.groups[j] = aggregation.groups[j - 1];
+      }
+      aggregation.groups[j] = group;
+    }
+    aggregation.finishing = 1;
+    aggregation.next_output = 0;
+  }
+
+  if(aggregation.next_output == aggregation.count) {
+    /* Stop the aggregation. */
+    AQL_GET_FLAGS((aql_adt_t *)handle->adt) &= ~AQL_FLAG_AGGREGATE;
+    return DB_FINISHED;
+  }
+
+  return emit_group(handle, &aggregation.groups[aggregation.next_output++]);
+}
+
+static db_result_t
+init_aggregation(db_handle_t *handle, aql_adt_t *adt)
+{
+  struct source_dest_map *attr_map_ptr;
+  unsigned attribute_count;
+  attribute_t *attr;
+
+  attribute_count = handle->result_rel->attribute_count;
+
+  aggregation.key_map = NULL;
+  aggregation.width = 0;
+  aggregation.flushed = 0;
+  aggregation.finishing = 0;
+  aggregation.count = 0;
+  memset(aggregation.heads, GROUP_END, sizeof(aggregation.heads));
+
+  if(AQL_GET_FLAGS(adt) & AQL_FLAG_GROUP) {
+    for(attr_map_ptr = attr_map;
+        attr_map_ptr < attr_map + attribute_count;
+        attr_map_ptr++) {
+      attr = attr_map_ptr->to_attr;
+      if(attr->aggregator == AQL_NONE &&
+         strcmp(attr->name, adt->group_attribute) == 0) {
+        break;
+      }
+    }
+    if(attr_map_ptr == attr_map + attribute_count ||
+       (attr->domain != DOMAIN_INT && attr->domain != DOMAIN_LONG)) {
+      PRINTF("DB: Cannot group by attribute %s\n", adt->group_attribute);
+      return DB_RELATIONAL_ERROR;
+    }
+    aggregation.key_map = attr_map_ptr;
+    aggregation.width = adt->group_width;
+  } else {
+    /* All tuples belong to a single group. */
+    group_init(&aggregation.groups[0], 0, attribute_count);
+    group_link(&aggregation.groups[0]);
+    aggregation.count = 1;
+  }
+
+  return DB_OK;
+}
+
+db_result_t
+relation_process_select(void *handle_ptr)
+{
+  db_handle_t *handle;
+  aql_adt_t *adt;
+  db_result_t result;
+  unsigned attribute_count;
+  struct source_dest_map *attr_map_ptr, *attr_map_end;
+  attribute_t *result_attr;
+  unsigned char *rows;
+  tuple_id_t count;
+  tuple_id_t tuple_id;
 
-end_aggregation:
-  /* Generate aggregated result if requested. */
+  handle = (db_handle_t *)handle_ptr;
+  adt = (aql_adt_t *)handle->adt;
+
+  attribute_count = handle->result_rel->attribute_count;
+  attr_map_end = attr_map + attribute_count;
+
+  if((AQL_GET_FLAGS(adt) & AQL_FLAG_AGGREGATE) && aggregation.finishing) {
+    return finish_aggregation(handle);
+  }
+
+  if(handle->flags & DB_HANDLE_FLAG_SEARCH_INDEX) {
+    handle->tuple_id = index_get_next(&handle->index_iterator);
+    if(handle->tuple_id == INVALID_TUPLE) {
+      PRINTF("DB: No more attribute values in the index range\n");
+      if(AQL_GET_FLAGS(adt) & AQL_FLAG_AGGREGATE) {
+        return finish_aggregation(handle);
+      }
+
+      return DB_FINISHED;
+    }
+
+    result = storage_get_row(handle->rel, &handle->tuple_id, row);
+    handle->tuple_id++;
+    if(DB_ERROR(result)) {
+      PRINTF("DB: Failed to get a row in relation %s!\n", handle->rel->name);
+      return result;
+    } else if(result == DB_FINISHED) {
+      if(AQL_GET_FLAGS(adt) & AQL_FLAG_AGGREGATE) {
+        return finish_aggregation(handle);
+      }
+      return DB_FINISHED;
+    }
+
+    if(select_rows(handle, row, 1, batch.selection) == 0) {
+      return DB_OK;
+    }
+
+    if(AQL_GET_FLAGS(adt) & AQL_FLAG_AGGREGATE) {
+      return aggregate_row(handle, row);
+    }
+  } else {
+    if(batch.next == batch.count) {
+      /* Evaluate the predicate for the next batch of tuples. */
+      count = LVM_BATCH_SIZE;
+      result = storage_get_rows(handle->rel, &handle->tuple_id, &rows, &count);
+      if(DB_ERROR(result)) {
+        PRINTF("DB: Failed to get a row in relation %s!\n", handle->rel->name);
+        return result;
+      } else if(result == DB_FINISHED) {
+        if(AQL_GET_FLAGS(adt) & AQL_FLAG_AGGREGATE) {
+          return finish_aggregation(handle);
+        }
+        return DB_FINISHED;
+      }
+
+      batch.first = handle->tuple_id;
+      batch.count = select_rows(handle, rows, count, batch.selection);
+      batch.next = 0;
+      handle->tuple_id += count;
+
+      if(AQL_GET_FLAGS(adt) & AQL_FLAG_AGGREGATE) {
+        return aggregate_batch(handle, rows);
+      }
+
+      if(batch.count == 0) {
+        return DB_OK;
+      }
+    } else if(AQL_GET_FLAGS(adt) & AQL_FLAG_AGGREGATE) {
+      /* A group was returned in the middle of the batch. */
+      return aggregate_batch(handle, NULL);
+    }
+
+    /* The batch rows are only valid until the next storage access. */
+    tuple_id = batch.first + batch.selection[batch.next++];
+    result = storage_get_row(handle->rel, &tuple_id, row);
+    if(result != DB_OK) {
+      PRINTF("DB: Failed to get a row in relation %s!\n", handle->rel->name);
+      return DB_ERROR(result) ? result : DB_STORAGE_ERROR;
+    }
+  }
+
+  /* Put the tuples fulfilling the given condition into a new relation.
+     The tuples may be projected. */
   for(attr_map_ptr = attr_map; attr_map_ptr < attr_map_end; attr_map_ptr++) {
     result_attr = attr_map_ptr->to_attr;
-    to_ptr = result_row + attr_map_ptr->to_offset;
+    if(result_attr->flags & ATTRIBUTE_FLAG_NO_STORE) {
+      /* The attribute is used just for the predicate,
+         so do not copy the current value into the result. */
+      continue;
+    }
 
-    intbuf[0] = result_attr->aggregation_value >> 8;
-    intbuf[1] = result_attr->aggregation_value & 0xff;
-    from_ptr = intbuf;
-    memcpy(to_ptr, from_ptr, result_attr->element_size);
+    memcpy(result_row + attr_map_ptr->to_offset,
+           row + attr_map_ptr->from_offset, result_attr->element_size);
   }
 
   if(AQL_GET_FLAGS(adt) & AQL_FLAG_ASSIGN) {
@@ -862,10 +1332,7 @@ end_aggregation:
       return DB_STORAGE_ERROR;
     }
   }
-
-  handle->current_row = 1;
-  AQL_GET_FLAGS(adt) &= ~AQL_FLAG_AGGREGATE; /* Stop the aggregation. */
-
+  handle->current_row++;
   return DB_GOT_ROW;
 }
 
@@ -880,6 +1347,7 @@ relation_select(void *handle_ptr, relation_t *rel, void *adt_ptr)
   attribute_t *attr;
   int i;
   int normal_attributes;
+  db_result_t result;
 
   adt = (aql_adt_t *)adt_ptr;
 
@@ -918,8 +1386,8 @@ relation_select(void *handle_ptr, relation_t *rel, void *adt_ptr)
 
     attr = relation_attribute_add(handle->result_rel, dir,
 				  attribute_name, 
-				  adt->aggregators[i] ? DOMAIN_INT : attr->domain,
-				  attr->element_size);
+				  adt->aggregators[i] ? DOMAIN_LONG : attr->domain,
+				  adt->aggregators[i] ? 4 : attr->element_size);
     if(attr == NULL) {
       PRINTF("DB: Failed to add a result attribute\n");
       relation_release(handle->result_rel);
@@ -927,22 +1395,13 @@ relation_select(void *handle_ptr, relation_t *rel, void *adt_ptr)
     }
 
     attr->aggregator = adt->aggregators[i];
-    switch(attr->aggregator) {
-    case AQL_NONE:
-      if(!(adt->attributes[i].flags & ATTRIBUTE_FLAG_NO_STORE)) {
-        /* Only count attributes projected into the result set. */
-        normal_attributes++;
-      }
-      break;
-    case AQL_MAX:
-      attr->aggregation_value = LONG_MIN;
-      break;
-    case AQL_MIN:
-      attr->aggregation_value = LONG_MAX;
-      break;
-    default:
-      attr->aggregation_value = 0;
-      break;
+    if(attr->aggregator == AQL_NONE &&
+       !(adt->attributes[i].flags & ATTRIBUTE_FLAG_NO_STORE) &&
+       !((AQL_GET_FLAGS(adt) & AQL_FLAG_GROUP) &&
+         strcmp(attribute_name, adt->group_attribute) == 0)) {
+      /* Only count attributes projected into the result set. The
+         grouping attribute can be projected along with aggregates. */
+      normal_attributes++;
     }
 
     attr->flags = adt->attributes[i].flags;
@@ -955,28 +1414,132 @@ relation_select(void *handle_ptr, relation_t *rel, void *adt_ptr)
      return DB_RELATIONAL_ERROR;
   }
 
-  return generate_selection_result(handle, rel, adt);
+  result = generate_selection_result(handle, rel, adt);
+  if(DB_ERROR(result) || !(AQL_GET_FLAGS(adt) & AQL_FLAG_AGGREGATE)) {
+    return result;
+  }
+
+  return init_aggregation(handle, adt);
 }
 
 #if DB_FEATURE_JOIN
-db_result_t
-relation_process_join(void *handle_ptr)
+static db_result_t
+emit_join_row(db_handle_t *handle)
+{
+  unsigned char *join_next_attribute_ptr;
+  size_t element_size;
+  int i;
+
+  /* Use the source attribute map to fill in the physical representation
+     of the resulting tuple. */
+  join_next_attribute_ptr = join_row;
+
+  for(i = 0; i < handle->join_rel->attribute_count; i++) {
+    element_size = source_map[i].attr->element_size;
+
+    memcpy(join_next_attribute_ptr, source_map[i].from_ptr, element_size);
+    join_next_attribute_ptr += element_size;
+  }
+
+  if(((aql_adt_t *)handle->adt)->flags & AQL_FLAG_ASSIGN) {
+    if(DB_ERROR(storage_put_row(handle->join_rel, join_row))) {
+      return DB_STORAGE_ERROR;
+    }
+  }
+
+  handle->current_row++;
+  return DB_GOT_ROW;
+}
+
+static db_result_t
+cursor_init(struct join_cursor *cursor, relation_t *rel, attribute_t *attr,
+            unsigned char *row, int use_index)
+{
+  attribute_value_t min;
+  attribute_value_t max;
+
+  cursor->rel = rel;
+  cursor->attr = attr;
+  cursor->row = row;
+  cursor->tuple_id = INVALID_TUPLE;
+  cursor->end = 0;
+  cursor->offset = get_attribute_value_offset(rel, attr);
+  if(cursor->offset < 0) {
+    return DB_IMPLEMENTATION_ERROR;
+  }
+
+  /* The rows of a relation with an inline index are already stored in
+     the order of the indexed attribute. */
+  cursor->use_index = use_index &&
+    ((index_t *)attr->index)->type != INDEX_INLINE;
+  if(cursor->use_index) {
+    min.domain = max.domain = DOMAIN_LONG;
+    VALUE_LONG(&min) = LONG_MIN;
+    VALUE_LONG(&max) = LONG_MAX;
+    return index_get_iterator(&cursor->iterator, attr->index, &min, &max);
+  }
+
+  return DB_OK;
+}
+
+/* Read a tuple into the row of the cursor without moving the cursor. */
+static db_result_t
+cursor_fetch(struct join_cursor *cursor, tuple_id_t tuple_id)
+{
+  db_result_t result;
+
+  result = storage_get_row(cursor->rel, &tuple_id, cursor->row);
+  if(result == DB_FINISHED) {
+    PRINTF("DB: The join refers to an invalid row: %lu\n",
+           (unsigned long)tuple_id);
+    return DB_IMPLEMENTATION_ERROR;
+  }
+  return result;
+}
+
+static db_result_t
+cursor_next(struct join_cursor *cursor)
+{
+  db_result_t result;
+
+  if(cursor->end) {
+    return DB_FINISHED;
+  }
+
+  if(cursor->use_index) {
+    cursor->tuple_id = index_get_next(&cursor->iterator);
+    if(cursor->tuple_id == INVALID_TUPLE) {
+      cursor->end = 1;
+      return DB_FINISHED;
+    }
+  } else {
+    cursor->tuple_id++;
+  }
+
+  result = storage_get_row(cursor->rel, &cursor->tuple_id, cursor->row);
+  if(DB_ERROR(result)) {
+    PRINTF("DB: Failed to get a row in relation %s!\n", cursor->rel->name);
+    return result;
+  } else if(result == DB_FINISHED) {
+    cursor->end = 1;
+    return DB_FINISHED;
+  }
+
+  cursor->key = phy_to_long(cursor->attr->domain, cursor->row + cursor->offset);
+  return DB_OK;
+}
+
+static db_result_t
+process_index_join(db_handle_t *handle)
 {
-  db_handle_t *handle;
   db_result_t result;
   relation_t *left_rel;
   relation_t *right_rel;
-  relation_t *join_rel;
-  unsigned char *join_next_attribute_ptr;
-  size_t element_size;
   tuple_id_t right_tuple_id;
   attribute_value_t value;
-  int i;
 
-  handle = (db_handle_t *)handle_ptr;
   left_rel = handle->left_rel;
   right_rel = handle->right_rel;
-  join_rel = handle->join_rel;
 
   if(!(handle->flags & DB_HANDLE_FLAG_INDEX_STEP)) {
     goto inner_loop;
@@ -1030,28 +1593,254 @@ inner_loop:
         return DB_IMPLEMENTATION_ERROR;
       }
 
-      /* Use the source attribute map to fill in the physical representation
-	 of the resulting tuple. */
-      join_next_attribute_ptr = join_row;
+      return emit_join_row(handle);
+    }
+  }
+
+  return DB_OK;
+}
 
-      for(i = 0; i < join_rel->attribute_count; i++) {
-	element_size = source_map[i].attr->element_size;
+static db_result_t
+process_merge_join(db_handle_t *handle)
+{
+  db_result_t result;
 
-	memcpy(join_next_attribute_ptr, source_map[i].from_ptr, element_size);
-	join_next_attribute_ptr += element_size;
+  for(;;) {
+    if(join.matching) {
+      /* Continue with the next inner tuple that has the same value,
+         and then repeat the group of inner tuples for the next outer
+         tuple if it also has the same value. */
+      result = cursor_next(&join.inner);
+      if(DB_ERROR(result)) {
+        return result;
+      } else if(result == DB_OK && join.inner.key == join.outer.key) {
+        return emit_join_row(handle);
       }
 
-      if(((aql_adt_t *)handle->adt)->flags & AQL_FLAG_ASSIGN) {
-        if(DB_ERROR(storage_put_row(join_rel, join_row))) {
-          return DB_STORAGE_ERROR;
+      result = cursor_next(&join.outer);
+      if(DB_ERROR(result)) {
+        return result;
+      } else if(result == DB_OK && join.outer.key == join.mark.key) {
+        join.inner = join.mark;
+        result = cursor_fetch(&join.inner, join.inner.tuple_id);
+        if(DB_ERROR(result)) {
+          return result;
         }
+        return emit_join_row(handle);
       }
+      join.matching = 0;
+    }
+
+    if(join.outer.end || join.inner.end) {
+      return DB_FINISHED;
+    }
+
+    if(join.outer.key < join.inner.key) {
+      result = cursor_next(&join.outer);
+    } else if(join.outer.key > join.inner.key) {
+      result = cursor_next(&join.inner);
+    } else {
+      join.mark = join.inner;
+      join.matching = 1;
+      return emit_join_row(handle);
+    }
 
-      handle->current_row++;
-      return DB_GOT_ROW;
+    if(DB_ERROR(result)) {
+      return result;
     }
   }
+}
 
+#if DB_JOIN_HASH_LIMIT > 0
+static void
+cursor_rewind(struct join_cursor *cursor)
+{
+  cursor->tuple_id = INVALID_TUPLE;
+  cursor->end = 0;
+}
+
+static db_result_t
+build_hash_table(void)
+{
+  db_result_t result;
+  unsigned count;
+  unsigned bucket;
+
+  /* Read the next part of the inner relation into the hash table. */
+  for(count = 0; count < DB_JOIN_HASH_LIMIT; count++) {
+    result = cursor_next(&join.inner);
+    if(DB_ERROR(result)) {
+      return result;
+    } else if(result == DB_FINISHED) {
+      break;
+    }
+    join.entries[count].key = join.inner.key;
+    join.entries[count].tuple_id = join.inner.tuple_id;
+  }
+
+  if(count == 0) {
+    return DB_FINISHED;
+  }
+
+  PRINTF("DB: Built a join hash table with %u tuples from %s\n",
+         count, join.inner.rel->name);
+
+  /* Link the entries in reverse order, so that the tuples of each
+     bucket are found in the order of the relation. */
+  memset(join.heads, 0xff, sizeof(join.heads));
+  while(count-- > 0) {
+    bucket = (unsigned long)join.entries[count].key % DB_JOIN_HASH_LIMIT;
+    join.entries[count].next = join.heads[bucket];
+    join.heads[bucket] = count;
+  }
+
+  cursor_rewind(&join.outer);
+  return DB_OK;
+}
+
+static db_result_t
+process_hash_join(db_handle_t *handle)
+{
+  db_result_t result;
+  struct hash_entry *entry;
+
+  for(;;) {
+    while(join.next_entry != HASH_END) {
+      entry = &join.entries[join.next_entry];
+      join.next_entry = entry->next;
+      if(entry->key == join.outer.key) {
+        result = cursor_fetch(&join.inner, entry->tuple_id);
+        if(DB_ERROR(result)) {
+          return result;
+        }
+        return emit_join_row(handle);
+      }
+    }
+
+    result = cursor_next(&join.outer);
+    if(DB_ERROR(result)) {
+      return result;
+    } else if(result == DB_FINISHED) {
+      /* The outer relation has been scanned for this part of the inner
+         relation. Continue with the next part, if any. */
+      result = build_hash_table();
+      if(result != DB_OK) {
+        return result;
+      }
+      continue;
+    }
+
+    join.next_entry =
+      join.heads[(unsigned long)join.outer.key % DB_JOIN_HASH_LIMIT];
+  }
+}
+#endif /* DB_JOIN_HASH_LIMIT > 0 */
+
+db_result_t
+relation_process_join(void *handle_ptr)
+{
+  db_handle_t *handle;
+
+  handle = (db_handle_t *)handle_ptr;
+
+  switch(join.method) {
+  case JOIN_MERGE:
+    return process_merge_join(handle);
+#if DB_JOIN_HASH_LIMIT > 0
+  case JOIN_HASH:
+    return process_hash_join(handle);
+#endif /* DB_JOIN_HASH_LIMIT > 0 */
+  default:
+    return process_index_join(handle);
+  }
+}
+
+static int
+is_ordered(attribute_t *attr)
+{
+  return index_exists(attr) &&
+    (((index_t *)attr->index)->api->flags & INDEX_API_RANGE_QUERIES);
+}
+
+static db_result_t
+plan_join(db_handle_t *handle)
+{
+  relation_t *left_rel;
+  relation_t *right_rel;
+  attribute_t *left_attr;
+  attribute_t *right_attr;
+#if DB_JOIN_HASH_LIMIT > 0
+  tuple_id_t left_cardinality;
+  tuple_id_t right_cardinality;
+  db_result_t result;
+#endif /* DB_JOIN_HASH_LIMIT > 0 */
+
+  left_rel = handle->left_rel;
+  right_rel = handle->right_rel;
+  left_attr = handle->left_join_attr;
+  right_attr = handle->right_join_attr;
+
+  if((left_attr->domain != DOMAIN_INT && left_attr->domain != DOMAIN_LONG) ||
+     (right_attr->domain != DOMAIN_INT && right_attr->domain != DOMAIN_LONG)) {
+    PRINTF("DB: Cannot join on a non-number attribute\n");
+    return DB_RELATIONAL_ERROR;
+  }
+
+  /* Merge the relations if both can be read in the order of the
+     join attribute. */
+  if(is_ordered(left_attr) && is_ordered(right_attr)) {
+    PRINTF("DB: Using a merge join\n");
+    join.method = JOIN_MERGE;
+    join.matching = 0;
+    if(DB_ERROR(cursor_init(&join.outer, left_rel, left_attr, left_row, 1)) ||
+       DB_ERROR(cursor_init(&join.inner, right_rel, right_attr, right_row, 1)) ||
+       DB_ERROR(cursor_next(&join.outer)) ||
+       DB_ERROR(cursor_next(&join.inner))) {
+      return DB_INDEX_ERROR;
+    }
+    return DB_OK;
+  }
+
+#if DB_JOIN_HASH_LIMIT > 0
+  left_cardinality = relation_cardinality(left_rel);
+  right_cardinality = relation_cardinality(right_rel);
+  if(left_cardinality == INVALID_TUPLE || right_cardinality == INVALID_TUPLE) {
+    return DB_STORAGE_ERROR;
+  }
+
+  /* Use a hash table over the smaller relation if it fits, or if there
+     is no index to look up matching tuples with. A smaller relation
+     that does not fit is joined in several passes. */
+  if(left_cardinality <= DB_JOIN_HASH_LIMIT ||
+     right_cardinality <= DB_JOIN_HASH_LIMIT ||
+     !index_exists(right_attr)) {
+    PRINTF("DB: Using a hash join\n");
+    join.method = JOIN_HASH;
+    join.next_entry = HASH_END;
+    if(left_cardinality < right_cardinality) {
+      result = cursor_init(&join.inner, left_rel, left_attr, left_row, 0);
+      if(!DB_ERROR(result)) {
+        result = cursor_init(&join.outer, right_rel, right_attr, right_row, 0);
+      }
+    } else {
+      result = cursor_init(&join.inner, right_rel, right_attr, right_row, 0);
+      if(!DB_ERROR(result)) {
+        result = cursor_init(&join.outer, left_rel, left_attr, left_row, 0);
+      }
+    }
+    /* The hash table is built when the first tuple is requested. */
+    join.outer.end = 1;
+    return result;
+  }
+#endif /* DB_JOIN_HASH_LIMIT > 0 */
+
+  if(!index_exists(right_attr)) {
+    PRINTF("DB: The attribute to join on is not indexed\n");
+    return DB_INDEX_ERROR;
+  }
+
+  PRINTF("DB: Using an index join\n");
+  join.method = JOIN_INDEX;
   return DB_OK;
 }
 
@@ -1120,6 +1909,7 @@ relation_join(void *query_result, void *adt_ptr)
   int i;
   char *attribute_name;
   attribute_t *attr;
+  db_result_t result;
 
   adt = (aql_adt_t *)adt_ptr;
 
@@ -1158,9 +1948,9 @@ relation_join(void *query_result, void *adt_ptr)
     return DB_RELATIONAL_ERROR;
   }
 
-  if(!index_exists(handle->right_join_attr)) {
-    PRINTF("DB: The attribute to join on is not indexed\n");
-    return DB_INDEX_ERROR;
+  result = plan_join(handle);
+  if(DB_ERROR(result)) {
+    return result;
   }
 
   /*
@@ -68,6 +68,28 @@ struct index_record {
 
 #define ROW_XOR 0xf6U
 
+#if DB_ROW_BUFFER_LIMIT > 0
+#if DB_ROW_BUFFER_SIZE < DB_MAX_ATTRIBUTES_PER_RELATION * DB_MAX_ELEMENT_SIZE
+#error DB_ROW_BUFFER_SIZE must be large enough to hold the largest row.
+#endif
+
+/* A block of consecutive rows read from a tuple file. */
+struct row_buffer {
+  relation_t *rel;
+  tuple_id_t first;
+  tuple_id_t count;
+  uint16_t row_length;
+  unsigned long last_use;
+  unsigned char data[DB_ROW_BUFFER_SIZE];
+};
+
+static struct row_buffer row_buffers[DB_ROW_BUFFER_LIMIT];
+static unsigned long row_buffer_clock;
+#else
+static unsigned char single_row[DB_MAX_ATTRIBUTES_PER_RELATION *
+                                DB_MAX_ELEMENT_SIZE];
+#endif /* DB_ROW_BUFFER_LIMIT > 0 */
+
 static bool
 merge_strings(char *dest, size_t dest_size, char *prefix, char *suffix)
 {
@@ -110,10 +132,121 @@ storage_generate_file(char *prefix, unsigned long size)
 #endif /* DB_FEATURE_COFFEE */
 }
 
+static void
+invalidate_rows(relation_t *rel)
+{
+#if DB_ROW_BUFFER_LIMIT > 0
+  int i;
+
+  for(i = 0; i < DB_ROW_BUFFER_LIMIT; i++) {
+    if(rel == NULL || row_buffers[i].rel == rel) {
+      row_buffers[i].rel = NULL;
+      row_buffers[i].count = 0;
+    }
+  }
+#endif /* DB_ROW_BUFFER_LIMIT > 0 */
+}
+
+static db_result_t
+read_rows(relation_t *rel, tuple_id_t tuple_id, unsigned char *buf,
+          unsigned size, tuple_id_t *count)
+{
+  int r;
+  tuple_id_t nrows;
+  tuple_id_t i;
+
+  if(DB_ERROR(storage_get_row_amount(rel, &nrows))) {
+    return DB_STORAGE_ERROR;
+  }
+
+  if(tuple_id >= nrows) {
+    return DB_FINISHED;
+  }
+
+  if(cfs_seek(rel->tuple_storage, tuple_id * rel->row_length, CFS_SEEK_SET) ==
+              (cfs_offset_t)-1) {
+    return DB_STORAGE_ERROR;
+  }
+
+  size -= size % rel->row_length;
+  r = cfs_read(rel->tuple_storage, buf, size);
+  if(r < 0) {
+    PRINTF("DB: Reading failed on fd %d\n", rel->tuple_storage);
+    return DB_STORAGE_ERROR;
+  } else if(r == 0) {
+    return DB_FINISHED;
+  } else if(r < rel->row_length) {
+    PRINTF("DB: Incomplete record: %d < %d\n", r, rel->row_length);
+    return DB_STORAGE_ERROR;
+  }
+
+  /* An incomplete row at the end of the file is left out. */
+  *count = r / rel->row_length;
+  for(i = 0; i < *count; i++) {
+    buf[(i + 1) * rel->row_length - 1] ^= ROW_XOR;
+  }
+
+  PRINTF("DB: Read %lu rows from relation %s\n", (unsigned long)*count,
+         rel->name);
+
+  return DB_OK;
+}
+
+#if DB_ROW_BUFFER_LIMIT > 0
+static struct row_buffer *
+get_row_buffer(relation_t *rel, tuple_id_t tuple_id, db_result_t *result)
+{
+  struct row_buffer *buffer;
+  struct row_buffer *victim;
+  int i;
+
+  victim = NULL;
+  for(i = 0; i < DB_ROW_BUFFER_LIMIT; i++) {
+    buffer = &row_buffers[i];
+    if(buffer->rel == rel && buffer->row_length == rel->row_length) {
+      if(tuple_id >= buffer->first &&
+         tuple_id - buffer->first < buffer->count) {
+        buffer->last_use = ++row_buffer_clock;
+        *result = DB_OK;
+        return buffer;
+      }
+      /* Keep to one buffer per relation, so that the rows of another
+         relation in a join are not evicted by this scan. */
+      victim = buffer;
+    }
+  }
+
+  if(victim == NULL) {
+    victim = &row_buffers[0];
+    for(i = 1; i < DB_ROW_BUFFER_LIMIT; i++) {
+      if(row_buffers[i].last_use < victim->last_use) {
+        victim = &row_buffers[i];
+      }
+    }
+  }
+
+  victim->rel = NULL;
+  victim->count = 0;
+  *result = read_rows(rel, tuple_id, victim->data, sizeof(victim->data),
+                      &victim->count);
+  if(*result != DB_OK) {
+    return NULL;
+  }
+
+  victim->rel = rel;
+  victim->first = tuple_id;
+  victim->row_length = rel->row_length;
+  victim->last_use = ++row_buffer_clock;
+
+  return victim;
+}
+#endif /* DB_ROW_BUFFER_LIMIT > 0 */
+
 db_result_t
 storage_load(relation_t *rel)
 {
   PRINTF("DB: Opening the tuple file %s\n", rel->tuple_filename);
+  invalidate_rows(rel);
   rel->tuple_storage = cfs_open(rel->tuple_filename,
                                 CFS_READ | CFS_WRITE | CFS_APPEND);
   if(rel->tuple_storage < 0) {
@@ -127,6 +260,8 @@ storage_load(relation_t *rel)
 void
 storage_unload(relation_t *rel)
 {
+  invalidate_rows(rel);
+
   if(RELATION_HAS_TUPLES(rel)) {
     PRINTF("DB: Unload tuple file %s\n", rel->tuple_filename);
 
@@ -290,6 +425,8 @@ storage_put_attribute(relation_t *rel, attribute_t *attr)
 db_result_t
 storage_drop_relation(relation_t *rel, int remove_tuples)
 {
+  invalidate_rows(rel);
+
   if(remove_tuples && RELATION_HAS_TUPLES(rel)) {
     cfs_remove(rel->tuple_filename);
   }
@@ -309,6 +446,8 @@ storage_rename_relation(char *old_name, char *new_name)
   result = DB_STORAGE_ERROR;
   old_fd = new_fd = -1;
 
+  invalidate_rows(NULL);
+
   old_fd = cfs_open(old_name, CFS_READ);
   new_fd = cfs_open(new_name, CFS_WRITE);
   if(old_fd < 0 || new_fd < 0) {
@@ -419,38 +558,50 @@ storage_put_index(index_t *index)
 db_result_t
 storage_get_row(relation_t *rel, tuple_id_t *tuple_id, storage_row_t row)
 {
-  int r;
-  tuple_id_t nrows;
+#if DB_ROW_BUFFER_LIMIT > 0
+  struct row_buffer *buffer;
+  db_result_t result;
 
-  if(DB_ERROR(storage_get_row_amount(rel, &nrows))) {
-    return DB_STORAGE_ERROR;
+  buffer = get_row_buffer(rel, *tuple_id, &result);
+  if(buffer == NULL) {
+    return result;
   }
 
-  if(*tuple_id >= nrows) {
-    return DB_FINISHED;
-  }
+  memcpy(row, buffer->data + (*tuple_id - buffer->first) * rel->row_length,
+         rel->row_length);
+  return DB_OK;
+#else
+  tuple_id_t count;
 
-  if(cfs_seek(rel->tuple_storage, *tuple_id * rel->row_length, CFS_SEEK_SET) ==
-              (cfs_offset_t)-1) {
-    return DB_STORAGE_ERROR;
-  }
+  return read_rows(rel, *tuple_id, row, rel->row_length, &count);
+#endif /* DB_ROW_BUFFER_LIMIT > 0 */
+}
 
-  r = cfs_read(rel->tuple_storage, row, rel->row_length);
-  if(r < 0) {
-    PRINTF("DB: Reading failed on fd %d\n", rel->tuple_storage);
-    return DB_STORAGE_ERROR;
-  } else if(r == 0) {
-    return DB_FINISHED;
-  } else if(r < rel->row_length) {
-    PRINTF("DB: Incomplete record: %d < %d\n", r, rel->row_length);
-    return DB_STORAGE_ERROR;
-  }
+db_result_t
+storage_get_rows(relation_t *rel, tuple_id_t *tuple_id,
+                 storage_row_t *rows, tuple_id_t *count)
+{
+  db_result_t result;
+#if DB_ROW_BUFFER_LIMIT > 0
+  struct row_buffer *buffer;
+  tuple_id_t offset;
 
-  row[rel->row_length - 1] ^= ROW_XOR;
+  buffer = get_row_buffer(rel, *tuple_id, &result);
+  if(buffer == NULL) {
+    return result;
+  }
 
-  PRINTF("DB: Read %d bytes from relation %s\n", rel->row_length, rel->name);
+  offset = *tuple_id - buffer->first;
+  *rows = buffer->data + offset * rel->row_length;
+  if(*count > buffer->count - offset) {
+    *count = buffer->count - offset;
+  }
+#else
+  result = read_rows(rel, *tuple_id, single_row, rel->row_length, count);
+  *rows = single_row;
+#endif /* DB_ROW_BUFFER_LIMIT > 0 */
 
-  return DB_OK;
+  return result;
 }
 
 db_result_t
@@ -65,6 +65,11 @@ db_result_t storage_get_index(index_t *, relation_t *, attribute_t *);
 db_result_t storage_put_index(index_t *);
 
 db_result_t storage_get_row(relation_t *, tuple_id_t *, storage_row_t);
+/* Gets a pointer to up to *count consecutive rows starting at the given
+   tuple ID, and sets *count to the number of rows available. The rows
+   are valid until the next call to the storage layer. */
+db_result_t storage_get_rows(relation_t *, tuple_id_t *, storage_row_t *,
+                             tuple_id_t *);
 db_result_t storage_put_row(relation_t *, storage_row_t);
 db_result_t storage_get_row_amount(relation_t *, tuple_id_t *);
 
@@ -84,6 +84,49 @@
 #define COFFEE_EXTENDED_WEAR_LEVELLING  1
 #endif
 
+/*
+ * The number of files that can be kept in a RAM directory of the
+ * active files, which lets file lookups and page allocations avoid
+ * scanning the file headers in the storage. The directory is built
+ * with one scan when Coffee is first used. While there are more files
+ * than directory entries, lookups of files that are not open fall back
+ * to scanning. Set to 0 to disable the directory.
+ */
+#ifndef COFFEE_DIRECTORY_SIZE
+#define COFFEE_DIRECTORY_SIZE  0
+#endif
+
+/*
+ * The number of pages in a RAM cache for the storage. Reads smaller
+ * than a page load the whole page into the cache, and writes to cached
+ * pages are combined and programmed when the page is evicted, when a
+ * file header is written, when a file is closed, or when
+ * cfs_coffee_flush() is called. Set to 0 to disable the cache.
+ */
+#ifndef COFFEE_PAGE_CACHE_SIZE
+#define COFFEE_PAGE_CACHE_SIZE  0
+#endif
+
+/*
+ * Run the garbage collector in a background process when the number of
+ * free pages drops below COFFEE_GC_WATERMARK after a file has been
+ * removed. Each invocation of the process scans and erases sectors
+ * until COFFEE_GC_BUDGET rtimer ticks have passed, and then yields. The
+ * next invocation continues with the following sector, unless a file
+ * has been reserved in between, which restarts the pass. An invocation
+ * handles at least one sector, so a pause can exceed the budget by the
+ * time to read the headers of one sector and erase it. The synchronous
+ * garbage collection in file reservations remains as a fallback when
+ * the storage runs full anyway.
+ */
+#ifndef COFFEE_GC_BACKGROUND
+#define COFFEE_GC_BACKGROUND  0
+#endif
+
+#ifndef COFFEE_GC_BUDGET
+#define COFFEE_GC_BUDGET  (RTIMER_SECOND / 50)
+#endif
+
 #if COFFEE_START & (COFFEE_SECTOR_SIZE - 1)
 #error COFFEE_START must point to the first byte in a sector.
 #endif
@@ -111,6 +154,9 @@
 #define GC_GREEDY         0
 /* "Reluctant" garbage collection stops after erasing one sector. */
 #define GC_RELUCTANT      1
+/* "Incremental" garbage collection erases sectors like the greedy one
+   until the free page watermark is reached or the time budget is used. */
+#define GC_INCREMENTAL    2
 
 /* File descriptor macros. */
 #define FD_VALID(fd)      ((fd) >= 0 && (fd) < COFFEE_FD_SET_SIZE && \
@@ -153,6 +199,12 @@
 #define COFFEE_PAGES_PER_SECTOR \
   ((coffee_page_t)(COFFEE_SECTOR_SIZE / COFFEE_PAGE_SIZE))
 
+/* The default number of free pages below which the background garbage
+   collector reclaims sectors. */
+#ifndef COFFEE_GC_WATERMARK
+#define COFFEE_GC_WATERMARK  (COFFEE_PAGE_COUNT / 4)
+#endif
+
 /* This structure is used for garbage collection statistics. */
 struct sector_status {
   coffee_page_t active;
@@ -190,6 +242,26 @@ struct file_header {
   char name[COFFEE_NAME_LENGTH];
 };
 
+#if COFFEE_DIRECTORY_SIZE > 0
+/* A RAM directory entry. Free entries have the page INVALID_PAGE. */
+struct directory_entry {
+  coffee_page_t page;
+  uint16_t hash;
+};
+#endif /* COFFEE_DIRECTORY_SIZE > 0 */
+
+#if COFFEE_PAGE_CACHE_SIZE > 0
+/* A cached page. Free entries have the page INVALID_PAGE. The bytes
+   from dirty_start to dirty_end have not been written to the storage. */
+struct cache_page {
+  uint32_t last_use;
+  coffee_page_t page;
+  uint16_t dirty_start;
+  uint16_t dirty_end;
+  uint8_t data[COFFEE_PAGE_SIZE];
+};
+#endif /* COFFEE_PAGE_CACHE_SIZE > 0 */
+
 /* This is needed because of a buggy compiler. */
 struct log_param {
   cfs_offset_t offset;
@@ -206,18 +278,273 @@ static struct file_desc coffee_fd_set[COFFEE_FD_SET_SIZE];
 static coffee_page_t next_free;
 static char gc_wait;
 
+static struct cfs_coffee_gc_stats gc_stats;
+/* The number of free pages, known after a complete garbage
+   collection pass. */
+static coffee_page_t free_pages;
+static uint8_t free_pages_known;
+
+#if COFFEE_GC_BACKGROUND
+PROCESS(coffee_gc_process, "Coffee garbage collector");
+/* Set when files have been removed since the last pass started. */
+static uint8_t gc_reclaimable = 1;
+/* The sector where an incremental pass that ran out of time continues,
+   and what the pass has counted in the sectors before it. */
+static coffee_page_t gc_next_sector;
+static coffee_page_t gc_free;
+static int gc_left;
+#endif
+
+#if COFFEE_DIRECTORY_SIZE > 0
+static struct directory_entry directory[COFFEE_DIRECTORY_SIZE];
+/* The first page of the free pages at the end of each sector, relative
+   to the start of the sector. */
+static coffee_page_t free_tail[COFFEE_SECTOR_COUNT];
+static uint8_t directory_loaded;
+/* The number of active files that did not fit in the directory. */
+static coffee_page_t directory_missing;
+/* Set when sectors have been erased since the directory was loaded.
+   The unwritten pages of a file that extend past an erased sector can
+   be allocated again, but the free page map still counts them as used. */
+static uint8_t free_tail_stale;
+#endif /* COFFEE_DIRECTORY_SIZE > 0 */
+
+#if COFFEE_PAGE_CACHE_SIZE > 0
+static struct cache_page page_cache[COFFEE_PAGE_CACHE_SIZE];
+static uint32_t cache_clock;
+static uint8_t cache_initialized;
+
+#define STORAGE_READ(buf, size, offset)   cache_read((buf), (size), (offset))
+#define STORAGE_WRITE(buf, size, offset)  cache_write((buf), (size), (offset))
+#define STORAGE_ERASE(sector)             cache_erase(sector)
+#else /* COFFEE_PAGE_CACHE_SIZE > 0 */
+#define STORAGE_READ(buf, size, offset)   COFFEE_READ((buf), (size), (offset))
+#define STORAGE_WRITE(buf, size, offset)  COFFEE_WRITE((buf), (size), (offset))
+#define STORAGE_ERASE(sector)             COFFEE_ERASE(sector)
+#endif /* COFFEE_PAGE_CACHE_SIZE > 0 */
+
+/*---------------------------------------------------------------------------*/
+#if COFFEE_PAGE_CACHE_SIZE > 0
+static void
+cache_init(void)
+{
+  int i;
+
+  if(!cache_initialized) {
+    for(i = 0; i < COFFEE_PAGE_CACHE_SIZE; i++) {
+      page_cache[i].page = INVALID_PAGE;
+    }
+    cache_initialized = 1;
+  }
+}
+/*---------------------------------------------------------------------------*/
+static void
+cache_flush_page(struct cache_page *cp)
+{
+  if(cp->dirty_end > cp->dirty_start) {
+    COFFEE_WRITE(cp->data + cp->dirty_start,
+                 cp->dirty_end - cp->dirty_start,
+                 (cfs_offset_t)cp->page * COFFEE_PAGE_SIZE + cp->dirty_start);
+  }
+  cp->dirty_start = cp->dirty_end = 0;
+}
+/*---------------------------------------------------------------------------*/
+static void
+cache_flush(void)
+{
+  int i;
+
+  for(i = 0; i < COFFEE_PAGE_CACHE_SIZE; i++) {
+    if(page_cache[i].page != INVALID_PAGE) {
+      cache_flush_page(&page_cache[i]);
+    }
+  }
+}
+/*---------------------------------------------------------------------------*/
+static struct cache_page *
+cache_find(coffee_page_t page)
+{
+  int i;
+
+  cache_init();
+  for(i = 0; i < COFFEE_PAGE_CACHE_SIZE; i++) {
+    if(page_cache[i].page == page) {
+      page_cache[i].last_use = ++cache_clock;
+      return &page_cache[i];
+    }
+  }
+  return NULL;
+}
+/*---------------------------------------------------------------------------*/
+static struct cache_page *
+cache_load(coffee_page_t page)
+{
+  struct cache_page *cp;
+  int i;
+
+  /* Replace a free entry, or else the least recently used one. */
+  cp = &page_cache[0];
+  for(i = 0; i < COFFEE_PAGE_CACHE_SIZE; i++) {
+    if(page_cache[i].page == INVALID_PAGE) {
+      cp = &page_cache[i];
+      break;
+    }
+    if(page_cache[i].last_use < cp->last_use) {
+      cp = &page_cache[i];
+    }
+  }
+
+  if(cp->page != INVALID_PAGE) {
+    cache_flush_page(cp);
+  }
+
+  COFFEE_READ(cp->data, COFFEE_PAGE_SIZE, (cfs_offset_t)page * COFFEE_PAGE_SIZE);
+  cp->page = page;
+  cp->dirty_start = cp->dirty_end = 0;
+  cp->last_use = ++cache_clock;
+  return cp;
+}
+/*---------------------------------------------------------------------------*/
+static void
+cache_read(void *buf, cfs_offset_t size, cfs_offset_t offset)
+{
+  struct cache_page *cp;
+  uint8_t *dst;
+  cfs_offset_t page_offset, len;
+  cfs_offset_t direct_offset, direct_len;
+
+  dst = buf;
+  direct_offset = offset;
+  direct_len = 0;
+
+  while(size > 0) {
+    page_offset = offset % COFFEE_PAGE_SIZE;
+    len = COFFEE_PAGE_SIZE - page_offset;
+    if(len > size) {
+      len = size;
+    }
+
+    cp = cache_find(offset / COFFEE_PAGE_SIZE);
+    if(cp == NULL && len == COFFEE_PAGE_SIZE) {
+      /* Uncached whole pages are read in one operation without
+         being cached. */
+      direct_len += len;
+    } else {
+      if(direct_len > 0) {
+        COFFEE_READ(dst - direct_len, direct_len, direct_offset);
+        direct_len = 0;
+      }
+      if(cp == NULL) {
+        cp = cache_load(offset / COFFEE_PAGE_SIZE);
+      }
+      memcpy(dst, cp->data + page_offset, len);
+      direct_offset = offset + len;
+    }
+
+    dst += len;
+    offset += len;
+    size -= len;
+  }
+
+  if(direct_len > 0) {
+    COFFEE_READ(dst - direct_len, direct_len, direct_offset);
+  }
+}
+/*---------------------------------------------------------------------------*/
+static void
+cache_write(const void *buf, cfs_offset_t size, cfs_offset_t offset)
+{
+  struct cache_page *cp;
+  const uint8_t *src;
+  cfs_offset_t page_offset, len;
+  cfs_offset_t direct_offset, direct_len;
+
+  src = buf;
+  direct_offset = offset;
+  direct_len = 0;
+
+  while(size > 0) {
+    page_offset = offset % COFFEE_PAGE_SIZE;
+    len = COFFEE_PAGE_SIZE - page_offset;
+    if(len > size) {
+      len = size;
+    }
+
+    cp = cache_find(offset / COFFEE_PAGE_SIZE);
+    if(cp == NULL && len == COFFEE_PAGE_SIZE) {
+      direct_len += len;
+    } else {
+      if(direct_len > 0) {
+        COFFEE_WRITE(src - direct_len, direct_len, direct_offset);
+        direct_len = 0;
+      }
+      if(cp == NULL) {
+        cp = cache_load(offset / COFFEE_PAGE_SIZE);
+      }
+      memcpy(cp->data + page_offset, src, len);
+      if(cp->dirty_end == 0) {
+        cp->dirty_start = page_offset;
+        cp->dirty_end = page_offset + len;
+      } else {
+        cp->dirty_start = MIN(cp->dirty_start, page_offset);
+        cp->dirty_end = MAX(cp->dirty_end, page_offset + len);
+      }
+      direct_offset = offset + len;
+    }
+
+    src += len;
+    offset += len;
+    size -= len;
+  }
+
+  if(direct_len > 0) {
+    COFFEE_WRITE(src - direct_len, direct_len, direct_offset);
+  }
+}
+/*---------------------------------------------------------------------------*/
+static void
+cache_update(const void *buf, cfs_offset_t size, cfs_offset_t offset)
+{
+  struct cache_page *cp;
+
+  /* Used for write-through of data that does not cross a page. */
+  cp = cache_find(offset / COFFEE_PAGE_SIZE);
+  if(cp != NULL) {
+    memcpy(cp->data + offset % COFFEE_PAGE_SIZE, buf, size);
+  }
+}
+/*---------------------------------------------------------------------------*/
+static void
+cache_erase(coffee_page_t sector)
+{
+  int i;
+
+  cache_init();
+  for(i = 0; i < COFFEE_PAGE_CACHE_SIZE; i++) {
+    if(page_cache[i].page / COFFEE_PAGES_PER_SECTOR == sector) {
+      page_cache[i].page = INVALID_PAGE;
+    }
+  }
+  COFFEE_ERASE(sector);
+}
+#endif /* COFFEE_PAGE_CACHE_SIZE > 0 */
 /*---------------------------------------------------------------------------*/
 static void
 write_header(struct file_header *hdr, coffee_page_t page)
 {
   hdr->flags |= HDR_FLAG_VALID;
+#if COFFEE_PAGE_CACHE_SIZE > 0
+  /* Headers are written through, after the data that they refer to. */
+  cache_flush();
+  cache_update(hdr, sizeof(*hdr), page * COFFEE_PAGE_SIZE);
+#endif
   COFFEE_WRITE(hdr, sizeof(*hdr), page * COFFEE_PAGE_SIZE);
 }
 /*---------------------------------------------------------------------------*/
 static void
 read_header(struct file_header *hdr, coffee_page_t page)
 {
-  COFFEE_READ(hdr, sizeof(*hdr), page * COFFEE_PAGE_SIZE);
+  STORAGE_READ(hdr, sizeof(*hdr), page * COFFEE_PAGE_SIZE);
   if(DEBUG && HDR_ACTIVE(*hdr) && !HDR_VALID(*hdr)) {
     PRINTF("Coffee: Invalid header at page %u!\n", (unsigned)page);
   }
@@ -348,31 +675,77 @@ isolate_pages(coffee_page_t start, coffee_page_t skip_pages)
          (unsigned)skip_pages, (int)start / COFFEE_PAGES_PER_SECTOR);
 }
 /*---------------------------------------------------------------------------*/
-static void
+/*
+ * Returns the number of erasable sectors that an incremental pass left
+ * because there were enough free pages, or -1 if it ran out of time.
+ */
+static int
 collect_garbage(int mode)
 {
-  coffee_page_t sector;
+  coffee_page_t sector, first_sector;
   struct sector_status stats;
   coffee_page_t first_page, isolation_count;
+  coffee_page_t free;
+  rtimer_clock_t start;
+  uint32_t pause;
+  int erased, left, complete;
 
   PRINTF("Coffee: Running the garbage collector in %s mode\n",
-         mode == GC_RELUCTANT ? "reluctant" : "greedy");
+         mode == GC_RELUCTANT ? "reluctant" :
+         mode == GC_GREEDY ? "greedy" : "incremental");
+
+  start = RTIMER_NOW();
+  first_sector = 0;
+  free = 0;
+  erased = left = 0;
+  complete = 1;
+#if COFFEE_GC_BACKGROUND
+  if(mode == GC_INCREMENTAL) {
+    /* get_sector_status() has kept its state since the last pass. */
+    first_sector = gc_next_sector;
+    free = gc_free;
+    left = gc_left;
+  }
+  gc_next_sector = 0;
+#endif
+
   /*
    * The garbage collector erases as many sectors as possible. A sector is
    * erasable if there are only free or obsolete pages in it.
    */
-  for(sector = 0; sector < COFFEE_SECTOR_COUNT; sector++) {
+  for(sector = first_sector; sector < COFFEE_SECTOR_COUNT; sector++) {
+#if COFFEE_GC_BACKGROUND
+    if(mode == GC_INCREMENTAL && sector > first_sector &&
+       (rtimer_clock_t)(RTIMER_NOW() - start) >= COFFEE_GC_BUDGET) {
+      /* Continue with this sector in the next pass. */
+      gc_next_sector = sector;
+      gc_free = free;
+      gc_left = left;
+      complete = 0;
+      break;
+    }
+#endif
     isolation_count = get_sector_status(sector, &stats);
     PRINTF("Coffee: Sector %u has %u active, %u obsolete, and %u free pages.\n",
            (unsigned)sector, (unsigned)stats.active,
            (unsigned)stats.obsolete, (unsigned)stats.free);
 
     if(stats.active > 0) {
+      free += stats.free;
       continue;
     }
 
+    if(mode == GC_INCREMENTAL && stats.obsolete > 0) {
+      if(!free_pages_known || free_pages >= COFFEE_GC_WATERMARK) {
+        /* Only count the free pages. */
+        left++;
+        free += stats.free;
+        continue;
+      }
+    }
+
     if((mode == GC_RELUCTANT && stats.free == 0) ||
-       (mode == GC_GREEDY && stats.obsolete > 0)) {
+       (mode != GC_RELUCTANT && stats.obsolete > 0)) {
       first_page = sector * COFFEE_PAGES_PER_SECTOR;
       if(first_page < next_free) {
         next_free = first_page;
@@ -382,14 +755,85 @@ collect_garbage(int mode)
         isolate_pages(first_page + COFFEE_PAGES_PER_SECTOR, isolation_count);
       }
 
-      COFFEE_ERASE(sector);
+      STORAGE_ERASE(sector);
       PRINTF("Coffee: Erased sector %d!\n", sector);
+#if COFFEE_DIRECTORY_SIZE > 0
+      free_tail[sector] = 0;
+      free_tail_stale = 1;
+#endif
+      erased++;
+      free += COFFEE_PAGES_PER_SECTOR;
+      free_pages += stats.obsolete;
 
       if(mode == GC_RELUCTANT && isolation_count > 0) {
+        complete = 0;
         break;
       }
+    } else {
+      free += stats.free;
     }
   }
+
+  if(complete) {
+    free_pages = free;
+    free_pages_known = 1;
+  }
+
+  pause = (rtimer_clock_t)(RTIMER_NOW() - start);
+  gc_stats.runs++;
+  gc_stats.erased_sectors += erased;
+  gc_stats.total_time += pause;
+  if(pause > gc_stats.max_pause) {
+    gc_stats.max_pause = pause;
+  }
+  if(mode == GC_INCREMENTAL) {
+    gc_stats.background_runs++;
+  } else if(pause > gc_stats.max_blocking_pause) {
+    gc_stats.max_blocking_pause = pause;
+  }
+
+  return complete ? left : -1;
+}
+/*---------------------------------------------------------------------------*/
+#if COFFEE_GC_BACKGROUND
+PROCESS_THREAD(coffee_gc_process, ev, data)
+{
+  int left;
+
+  PROCESS_BEGIN();
+
+  while(1) {
+    PROCESS_WAIT_EVENT_UNTIL(ev == PROCESS_EVENT_POLL);
+
+    if(gc_next_sector == 0) {
+      /* A new pass sees all the files removed until now. */
+      gc_reclaimable = 0;
+    }
+    left = collect_garbage(GC_INCREMENTAL);
+    if(left < 0 || (left > 0 && free_pages < COFFEE_GC_WATERMARK)) {
+      /* Yield to other processes before the next pass. */
+      process_poll(PROCESS_CURRENT());
+    } else if(left > 0) {
+      gc_reclaimable = 1;
+    }
+  }
+
+  PROCESS_END();
+}
+#endif /* COFFEE_GC_BACKGROUND */
+/*---------------------------------------------------------------------------*/
+static void
+request_gc(void)
+{
+#if COFFEE_GC_BACKGROUND
+  if(gc_reclaimable &&
+     (!free_pages_known || free_pages < COFFEE_GC_WATERMARK)) {
+    if(!process_is_running(&coffee_gc_process)) {
+      process_start(&coffee_gc_process, NULL);
+    }
+    process_poll(&coffee_gc_process);
+  }
+#endif /* COFFEE_GC_BACKGROUND */
 }
 /*---------------------------------------------------------------------------*/
 static coffee_page_t
@@ -452,6 +896,143 @@ load_file(coffee_page_t start, struct file_header *hdr)
   return file;
 }
 /*---------------------------------------------------------------------------*/
+#if COFFEE_DIRECTORY_SIZE > 0
+static uint16_t
+name_hash(const char *name)
+{
+  uint16_t hash;
+  int i;
+
+  hash = 5381;
+  for(i = 0; i < COFFEE_NAME_LENGTH && name[i] != '\0'; i++) {
+    hash = (hash << 5) + hash + (unsigned char)name[i];
+  }
+  return hash;
+}
+/*---------------------------------------------------------------------------*/
+static void
+directory_add(coffee_page_t page, const char *name)
+{
+  int i;
+
+  for(i = 0; i < COFFEE_DIRECTORY_SIZE; i++) {
+    if(directory[i].page == INVALID_PAGE) {
+      directory[i].page = page;
+      directory[i].hash = name_hash(name);
+      return;
+    }
+  }
+
+  PRINTF("Coffee: The directory is full\n");
+  directory_missing++;
+}
+/*---------------------------------------------------------------------------*/
+static void
+directory_remove(coffee_page_t page)
+{
+  int i;
+
+  for(i = 0; i < COFFEE_DIRECTORY_SIZE; i++) {
+    if(directory[i].page == page) {
+      directory[i].page = INVALID_PAGE;
+      return;
+    }
+  }
+
+  /* The file was one of those that did not fit. */
+  if(directory_missing > 0) {
+    directory_missing--;
+  }
+}
+/*---------------------------------------------------------------------------*/
+static void
+directory_reset(coffee_page_t tail)
+{
+  int i;
+
+  for(i = 0; i < COFFEE_DIRECTORY_SIZE; i++) {
+    directory[i].page = INVALID_PAGE;
+  }
+  for(i = 0; i < COFFEE_SECTOR_COUNT; i++) {
+    free_tail[i] = tail;
+  }
+  directory_loaded = 1;
+  directory_missing = 0;
+  free_tail_stale = 0;
+}
+/*---------------------------------------------------------------------------*/
+static void
+directory_load(void)
+{
+  struct file_header hdr;
+  coffee_page_t page;
+
+  if(directory_loaded) {
+    return;
+  }
+
+  /* Sectors in which no free page is found are full. */
+  directory_reset(COFFEE_PAGES_PER_SECTOR);
+
+  for(page = 0; page < COFFEE_PAGE_COUNT; page = next_file(page, &hdr)) {
+    read_header(&hdr, page);
+    if(HDR_FREE(hdr)) {
+      /* The rest of the sector is free. */
+      free_tail[page / COFFEE_PAGES_PER_SECTOR] =
+        page % COFFEE_PAGES_PER_SECTOR;
+    } else if(HDR_ACTIVE(hdr) && !HDR_LOG(hdr)) {
+      directory_add(page, hdr.name);
+    }
+  }
+}
+/*---------------------------------------------------------------------------*/
+static void
+directory_reserve(coffee_page_t page, struct file_header *hdr)
+{
+  coffee_page_t sector, end, used;
+
+  end = page + hdr->max_pages;
+  for(sector = page / COFFEE_PAGES_PER_SECTOR;
+      sector * COFFEE_PAGES_PER_SECTOR < end;
+      sector++) {
+    used = end - sector * COFFEE_PAGES_PER_SECTOR;
+    if(used > COFFEE_PAGES_PER_SECTOR) {
+      used = COFFEE_PAGES_PER_SECTOR;
+    }
+    if(free_tail[sector] < used) {
+      free_tail[sector] = used;
+    }
+  }
+
+  if(!HDR_LOG(*hdr)) {
+    directory_add(page, hdr->name);
+  }
+}
+/*---------------------------------------------------------------------------*/
+static struct file *
+directory_find(const char *name)
+{
+  struct file_header hdr;
+  uint16_t hash;
+  int i;
+
+  hash = name_hash(name);
+  for(i = 0; i < COFFEE_DIRECTORY_SIZE; i++) {
+    if(directory[i].page == INVALID_PAGE || directory[i].hash != hash) {
+      continue;
+    }
+
+    /* Different names can have the same hash. */
+    read_header(&hdr, directory[i].page);
+    if(HDR_ACTIVE(hdr) && !HDR_LOG(hdr) && strcmp(name, hdr.name) == 0) {
+      return load_file(directory[i].page, &hdr);
+    }
+  }
+
+  return NULL;
+}
+#endif /* COFFEE_DIRECTORY_SIZE > 0 */
+/*---------------------------------------------------------------------------*/
 static struct file *
 find_file(const char *name)
 {
@@ -471,6 +1052,13 @@ find_file(const char *name)
     }
   }
 
+#if COFFEE_DIRECTORY_SIZE > 0
+  directory_load();
+  if(directory_missing == 0) {
+    return directory_find(name);
+  }
+#endif /* COFFEE_DIRECTORY_SIZE > 0 */
+
   /* Scan the flash memory sequentially otherwise. */
   for(page = 0; page < COFFEE_PAGE_COUNT; page = next_file(page, &hdr)) {
     read_header(&hdr, page);
@@ -501,7 +1089,7 @@ file_end(coffee_page_t start)
    */
 
   for(page = hdr.max_pages - 1; page >= 0; page--) {
-    COFFEE_READ(buf, sizeof(buf), (start + page) * COFFEE_PAGE_SIZE);
+    STORAGE_READ(buf, sizeof(buf), (start + page) * COFFEE_PAGE_SIZE);
     for(i = COFFEE_PAGE_SIZE - 1; i >= 0; i--) {
       if(buf[i] != 0) {
         if(page == 0 && i < sizeof(hdr)) {
@@ -516,6 +1104,59 @@ file_end(coffee_page_t start)
   return 0;
 }
 /*---------------------------------------------------------------------------*/
+#if COFFEE_DIRECTORY_SIZE > 0
+static coffee_page_t
+find_free_pages(coffee_page_t amount)
+{
+  coffee_page_t page, start, first_free;
+
+  /* Like the header scan below, but checks the free page map instead.
+     The map may count more pages as used than the scan would. */
+  start = INVALID_PAGE;
+  for(page = next_free; page < COFFEE_PAGE_COUNT;) {
+    first_free = page - page % COFFEE_PAGES_PER_SECTOR +
+      free_tail[page / COFFEE_PAGES_PER_SECTOR];
+    if(page >= first_free) {
+      if(start == INVALID_PAGE) {
+        start = page;
+        if(start + amount >= COFFEE_PAGE_COUNT) {
+          break;
+        }
+      }
+
+      page = (page + COFFEE_PAGES_PER_SECTOR) & ~(COFFEE_PAGES_PER_SECTOR - 1);
+
+      if(start + amount <= page) {
+        if(start == next_free) {
+          next_free = start + amount;
+        }
+        return start;
+      }
+    } else {
+      /* Skip the allocated pages in this sector. */
+      start = INVALID_PAGE;
+      page = first_free;
+    }
+  }
+  return INVALID_PAGE;
+}
+/*---------------------------------------------------------------------------*/
+static coffee_page_t
+find_contiguous_pages(coffee_page_t amount)
+{
+  coffee_page_t page;
+
+  directory_load();
+  page = find_free_pages(amount);
+  if(page == INVALID_PAGE && free_tail_stale) {
+    /* Read the free pages from the headers again before giving up. */
+    directory_loaded = 0;
+    directory_load();
+    page = find_free_pages(amount);
+  }
+  return page;
+}
+#else /* COFFEE_DIRECTORY_SIZE > 0 */
 static coffee_page_t
 find_contiguous_pages(coffee_page_t amount)
 {
@@ -551,6 +1192,7 @@ find_contiguous_pages(coffee_page_t amount)
   }
   return INVALID_PAGE;
 }
+#endif /* COFFEE_DIRECTORY_SIZE > 0 */
 /*---------------------------------------------------------------------------*/
 static int
 remove_by_page(coffee_page_t page, int remove_log,
@@ -572,8 +1214,16 @@ remove_by_page(coffee_page_t page, int remove_log,
 
   hdr.flags |= HDR_FLAG_OBSOLETE;
   write_header(&hdr, page);
+#if COFFEE_DIRECTORY_SIZE > 0
+  if(!HDR_LOG(hdr)) {
+    directory_remove(page);
+  }
+#endif
 
   gc_wait = 0;
+#if COFFEE_GC_BACKGROUND
+  gc_reclaimable = 1;
+#endif
 
   /* Close all file descriptors that reference the removed file. */
   if(close_fds) {
@@ -595,6 +1245,7 @@ remove_by_page(coffee_page_t page, int remove_log,
   if(!COFFEE_EXTENDED_WEAR_LEVELLING && gc_allowed) {
     collect_garbage(GC_RELUCTANT);
   }
+  request_gc();
 
   return 0;
 }
@@ -636,6 +1287,16 @@ reserve(const char *name, coffee_page_t pages,
   hdr.max_pages = pages;
   hdr.flags = HDR_FLAG_ALLOCATED | flags;
   write_header(&hdr, page);
+#if COFFEE_DIRECTORY_SIZE > 0
+  directory_reserve(page, &hdr);
+#endif
+#if COFFEE_GC_BACKGROUND
+  /* The file may extend into sectors that an unfinished pass has not
+     scanned yet, from a sector that it has. */
+  gc_next_sector = 0;
+#endif
+  free_pages = free_pages > pages ? free_pages - pages : 0;
+  request_gc();
 
   PRINTF("Coffee: Reserved %u pages starting from %u for file %s\n",
          (unsigned)pages, (unsigned)page, name);
@@ -703,7 +1364,7 @@ get_record_index(coffee_page_t log_page, uint16_t search_records,
       }
 
       base -= batch_size * sizeof(indices[0]);
-      COFFEE_READ(&indices, sizeof(indices[0]) * batch_size, base);
+      STORAGE_READ(&indices, sizeof(indices[0]) * batch_size, base);
 
       for(i = batch_size - 1; i >= 0; i--) {
         if(indices[i] - 1 == region) {
@@ -744,7 +1405,7 @@ read_log_page(struct file_header *hdr, int16_t record_count,
   base = absolute_offset(hdr->log_page, log_records * sizeof(region));
   base += (cfs_offset_t)match_index * log_record_size;
   base += lp->offset;
-  COFFEE_READ(lp->buf, lp->size, base);
+  STORAGE_READ(lp->buf, lp->size, base);
 
   return lp->size;
 }
@@ -814,7 +1475,7 @@ merge_log(coffee_page_t file_page, int extend)
       cfs_close(fd);
       return -1;
     } else if(n > 0) {
-      COFFEE_WRITE(buf, n, absolute_offset(new_file->page, offset));
+      STORAGE_WRITE(buf, n, absolute_offset(new_file->page, offset));
       offset += n;
     }
   } while(n != 0);
@@ -871,7 +1532,7 @@ find_next_record(struct file *file, coffee_page_t log_page,
       batch_size = log_records - processed >= preferred_batch_size ?
         preferred_batch_size : log_records - processed;
 
-      COFFEE_READ(&indices, batch_size * sizeof(indices[0]),
+      STORAGE_READ(&indices, batch_size * sizeof(indices[0]),
                   absolute_offset(log_page, processed * sizeof(indices[0])));
       for(log_record = 0; log_record < batch_size; log_record++) {
         if(indices[log_record] == 0) {
@@ -935,7 +1596,7 @@ write_log_page(struct file *file, struct log_param *lp)
 
     if((lp->offset > 0 || lp->size != log_record_size) &&
        read_log_page(&hdr, log_record, &lp_out) < 0) {
-      COFFEE_READ(copy_buf, sizeof(copy_buf),
+      STORAGE_READ(copy_buf, sizeof(copy_buf),
                   absolute_offset(file->page, offset));
     }
 
@@ -947,11 +1608,11 @@ write_log_page(struct file *file, struct log_param *lp)
      */
     offset = absolute_offset(log_page, 0);
     ++region;
-    COFFEE_WRITE(&region, sizeof(region),
+    STORAGE_WRITE(&region, sizeof(region),
                  offset + log_record * sizeof(region));
 
     offset += log_records * sizeof(region);
-    COFFEE_WRITE(copy_buf, sizeof(copy_buf),
+    STORAGE_WRITE(copy_buf, sizeof(copy_buf),
                  offset + log_record * log_record_size);
     file->record_count = log_record + 1;
   }
@@ -1013,6 +1674,9 @@ cfs_open(const char *name, int flags)
 void
 cfs_close(int fd)
 {
+#if COFFEE_PAGE_CACHE_SIZE > 0
+  cache_flush();
+#endif
   if(FD_VALID(fd)) {
     coffee_fd_set[fd].flags = COFFEE_FD_FREE;
     coffee_fd_set[fd].file->references--;
@@ -1105,7 +1769,7 @@ cfs_read(int fd, void *buf, unsigned size)
 
   /* If the file is not modified, read directly from the file extent. */
   if(!FILE_MODIFIED(file)) {
-    COFFEE_READ(buf, size, absolute_offset(file->page, fdp->offset));
+    STORAGE_READ(buf, size, absolute_offset(file->page, fdp->offset));
     fdp->offset += size;
     return size;
   }
@@ -1126,7 +1790,7 @@ cfs_read(int fd, void *buf, unsigned size)
 
     /* Read from the original file if we cannot find the data in the log. */
     if(r < 0) {
-      COFFEE_READ(buf, lp.size, absolute_offset(file->page, fdp->offset));
+      STORAGE_READ(buf, lp.size, absolute_offset(file->page, fdp->offset));
       r = lp.size;
     }
     fdp->offset += r;
@@ -1209,7 +1873,7 @@ cfs_write(int fd, const void *buf, unsigned size)
        * corresponding end offset in the original extent to ensure that
        * the correct file size is calculated when opening the file again.
        */
-      COFFEE_WRITE(dummy, 1, absolute_offset(file->page, fdp->offset - 1));
+      STORAGE_WRITE(dummy, 1, absolute_offset(file->page, fdp->offset - 1));
     }
   } else {
 #endif /* COFFEE_MICRO_LOGS */
@@ -1217,7 +1881,7 @@ cfs_write(int fd, const void *buf, unsigned size)
       return -1;
     }
 
-    COFFEE_WRITE(buf, size, absolute_offset(file->page, fdp->offset));
+    STORAGE_WRITE(buf, size, absolute_offset(file->page, fdp->offset));
     fdp->offset += size;
 #if COFFEE_MICRO_LOGS
   }
@@ -1323,6 +1987,20 @@ cfs_coffee_set_io_semantics(int fd, unsigned flags)
   return 0;
 }
 /*---------------------------------------------------------------------------*/
+void
+cfs_coffee_get_gc_stats(struct cfs_coffee_gc_stats *stats)
+{
+  memcpy(stats, &gc_stats, sizeof(*stats));
+}
+/*---------------------------------------------------------------------------*/
+void
+cfs_coffee_flush(void)
+{
+#if COFFEE_PAGE_CACHE_SIZE > 0
+  cache_flush();
+#endif
+}
+/*---------------------------------------------------------------------------*/
 int
 cfs_coffee_format(void)
 {
@@ -1331,7 +2009,7 @@ cfs_coffee_format(void)
   PRINTF("Coffee: Formatting %u sectors", (unsigned)COFFEE_SECTOR_COUNT);
 
   for(i = 0; i < COFFEE_SECTOR_COUNT; i++) {
-    COFFEE_ERASE(i);
+    STORAGE_ERASE(i);
     PRINTF(".");
   }
 
@@ -1340,6 +2018,14 @@ cfs_coffee_format(void)
   memset(&coffee_fd_set, 0, sizeof(coffee_fd_set));
   next_free = 0;
   gc_wait = 1;
+  free_pages = COFFEE_PAGE_COUNT;
+  free_pages_known = 1;
+#if COFFEE_DIRECTORY_SIZE > 0
+  directory_reset(0);
+#endif
+#if COFFEE_GC_BACKGROUND
+  gc_next_sector = 0;
+#endif
 
   PRINTF(" done!\n");
 
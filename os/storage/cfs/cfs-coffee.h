@@ -125,6 +125,43 @@ int cfs_coffee_configure_log(const char *file, unsigned log_size,
  */
 int cfs_coffee_set_io_semantics(int fd, unsigned flags);
 
+/** Garbage collection statistics. The times are in rtimer ticks. */
+struct cfs_coffee_gc_stats {
+  /** Number of garbage collection passes */
+  uint32_t runs;
+  /** Number of passes made by the background garbage collector */
+  uint32_t background_runs;
+  /** Number of erased sectors */
+  uint32_t erased_sectors;
+  /** Total time spent in garbage collection */
+  uint32_t total_time;
+  /** Longest garbage collection pass */
+  uint32_t max_pause;
+  /** Longest pass that was run inside a file operation */
+  uint32_t max_blocking_pause;
+};
+
+/**
+ * \brief Get the garbage collection statistics.
+ * \param stats The statistics are copied here.
+ *
+ * The garbage collector erases sectors that contain only obsolete and
+ * free pages. It runs synchronously when a file reservation cannot be
+ * granted, and, if COFFEE_GC_BACKGROUND is set, incrementally in a
+ * background process when the free space runs low.
+ */
+void cfs_coffee_get_gc_stats(struct cfs_coffee_gc_stats *stats);
+
+/**
+ * \brief Write buffered changes to the storage.
+ *
+ * When Coffee is configured with a page cache (COFFEE_PAGE_CACHE_SIZE),
+ * writes to cached pages are kept in RAM until the page is evicted, a
+ * file is closed, or this function is called. Otherwise, this function
+ * does nothing.
+ */
+void cfs_coffee_flush(void);
+
 /**
  * \brief Format the storage area assigned to Coffee.
  * \return 0 on success, -1 on failure.
@@ -0,0 +1,635 @@
+/*
+ * Copyright (c) 2026, agent <agent@local>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+ * OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * \file
+ *         An append-only log of time-stamped samples in CFS files.
+ */
+
+#include "contiki.h"
+#include "cfs/cfs.h"
+#include "tslog.h"
+
+#include <stdio.h>
+#include <string.h>
+
+/*
+ * Block layout:
+ *
+ *  0      magic
+ *  1      reserved
+ *  2-3    number of samples
+ *  4-7    segment number
+ *  8-11   time stamp of the first sample
+ *  12-15  time stamp of the last sample
+ *  16-19  value of the first sample
+ *  20-    bit stream of the other samples
+ *  last   magic
+ *
+ * The magic byte at the end of the block marks it as completely
+ * written. It also keeps Coffee from taking trailing zero bytes
+ * of the block as unwritten space.
+ */
+#define BLOCK_MAGIC       0x7a
+#define OFFSET_COUNT      2
+#define OFFSET_SEQ        4
+#define OFFSET_FIRST_TIME 8
+#define OFFSET_LAST_TIME  12
+#define OFFSET_FIRST_VALUE 16
+#define HEADER_SIZE       20
+
+#define DATA_END_BIT      ((TSLOG_BLOCK_SIZE - 1) * 8)
+
+/* The longest codes of a time stamp and a value. */
+#define MAX_SAMPLE_BITS   (4 + 32 + 3 + 32)
+
+#define SLOT(seq)         ((seq) % TSLOG_SEGMENT_LIMIT)
+
+#if TSLOG_BLOCK_SIZE < HEADER_SIZE + 1 + (MAX_SAMPLE_BITS + 7) / 8
+#error "TSLOG_BLOCK_SIZE is too small"
+#endif
+/*---------------------------------------------------------------------------*/
+static void
+put32(uint8_t *p, uint32_t v)
+{
+  p[0] = v >> 24;
+  p[1] = v >> 16;
+  p[2] = v >> 8;
+  p[3] = v;
+}
+/*---------------------------------------------------------------------------*/
+static uint32_t
+get32(const uint8_t *p)
+{
+  return (uint32_t)p[0] << 24 | (uint32_t)p[1] << 16 |
+         (uint32_t)p[2] << 8 | p[3];
+}
+/*---------------------------------------------------------------------------*/
+static void
+put_bits(uint8_t *buf, uint16_t *bit, uint32_t value, unsigned n)
+{
+  while(n-- > 0) {
+    if(value & ((uint32_t)1 << n)) {
+      buf[*bit >> 3] |= 0x80 >> (*bit & 7);
+    }
+    (*bit)++;
+  }
+}
+/*---------------------------------------------------------------------------*/
+static uint32_t
+get_bits(const uint8_t *buf, uint16_t *bit, unsigned n)
+{
+  uint32_t value;
+
+  for(value = 0; n > 0; n--) {
+    value = value << 1 | ((buf[*bit >> 3] >> (7 - (*bit & 7))) & 1);
+    (*bit)++;
+  }
+  return value;
+}
+/*---------------------------------------------------------------------------*/
+static uint32_t
+zigzag(int32_t v)
+{
+  return ((uint32_t)v << 1) ^ (v < 0 ? 0xffffffff : 0);
+}
+/*---------------------------------------------------------------------------*/
+static int32_t
+unzigzag(uint32_t v)
+{
+  return (int32_t)((v >> 1) ^ (0 - (v & 1)));
+}
+/*---------------------------------------------------------------------------*/
+/*
+ * Delta-of-delta codes: '0' for 0, then '10', '110', and '1110' with
+ * 7, 9, and 12 bits, and '1111' with 32 bits.
+ */
+static void
+put_time(uint8_t *buf, uint16_t *bit, int32_t dod)
+{
+  uint32_t v;
+
+  v = zigzag(dod);
+  if(v == 0) {
+    put_bits(buf, bit, 0, 1);
+  } else if(v < (1 << 7)) {
+    put_bits(buf, bit, 0x2, 2);
+    put_bits(buf, bit, v, 7);
+  } else if(v < (1 << 9)) {
+    put_bits(buf, bit, 0x6, 3);
+    put_bits(buf, bit, v, 9);
+  } else if(v < (1 << 12)) {
+    put_bits(buf, bit, 0xe, 4);
+    put_bits(buf, bit, v, 12);
+  } else {
+    put_bits(buf, bit, 0xf, 4);
+    put_bits(buf, bit, v, 32);
+  }
+}
+/*---------------------------------------------------------------------------*/
+static int32_t
+get_time(const uint8_t *buf, uint16_t *bit)
+{
+  if(get_bits(buf, bit, 1) == 0) {
+    return 0;
+  } else if(get_bits(buf, bit, 1) == 0) {
+    return unzigzag(get_bits(buf, bit, 7));
+  } else if(get_bits(buf, bit, 1) == 0) {
+    return unzigzag(get_bits(buf, bit, 9));
+  } else if(get_bits(buf, bit, 1) == 0) {
+    return unzigzag(get_bits(buf, bit, 12));
+  }
+  return unzigzag(get_bits(buf, bit, 32));
+}
+/*---------------------------------------------------------------------------*/
+/* Value delta codes: '0' for 0, then '10' and '110' with 6 and 12 bits,
+   and '111' with 32 bits. */
+static void
+put_value(uint8_t *buf, uint16_t *bit, int32_t delta)
+{
+  uint32_t v;
+
+  v = zigzag(delta);
+  if(v == 0) {
+    put_bits(buf, bit, 0, 1);
+  } else if(v < (1 << 6)) {
+    put_bits(buf, bit, 0x2, 2);
+    put_bits(buf, bit, v, 6);
+  } else if(v < (1 << 12)) {
+    put_bits(buf, bit, 0x6, 3);
+    put_bits(buf, bit, v, 12);
+  } else {
+    put_bits(buf, bit, 0x7, 3);
+    put_bits(buf, bit, v, 32);
+  }
+}
+/*---------------------------------------------------------------------------*/
+static int32_t
+get_value(const uint8_t *buf, uint16_t *bit)
+{
+  if(get_bits(buf, bit, 1) == 0) {
+    return 0;
+  } else if(get_bits(buf, bit, 1) == 0) {
+    return unzigzag(get_bits(buf, bit, 6));
+  } else if(get_bits(buf, bit, 1) == 0) {
+    return unzigzag(get_bits(buf, bit, 12));
+  }
+  return unzigzag(get_bits(buf, bit, 32));
+}
+/*---------------------------------------------------------------------------*/
+static void
+segment_name(const tslog_t *log, uint32_t seq, char *name, size_t size)
+{
+  snprintf(name, size, "%s.%u", log->name, (unsigned)SLOT(seq));
+}
+/*---------------------------------------------------------------------------*/
+/* Read the beginning of a block, and check that the block is complete. */
+static int
+read_block(const tslog_t *log, uint32_t seq, uint16_t block_no,
+           uint8_t *buf, unsigned len)
+{
+  char name[TSLOG_NAME_LENGTH + 8];
+  cfs_offset_t offset;
+  uint8_t magic;
+  int fd;
+  int r;
+
+  segment_name(log, seq, name, sizeof(name));
+  fd = cfs_open(name, CFS_READ);
+  if(fd < 0) {
+    return -1;
+  }
+
+  r = -1;
+  offset = (cfs_offset_t)block_no * TSLOG_BLOCK_SIZE;
+  if(cfs_seek(fd, offset, CFS_SEEK_SET) == offset &&
+     cfs_read(fd, buf, len) == len && buf[0] == BLOCK_MAGIC) {
+    if(len == TSLOG_BLOCK_SIZE) {
+      magic = buf[TSLOG_BLOCK_SIZE - 1];
+    } else if(cfs_seek(fd, offset + TSLOG_BLOCK_SIZE - 1, CFS_SEEK_SET) !=
+              offset + TSLOG_BLOCK_SIZE - 1 ||
+              cfs_read(fd, &magic, 1) != 1) {
+      magic = 0;
+    }
+    if(magic == BLOCK_MAGIC) {
+      r = 0;
+    }
+  }
+  cfs_close(fd);
+  return r;
+}
+/*---------------------------------------------------------------------------*/
+/* Check whether a segment holds data after its complete blocks. */
+static int
+segment_has_tail(const tslog_t *log, uint32_t seq)
+{
+  char name[TSLOG_NAME_LENGTH + 8];
+  cfs_offset_t size;
+  int fd;
+
+  segment_name(log, seq, name, sizeof(name));
+  fd = cfs_open(name, CFS_READ);
+  if(fd < 0) {
+    return 0;
+  }
+  size = cfs_seek(fd, 0, CFS_SEEK_END);
+  cfs_close(fd);
+  return size != (cfs_offset_t)log->blocks[SLOT(seq)] * TSLOG_BLOCK_SIZE;
+}
+/*---------------------------------------------------------------------------*/
+static void
+remove_segment(tslog_t *log, uint32_t seq)
+{
+  char name[TSLOG_NAME_LENGTH + 8];
+
+  segment_name(log, seq, name, sizeof(name));
+  cfs_remove(name);
+  log->blocks[SLOT(seq)] = 0;
+}
+/*---------------------------------------------------------------------------*/
+static void
+start_segment(tslog_t *log, uint32_t seq)
+{
+  if(seq - log->first_seq >= TSLOG_SEGMENT_LIMIT) {
+    /* Reclaim the oldest segment. */
+    remove_segment(log, log->first_seq);
+    log->first_seq++;
+  }
+  log->write_seq = seq;
+  remove_segment(log, seq);
+}
+/*---------------------------------------------------------------------------*/
+static int
+write_block(tslog_t *log)
+{
+  char name[TSLOG_NAME_LENGTH + 8];
+  cfs_offset_t offset;
+  uint16_t *blocks;
+  int fd;
+  int r;
+
+  log->block[0] = BLOCK_MAGIC;
+  log->block[OFFSET_COUNT] = log->count >> 8;
+  log->block[OFFSET_COUNT + 1] = log->count & 0xff;
+  put32(&log->block[OFFSET_SEQ], log->write_seq);
+  put32(&log->block[OFFSET_LAST_TIME], log->last_time);
+  log->block[TSLOG_BLOCK_SIZE - 1] = BLOCK_MAGIC;
+
+  segment_name(log, log->write_seq, name, sizeof(name));
+  fd = cfs_open(name, CFS_WRITE | CFS_APPEND);
+  if(fd < 0) {
+    return -1;
+  }
+
+  blocks = &log->blocks[SLOT(log->write_seq)];
+  offset = (cfs_offset_t)*blocks * TSLOG_BLOCK_SIZE;
+  r = cfs_seek(fd, offset, CFS_SEEK_SET) == offset &&
+      cfs_write(fd, log->block, TSLOG_BLOCK_SIZE) == TSLOG_BLOCK_SIZE;
+  cfs_close(fd);
+  if(!r) {
+    return -1;
+  }
+
+  if(*blocks == 0) {
+    log->first_time[SLOT(log->write_seq)] =
+      get32(&log->block[OFFSET_FIRST_TIME]);
+  }
+  log->count = 0;
+  if(++(*blocks) == TSLOG_SEGMENT_BLOCKS) {
+    start_segment(log, log->write_seq + 1);
+  }
+  return 0;
+}
+/*---------------------------------------------------------------------------*/
+/* Return the first time stamp of a segment, including the block in RAM. */
+static int
+segment_first_time(const tslog_t *log, uint32_t seq, uint32_t *time)
+{
+  if(log->blocks[SLOT(seq)] > 0) {
+    *time = log->first_time[SLOT(seq)];
+    return 1;
+  }
+  if(seq == log->write_seq && log->count > 0) {
+    *time = get32(&log->block[OFFSET_FIRST_TIME]);
+    return 1;
+  }
+  return 0;
+}
+/*---------------------------------------------------------------------------*/
+int
+tslog_open(tslog_t *log, const char *name)
+{
+  uint8_t header[HEADER_SIZE];
+  uint32_t seqs[TSLOG_SEGMENT_LIMIT];
+  uint32_t last_times[TSLOG_SEGMENT_LIMIT];
+  uint32_t seq;
+  uint16_t n;
+  unsigned i;
+  int found;
+
+  if(strlen(name) > TSLOG_NAME_LENGTH) {
+    return -1;
+  }
+
+  memset(log, 0, sizeof(*log));
+  strcpy(log->name, name);
+
+  /* Find the segments and count their complete blocks. */
+  found = 0;
+  for(i = 0; i < TSLOG_SEGMENT_LIMIT; i++) {
+    for(n = 0; n < TSLOG_SEGMENT_BLOCKS; n++) {
+      if(read_block(log, i, n, header, sizeof(header)) < 0 ||
+         (n > 0 && get32(&header[OFFSET_SEQ]) != seqs[i])) {
+        break;
+      }
+      if(n == 0) {
+        seqs[i] = get32(&header[OFFSET_SEQ]);
+        log->first_time[i] = get32(&header[OFFSET_FIRST_TIME]);
+      }
+      last_times[i] = get32(&header[OFFSET_LAST_TIME]);
+    }
+    log->blocks[i] = n;
+    if(n > 0 && SLOT(seqs[i]) == i &&
+       (!found || seqs[i] - log->write_seq < 0x80000000UL)) {
+      log->write_seq = seqs[i];
+      found = 1;
+    }
+  }
+
+  /* Keep the segments that belong to the window of the newest one. */
+  log->first_seq = log->write_seq;
+  for(i = 0; i < TSLOG_SEGMENT_LIMIT; i++) {
+    if(log->blocks[i] == 0 || SLOT(seqs[i]) != i ||
+       log->write_seq - seqs[i] >= TSLOG_SEGMENT_LIMIT) {
+      remove_segment(log, i);
+    } else if(log->write_seq - seqs[i] > log->write_seq - log->first_seq) {
+      log->first_seq = seqs[i];
+    }
+  }
+
+  if(found) {
+    seq = log->write_seq;
+    log->last_time = last_times[SLOT(seq)];
+    /* Blocks are appended to the end of the file, so a segment that
+       ends with a torn block cannot take any more blocks. */
+    if(log->blocks[SLOT(seq)] == TSLOG_SEGMENT_BLOCKS ||
+       segment_has_tail(log, seq)) {
+      start_segment(log, seq + 1);
+    }
+  }
+
+  return 0;
+}
+/*---------------------------------------------------------------------------*/
+int
+tslog_close(tslog_t *log)
+{
+  return tslog_flush(log);
+}
+/*---------------------------------------------------------------------------*/
+int
+tslog_append(tslog_t *log, uint32_t time, int32_t value)
+{
+  uint32_t delta;
+
+  if(time < log->last_time) {
+    return -1;
+  }
+
+  if(log->count > 0 &&
+     (log->bit + MAX_SAMPLE_BITS > DATA_END_BIT || log->count == 0xffff)) {
+    if(write_block(log) < 0) {
+      return -1;
+    }
+  }
+
+  if(log->count == 0) {
+    memset(log->block, 0, sizeof(log->block));
+    put32(&log->block[OFFSET_FIRST_TIME], time);
+    put32(&log->block[OFFSET_FIRST_VALUE], (uint32_t)value);
+    log->bit = HEADER_SIZE * 8;
+    log->last_delta = 0;
+  } else {
+    delta = time - log->last_time;
+    put_time(log->block, &log->bit, (int32_t)(delta - log->last_delta));
+    put_value(log->block, &log->bit,
+              (int32_t)((uint32_t)value - (uint32_t)log->last_value));
+    log->last_delta = delta;
+  }
+
+  log->last_time = time;
+  log->last_value = value;
+  log->count++;
+  return 0;
+}
+/*---------------------------------------------------------------------------*/
+int
+tslog_flush(tslog_t *log)
+{
+  if(log->count == 0) {
+    return 0;
+  }
+  return write_block(log);
+}
+/*---------------------------------------------------------------------------*/
+int
+tslog_remove_before(tslog_t *log, uint32_t time)
+{
+  uint32_t next_time;
+  int removed;
+
+  /* A segment only holds samples older than the first sample of the
+     next segment. */
+  for(removed = 0; log->first_seq != log->write_seq; removed++) {
+    if(!segment_first_time(log, log->first_seq + 1, &next_time) ||
+       next_time >= time) {
+      break;
+    }
+    remove_segment(log, log->first_seq);
+    log->first_seq++;
+  }
+
+  return removed;
+}
+/*---------------------------------------------------------------------------*/
+void
+tslog_remove(tslog_t *log)
+{
+  char name[TSLOG_NAME_LENGTH + 1];
+  unsigned i;
+
+  for(i = 0; i < TSLOG_SEGMENT_LIMIT; i++) {
+    remove_segment(log, i);
+  }
+  strcpy(name, log->name);
+  memset(log, 0, sizeof(*log));
+  strcpy(log->name, name);
+}
+/*---------------------------------------------------------------------------*/
+void
+tslog_read_start(tslog_t *log, tslog_reader_t *reader,
+                 uint32_t from, uint32_t to)
+{
+  uint32_t next_time;
+
+  memset(reader, 0, sizeof(*reader));
+  reader->log = log;
+  reader->from = from;
+  reader->to = to;
+
+  /* Skip the segments that end before the range. */
+  reader->seq = log->first_seq;
+  while(reader->seq != log->write_seq &&
+        segment_first_time(log, reader->seq + 1, &next_time) &&
+        next_time < from) {
+    reader->seq++;
+  }
+}
+/*---------------------------------------------------------------------------*/
+/* Find the first block of the segment that ends at or after a time. */
+static int
+search_segment(tslog_reader_t *reader)
+{
+  uint8_t header[HEADER_SIZE];
+  uint16_t low, high, mid;
+
+  low = 0;
+  high = reader->log->blocks[SLOT(reader->seq)];
+  while(low < high) {
+    mid = (low + high) / 2;
+    if(read_block(reader->log, reader->seq, mid, header, sizeof(header)) < 0) {
+      return -1;
+    }
+    if(get32(&header[OFFSET_LAST_TIME]) < reader->from) {
+      low = mid + 1;
+    } else {
+      high = mid;
+    }
+  }
+  reader->block_no = low;
+  return 0;
+}
+/*---------------------------------------------------------------------------*/
+static int
+load_block(tslog_reader_t *reader)
+{
+  tslog_t *log;
+
+  log = reader->log;
+
+  if(reader->seq - log->first_seq > log->write_seq - log->first_seq) {
+    /* The segment has been removed while reading. */
+    reader->seq = log->first_seq;
+    reader->block_no = 0;
+  }
+
+  if(!reader->searched) {
+    reader->searched = 1;
+    if(search_segment(reader) < 0) {
+      return -1;
+    }
+  }
+
+  for(;;) {
+    if(reader->block_no < log->blocks[SLOT(reader->seq)]) {
+      if(read_block(log, reader->seq, reader->block_no,
+                    reader->block, TSLOG_BLOCK_SIZE) < 0 ||
+         get32(&reader->block[OFFSET_SEQ]) != reader->seq) {
+        return -1;
+      }
+      reader->block_no++;
+      break;
+    }
+    if(reader->seq == log->write_seq) {
+      /* Finish with the samples that are still in RAM. */
+      if(log->count == 0) {
+        return 0;
+      }
+      memcpy(reader->block, log->block, TSLOG_BLOCK_SIZE);
+      reader->block[OFFSET_COUNT] = log->count >> 8;
+      reader->block[OFFSET_COUNT + 1] = log->count & 0xff;
+      reader->in_ram = 1;
+      break;
+    }
+    reader->seq++;
+    reader->block_no = 0;
+  }
+
+  reader->remaining = reader->block[OFFSET_COUNT] << 8 |
+                      reader->block[OFFSET_COUNT + 1];
+  reader->bit = 0;
+  return 1;
+}
+/*---------------------------------------------------------------------------*/
+int
+tslog_read(tslog_reader_t *reader, uint32_t *time, int32_t *value)
+{
+  int r;
+
+  while(!reader->done) {
+    if(reader->remaining == 0) {
+      if(reader->in_ram) {
+        break;
+      }
+      r = load_block(reader);
+      if(r <= 0) {
+        reader->done = 1;
+        return r;
+      }
+    }
+
+    if(reader->bit == 0) {
+      reader->time = get32(&reader->block[OFFSET_FIRST_TIME]);
+      reader->value = (int32_t)get32(&reader->block[OFFSET_FIRST_VALUE]);
+      reader->delta = 0;
+      reader->bit = HEADER_SIZE * 8;
+    } else {
+      reader->delta += (uint32_t)get_time(reader->block, &reader->bit);
+      reader->time += reader->delta;
+      reader->value = (int32_t)((uint32_t)reader->value +
+                                (uint32_t)get_value(reader->block,
+                                                    &reader->bit));
+    }
+    reader->remaining--;
+
+    if(reader->time > reader->to) {
+      break;
+    }
+    if(reader->time >= reader->from) {
+      *time = reader->time;
+      *value = reader->value;
+      return 1;
+    }
+  }
+
+  reader->done = 1;
+  return 0;
+}
+/*---------------------------------------------------------------------------*/
@@ -0,0 +1,202 @@
+/*
+ * Copyright (c) 2026, agent <agent@local>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+ * OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * \file
+ *         An append-only log of time-stamped samples in CFS files.
+ *
+ *         Samples are compressed into fixed-size blocks in RAM. The
+ *         time stamps are stored as deltas of deltas and the values as
+ *         deltas, with short bit codes for the common small cases. A
+ *         full block is appended once to a segment file and never
+ *         rewritten. The header of each block holds its time range, so
+ *         the block headers form a sparse time index for range reads.
+ *
+ *         A log uses up to TSLOG_SEGMENT_LIMIT segment files. When all
+ *         of them are full, the oldest segment is removed to make room.
+ *         Older segments can also be removed by time with
+ *         tslog_remove_before().
+ *
+ *         On Coffee, a segment should not be larger than
+ *         COFFEE_DYN_SIZE, so that it never has to be extended.
+ */
+
+#ifndef TSLOG_H_
+#define TSLOG_H_
+
+#include "contiki.h"
+
+#include <stdint.h>
+
+#ifdef TSLOG_CONF_BLOCK_SIZE
+#define TSLOG_BLOCK_SIZE TSLOG_CONF_BLOCK_SIZE
+#else
+/** The size of a compressed block in bytes */
+#define TSLOG_BLOCK_SIZE 128
+#endif
+
+#ifdef TSLOG_CONF_SEGMENT_BLOCKS
+#define TSLOG_SEGMENT_BLOCKS TSLOG_CONF_SEGMENT_BLOCKS
+#else
+/** The number of blocks in a segment file */
+#define TSLOG_SEGMENT_BLOCKS 32
+#endif
+
+#ifdef TSLOG_CONF_SEGMENT_LIMIT
+#define TSLOG_SEGMENT_LIMIT TSLOG_CONF_SEGMENT_LIMIT
+#else
+/** The maximum number of segment files of a log */
+#define TSLOG_SEGMENT_LIMIT 16
+#endif
+
+#ifdef TSLOG_CONF_NAME_LENGTH
+#define TSLOG_NAME_LENGTH TSLOG_CONF_NAME_LENGTH
+#else
+/** The maximum length of a log name. The segment file names are
+    the log name followed by a dot and the segment number. */
+#define TSLOG_NAME_LENGTH 12
+#endif
+
+/** A time-series log */
+typedef struct tslog {
+  char name[TSLOG_NAME_LENGTH + 1];
+  /* The oldest segment and the segment that is being written */
+  uint32_t first_seq;
+  uint32_t write_seq;
+  /* The first time stamp and the number of blocks of each segment,
+     indexed by the segment number modulo TSLOG_SEGMENT_LIMIT */
+  uint32_t first_time[TSLOG_SEGMENT_LIMIT];
+  uint16_t blocks[TSLOG_SEGMENT_LIMIT];
+  /* The block that is being filled */
+  uint8_t block[TSLOG_BLOCK_SIZE];
+  uint16_t bit;
+  uint16_t count;
+  uint32_t last_time;
+  uint32_t last_delta;
+  int32_t last_value;
+} tslog_t;
+
+/** A reader of a time range in a log */
+typedef struct tslog_reader {
+  tslog_t *log;
+  uint32_t from;
+  uint32_t to;
+  uint32_t seq;
+  uint16_t block_no;
+  uint8_t block[TSLOG_BLOCK_SIZE];
+  uint16_t bit;
+  uint16_t remaining;
+  uint32_t time;
+  uint32_t delta;
+  int32_t value;
+  uint8_t searched;
+  uint8_t in_ram;
+  uint8_t done;
+} tslog_reader_t;
+
+/**
+ * \brief Open a log and recover its segments from the file system
+ * \param log The log
+ * \param name The name of the log
+ * \return 0 on success, -1 if the name is too long
+ *
+ * Blocks that were not completely written are ignored. If the newest
+ * segment ends with such a block, new blocks go to the next segment.
+ */
+int tslog_open(tslog_t *log, const char *name);
+
+/**
+ * \brief Write out the block that is being filled and close the log
+ * \param log The log
+ * \return 0 on success, -1 if the block could not be written
+ */
+int tslog_close(tslog_t *log);
+
+/**
+ * \brief Append a sample to a log
+ * \param log The log
+ * \param time The time stamp. It must not be earlier than the time
+ *        stamp of the previous sample.
+ * \param value The value
+ * \return 0 on success, -1 on error
+ *
+ * The sample is kept in RAM until its block is full, or until
+ * tslog_flush() is called.
+ */
+int tslog_append(tslog_t *log, uint32_t time, int32_t value);
+
+/**
+ * \brief Write out the block that is being filled, even if it is not full
+ * \param log The log
+ * \return 0 on success, -1 if the block could not be written
+ *
+ * The next sample starts a new block, so frequent flushing uses more
+ * space in the file system.
+ */
+int tslog_flush(tslog_t *log);
+
+/**
+ * \brief Remove the segments that only hold samples older than a time
+ * \param log The log
+ * \param time The time stamp of the oldest sample to keep
+ * \return The number of removed segments
+ */
+int tslog_remove_before(tslog_t *log, uint32_t time);
+
+/**
+ * \brief Remove all the samples of a log
+ * \param log The log
+ */
+void tslog_remove(tslog_t *log);
+
+/**
+ * \brief Start reading the samples in a time range
+ * \param log The log
+ * \param reader The reader
+ * \param from The earliest time stamp to read
+ * \param to The latest time stamp to read
+ *
+ * The reader also returns the samples that are still in RAM. Samples
+ * that are appended while reading may or may not be returned.
+ */
+void tslog_read_start(tslog_t *log, tslog_reader_t *reader,
+                      uint32_t from, uint32_t to);
+
+/**
+ * \brief Read the next sample in the range
+ * \param reader The reader
+ * \param time Set to the time stamp of the sample
+ * \param value Set to the value of the sample
+ * \return 1 if a sample was read, 0 at the end of the range, or
+ *         -1 if a block could not be read
+ */
+int tslog_read(tslog_reader_t *reader, uint32_t *time, int32_t *value);
+
+#endif /* TSLOG_H_ */
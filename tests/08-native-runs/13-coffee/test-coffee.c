@@ -239,6 +239,8 @@ UNIT_TEST(coffee_gc)
 {
   UNIT_TEST_BEGIN();
 
+  struct cfs_coffee_gc_stats stats;
+
   for (int i = 0; i < 100; i++) {
     if (i & 1) {
       UNIT_TEST_ASSERT(cfs_coffee_reserve("FileB", random_rand() & 0xffff) == 0);
@@ -249,11 +251,87 @@ UNIT_TEST(coffee_gc)
     }
   }
 
+  /* The storage has been filled several times. */
+  cfs_coffee_get_gc_stats(&stats);
+  UNIT_TEST_ASSERT(stats.runs > 0);
+  UNIT_TEST_ASSERT(stats.erased_sectors > 0);
+  UNIT_TEST_ASSERT(stats.max_pause <= stats.total_time);
+
+  UNIT_TEST_END();
+}
+/*---------------------------------------------------------------------------*/
+UNIT_TEST_REGISTER(coffee_many_files, "Coffee with many files");
+UNIT_TEST(coffee_many_files)
+{
+  UNIT_TEST_BEGIN();
+
+  char name[8], buf[8];
+  int fd, i, len;
+#define FILE_COUNT 24
+
+  UNIT_TEST_ASSERT(cfs_coffee_format() == 0);
+
+  /* Test 1: Create more files than there are open file slots. */
+  for(i = 0; i < FILE_COUNT; i++) {
+    snprintf(name, sizeof(name), "M%d", i);
+    fd = cfs_open(name, CFS_WRITE);
+    UNIT_TEST_ASSERT(fd >= 0);
+    len = strlen(name);
+    UNIT_TEST_ASSERT(cfs_write(fd, name, len) == len);
+    cfs_close(fd);
+  }
+
+  /* Test 2: Remove every other file. */
+  for(i = 0; i < FILE_COUNT; i += 2) {
+    snprintf(name, sizeof(name), "M%d", i);
+    UNIT_TEST_ASSERT(cfs_remove(name) == 0);
+    UNIT_TEST_ASSERT(cfs_remove(name) == -1);
+  }
+
+  /* Test 3: Only the remaining files can be found. */
+  for(i = 0; i < FILE_COUNT; i++) {
+    snprintf(name, sizeof(name), "M%d", i);
+    fd = cfs_open(name, CFS_READ);
+    if(i & 1) {
+      UNIT_TEST_ASSERT(fd >= 0);
+      len = cfs_read(fd, buf, sizeof(buf));
+      UNIT_TEST_ASSERT(len == strlen(name) && memcmp(buf, name, len) == 0);
+      cfs_close(fd);
+    } else {
+      UNIT_TEST_ASSERT(fd < 0);
+    }
+  }
+
+  /* Test 4: Recreate the removed files. */
+  for(i = 0; i < FILE_COUNT; i += 2) {
+    snprintf(name, sizeof(name), "M%d", i);
+    UNIT_TEST_ASSERT(cfs_coffee_reserve(name, sizeof(buf)) == 0);
+    UNIT_TEST_ASSERT(cfs_coffee_reserve(name, sizeof(buf)) == -1);
+    fd = cfs_open(name, CFS_WRITE);
+    UNIT_TEST_ASSERT(fd >= 0);
+    len = strlen(name);
+    UNIT_TEST_ASSERT(cfs_write(fd, name, len) == len);
+    cfs_close(fd);
+  }
+
+  for(i = 0; i < FILE_COUNT; i++) {
+    snprintf(name, sizeof(name), "M%d", i);
+    fd = cfs_open(name, CFS_READ);
+    UNIT_TEST_ASSERT(fd >= 0);
+    len = cfs_read(fd, buf, sizeof(buf));
+    UNIT_TEST_ASSERT(len == strlen(name) && memcmp(buf, name, len) == 0);
+    cfs_close(fd);
+    UNIT_TEST_ASSERT(cfs_remove(name) == 0);
+  }
+
   UNIT_TEST_END();
 }
 /*---------------------------------------------------------------------------*/
 PROCESS_THREAD(testcoffee_process, ev, data)
 {
+  static struct cfs_coffee_gc_stats gc_stats;
+  static uint32_t background_runs;
+
   PROCESS_BEGIN();
 
   printf("Run unit-test\n");
@@ -263,6 +341,14 @@ PROCESS_THREAD(testcoffee_process, ev, data)
   UNIT_TEST_RUN(coffee_append);
   UNIT_TEST_RUN(coffee_modify);
   UNIT_TEST_RUN(coffee_gc);
+  /* Let a background garbage collector finish its pass. */
+  do {
+    cfs_coffee_get_gc_stats(&gc_stats);
+    background_runs = gc_stats.background_runs;
+    PROCESS_PAUSE();
+    cfs_coffee_get_gc_stats(&gc_stats);
+  } while(gc_stats.background_runs != background_runs);
+  UNIT_TEST_RUN(coffee_many_files);
 
   cfs_close(wfd);
   cfs_close(rfd);
@@ -274,7 +360,8 @@ PROCESS_THREAD(testcoffee_process, ev, data)
   if(!UNIT_TEST_PASSED(coffee_basic_io) ||
      !UNIT_TEST_PASSED(coffee_append) ||
      !UNIT_TEST_PASSED(coffee_modify) ||
-     !UNIT_TEST_PASSED(coffee_gc)) {
+     !UNIT_TEST_PASSED(coffee_gc) ||
+     !UNIT_TEST_PASSED(coffee_many_files)) {
     printf("=check-me= FAILED\n");
     printf("---\n");
   }
@@ -0,0 +1,329 @@
+/*
+ * Copyright (c) 2026, agent <agent@local>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+ * OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "contiki.h"
+#include "unit-test.h"
+#include "cbor.h"
+#include "senml-cbor.h"
+#include <stddef.h>
+#include <string.h>
+#include <stdio.h>
+
+PROCESS(test_process, "test");
+AUTOSTART_PROCESSES(&test_process);
+
+/* Examples from RFC 8949, Appendix A */
+static const struct {
+  int64_t value;
+  uint8_t len;
+  uint8_t cbor[9];
+} integers[] = {
+  { 0, 1, { 0x00 } },
+  { 23, 1, { 0x17 } },
+  { 24, 2, { 0x18, 0x18 } },
+  { 100, 2, { 0x18, 0x64 } },
+  { 1000, 3, { 0x19, 0x03, 0xe8 } },
+  { 1000000, 5, { 0x1a, 0x00, 0x0f, 0x42, 0x40 } },
+  { 1000000000000, 9,
+    { 0x1b, 0x00, 0x00, 0x00, 0xe8, 0xd4, 0xa5, 0x10, 0x00 } },
+  { -1, 1, { 0x20 } },
+  { -10, 1, { 0x29 } },
+  { -100, 2, { 0x38, 0x63 } },
+  { -1000, 3, { 0x39, 0x03, 0xe7 } },
+};
+
+static const struct {
+  float value;
+  uint8_t len;
+  uint8_t cbor[9];
+} floats[] = {
+  { 1.0, 3, { 0xf9, 0x3c, 0x00 } },
+  { -4.0, 3, { 0xf9, 0xc4, 0x00 } },
+  { 65504.0, 3, { 0xf9, 0x7b, 0xff } },
+  { 5.960464477539063e-8, 3, { 0xf9, 0x00, 0x01 } },
+  { 100000.0, 5, { 0xfa, 0x47, 0xc3, 0x50, 0x00 } },
+  { 1.1, 9, { 0xfb, 0x3f, 0xf1, 0x99, 0x99, 0x99, 0x99, 0x99, 0x9a } },
+};
+
+/* {"a": 1, "b": [2, 3]}, [_ "a", {_ "b": "c"}], (_ h'0102', h'030405') */
+static const uint8_t nested[] = {
+  0xa2, 0x61, 0x61, 0x01, 0x61, 0x62, 0x82, 0x02, 0x03,
+  0x9f, 0x61, 0x61, 0xbf, 0x61, 0x62, 0x61, 0x63, 0xff, 0xff,
+  0x5f, 0x42, 0x01, 0x02, 0x43, 0x03, 0x04, 0x05, 0xff,
+  0x18, 0x2a
+};
+/*---------------------------------------------------------------------------*/
+UNIT_TEST_REGISTER(cbor_encode, "CBOR encoding");
+UNIT_TEST(cbor_encode)
+{
+  static const uint8_t expected[] = {
+    0xf4, 0xf5, 0xf6,
+    0x64, 0x49, 0x45, 0x54, 0x46,
+    0x44, 0x01, 0x02, 0x03, 0x04,
+    0x82, 0x01, 0x82, 0x02, 0x03,
+    0xbf, 0x01, 0xfa, 0x47, 0xc3, 0x50, 0x00, 0xff,
+    0xc1, 0x1a, 0x51, 0x4b, 0x67, 0xb0
+  };
+  uint8_t buf[64];
+  cbor_writer_t writer;
+  size_t i;
+
+  UNIT_TEST_BEGIN();
+
+  for(i = 0; i < sizeof(integers) / sizeof(integers[0]); i++) {
+    cbor_writer_init(&writer, buf, sizeof(buf));
+    UNIT_TEST_ASSERT(cbor_write_int(&writer, integers[i].value) ==
+                     integers[i].len);
+    UNIT_TEST_ASSERT(!memcmp(buf, integers[i].cbor, integers[i].len));
+  }
+
+  cbor_writer_init(&writer, buf, sizeof(buf));
+  cbor_write_bool(&writer, 0);
+  cbor_write_bool(&writer, 1);
+  cbor_write_null(&writer);
+  cbor_write_text(&writer, "IETF", 4);
+  cbor_write_bytes(&writer, (const uint8_t *)"\x01\x02\x03\x04", 4);
+  cbor_write_array(&writer, 2);
+  cbor_write_uint(&writer, 1);
+  cbor_write_array(&writer, 2);
+  cbor_write_uint(&writer, 2);
+  cbor_write_uint(&writer, 3);
+  cbor_write_map(&writer, CBOR_INDEFINITE);
+  cbor_write_uint(&writer, 1);
+  cbor_write_float(&writer, 100000.0);
+  cbor_write_break(&writer);
+  cbor_write_tag(&writer, 1);
+  cbor_write_uint(&writer, 1363896240);
+  UNIT_TEST_ASSERT(!writer.overflow);
+  UNIT_TEST_ASSERT(writer.len == sizeof(expected));
+  UNIT_TEST_ASSERT(!memcmp(buf, expected, sizeof(expected)));
+
+  UNIT_TEST_END();
+}
+/*---------------------------------------------------------------------------*/
+UNIT_TEST_REGISTER(cbor_overflow, "CBOR buffer overflow");
+UNIT_TEST(cbor_overflow)
+{
+  uint8_t buf[6];
+  cbor_writer_t writer;
+
+  UNIT_TEST_BEGIN();
+
+  cbor_writer_init(&writer, buf, sizeof(buf));
+  UNIT_TEST_ASSERT(cbor_write_uint(&writer, 1000) == 3);
+  /* Items are written completely or not at all */
+  UNIT_TEST_ASSERT(cbor_write_text(&writer, "abc", 3) == 0);
+  UNIT_TEST_ASSERT(writer.len == 3);
+  UNIT_TEST_ASSERT(writer.overflow);
+  UNIT_TEST_ASSERT(cbor_write_uint(&writer, 1000000) == 0);
+  UNIT_TEST_ASSERT(cbor_write_text(&writer, "ab", 2) == 3);
+  UNIT_TEST_ASSERT(writer.len == sizeof(buf));
+  UNIT_TEST_ASSERT(cbor_write_break(&writer) == 0);
+
+  UNIT_TEST_END();
+}
+/*---------------------------------------------------------------------------*/
+UNIT_TEST_REGISTER(cbor_decode, "CBOR decoding");
+UNIT_TEST(cbor_decode)
+{
+  cbor_reader_t reader;
+  int64_t value;
+  uint64_t uvalue;
+  float number;
+  const char *text;
+  size_t len;
+  size_t count;
+  size_t i;
+
+  UNIT_TEST_BEGIN();
+
+  for(i = 0; i < sizeof(integers) / sizeof(integers[0]); i++) {
+    cbor_reader_init(&reader, integers[i].cbor, integers[i].len);
+    UNIT_TEST_ASSERT(cbor_read_int(&reader, &value));
+    UNIT_TEST_ASSERT(value == integers[i].value);
+    UNIT_TEST_ASSERT(reader.pos == integers[i].len);
+  }
+
+  for(i = 0; i < sizeof(floats) / sizeof(floats[0]); i++) {
+    cbor_reader_init(&reader, floats[i].cbor, floats[i].len);
+    UNIT_TEST_ASSERT(!cbor_read_int(&reader, &value));
+    UNIT_TEST_ASSERT(cbor_read_float(&reader, &number));
+    UNIT_TEST_ASSERT(number == floats[i].value);
+  }
+
+  /* Truncated argument */
+  cbor_reader_init(&reader, integers[4].cbor, integers[4].len - 1);
+  UNIT_TEST_ASSERT(!cbor_read_uint(&reader, &uvalue));
+  UNIT_TEST_ASSERT(reader.error);
+  UNIT_TEST_ASSERT(reader.pos == 0);
+
+  cbor_reader_init(&reader, nested, sizeof(nested));
+  UNIT_TEST_ASSERT(cbor_read_type(&reader) == CBOR_MAJOR_MAP);
+  UNIT_TEST_ASSERT(cbor_read_map(&reader, &count) && count == 2);
+  UNIT_TEST_ASSERT(cbor_read_text(&reader, &text, &len));
+  UNIT_TEST_ASSERT(len == 1 && text[0] == 'a');
+  UNIT_TEST_ASSERT(text == (const char *)&nested[2]);
+  UNIT_TEST_ASSERT(cbor_read_skip(&reader));
+  UNIT_TEST_ASSERT(cbor_read_skip(&reader));
+  UNIT_TEST_ASSERT(cbor_read_skip(&reader));
+  UNIT_TEST_ASSERT(reader.pos == 9);
+  UNIT_TEST_ASSERT(cbor_read_array(&reader, &count));
+  UNIT_TEST_ASSERT(count == CBOR_INDEFINITE);
+  UNIT_TEST_ASSERT(!cbor_read_break(&reader));
+  UNIT_TEST_ASSERT(cbor_read_skip(&reader));
+  UNIT_TEST_ASSERT(cbor_read_skip(&reader));
+  UNIT_TEST_ASSERT(cbor_read_type(&reader) == -1);
+  UNIT_TEST_ASSERT(cbor_read_break(&reader));
+  /* Chunked byte strings are skipped but not returned */
+  UNIT_TEST_ASSERT(!cbor_read_text(&reader, &text, &len));
+  UNIT_TEST_ASSERT(cbor_read_skip(&reader));
+  UNIT_TEST_ASSERT(cbor_read_uint(&reader, &uvalue) && uvalue == 42);
+  UNIT_TEST_ASSERT(cbor_read_type(&reader) == -1);
+  UNIT_TEST_ASSERT(!reader.error);
+
+  /* Skipping truncated data fails without moving */
+  cbor_reader_init(&reader, nested, 8);
+  UNIT_TEST_ASSERT(!cbor_read_skip(&reader));
+  UNIT_TEST_ASSERT(reader.pos == 0);
+  UNIT_TEST_ASSERT(reader.error);
+
+  UNIT_TEST_END();
+}
+/*---------------------------------------------------------------------------*/
+UNIT_TEST_REGISTER(senml_cbor, "SenML-CBOR records");
+UNIT_TEST(senml_cbor)
+{
+  /* [_ {-2: "/3303/0/", 0: "5700", 2: 21.5}, {0: "5701", 3: "Cel"}, ... */
+  static const uint8_t expected[] = {
+    0x9f,
+    0xa3, 0x21, 0x68, '/', '3', '3', '0', '3', '/', '0', '/',
+    0x00, 0x64, '5', '7', '0', '0',
+    0x02, 0xfa, 0x41, 0xac, 0x00, 0x00,
+    0xa2, 0x00, 0x64, '5', '7', '0', '1', 0x03, 0x63, 'C', 'e', 'l',
+    0xa3, 0x00, 0x61, '1', 0x06, 0x3a, 0x00, 0x01, 0x86, 0x9f,
+    0x04, 0xf5,
+    0xff
+  };
+  uint8_t buf[64];
+  cbor_writer_t writer;
+  cbor_reader_t reader;
+  senml_record_t record;
+  size_t remaining;
+  size_t len;
+
+  UNIT_TEST_BEGIN();
+
+  cbor_writer_init(&writer, buf, sizeof(buf));
+  UNIT_TEST_ASSERT(senml_cbor_start_pack(&writer) == 1);
+
+  memset(&record, 0, sizeof(record));
+  record.base_name = "/3303/0/";
+  record.name = "5700";
+  record.type = SENML_VALUE_FLOAT;
+  record.value.number = 21.5;
+  UNIT_TEST_ASSERT(senml_cbor_write_record(&writer, &record) == 23);
+
+  memset(&record, 0, sizeof(record));
+  record.name = "5701xyz";
+  record.name_len = 4;
+  record.type = SENML_VALUE_STRING;
+  record.value.string.data = (const uint8_t *)"Cel";
+  record.value.string.len = 3;
+  UNIT_TEST_ASSERT(senml_cbor_write_record(&writer, &record) > 0);
+
+  memset(&record, 0, sizeof(record));
+  record.name = "1";
+  record.has_time = 1;
+  record.time = -100000;
+  record.type = SENML_VALUE_BOOL;
+  record.value.boolean = 1;
+  UNIT_TEST_ASSERT(senml_cbor_write_record(&writer, &record) > 0);
+
+  /* A record that does not fit leaves nothing behind */
+  len = writer.len;
+  writer.size = len + 8;
+  UNIT_TEST_ASSERT(senml_cbor_write_record(&writer, &record) == 0);
+  UNIT_TEST_ASSERT(writer.len == len);
+  writer.size = sizeof(buf);
+
+  UNIT_TEST_ASSERT(senml_cbor_end_pack(&writer) == 1);
+  UNIT_TEST_ASSERT(writer.len == sizeof(expected));
+  UNIT_TEST_ASSERT(!memcmp(buf, expected, sizeof(expected)));
+
+  cbor_reader_init(&reader, buf, writer.len);
+  UNIT_TEST_ASSERT(senml_cbor_read_pack(&reader, &remaining));
+  UNIT_TEST_ASSERT(senml_cbor_read_record(&reader, &remaining, &record));
+  UNIT_TEST_ASSERT(record.base_name_len == 8);
+  UNIT_TEST_ASSERT(!memcmp(record.base_name, "/3303/0/", 8));
+  UNIT_TEST_ASSERT(record.name_len == 4 && !memcmp(record.name, "5700", 4));
+  UNIT_TEST_ASSERT(record.type == SENML_VALUE_FLOAT);
+  UNIT_TEST_ASSERT(record.value.number == 21.5);
+  UNIT_TEST_ASSERT(senml_cbor_read_record(&reader, &remaining, &record));
+  UNIT_TEST_ASSERT(record.base_name == NULL);
+  UNIT_TEST_ASSERT(record.type == SENML_VALUE_STRING);
+  UNIT_TEST_ASSERT(record.value.string.len == 3);
+  UNIT_TEST_ASSERT(senml_cbor_read_record(&reader, &remaining, &record));
+  UNIT_TEST_ASSERT(record.has_time && record.time == -100000);
+  UNIT_TEST_ASSERT(record.type == SENML_VALUE_BOOL);
+  UNIT_TEST_ASSERT(record.value.boolean == 1);
+  UNIT_TEST_ASSERT(!senml_cbor_read_record(&reader, &remaining, &record));
+  UNIT_TEST_ASSERT(remaining == 0);
+  UNIT_TEST_ASSERT(!reader.error);
+  UNIT_TEST_ASSERT(reader.pos == writer.len);
+
+  UNIT_TEST_END();
+}
+/*---------------------------------------------------------------------------*/
+PROCESS_THREAD(test_process, ev, data)
+{
+  PROCESS_BEGIN();
+
+  printf("Run unit-test\n");
+  printf("---\n");
+
+  UNIT_TEST_RUN(cbor_encode);
+  UNIT_TEST_RUN(cbor_overflow);
+  UNIT_TEST_RUN(cbor_decode);
+  UNIT_TEST_RUN(senml_cbor);
+
+  if(!UNIT_TEST_PASSED(cbor_encode)
+      || !UNIT_TEST_PASSED(cbor_overflow)
+      || !UNIT_TEST_PASSED(cbor_decode)
+      || !UNIT_TEST_PASSED(senml_cbor)) {
+    printf("=check-me= FAILED\n");
+    printf("---\n");
+  }
+
+  printf("=check-me= DONE\n");
+  printf("---\n");
+
+  PROCESS_END();
+}
+/*---------------------------------------------------------------------------*/
@@ -0,0 +1,237 @@
+/*
+ * Copyright (c) 2026, agent <agent@local>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+ * OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "contiki.h"
+#include "unit-test.h"
+#include "jsonsax.h"
+#include <string.h>
+#include <stdio.h>
+
+PROCESS(test_process, "test");
+AUTOSTART_PROCESSES(&test_process);
+
+/*
+ * The callback records the parsed elements as "<type><value>;" with
+ * string fragments joined, so that the result does not depend on how
+ * the document was split into chunks.
+ */
+static char transcript[256];
+static int transcript_len;
+static int fragments;
+static const char *last_value;
+static int abort_at;
+
+static const char document[] =
+  "{\"name\": \"Temp\\u00e9rature\\n\", \"values\" : [21, -0.5e+2, 1E3, 0],"
+  "\"ok\":true, \"err\":false ,\"x\":null, \"empty\":{}, \"list\":[[]],"
+  "\"\\ud83d\\ude00\":\"a\\\"b\\/c\"}  \n";
+
+static const char expected[] =
+  "{;Nname;STemp\xc3\xa9rature\n;Nvalues;[;021;0-0.5e+2;01E3;00;];"
+  "Nok;t;Nerr;f;Nx;n;Nempty;{;};Nlist;[;[;];];N\xf0\x9f\x98\x80;Sa\"b/c;};";
+/*---------------------------------------------------------------------------*/
+static int
+callback(struct jsonsax_state *state, int type, const char *value, int len)
+{
+  if(abort_at > 0 && --abort_at == 0) {
+    return 1;
+  }
+  if(type == JSON_TYPE_PAIR_NAME || type == JSON_TYPE_STRING) {
+    if(fragments++ == 0) {
+      /* The first fragment of a string */
+      transcript[transcript_len++] = type == JSON_TYPE_STRING ? 'S' : 'N';
+    }
+  } else {
+    transcript[transcript_len++] = type;
+  }
+  if(len > 0 && transcript_len + len < sizeof(transcript) - 1) {
+    memcpy(&transcript[transcript_len], value, len);
+    transcript_len += len;
+  }
+  if(!state->partial) {
+    transcript[transcript_len++] = ';';
+    fragments = 0;
+  }
+  transcript[transcript_len] = '\0';
+  last_value = value;
+  return 0;
+}
+/*---------------------------------------------------------------------------*/
+static void
+reset(struct jsonsax_state *state)
+{
+  jsonsax_init(state, callback, NULL);
+  transcript_len = 0;
+  transcript[0] = '\0';
+  fragments = 0;
+  abort_at = 0;
+}
+/*---------------------------------------------------------------------------*/
+static int
+parse(struct jsonsax_state *state, const char *json, int chunk)
+{
+  int len = strlen(json);
+  int pos;
+  int n;
+
+  reset(state);
+  for(pos = 0; pos < len; pos += n) {
+    n = len - pos < chunk ? len - pos : chunk;
+    if(jsonsax_feed(state, &json[pos], n) != JSONSAX_OK) {
+      return JSONSAX_ERROR;
+    }
+  }
+  return jsonsax_finish(state);
+}
+/*---------------------------------------------------------------------------*/
+UNIT_TEST_REGISTER(jsonsax_chunks, "JSON SAX chunked parsing");
+UNIT_TEST(jsonsax_chunks)
+{
+  struct jsonsax_state state;
+  int chunk;
+
+  UNIT_TEST_BEGIN();
+
+  for(chunk = 1; chunk <= sizeof(document); chunk++) {
+    UNIT_TEST_ASSERT(parse(&state, document, chunk) == JSONSAX_OK);
+    UNIT_TEST_ASSERT(strcmp(transcript, expected) == 0);
+    UNIT_TEST_ASSERT(state.offset == sizeof(document) - 1);
+  }
+
+  /* Numbers at the top level end with the document */
+  for(chunk = 1; chunk <= 8; chunk++) {
+    UNIT_TEST_ASSERT(parse(&state, " -12.5e-3", chunk) == JSONSAX_OK);
+    UNIT_TEST_ASSERT(strcmp(transcript, "0-12.5e-3;") == 0);
+  }
+
+  UNIT_TEST_END();
+}
+/*---------------------------------------------------------------------------*/
+UNIT_TEST_REGISTER(jsonsax_zero_copy, "JSON SAX zero-copy values");
+UNIT_TEST(jsonsax_zero_copy)
+{
+  static const char json[] = "[\"value\", 12345]";
+  struct jsonsax_state state;
+
+  UNIT_TEST_BEGIN();
+
+  reset(&state);
+  UNIT_TEST_ASSERT(jsonsax_feed(&state, json, 8) == JSONSAX_OK);
+  UNIT_TEST_ASSERT(last_value == &json[2]);
+  UNIT_TEST_ASSERT(jsonsax_get_depth(&state) == 1);
+  UNIT_TEST_ASSERT(jsonsax_get_type(&state) == '[');
+  UNIT_TEST_ASSERT(jsonsax_feed(&state, &json[8], 7) == JSONSAX_OK);
+  UNIT_TEST_ASSERT(!jsonsax_is_done(&state));
+  UNIT_TEST_ASSERT(jsonsax_feed(&state, &json[15], 1) == JSONSAX_OK);
+  /* The number was complete within the second chunk */
+  UNIT_TEST_ASSERT(jsonsax_is_done(&state));
+  UNIT_TEST_ASSERT(strcmp(transcript, "[;Svalue;012345;];") == 0);
+  UNIT_TEST_ASSERT(jsonsax_value_as_long("12345]", 5) == 12345);
+
+  UNIT_TEST_END();
+}
+/*---------------------------------------------------------------------------*/
+UNIT_TEST_REGISTER(jsonsax_errors, "JSON SAX errors");
+UNIT_TEST(jsonsax_errors)
+{
+  static const struct {
+    const char *json;
+    char error;
+    unsigned long offset;
+  } invalid[] = {
+    { "{\"a\" 1}", JSON_ERROR_SYNTAX, 5 },
+    { "[1,]", JSON_ERROR_UNEXPECTED_END_OF_ARRAY, 3 },
+    { "{\"a\":1,}", JSON_ERROR_UNEXPECTED_END_OF_OBJECT, 7 },
+    { "[1}", JSON_ERROR_UNEXPECTED_END_OF_OBJECT, 2 },
+    { "[01]", JSON_ERROR_SYNTAX, 2 },
+    { "[1.]", JSON_ERROR_SYNTAX, 3 },
+    { "[-]", JSON_ERROR_SYNTAX, 2 },
+    { "[tru]", JSON_ERROR_SYNTAX, 4 },
+    { "[\"a\\x\"]", JSON_ERROR_SYNTAX, 4 },
+    { "[\"\\ud83d\"]", JSON_ERROR_SYNTAX, 8 },
+    { "[\"a\nb\"]", JSON_ERROR_SYNTAX, 3 },
+    { "{} {}", JSON_ERROR_SYNTAX, 3 },
+    { "[[[[[[[[[[[1]]]]]]]]]]]", JSON_ERROR_UNEXPECTED_ARRAY, 10 },
+    { "[123456789012345678901234567890]", JSON_ERROR_SYNTAX, 25 },
+  };
+  struct jsonsax_state state;
+  int i;
+  int chunk;
+
+  UNIT_TEST_BEGIN();
+
+  for(i = 0; i < sizeof(invalid) / sizeof(invalid[0]); i++) {
+    for(chunk = 1; chunk <= 4; chunk++) {
+      UNIT_TEST_ASSERT(parse(&state, invalid[i].json, chunk) ==
+                       JSONSAX_ERROR);
+      UNIT_TEST_ASSERT(state.error == invalid[i].error);
+      UNIT_TEST_ASSERT(state.offset == invalid[i].offset);
+    }
+  }
+
+  /* Incomplete documents */
+  UNIT_TEST_ASSERT(parse(&state, "{\"a\":[1,2]", 3) == JSONSAX_ERROR);
+  UNIT_TEST_ASSERT(parse(&state, "", 1) == JSONSAX_ERROR);
+
+  /* The callback stops the parser */
+  reset(&state);
+  abort_at = 3;
+  UNIT_TEST_ASSERT(jsonsax_feed(&state, "[1,2,3]", 7) == JSONSAX_ERROR);
+  UNIT_TEST_ASSERT(state.error == JSON_ERROR_ABORTED);
+  UNIT_TEST_ASSERT(state.offset == 4);
+  UNIT_TEST_ASSERT(jsonsax_feed(&state, "]", 1) == JSONSAX_ERROR);
+
+  UNIT_TEST_END();
+}
+/*---------------------------------------------------------------------------*/
+PROCESS_THREAD(test_process, ev, data)
+{
+  PROCESS_BEGIN();
+
+  printf("Run unit-test\n");
+  printf("---\n");
+
+  UNIT_TEST_RUN(jsonsax_chunks);
+  UNIT_TEST_RUN(jsonsax_zero_copy);
+  UNIT_TEST_RUN(jsonsax_errors);
+
+  if(!UNIT_TEST_PASSED(jsonsax_chunks)
+      || !UNIT_TEST_PASSED(jsonsax_zero_copy)
+      || !UNIT_TEST_PASSED(jsonsax_errors)) {
+    printf("=check-me= FAILED\n");
+    printf("---\n");
+  }
+
+  printf("=check-me= DONE\n");
+  printf("---\n");
+
+  PROCESS_END();
+}
+/*---------------------------------------------------------------------------*/
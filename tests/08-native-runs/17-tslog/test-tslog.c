@@ -0,0 +1,315 @@
+/*
+ * Copyright (c) 2026, agent <agent@local>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+ * OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "contiki.h"
+#include "cfs/cfs.h"
+#if TEST_CFS_COFFEE
+#include "cfs/cfs-coffee.h"
+#endif
+#include "unit-test.h"
+#include "tslog.h"
+
+#include <stdio.h>
+
+PROCESS(test_process, "test");
+AUTOSTART_PROCESSES(&test_process);
+
+/* Sample i of a periodic sensor with some jitter and a few outliers. */
+static uint32_t
+sample_time(uint32_t i)
+{
+  return 100000 + i * 60 + (i % 7 == 3 ? 2 : 0) + (i >= 5000 ? 86400 : 0);
+}
+
+static int32_t
+sample_value(uint32_t i)
+{
+  if(i % 997 == 500) {
+    return -1000000;
+  }
+  return 400 + (int32_t)((i / 10) % 40) - (i % 3 == 0 ? 5 : 0);
+}
+
+static tslog_t log;
+static tslog_reader_t reader;
+
+/* Read a range and check that it holds the samples first..last. */
+static int
+check_range(uint32_t from, uint32_t to, uint32_t first, uint32_t last)
+{
+  uint32_t time;
+  int32_t value;
+  uint32_t i;
+  int r;
+
+  tslog_read_start(&log, &reader, from, to);
+  for(i = first; i <= last; i++) {
+    r = tslog_read(&reader, &time, &value);
+    if(r != 1 || time != sample_time(i) || value != sample_value(i)) {
+      printf("sample %lu: r %d time %lu value %ld\n",
+             (unsigned long)i, r, (unsigned long)time, (long)value);
+      return 0;
+    }
+  }
+  return tslog_read(&reader, &time, &value) == 0;
+}
+
+static int
+append_samples(uint32_t first, uint32_t last)
+{
+  uint32_t i;
+
+  for(i = first; i <= last; i++) {
+    if(tslog_append(&log, sample_time(i), sample_value(i)) < 0) {
+      return 0;
+    }
+  }
+  return 1;
+}
+
+UNIT_TEST_REGISTER(tslog_append_read, "Append and read samples");
+UNIT_TEST(tslog_append_read)
+{
+  unsigned blocks;
+
+  UNIT_TEST_BEGIN();
+
+#if TEST_CFS_COFFEE
+  UNIT_TEST_ASSERT(cfs_coffee_format() == 0);
+#else
+  /* Remove the files of an earlier run. */
+  UNIT_TEST_ASSERT(tslog_open(&log, "torn") == 0);
+  tslog_remove(&log);
+  UNIT_TEST_ASSERT(tslog_open(&log, "light") == 0);
+  tslog_remove(&log);
+#endif
+  UNIT_TEST_ASSERT(tslog_open(&log, "light") == 0);
+  UNIT_TEST_ASSERT(append_samples(0, 2999));
+
+  /* Everything, including the samples that are still in RAM. */
+  UNIT_TEST_ASSERT(check_range(0, 0xffffffff, 0, 2999));
+
+  /* Ranges that start and end inside blocks. */
+  UNIT_TEST_ASSERT(check_range(sample_time(1234), sample_time(2345),
+                               1234, 2345));
+  UNIT_TEST_ASSERT(check_range(sample_time(10) + 1, sample_time(11) + 1,
+                               11, 11));
+  UNIT_TEST_ASSERT(check_range(sample_time(2990), 0xffffffff, 2990, 2999));
+  UNIT_TEST_ASSERT(check_range(0, 0, 1, 0));
+
+  /* Periodic samples take less than two bytes each. */
+  blocks = log.blocks[0] + log.blocks[1];
+  UNIT_TEST_ASSERT(blocks * TSLOG_BLOCK_SIZE < 3000 * 2);
+
+  /* A time stamp before the previous one is rejected. */
+  UNIT_TEST_ASSERT(tslog_append(&log, sample_time(2998), 0) < 0);
+
+  UNIT_TEST_END();
+}
+
+UNIT_TEST_REGISTER(tslog_recover, "Reopen a log");
+UNIT_TEST(tslog_recover)
+{
+  UNIT_TEST_BEGIN();
+
+  UNIT_TEST_ASSERT(tslog_close(&log) == 0);
+  UNIT_TEST_ASSERT(tslog_open(&log, "light") == 0);
+  UNIT_TEST_ASSERT(check_range(0, 0xffffffff, 0, 2999));
+
+  /* Continue after a gap in time. */
+  UNIT_TEST_ASSERT(append_samples(3000, 5999));
+  UNIT_TEST_ASSERT(tslog_flush(&log) == 0);
+  UNIT_TEST_ASSERT(tslog_open(&log, "light") == 0);
+  UNIT_TEST_ASSERT(check_range(0, 0xffffffff, 0, 5999));
+  UNIT_TEST_ASSERT(check_range(sample_time(4999), sample_time(5000),
+                               4999, 5000));
+
+  UNIT_TEST_END();
+}
+
+UNIT_TEST_REGISTER(tslog_retention, "Reclaim old segments");
+UNIT_TEST(tslog_retention)
+{
+  uint32_t first_seq;
+  uint32_t time;
+  int32_t value;
+  uint32_t last;
+
+  UNIT_TEST_BEGIN();
+
+  /* Fill more than all the segments. */
+  last = 5999;
+  while(log.write_seq - log.first_seq < TSLOG_SEGMENT_LIMIT - 1 ||
+        log.first_seq == 0) {
+    UNIT_TEST_ASSERT(append_samples(last + 1, last + 1000));
+    last += 1000;
+  }
+
+  /* The oldest samples are gone, and the rest are intact. */
+  tslog_read_start(&log, &reader, 0, 0xffffffff);
+  UNIT_TEST_ASSERT(tslog_read(&reader, &time, &value) == 1);
+  UNIT_TEST_ASSERT(time > sample_time(0));
+  UNIT_TEST_ASSERT(check_range(sample_time(last - 20000), 0xffffffff,
+                               last - 20000, last));
+
+  first_seq = log.first_seq;
+  UNIT_TEST_ASSERT(tslog_remove_before(&log, sample_time(last - 20000)) > 0);
+  UNIT_TEST_ASSERT(log.first_seq > first_seq);
+  UNIT_TEST_ASSERT(check_range(sample_time(last - 20000), 0xffffffff,
+                               last - 20000, last));
+  UNIT_TEST_ASSERT(tslog_remove_before(&log, sample_time(last - 20000)) == 0);
+
+  /* The reclaimed log can be reopened. */
+  UNIT_TEST_ASSERT(tslog_close(&log) == 0);
+  UNIT_TEST_ASSERT(tslog_open(&log, "light") == 0);
+  UNIT_TEST_ASSERT(log.first_seq > first_seq);
+  UNIT_TEST_ASSERT(check_range(sample_time(last - 20000), 0xffffffff,
+                               last - 20000, last));
+
+  tslog_remove(&log);
+  tslog_read_start(&log, &reader, 0, 0xffffffff);
+  UNIT_TEST_ASSERT(tslog_read(&reader, &time, &value) == 0);
+
+  UNIT_TEST_END();
+}
+
+/* Keep the first size bytes of a file, as if a write had been cut. */
+static int
+truncate_file(const char *name, cfs_offset_t size)
+{
+  uint8_t buf[64];
+  cfs_offset_t done;
+  int from;
+  int to;
+  int len;
+
+  cfs_remove("torn.tmp");
+  from = cfs_open(name, CFS_READ);
+  to = cfs_open("torn.tmp", CFS_WRITE);
+  for(done = 0; from >= 0 && to >= 0 && done < size; done += len) {
+    len = size - done < (cfs_offset_t)sizeof(buf) ?
+      size - done : (cfs_offset_t)sizeof(buf);
+    if(cfs_read(from, buf, len) != len || cfs_write(to, buf, len) != len) {
+      break;
+    }
+  }
+  cfs_close(from);
+  cfs_close(to);
+  if(done != size) {
+    return 0;
+  }
+
+  cfs_remove(name);
+  from = cfs_open("torn.tmp", CFS_READ);
+  to = cfs_open(name, CFS_WRITE);
+  for(done = 0; from >= 0 && to >= 0 && done < size; done += len) {
+    len = cfs_read(from, buf, sizeof(buf));
+    if(len <= 0 || cfs_write(to, buf, len) != len) {
+      break;
+    }
+  }
+  cfs_close(from);
+  cfs_close(to);
+  cfs_remove("torn.tmp");
+  return done == size;
+}
+
+UNIT_TEST_REGISTER(tslog_torn_block, "Recover from a torn block");
+UNIT_TEST(tslog_torn_block)
+{
+  char name[TSLOG_NAME_LENGTH + 8];
+  uint32_t seq;
+  uint16_t blocks;
+  uint32_t time;
+  int32_t value;
+  uint32_t kept;
+
+  UNIT_TEST_BEGIN();
+
+  UNIT_TEST_ASSERT(tslog_open(&log, "torn") == 0);
+  UNIT_TEST_ASSERT(append_samples(0, 499));
+  UNIT_TEST_ASSERT(tslog_close(&log) == 0);
+  seq = log.write_seq;
+  blocks = log.blocks[seq % TSLOG_SEGMENT_LIMIT];
+  UNIT_TEST_ASSERT(blocks >= 2);
+
+  /* Cut the last block in the middle. The file systems that append at
+     the end of the file would put new blocks after the torn one. */
+  snprintf(name, sizeof(name), "torn.%u",
+           (unsigned)(seq % TSLOG_SEGMENT_LIMIT));
+  UNIT_TEST_ASSERT(truncate_file(name, (cfs_offset_t)(blocks - 1) *
+                                 TSLOG_BLOCK_SIZE + TSLOG_BLOCK_SIZE / 2));
+
+  /* The samples of the complete blocks are kept, and new blocks go to
+     the next segment. */
+  UNIT_TEST_ASSERT(tslog_open(&log, "torn") == 0);
+  UNIT_TEST_ASSERT(log.blocks[seq % TSLOG_SEGMENT_LIMIT] == blocks - 1);
+  UNIT_TEST_ASSERT(log.write_seq == seq + 1);
+  tslog_read_start(&log, &reader, 0, 0xffffffff);
+  for(kept = 0; tslog_read(&reader, &time, &value) == 1; kept++);
+  UNIT_TEST_ASSERT(kept > 0 && kept < 500);
+  UNIT_TEST_ASSERT(check_range(0, 0xffffffff, 0, kept - 1));
+
+  /* The lost samples can be appended again. */
+  UNIT_TEST_ASSERT(append_samples(kept, 999));
+  UNIT_TEST_ASSERT(tslog_close(&log) == 0);
+  UNIT_TEST_ASSERT(tslog_open(&log, "torn") == 0);
+  UNIT_TEST_ASSERT(check_range(0, 0xffffffff, 0, 999));
+
+  tslog_remove(&log);
+
+  UNIT_TEST_END();
+}
+
+PROCESS_THREAD(test_process, ev, data)
+{
+  PROCESS_BEGIN();
+
+  printf("Run unit-test\n");
+  printf("---\n");
+
+  UNIT_TEST_RUN(tslog_append_read);
+  UNIT_TEST_RUN(tslog_recover);
+  UNIT_TEST_RUN(tslog_retention);
+  UNIT_TEST_RUN(tslog_torn_block);
+
+  if(!UNIT_TEST_PASSED(tslog_append_read) ||
+     !UNIT_TEST_PASSED(tslog_recover) ||
+     !UNIT_TEST_PASSED(tslog_retention) ||
+     !UNIT_TEST_PASSED(tslog_torn_block)) {
+    printf("=check-me= FAILED\n");
+    printf("---\n");
+  }
+
+  printf("=check-me= DONE\n");
+  printf("---\n");
+
+  PROCESS_END();
+}
@@ -0,0 +1,227 @@
+/*
+ * Copyright (c) 2026, agent <agent@local>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+ * OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "contiki.h"
+#include "cfs/cfs.h"
+#include "cfs-mmap.h"
+#include "unit-test.h"
+
+#include <stdio.h>
+#include <string.h>
+
+#define FILE_NAME "test-cfs-mmap.bin"
+/* Larger than the first mapping of the file */
+#define LARGE_SIZE (CFS_MMAP_GROW_SIZE * 2 + 100)
+
+PROCESS(test_process, "test");
+AUTOSTART_PROCESSES(&test_process);
+
+static uint8_t buf[256];
+
+static uint8_t
+pattern(unsigned long i)
+{
+  return (uint8_t)(i * 7 + (i >> 8));
+}
+
+UNIT_TEST_REGISTER(mmap_read_write, "Read, write and seek");
+UNIT_TEST(mmap_read_write)
+{
+  int fd;
+
+  UNIT_TEST_BEGIN();
+
+  cfs_remove(FILE_NAME);
+  UNIT_TEST_ASSERT(cfs_open(FILE_NAME, CFS_READ) < 0);
+
+  fd = cfs_open(FILE_NAME, CFS_READ | CFS_WRITE);
+  UNIT_TEST_ASSERT(fd >= 0);
+  UNIT_TEST_ASSERT(cfs_read(fd, buf, sizeof(buf)) == 0);
+  UNIT_TEST_ASSERT(cfs_write(fd, "Hello, World!", 13) == 13);
+  UNIT_TEST_ASSERT(cfs_seek(fd, 7, CFS_SEEK_SET) == 7);
+  UNIT_TEST_ASSERT(cfs_write(fd, "there", 5) == 5);
+  UNIT_TEST_ASSERT(cfs_seek(fd, 0, CFS_SEEK_END) == 13);
+  UNIT_TEST_ASSERT(cfs_seek(fd, -13, CFS_SEEK_CUR) == 0);
+  UNIT_TEST_ASSERT(cfs_seek(fd, -1, CFS_SEEK_SET) == -1);
+  UNIT_TEST_ASSERT(cfs_read(fd, buf, sizeof(buf)) == 13);
+  UNIT_TEST_ASSERT(memcmp(buf, "Hello, there!", 13) == 0);
+  cfs_close(fd);
+
+  /* Appending keeps the contents, and the host file has the real size. */
+  fd = cfs_open(FILE_NAME, CFS_WRITE | CFS_APPEND);
+  UNIT_TEST_ASSERT(fd >= 0);
+  UNIT_TEST_ASSERT(cfs_read(fd, buf, 1) == -1);
+  UNIT_TEST_ASSERT(cfs_write(fd, "!!", 2) == 2);
+  cfs_close(fd);
+
+  fd = cfs_open(FILE_NAME, CFS_READ);
+  UNIT_TEST_ASSERT(fd >= 0);
+  UNIT_TEST_ASSERT(cfs_write(fd, "x", 1) == -1);
+  UNIT_TEST_ASSERT(cfs_read(fd, buf, sizeof(buf)) == 15);
+  UNIT_TEST_ASSERT(memcmp(buf, "Hello, there!!!", 15) == 0);
+  cfs_close(fd);
+
+  /* Writing without appending truncates the file. */
+  fd = cfs_open(FILE_NAME, CFS_WRITE);
+  UNIT_TEST_ASSERT(fd >= 0);
+  cfs_close(fd);
+  fd = cfs_open(FILE_NAME, CFS_READ);
+  UNIT_TEST_ASSERT(cfs_seek(fd, 0, CFS_SEEK_END) == 0);
+  cfs_close(fd);
+
+  UNIT_TEST_END();
+}
+
+UNIT_TEST_REGISTER(mmap_large, "Grow and share a file");
+UNIT_TEST(mmap_large)
+{
+  int writer;
+  int reader;
+  unsigned long i;
+  unsigned long j;
+  int ok;
+
+  UNIT_TEST_BEGIN();
+
+  writer = cfs_open(FILE_NAME, CFS_WRITE);
+  UNIT_TEST_ASSERT(writer >= 0);
+  reader = cfs_open(FILE_NAME, CFS_READ);
+  UNIT_TEST_ASSERT(reader >= 0);
+
+  /* The reader sees the data of the writer through the same mapping. */
+  for(i = 0; i < LARGE_SIZE; i += sizeof(buf)) {
+    for(j = 0; j < sizeof(buf); j++) {
+      buf[j] = pattern(i + j);
+    }
+    UNIT_TEST_ASSERT(cfs_write(writer, buf, sizeof(buf)) == sizeof(buf));
+  }
+  UNIT_TEST_ASSERT(cfs_seek(reader, 0, CFS_SEEK_END) == i);
+
+  ok = 1;
+  cfs_seek(reader, 0, CFS_SEEK_SET);
+  for(i = 0; i < LARGE_SIZE; i += sizeof(buf)) {
+    if(cfs_read(reader, buf, sizeof(buf)) != sizeof(buf)) {
+      ok = 0;
+      break;
+    }
+    for(j = 0; j < sizeof(buf); j++) {
+      if(buf[j] != pattern(i + j)) {
+        ok = 0;
+      }
+    }
+  }
+  UNIT_TEST_ASSERT(ok);
+  UNIT_TEST_ASSERT(cfs_read(reader, buf, sizeof(buf)) == 0);
+  UNIT_TEST_ASSERT(cfs_mmap_sync(writer) == 0);
+
+  cfs_close(writer);
+  cfs_close(reader);
+
+  reader = cfs_open(FILE_NAME, CFS_READ);
+  UNIT_TEST_ASSERT(cfs_seek(reader, 0, CFS_SEEK_END) == i);
+  cfs_close(reader);
+
+  UNIT_TEST_END();
+}
+
+UNIT_TEST_REGISTER(mmap_range, "Access file ranges directly");
+UNIT_TEST(mmap_range)
+{
+  int fd;
+  uint8_t *p;
+  unsigned long size;
+
+  UNIT_TEST_BEGIN();
+
+  fd = cfs_open(FILE_NAME, CFS_READ | CFS_WRITE | CFS_APPEND);
+  UNIT_TEST_ASSERT(fd >= 0);
+  size = cfs_seek(fd, 0, CFS_SEEK_END);
+
+  p = cfs_mmap_range(fd, 1000, 16, CFS_READ);
+  UNIT_TEST_ASSERT(p != NULL);
+  UNIT_TEST_ASSERT(p[0] == pattern(1000) && p[15] == pattern(1015));
+  UNIT_TEST_ASSERT(cfs_mmap_range(fd, size - 1, 2, CFS_READ) == NULL);
+
+  /* Modify a range in place. */
+  p = cfs_mmap_range(fd, 10, 4, CFS_WRITE);
+  UNIT_TEST_ASSERT(p != NULL);
+  memcpy(p, "abcd", 4);
+  UNIT_TEST_ASSERT(cfs_seek(fd, 8, CFS_SEEK_SET) == 8);
+  UNIT_TEST_ASSERT(cfs_read(fd, buf, 8) == 8);
+  UNIT_TEST_ASSERT(memcmp(buf + 2, "abcd", 4) == 0);
+  UNIT_TEST_ASSERT(buf[0] == pattern(8) && buf[7] == pattern(15));
+
+  /* A range after the end extends the file. */
+  p = cfs_mmap_range(fd, size + CFS_MMAP_GROW_SIZE, 8, CFS_WRITE);
+  UNIT_TEST_ASSERT(p != NULL);
+  memcpy(p, "the end!", 8);
+  UNIT_TEST_ASSERT(cfs_seek(fd, 0, CFS_SEEK_END) ==
+                   size + CFS_MMAP_GROW_SIZE + 8);
+  UNIT_TEST_ASSERT(cfs_seek(fd, size, CFS_SEEK_SET) == size);
+  UNIT_TEST_ASSERT(cfs_read(fd, buf, 4) == 4);
+  UNIT_TEST_ASSERT(buf[0] == 0 && buf[3] == 0);
+  cfs_close(fd);
+
+  /* Descriptors that were not opened for writing get no writable range. */
+  fd = cfs_open(FILE_NAME, CFS_READ);
+  UNIT_TEST_ASSERT(cfs_mmap_range(fd, 0, 4, CFS_WRITE) == NULL);
+  p = cfs_mmap_range(fd, size + CFS_MMAP_GROW_SIZE, 8, CFS_READ);
+  UNIT_TEST_ASSERT(p != NULL && memcmp(p, "the end!", 8) == 0);
+  cfs_close(fd);
+
+  UNIT_TEST_ASSERT(cfs_remove(FILE_NAME) == 0);
+  UNIT_TEST_ASSERT(cfs_open(FILE_NAME, CFS_READ) < 0);
+
+  UNIT_TEST_END();
+}
+
+PROCESS_THREAD(test_process, ev, data)
+{
+  PROCESS_BEGIN();
+
+  printf("Run unit-test\n");
+  printf("---\n");
+
+  UNIT_TEST_RUN(mmap_read_write);
+  UNIT_TEST_RUN(mmap_large);
+  UNIT_TEST_RUN(mmap_range);
+
+  if(!UNIT_TEST_PASSED(mmap_read_write) ||
+     !UNIT_TEST_PASSED(mmap_large) ||
+     !UNIT_TEST_PASSED(mmap_range)) {
+    printf("=check-me= FAILED\n");
+    printf("---\n");
+  }
+
+  printf("=check-me= DONE\n");
+  printf("---\n");
+
+  PROCESS_END();
+}
@@ -0,0 +1,30 @@
+#!/bin/bash
+source ../utils.sh
+
+BASENAME=19-mqtt-inflight
+TEST=test-mqtt-inflight
+RUNLOG=$TEST.run.log
+BROKERLOG=broker.log
+
+cd $BASENAME
+test_init
+
+echo "-- Starting test $BASENAME"
+
+register_logfile $RUNLOG
+register_logfile $BROKERLOG
+
+# Start the scripted broker, then the MQTT client node
+python3 ../mqtt-broker.py inflight 18830 &> $BROKERLOG &
+register_last_bg_cmd
+sleep 1
+
+sudo ./$TEST.native &> $RUNLOG &
+register_last_bg_cmd
+
+wait_log_assert "start $TEST" "Run unit-test" $RUNLOG 30
+wait_log_assert "run $TEST" "=check-me= DONE" $RUNLOG 120
+assert "check $TEST" "! grep -q '=check-me= FAILED' $RUNLOG"
+wait_log_assert "broker" "broker OK" $BROKERLOG 10
+
+do_wrap_up
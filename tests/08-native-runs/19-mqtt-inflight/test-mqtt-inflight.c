@@ -0,0 +1,243 @@
+/*
+ * Copyright (c) 2026, agent <agent@local>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+ * OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+ * Exercises the in-flight window of the MQTT client against the "inflight"
+ * script of ../mqtt-broker.py: window exhaustion, release of QoS 1 slots by
+ * PUBACKs received out of order, QoS 0 publishes, a connection lost while
+ * publishes are in flight, and the retransmission of QoS 1 publishes whose
+ * PUBACK does not arrive.
+ */
+
+#include "contiki.h"
+#include "mqtt.h"
+
+#include <stdio.h>
+#include <string.h>
+
+#define BROKER_IP "fd00::1"
+#define BROKER_PORT 18830
+
+#define PAYLOAD_LEN 80
+#define MESSAGES 11
+
+#define WAIT_TIMEOUT (CLOCK_SECOND * 20)
+
+PROCESS(test_process, "MQTT in-flight test");
+AUTOSTART_PROCESSES(&test_process);
+
+static struct mqtt_connection conn;
+static struct etimer timeout;
+static struct etimer tick;
+
+static uint8_t payload[MESSAGES][PAYLOAD_LEN];
+static uint16_t mids[MESSAGES];
+static uint16_t acked[MESSAGES];
+static uint8_t acks;
+static uint16_t timed_out;
+static uint8_t timeouts;
+static uint8_t connected;
+static uint8_t disconnected;
+static int attempt;
+static int i;
+
+#define CHECK(cond) do {                                        \
+    if(!(cond)) {                                               \
+      printf("check failed at line %d: %s\n", __LINE__, #cond); \
+      printf("=check-me= FAILED\n");                            \
+      printf("=check-me= DONE\n");                              \
+      PROCESS_EXIT();                                           \
+    }                                                           \
+  } while(0)
+
+/* Wait until a condition holds, polling it while TCP makes progress */
+#define WAIT_FOR(cond) do {                                     \
+    etimer_set(&timeout, WAIT_TIMEOUT);                         \
+    while(!(cond) && !etimer_expired(&timeout)) {               \
+      etimer_set(&tick, CLOCK_SECOND / 20);                     \
+      PROCESS_WAIT_EVENT_UNTIL(etimer_expired(&tick));          \
+    }                                                           \
+  } while(0)
+
+#define WAIT_UNTIL(cond) do {                                   \
+    WAIT_FOR(cond);                                             \
+    CHECK(cond);                                                \
+  } while(0)
+
+/* Connect to the broker, retrying while the network comes up */
+#define CONNECT() do {                                          \
+    for(attempt = 0; !connected && attempt < 5; attempt++) {    \
+      disconnected = 0;                                         \
+      CHECK(mqtt_connect(&conn, BROKER_IP, BROKER_PORT, 60, 1)  \
+            == MQTT_STATUS_OK);                                 \
+      WAIT_FOR(connected || (disconnected &&                    \
+               conn.state == MQTT_CONN_STATE_NOT_CONNECTED));   \
+    }                                                           \
+    CHECK(connected);                                           \
+    disconnected = 0;                                           \
+  } while(0)
+/*---------------------------------------------------------------------------*/
+static void
+mqtt_event(struct mqtt_connection *m, mqtt_event_t event, void *data)
+{
+  switch(event) {
+  case MQTT_EVENT_CONNECTED:
+    printf("connected\n");
+    connected = 1;
+    break;
+  case MQTT_EVENT_DISCONNECTED:
+    printf("disconnected\n");
+    connected = 0;
+    disconnected = 1;
+    break;
+  case MQTT_EVENT_PUBACK:
+    printf("PUBACK %u\n", *(uint16_t *)data);
+    if(acks < MESSAGES) {
+      acked[acks++] = *(uint16_t *)data;
+    }
+    break;
+  case MQTT_EVENT_PUBLISH_TIMEOUT:
+    printf("PUBLISH timeout %u\n", *(uint16_t *)data);
+    timed_out = *(uint16_t *)data;
+    timeouts++;
+    break;
+  default:
+    break;
+  }
+}
+/*---------------------------------------------------------------------------*/
+static mqtt_status_t
+publish(int idx, mqtt_qos_level_t qos)
+{
+  return mqtt_publish(&conn, &mids[idx], "test/data", payload[idx],
+                      PAYLOAD_LEN, qos, MQTT_RETAIN_OFF);
+}
+/*---------------------------------------------------------------------------*/
+PROCESS_THREAD(test_process, ev, data)
+{
+  static uint16_t mid;
+  int j;
+
+  PROCESS_BEGIN();
+
+  printf("Run unit-test\n");
+  printf("---\n");
+
+  for(i = 0; i < MESSAGES; i++) {
+    payload[i][0] = '0' + i;
+    for(j = 1; j < PAYLOAD_LEN; j++) {
+      payload[i][j] = 'a' + (i + j) % 26;
+    }
+  }
+
+  mqtt_register(&conn, &test_process, "inflight", mqtt_event, 128);
+  conn.auto_reconnect = 0;
+  CONNECT();
+  CHECK(mqtt_publish_slots(&conn) == MQTT_MAX_INFLIGHT);
+
+  /* Fill the window with QoS 1 publishes the broker does not ack yet */
+  for(i = 0; i < 4; i++) {
+    CHECK(publish(i, MQTT_QOS_LEVEL_1) == MQTT_STATUS_OK);
+  }
+  CHECK(mqtt_publish_slots(&conn) == 0);
+  CHECK(!mqtt_ready(&conn));
+  CHECK(publish(4, MQTT_QOS_LEVEL_1) == MQTT_STATUS_OUT_QUEUE_FULL);
+
+  /* PUBACKs out of order release exactly the acknowledged slots */
+  WAIT_UNTIL(acks == 2);
+  CHECK(acked[0] == mids[2] && acked[1] == mids[0]);
+  CHECK(mqtt_publish_slots(&conn) == 2);
+  CHECK(mqtt_ready(&conn));
+  CHECK(!mqtt_publish_pending(&conn, mids[0]));
+  CHECK(mqtt_publish_pending(&conn, mids[1]));
+  CHECK(!mqtt_publish_pending(&conn, mids[2]));
+  CHECK(mqtt_publish_pending(&conn, mids[3]));
+
+  /* A short QoS 0 publish asks the broker for the remaining PUBACKs */
+  CHECK(mqtt_publish(&conn, &mid, "test/next", (uint8_t *)"go", 2,
+                     MQTT_QOS_LEVEL_0, MQTT_RETAIN_OFF) == MQTT_STATUS_OK);
+  WAIT_UNTIL(acks == 4);
+  CHECK(acked[2] == mids[1] && acked[3] == mids[3]);
+  WAIT_UNTIL(mqtt_publish_slots(&conn) == MQTT_MAX_INFLIGHT);
+
+  /* QoS 0 publishes hold their slot at most until TCP has delivered them */
+  CHECK(publish(4, MQTT_QOS_LEVEL_0) == MQTT_STATUS_OK);
+  CHECK(publish(5, MQTT_QOS_LEVEL_0) == MQTT_STATUS_OK);
+  WAIT_UNTIL(mqtt_publish_slots(&conn) == MQTT_MAX_INFLIGHT);
+  CHECK(!mqtt_publish_pending(&conn, mids[4]));
+  CHECK(!mqtt_publish_pending(&conn, mids[5]));
+
+  /* The broker closes the connection with these two unacknowledged */
+  CHECK(publish(6, MQTT_QOS_LEVEL_1) == MQTT_STATUS_OK);
+  CHECK(publish(7, MQTT_QOS_LEVEL_1) == MQTT_STATUS_OK);
+  CHECK(mqtt_publish_pending(&conn, mids[6]));
+  CHECK(mqtt_publish_pending(&conn, mids[7]));
+  WAIT_UNTIL(disconnected && conn.state == MQTT_CONN_STATE_NOT_CONNECTED);
+  CHECK(acks == 4);
+  CHECK(mqtt_publish_slots(&conn) == MQTT_MAX_INFLIGHT);
+  CHECK(!mqtt_publish_pending(&conn, mids[6]));
+  CHECK(!mqtt_publish_pending(&conn, mids[7]));
+  CHECK(publish(8, MQTT_QOS_LEVEL_1) == MQTT_STATUS_NOT_CONNECTED_ERROR);
+
+  /* The window is usable again on the next connection */
+  CONNECT();
+  CHECK(mqtt_publish_slots(&conn) == MQTT_MAX_INFLIGHT);
+  CHECK(publish(8, MQTT_QOS_LEVEL_1) == MQTT_STATUS_OK);
+  WAIT_UNTIL(acks == 5);
+  CHECK(acked[4] == mids[8]);
+  CHECK(mqtt_publish_slots(&conn) == MQTT_MAX_INFLIGHT);
+
+  /*
+   * The broker ignores both messages. After the response timeout they are
+   * sent again with DUP set; only the first of them gets acknowledged then,
+   * and the second is given up after its only retransmission.
+   */
+  CHECK(publish(9, MQTT_QOS_LEVEL_1) == MQTT_STATUS_OK);
+  CHECK(publish(10, MQTT_QOS_LEVEL_1) == MQTT_STATUS_OK);
+  WAIT_UNTIL(acks == 6);
+  CHECK(acked[5] == mids[9]);
+  CHECK(timeouts == 0);
+  CHECK(mqtt_publish_pending(&conn, mids[10]));
+  CHECK(mqtt_publish_slots(&conn) == MQTT_MAX_INFLIGHT - 1);
+  WAIT_UNTIL(timeouts == 1);
+  CHECK(timed_out == mids[10]);
+  CHECK(!mqtt_publish_pending(&conn, mids[10]));
+  CHECK(mqtt_publish_slots(&conn) == MQTT_MAX_INFLIGHT);
+  CHECK(acks == 6);
+
+  mqtt_disconnect(&conn);
+  WAIT_UNTIL(disconnected);
+
+  printf("=check-me= DONE\n");
+  printf("---\n");
+
+  PROCESS_END();
+}
+/*---------------------------------------------------------------------------*/
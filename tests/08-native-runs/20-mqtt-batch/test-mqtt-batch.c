@@ -0,0 +1,205 @@
+/*
+ * Copyright (c) 2026, agent <agent@local>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+ * OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+ * Exercises MQTT publish batching against the "batch" script of
+ * ../mqtt-broker.py: batches flushed when full, explicitly and by their
+ * latency timer, the JSON, CBOR and raw formats, and a flush held back while
+ * the previous message of the batch is still waiting for its PUBACK.
+ */
+
+#include "contiki.h"
+#include "mqtt.h"
+#include "mqtt-prop.h"
+#include "mqtt-batch.h"
+
+#include <stdio.h>
+#include <string.h>
+
+#define BROKER_IP "fd00::1"
+#define BROKER_PORT 18831
+
+#define WAIT_TIMEOUT (CLOCK_SECOND * 20)
+
+PROCESS(test_process, "MQTT batch test");
+AUTOSTART_PROCESSES(&test_process);
+
+static struct mqtt_connection conn;
+static struct mqtt_batch batch;
+static struct etimer timeout;
+static struct etimer tick;
+
+static uint8_t connected;
+static uint8_t disconnected;
+static int attempt;
+
+static const int32_t cbor_values[] = {
+  0, 23, 24, -1, -25, 255, 256, 65536, -100000
+};
+
+#define CHECK(cond) do {                                        \
+    if(!(cond)) {                                               \
+      printf("check failed at line %d: %s\n", __LINE__, #cond); \
+      printf("=check-me= FAILED\n");                            \
+      printf("=check-me= DONE\n");                              \
+      PROCESS_EXIT();                                           \
+    }                                                           \
+  } while(0)
+
+/* Wait until a condition holds, polling it while TCP makes progress */
+#define WAIT_FOR(cond) do {                                     \
+    etimer_set(&timeout, WAIT_TIMEOUT);                         \
+    while(!(cond) && !etimer_expired(&timeout)) {               \
+      etimer_set(&tick, CLOCK_SECOND / 20);                     \
+      PROCESS_WAIT_EVENT_UNTIL(etimer_expired(&tick));          \
+    }                                                           \
+  } while(0)
+
+#define WAIT_UNTIL(cond) do {                                   \
+    WAIT_FOR(cond);                                             \
+    CHECK(cond);                                                \
+  } while(0)
+
+#if MQTT_5
+#define MQTT_CONNECT() \
+  mqtt_connect(&conn, BROKER_IP, BROKER_PORT, 60, 1, MQTT_PROP_LIST_NONE)
+#define MQTT_DISCONNECT() mqtt_disconnect(&conn, MQTT_PROP_LIST_NONE)
+#else
+#define MQTT_CONNECT() mqtt_connect(&conn, BROKER_IP, BROKER_PORT, 60, 1)
+#define MQTT_DISCONNECT() mqtt_disconnect(&conn)
+#endif
+/*---------------------------------------------------------------------------*/
+static void
+mqtt_event(struct mqtt_connection *m, mqtt_event_t event, void *data)
+{
+  switch(event) {
+  case MQTT_EVENT_CONNECTED:
+    printf("connected\n");
+    connected = 1;
+    break;
+  case MQTT_EVENT_DISCONNECTED:
+    printf("disconnected\n");
+    connected = 0;
+    disconnected = 1;
+    break;
+  case MQTT_EVENT_PUBACK:
+    printf("PUBACK %u\n", *(uint16_t *)data);
+    break;
+  default:
+    break;
+  }
+}
+/*---------------------------------------------------------------------------*/
+static mqtt_status_t
+add_string(const char *s)
+{
+  return mqtt_batch_add(&batch, (const uint8_t *)s, strlen(s));
+}
+/*---------------------------------------------------------------------------*/
+PROCESS_THREAD(test_process, ev, data)
+{
+  static int i;
+
+  PROCESS_BEGIN();
+
+  printf("Run unit-test\n");
+  printf("---\n");
+
+  mqtt_register(&conn, &test_process, "batch", mqtt_event, 128);
+  conn.auto_reconnect = 0;
+
+  /* Connect, retrying while the network comes up */
+  for(attempt = 0; !connected && attempt < 5; attempt++) {
+    disconnected = 0;
+    CHECK(MQTT_CONNECT() == MQTT_STATUS_OK);
+    WAIT_FOR(connected ||
+             (disconnected && conn.state == MQTT_CONN_STATE_NOT_CONNECTED));
+  }
+  CHECK(connected);
+
+  /* JSON: a full batch is published when the next reading does not fit */
+  mqtt_batch_init(&batch, &conn, "test/json", MQTT_QOS_LEVEL_0,
+                  MQTT_BATCH_FORMAT_JSON, 16, CLOCK_SECOND * 60);
+  for(i = 1; i <= 7; i++) {
+    CHECK(mqtt_batch_add_int(&batch, i) == MQTT_STATUS_OK);
+  }
+  CHECK(batch.count == 7 && batch.len == 14);
+  CHECK(mqtt_batch_add_int(&batch, 8) == MQTT_STATUS_OK);
+  CHECK(batch.count == 1);
+  WAIT_UNTIL(mqtt_publish_slots(&conn) == MQTT_MAX_INFLIGHT);
+  CHECK(mqtt_batch_flush(&batch) == MQTT_STATUS_OK);
+  CHECK(batch.count == 0);
+  CHECK(mqtt_batch_flush(&batch) == MQTT_STATUS_OK);
+  WAIT_UNTIL(mqtt_publish_slots(&conn) == MQTT_MAX_INFLIGHT);
+
+  /* CBOR: the latency timer publishes the batch */
+  mqtt_batch_init(&batch, &conn, "test/cbor", MQTT_QOS_LEVEL_1,
+                  MQTT_BATCH_FORMAT_CBOR, 0, CLOCK_SECOND);
+  CHECK(batch.max_bytes == MQTT_BATCH_BUF_SIZE);
+  for(i = 0; i < sizeof(cbor_values) / sizeof(cbor_values[0]); i++) {
+    CHECK(mqtt_batch_add_int(&batch, cbor_values[i]) == MQTT_STATUS_OK);
+  }
+  WAIT_UNTIL(batch.publishing && batch.count == 0);
+
+  /* The next message waits until the broker has acked the previous one */
+  CHECK(mqtt_batch_add_int(&batch, 1) == MQTT_STATUS_OK);
+  CHECK(mqtt_publish_pending(&conn, batch.mid));
+  CHECK(mqtt_batch_flush(&batch) == MQTT_STATUS_OUT_QUEUE_FULL);
+  CHECK(batch.count == 1);
+  WAIT_UNTIL(!mqtt_publish_pending(&conn, batch.mid));
+  CHECK(mqtt_batch_flush(&batch) == MQTT_STATUS_OK);
+  WAIT_UNTIL(!mqtt_publish_pending(&conn, batch.mid));
+
+  /* Raw: readings are concatenated, and oversized ones are refused */
+  mqtt_batch_init(&batch, &conn, "test/raw", MQTT_QOS_LEVEL_0,
+                  MQTT_BATCH_FORMAT_RAW, 8, CLOCK_SECOND * 60);
+  CHECK(add_string("123456789") == MQTT_STATUS_INVALID_ARGS_ERROR);
+  CHECK(add_string("abc") == MQTT_STATUS_OK);
+  CHECK(add_string("defg") == MQTT_STATUS_OK);
+  CHECK(add_string("hi") == MQTT_STATUS_OK);
+  CHECK(batch.count == 1);
+  WAIT_UNTIL(mqtt_publish_slots(&conn) == MQTT_MAX_INFLIGHT);
+  CHECK(mqtt_batch_flush(&batch) == MQTT_STATUS_OK);
+  WAIT_UNTIL(mqtt_publish_slots(&conn) == MQTT_MAX_INFLIGHT);
+
+  MQTT_DISCONNECT();
+  WAIT_UNTIL(disconnected);
+
+  /* Nothing is lost while disconnected */
+  CHECK(add_string("jk") == MQTT_STATUS_OK);
+  CHECK(mqtt_batch_flush(&batch) == MQTT_STATUS_NOT_CONNECTED_ERROR);
+  CHECK(batch.count == 1 && batch.len == 2);
+
+  printf("=check-me= DONE\n");
+  printf("---\n");
+
+  PROCESS_END();
+}
+/*---------------------------------------------------------------------------*/
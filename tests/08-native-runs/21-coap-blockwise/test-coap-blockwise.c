@@ -0,0 +1,449 @@
+/*
+ * Copyright (c) 2026, agent <agent@local>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+ * OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+ * Tests the block-wise transfers of the CoAP server: buffered Block2
+ * and Q-Block2 bursts, Block1 and Q-Block1 uploads, and the parsing of
+ * a message that ends with a zero-length option. Requests are passed
+ * to coap_receive(), and the messages sent in return are captured
+ * before they reach the network.
+ */
+
+#include "contiki.h"
+#include "unit-test.h"
+#include "coap-engine.h"
+#include "coap-blockwise.h"
+#include "coap-block1.h"
+#include "net/ipv6/uip.h"
+#include "net/netstack.h"
+
+#include <stdio.h>
+#include <string.h>
+
+PROCESS(test_process, "test");
+AUTOSTART_PROCESSES(&test_process);
+
+#define BIG_LEN    200
+#define BLOCK_SIZE 16
+#define MAX_SENT   8
+
+static int big_calls;
+static uint8_t upload[128];
+static size_t upload_len;
+static int upload_done;
+
+static coap_endpoint_t client;
+static uint16_t mid = 1;
+
+static struct {
+  uint8_t data[COAP_MAX_PACKET_SIZE];
+  uint16_t len;
+} sent[MAX_SENT];
+static coap_message_t sent_message[MAX_SENT];
+static int sent_count;
+/*---------------------------------------------------------------------------*/
+static uint8_t
+big_byte(uint32_t offset)
+{
+  return 'A' + offset % 26;
+}
+/*---------------------------------------------------------------------------*/
+/* A block-wise resource, generating its representation chunk by chunk */
+static void
+big_get_handler(coap_message_t *request, coap_message_t *response,
+                uint8_t *buffer, uint16_t preferred_size, int32_t *offset)
+{
+  int32_t len;
+  int32_t i;
+
+  big_calls++;
+  if(*offset >= BIG_LEN) {
+    coap_set_status_code(response, BAD_OPTION_4_02);
+    coap_set_payload(response, "BlockOutOfScope", 15);
+    return;
+  }
+  len = MIN(BIG_LEN - *offset, preferred_size);
+  for(i = 0; i < len; i++) {
+    buffer[i] = big_byte(*offset + i);
+  }
+  coap_set_header_content_format(response, TEXT_PLAIN);
+  coap_set_payload(response, buffer, len);
+  *offset += len;
+  if(*offset >= BIG_LEN) {
+    *offset = -1;
+  }
+}
+RESOURCE(res_big, "", big_get_handler, NULL, NULL, NULL);
+/*---------------------------------------------------------------------------*/
+static void
+upload_put_handler(coap_message_t *request, coap_message_t *response,
+                   uint8_t *buffer, uint16_t preferred_size, int32_t *offset)
+{
+  if(coap_block1_handler(request, response, upload, &upload_len,
+                         sizeof(upload)) == 0) {
+    coap_set_status_code(response, CHANGED_2_04);
+    upload_done = 1;
+  }
+}
+RESOURCE(res_upload, "", NULL, NULL, upload_put_handler, NULL);
+/*---------------------------------------------------------------------------*/
+static coap_handler_status_t
+big_service(coap_message_t *request, coap_message_t *response,
+            uint8_t *buffer, uint16_t buffer_size, int32_t *offset)
+{
+  big_get_handler(request, response, buffer, buffer_size, offset);
+  return COAP_HANDLER_STATUS_PROCESSED;
+}
+/*---------------------------------------------------------------------------*/
+/* Keeps the CoAP messages sent to the client */
+static enum netstack_ip_action
+capture_output(const linkaddr_t *localdest)
+{
+  uint16_t len;
+
+  if(UIP_IP_BUF->proto == UIP_PROTO_UDP && uip_len > UIP_IPUDPH_LEN
+     && sent_count < MAX_SENT) {
+    len = uip_len - UIP_IPUDPH_LEN;
+    memcpy(sent[sent_count].data, uip_buf + UIP_IPUDPH_LEN, len);
+    sent[sent_count].len = len;
+    sent_count++;
+  }
+  return NETSTACK_IP_DROP;
+}
+static struct netstack_ip_packet_processor capture = {
+  .process_output = capture_output
+};
+/*---------------------------------------------------------------------------*/
+static void
+init_request(coap_message_t *request, coap_message_type_t type,
+             coap_method_t method, const char *path)
+{
+  static uint8_t token[] = { 0x42, 0x17 };
+
+  coap_init_message(request, type, method, mid++);
+  coap_set_token(request, token, sizeof(token));
+  coap_set_header_uri_path(request, path);
+}
+/*---------------------------------------------------------------------------*/
+/* Sends a request to the server, and parses the messages sent back */
+static int
+receive(coap_message_t *request)
+{
+  static uint8_t packet[COAP_MAX_PACKET_SIZE];
+  size_t len;
+  int i;
+
+  len = coap_serialize_message(request, packet);
+  if(len == 0) {
+    return 0;
+  }
+  sent_count = 0;
+  coap_receive(&client, packet, len);
+  for(i = 0; i < sent_count; i++) {
+    if(coap_parse_message(&sent_message[i], sent[i].data, sent[i].len)
+       != NO_ERROR) {
+      return 0;
+    }
+  }
+  return 1;
+}
+/*---------------------------------------------------------------------------*/
+/* Checks that a message carries block num of the test resource */
+static int
+is_big_block(coap_message_t *message, uint32_t num)
+{
+  uint32_t i;
+
+  if(message->code != CONTENT_2_05 || message->block2_num != num
+     || message->block2_size != BLOCK_SIZE
+     || message->block2_more != ((num + 1) * BLOCK_SIZE < BIG_LEN)
+     || message->payload_len != MIN(BIG_LEN - num * BLOCK_SIZE, BLOCK_SIZE)) {
+    return 0;
+  }
+  for(i = 0; i < message->payload_len; i++) {
+    if(message->payload[i] != big_byte(num * BLOCK_SIZE + i)) {
+      return 0;
+    }
+  }
+  return 1;
+}
+/*---------------------------------------------------------------------------*/
+UNIT_TEST_REGISTER(zero_length_option, "Zero-length option at the end");
+UNIT_TEST(zero_length_option)
+{
+  /* GET /big with Block2 0/16, whose value has no bytes */
+  uint8_t packet[] = { 0x40, COAP_GET, 0x12, 0x34,
+                       0xb3, 'b', 'i', 'g', 0xc0 };
+  /* The same option with an extended delta that is missing */
+  uint8_t truncated[] = { 0x40, COAP_GET, 0x12, 0x34,
+                          0xb3, 'b', 'i', 'g', 0xd0 };
+  coap_message_t message[1];
+  uint32_t num;
+  uint8_t more;
+  uint16_t size;
+
+  UNIT_TEST_BEGIN();
+
+  UNIT_TEST_ASSERT(coap_parse_message(message, packet, sizeof(packet))
+                   == NO_ERROR);
+  UNIT_TEST_ASSERT(coap_get_header_block2(message, &num, &more, &size,
+                                          NULL));
+  UNIT_TEST_ASSERT(num == 0 && more == 0 && size == 16);
+  UNIT_TEST_ASSERT(message->payload_len == 0);
+
+  UNIT_TEST_ASSERT(coap_parse_message(message, truncated, sizeof(truncated))
+                   == BAD_REQUEST_4_00);
+
+  UNIT_TEST_END();
+}
+/*---------------------------------------------------------------------------*/
+UNIT_TEST_REGISTER(block2_buffered, "Buffered Block2 representation");
+UNIT_TEST(block2_buffered)
+{
+  static uint8_t buffer[COAP_MAX_CHUNK_SIZE];
+  coap_message_t request[1];
+  coap_message_t response[1];
+  int calls;
+
+  UNIT_TEST_BEGIN();
+
+  /* The representation is generated at once for the first block */
+  init_request(request, COAP_TYPE_CON, COAP_GET, "big");
+  coap_set_header_block2(request, 0, 0, BLOCK_SIZE);
+  coap_set_src_endpoint(request, &client);
+  coap_init_message(response, COAP_TYPE_ACK, CONTENT_2_05, request->mid);
+  coap_status_code = NO_ERROR;
+  big_calls = 0;
+  coap_blockwise_handle_request(request, response, buffer, big_service);
+  UNIT_TEST_ASSERT(coap_status_code == NO_ERROR);
+  UNIT_TEST_ASSERT(big_calls == (BIG_LEN + BLOCK_SIZE - 1) / BLOCK_SIZE);
+  UNIT_TEST_ASSERT(is_big_block(response, 0));
+
+  /* The block fields of the request are those it was received with */
+  UNIT_TEST_ASSERT(request->block2_num == 0);
+  UNIT_TEST_ASSERT(request->block2_offset == 0);
+  UNIT_TEST_ASSERT(request->block2_size == BLOCK_SIZE);
+
+  /* Later blocks come from the buffer */
+  calls = big_calls;
+  init_request(request, COAP_TYPE_CON, COAP_GET, "big");
+  coap_set_header_block2(request, 5, 0, BLOCK_SIZE);
+  UNIT_TEST_ASSERT(receive(request));
+  UNIT_TEST_ASSERT(big_calls == calls);
+  UNIT_TEST_ASSERT(sent_count == 1);
+  UNIT_TEST_ASSERT(sent_message[0].type == COAP_TYPE_ACK);
+  UNIT_TEST_ASSERT(coap_is_option(&sent_message[0], COAP_OPTION_BLOCK2));
+  UNIT_TEST_ASSERT(is_big_block(&sent_message[0], 5));
+
+  UNIT_TEST_END();
+}
+/*---------------------------------------------------------------------------*/
+UNIT_TEST_REGISTER(q_block2_burst, "Q-Block2 burst");
+UNIT_TEST(q_block2_burst)
+{
+  coap_message_t request[1];
+  const uint8_t *etag;
+  const uint8_t *block_etag;
+  int etag_len;
+  int calls;
+  int i;
+
+  UNIT_TEST_BEGIN();
+
+  /* The first block is followed by the rest of the set */
+  init_request(request, COAP_TYPE_CON, COAP_GET, "big");
+  coap_set_header_q_block2(request, 0, 1, BLOCK_SIZE);
+  UNIT_TEST_ASSERT(receive(request));
+  UNIT_TEST_ASSERT(sent_count == COAP_QBLOCK_MAX_PAYLOADS);
+  UNIT_TEST_ASSERT(sent_message[0].type == COAP_TYPE_ACK);
+  etag_len = coap_get_header_etag(&sent_message[0], &etag);
+  UNIT_TEST_ASSERT(etag_len > 0);
+  for(i = 0; i < sent_count; i++) {
+    UNIT_TEST_ASSERT(i == 0 || sent_message[i].type == COAP_TYPE_NON);
+    UNIT_TEST_ASSERT(coap_is_option(&sent_message[i], COAP_OPTION_Q_BLOCK2));
+    UNIT_TEST_ASSERT(!coap_is_option(&sent_message[i], COAP_OPTION_BLOCK2));
+    UNIT_TEST_ASSERT(sent_message[i].token_len == 2);
+    UNIT_TEST_ASSERT(coap_get_header_etag(&sent_message[i], &block_etag)
+                     == etag_len && memcmp(etag, block_etag, etag_len) == 0);
+    UNIT_TEST_ASSERT(is_big_block(&sent_message[i], i));
+  }
+
+  /* The next set is served from the buffer */
+  calls = big_calls;
+  init_request(request, COAP_TYPE_CON, COAP_GET, "big");
+  coap_set_header_q_block2(request, COAP_QBLOCK_MAX_PAYLOADS, 1, BLOCK_SIZE);
+  UNIT_TEST_ASSERT(receive(request));
+  UNIT_TEST_ASSERT(big_calls == calls);
+  UNIT_TEST_ASSERT(sent_count == COAP_QBLOCK_MAX_PAYLOADS);
+  for(i = 0; i < sent_count; i++) {
+    UNIT_TEST_ASSERT(is_big_block(&sent_message[i],
+                                  COAP_QBLOCK_MAX_PAYLOADS + i));
+  }
+
+  /* The burst stops at the last block */
+  init_request(request, COAP_TYPE_CON, COAP_GET, "big");
+  coap_set_header_q_block2(request, BIG_LEN / BLOCK_SIZE - 1, 1, BLOCK_SIZE);
+  UNIT_TEST_ASSERT(receive(request));
+  UNIT_TEST_ASSERT(sent_count == 2);
+  UNIT_TEST_ASSERT(is_big_block(&sent_message[1], BIG_LEN / BLOCK_SIZE));
+  UNIT_TEST_ASSERT(!sent_message[1].block2_more);
+
+  UNIT_TEST_END();
+}
+/*---------------------------------------------------------------------------*/
+static int
+upload_block(coap_message_type_t type, uint8_t q, uint32_t num, size_t len)
+{
+  coap_message_t request[1];
+  static uint8_t payload[BLOCK_SIZE];
+  size_t offset = num * BLOCK_SIZE;
+  size_t i;
+
+  init_request(request, type, COAP_PUT, "upload");
+  if(q) {
+    coap_set_header_q_block1(request, num, offset + BLOCK_SIZE < len,
+                             BLOCK_SIZE);
+  } else {
+    coap_set_header_block1(request, num, offset + BLOCK_SIZE < len,
+                           BLOCK_SIZE);
+  }
+  for(i = 0; i < BLOCK_SIZE && offset + i < len; i++) {
+    payload[i] = big_byte(offset + i) + num;
+  }
+  coap_set_payload(request, payload, i);
+  return receive(request);
+}
+/*---------------------------------------------------------------------------*/
+static int
+check_upload(size_t len)
+{
+  size_t i;
+
+  if(!upload_done || upload_len != len) {
+    return 0;
+  }
+  for(i = 0; i < len; i++) {
+    if(upload[i] != big_byte(i) + i / BLOCK_SIZE) {
+      return 0;
+    }
+  }
+  return 1;
+}
+/*---------------------------------------------------------------------------*/
+UNIT_TEST_REGISTER(block1_upload, "Block1 upload");
+UNIT_TEST(block1_upload)
+{
+  uint32_t num;
+  coap_message_t *response = &sent_message[0];
+
+  UNIT_TEST_BEGIN();
+
+  upload_done = 0;
+  for(num = 0; num * BLOCK_SIZE < 100; num++) {
+    UNIT_TEST_ASSERT(upload_block(COAP_TYPE_CON, 0, num, 100));
+    /* Every block is acknowledged */
+    UNIT_TEST_ASSERT(sent_count == 1);
+    UNIT_TEST_ASSERT(response->type == COAP_TYPE_ACK);
+    UNIT_TEST_ASSERT(coap_is_option(response, COAP_OPTION_BLOCK1));
+    UNIT_TEST_ASSERT(response->block1_num == num);
+    UNIT_TEST_ASSERT(response->code ==
+                     ((num + 1) * BLOCK_SIZE < 100 ? CONTINUE_2_31
+                      : CHANGED_2_04));
+  }
+  UNIT_TEST_ASSERT(check_upload(100));
+
+  UNIT_TEST_END();
+}
+/*---------------------------------------------------------------------------*/
+UNIT_TEST_REGISTER(q_block1_upload, "Q-Block1 upload");
+UNIT_TEST(q_block1_upload)
+{
+  uint32_t num;
+  coap_message_t *response = &sent_message[0];
+  int last;
+
+  UNIT_TEST_BEGIN();
+
+  upload_done = 0;
+  for(num = 0; num * BLOCK_SIZE < 100; num++) {
+    UNIT_TEST_ASSERT(upload_block(COAP_TYPE_NON, 1, num, 100));
+    last = (num + 1) * BLOCK_SIZE >= 100;
+    if(!last && (num + 1) % COAP_QBLOCK_MAX_PAYLOADS != 0) {
+      /* Only the last block of a set is answered */
+      UNIT_TEST_ASSERT(sent_count == 0);
+      continue;
+    }
+    UNIT_TEST_ASSERT(sent_count == 1);
+    UNIT_TEST_ASSERT(response->type == COAP_TYPE_NON);
+    UNIT_TEST_ASSERT(coap_is_option(response, COAP_OPTION_Q_BLOCK1));
+    UNIT_TEST_ASSERT(!coap_is_option(response, COAP_OPTION_BLOCK1));
+    UNIT_TEST_ASSERT(response->block1_num == num);
+    UNIT_TEST_ASSERT(response->code == (last ? CHANGED_2_04 : CONTINUE_2_31));
+  }
+  UNIT_TEST_ASSERT(check_upload(100));
+
+  UNIT_TEST_END();
+}
+/*---------------------------------------------------------------------------*/
+PROCESS_THREAD(test_process, ev, data)
+{
+  static const char *ep = "coap://[fe80::1]:5683";
+
+  PROCESS_BEGIN();
+
+  printf("Run unit-test\n");
+  printf("---\n");
+
+  coap_engine_init();
+  coap_activate_resource(&res_big, "big");
+  coap_activate_resource(&res_upload, "upload");
+  coap_endpoint_parse(ep, strlen(ep), &client);
+  netstack_ip_packet_processor_add(&capture);
+
+  UNIT_TEST_RUN(zero_length_option);
+  UNIT_TEST_RUN(block2_buffered);
+  UNIT_TEST_RUN(q_block2_burst);
+  UNIT_TEST_RUN(block1_upload);
+  UNIT_TEST_RUN(q_block1_upload);
+
+  if(!UNIT_TEST_PASSED(zero_length_option) ||
+     !UNIT_TEST_PASSED(block2_buffered) ||
+     !UNIT_TEST_PASSED(q_block2_burst) ||
+     !UNIT_TEST_PASSED(block1_upload) ||
+     !UNIT_TEST_PASSED(q_block1_upload)) {
+    printf("=check-me= FAILED\n");
+    printf("---\n");
+  }
+
+  printf("=check-me= DONE\n");
+  printf("---\n");
+
+  PROCESS_END();
+}
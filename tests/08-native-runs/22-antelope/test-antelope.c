@@ -0,0 +1,675 @@
+/*
+ * Copyright (c) 2026, agent <agent@local>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+ * OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+ * Tests Antelope queries over relations stored in Coffee. The results
+ * are checked against values computed from the inserted tuples.
+ */
+
+#include "contiki.h"
+#include "unit-test.h"
+#include "cfs/cfs-coffee.h"
+#include "antelope.h"
+#include "relation.h"
+#include "index.h"
+#include "aql.h"
+#include "lvm.h"
+
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+PROCESS(test_process, "test");
+AUTOSTART_PROCESSES(&test_process);
+
+#define MAX_ROWS    256
+#define MAX_COLUMNS 3
+
+/* The first columns of the rows returned by the last query */
+static long rows[MAX_ROWS][MAX_COLUMNS];
+static int row_count;
+/*---------------------------------------------------------------------------*/
+static db_result_t
+query(const char *format, ...)
+{
+  static db_handle_t handle;
+  static char buf[AQL_MAX_QUERY_LENGTH];
+  attribute_value_t value;
+  db_result_t result;
+  va_list ap;
+  unsigned col;
+
+  va_start(ap, format);
+  vsnprintf(buf, sizeof(buf), format, ap);
+  va_end(ap);
+
+  row_count = 0;
+  result = db_query(&handle, "%s", buf);
+  while(!DB_ERROR(result) && db_processing(&handle)) {
+    result = db_process(&handle);
+    if(result == DB_GOT_ROW && row_count < MAX_ROWS) {
+      for(col = 0; col < handle.ncolumns && col < MAX_COLUMNS; col++) {
+        if(DB_ERROR(db_get_value(&value, &handle, col))) {
+          result = DB_INCONSISTENCY_ERROR;
+          break;
+        }
+        rows[row_count][col] = db_value_to_long(&value);
+      }
+      row_count++;
+    } else if(result == DB_FINISHED) {
+      break;
+    }
+  }
+  db_free(&handle);
+
+  if(DB_ERROR(result)) {
+    printf("\"%s\" failed: %s\n", buf, db_get_result_message(result));
+  }
+  return DB_ERROR(result) ? result : DB_OK;
+}
+/*---------------------------------------------------------------------------*/
+#define SAMPLES 200
+
+/* Every time stamp appears twice, in a shuffled order */
+static long
+sample_ts(int i)
+{
+  return (i * 73L) % (SAMPLES / 2) * 10;
+}
+/*---------------------------------------------------------------------------*/
+/* Checks that the last query returned the samples with lo <= ts < hi */
+static int
+check_ts_range(long lo, long hi)
+{
+  int expected;
+  int i;
+
+  expected = 0;
+  for(i = 0; i < SAMPLES; i++) {
+    expected += sample_ts(i) >= lo && sample_ts(i) < hi;
+  }
+  if(row_count != expected) {
+    printf("%d rows in [%ld, %ld), expected %d\n", row_count, lo, hi,
+           expected);
+    return 0;
+  }
+  for(i = 0; i < row_count; i++) {
+    if(rows[i][0] < lo || rows[i][0] >= hi ||
+       sample_ts(rows[i][1]) != rows[i][0]) {
+      return 0;
+    }
+  }
+  return 1;
+}
+/*---------------------------------------------------------------------------*/
+UNIT_TEST_REGISTER(btree_index, "B+-tree index");
+UNIT_TEST(btree_index)
+{
+  relation_t *rel;
+  attribute_t *attr;
+  int i;
+
+  UNIT_TEST_BEGIN();
+
+  UNIT_TEST_ASSERT(!DB_ERROR(query("CREATE RELATION samples;")));
+  UNIT_TEST_ASSERT(!DB_ERROR(query("CREATE ATTRIBUTE ts DOMAIN LONG "
+                                   "IN samples;")));
+  UNIT_TEST_ASSERT(!DB_ERROR(query("CREATE ATTRIBUTE id DOMAIN INT "
+                                   "IN samples;")));
+  UNIT_TEST_ASSERT(!DB_ERROR(query("CREATE INDEX samples.ts TYPE BTREE;")));
+  for(i = 0; i < SAMPLES; i++) {
+    UNIT_TEST_ASSERT(!DB_ERROR(query("INSERT (%ld, %d) INTO samples;",
+                                     sample_ts(i), i)));
+  }
+
+  /* Range and equality queries */
+  UNIT_TEST_ASSERT(!DB_ERROR(query("SELECT ts, id FROM samples "
+                                   "WHERE ts >= 250 AND ts < 600;")));
+  UNIT_TEST_ASSERT(check_ts_range(250, 600));
+  UNIT_TEST_ASSERT(!DB_ERROR(query("SELECT ts, id FROM samples "
+                                   "WHERE ts = 420;")));
+  UNIT_TEST_ASSERT(check_ts_range(420, 421));
+  UNIT_TEST_ASSERT(!DB_ERROR(query("SELECT ts, id FROM samples "
+                                   "WHERE 100 > ts;")));
+  UNIT_TEST_ASSERT(check_ts_range(0, 100));
+  UNIT_TEST_ASSERT(!DB_ERROR(query("SELECT ts, id FROM samples "
+                                   "WHERE ts > 5000;")));
+  UNIT_TEST_ASSERT(row_count == 0);
+
+  /* An unrestricted attribute in an OR needs all tuples */
+  UNIT_TEST_ASSERT(!DB_ERROR(query("SELECT ts, id FROM samples "
+                                   "WHERE ts < 50 OR id = 7;")));
+  UNIT_TEST_ASSERT(row_count == 11);
+
+  /* The index is read again from its file */
+  rel = relation_load("samples");
+  UNIT_TEST_ASSERT(rel != NULL);
+  attr = relation_attribute_get(rel, "ts");
+  UNIT_TEST_ASSERT(attr != NULL && index_exists(attr));
+  UNIT_TEST_ASSERT(!DB_ERROR(index_release(attr->index)));
+  UNIT_TEST_ASSERT(!DB_ERROR(index_load(rel, attr)));
+  UNIT_TEST_ASSERT(index_exists(attr));
+  relation_release(rel);
+
+  UNIT_TEST_ASSERT(!DB_ERROR(query("SELECT ts, id FROM samples "
+                                   "WHERE ts >= 250 AND ts < 600;")));
+  UNIT_TEST_ASSERT(check_ts_range(250, 600));
+
+  /* The reopened index takes new keys */
+  for(i = 0; i < 10; i++) {
+    UNIT_TEST_ASSERT(!DB_ERROR(query("INSERT (%d, %d) INTO samples;",
+                                     1000 + i * 10, SAMPLES + i)));
+  }
+  UNIT_TEST_ASSERT(!DB_ERROR(query("SELECT ts, id FROM samples "
+                                   "WHERE ts >= 990;")));
+  UNIT_TEST_ASSERT(row_count == 12);
+  for(i = 0; i < row_count; i++) {
+    UNIT_TEST_ASSERT(rows[i][0] >= 990);
+  }
+
+  UNIT_TEST_ASSERT(!DB_ERROR(query("REMOVE RELATION samples;")));
+
+  UNIT_TEST_END();
+}
+/*---------------------------------------------------------------------------*/
+#define LEFT_TUPLES  40
+#define RIGHT_TUPLES 50
+
+/* Both relations have two tuples for each key */
+#define LEFT_KEY(i)  ((i) % 20)
+#define RIGHT_KEY(i) ((i) * 7 % 25)
+
+static long hash_rows[MAX_ROWS];
+static int hash_row_count;
+/*---------------------------------------------------------------------------*/
+static int
+compare_longs(const void *a, const void *b)
+{
+  long x = *(const long *)a;
+  long y = *(const long *)b;
+
+  return x < y ? -1 : x > y;
+}
+/*---------------------------------------------------------------------------*/
+static db_result_t
+create_join_relations(const char *left, const char *right, int indexed)
+{
+  int i;
+
+  if(DB_ERROR(query("CREATE RELATION %s;", left)) ||
+     DB_ERROR(query("CREATE ATTRIBUTE k DOMAIN INT IN %s;", left)) ||
+     DB_ERROR(query("CREATE ATTRIBUTE a DOMAIN INT IN %s;", left)) ||
+     DB_ERROR(query("CREATE RELATION %s;", right)) ||
+     DB_ERROR(query("CREATE ATTRIBUTE k DOMAIN INT IN %s;", right)) ||
+     DB_ERROR(query("CREATE ATTRIBUTE b DOMAIN INT IN %s;", right))) {
+    return DB_STORAGE_ERROR;
+  }
+  if(indexed &&
+     (DB_ERROR(query("CREATE INDEX %s.k TYPE BTREE;", left)) ||
+      DB_ERROR(query("CREATE INDEX %s.k TYPE BTREE;", right)))) {
+    return DB_INDEX_ERROR;
+  }
+
+  for(i = 0; i < LEFT_TUPLES; i++) {
+    if(DB_ERROR(query("INSERT (%d, %d) INTO %s;", LEFT_KEY(i), i, left))) {
+      return DB_STORAGE_ERROR;
+    }
+  }
+  for(i = 0; i < RIGHT_TUPLES; i++) {
+    if(DB_ERROR(query("INSERT (%d, %d) INTO %s;", RIGHT_KEY(i), i, right))) {
+      return DB_STORAGE_ERROR;
+    }
+  }
+  return DB_OK;
+}
+/*---------------------------------------------------------------------------*/
+/*
+ * Checks that the last join returned every matching pair of tuples
+ * once, and stores the pairs as sorted numbers in the given array.
+ */
+static int
+check_join(long *pairs)
+{
+  int expected;
+  int i, j;
+
+  expected = 0;
+  for(i = 0; i < LEFT_TUPLES; i++) {
+    for(j = 0; j < RIGHT_TUPLES; j++) {
+      expected += LEFT_KEY(i) == RIGHT_KEY(j);
+    }
+  }
+  if(row_count != expected) {
+    printf("The join returned %d rows, expected %d\n", row_count, expected);
+    return 0;
+  }
+
+  for(i = 0; i < row_count; i++) {
+    if(rows[i][1] < 0 || rows[i][1] >= LEFT_TUPLES ||
+       rows[i][2] < 0 || rows[i][2] >= RIGHT_TUPLES ||
+       LEFT_KEY(rows[i][1]) != rows[i][0] ||
+       RIGHT_KEY(rows[i][2]) != rows[i][0]) {
+      printf("Bad join row (%ld, %ld, %ld)\n",
+             rows[i][0], rows[i][1], rows[i][2]);
+      return 0;
+    }
+    pairs[i] = rows[i][1] * RIGHT_TUPLES + rows[i][2];
+  }
+
+  qsort(pairs, row_count, sizeof(pairs[0]), compare_longs);
+  for(i = 1; i < row_count; i++) {
+    if(pairs[i] == pairs[i - 1]) {
+      printf("The join returned a pair twice\n");
+      return 0;
+    }
+  }
+  return 1;
+}
+/*---------------------------------------------------------------------------*/
+UNIT_TEST_REGISTER(joins, "Hash and merge joins");
+UNIT_TEST(joins)
+{
+  static long merge_rows[MAX_ROWS];
+  int merge_row_count;
+  int i;
+
+  UNIT_TEST_BEGIN();
+
+  /* Without indexes, both relations are larger than the hash table,
+     so the hash join is made in several passes. */
+  UNIT_TEST_ASSERT(LEFT_TUPLES > DB_JOIN_HASH_LIMIT);
+  UNIT_TEST_ASSERT(!DB_ERROR(create_join_relations("hleft", "hright", 0)));
+  UNIT_TEST_ASSERT(!DB_ERROR(query("JOIN hleft, hright ON k "
+                                   "PROJECT k, a, b;")));
+  UNIT_TEST_ASSERT(check_join(hash_rows));
+  hash_row_count = row_count;
+  UNIT_TEST_ASSERT(!DB_ERROR(query("REMOVE RELATION hleft;")));
+  UNIT_TEST_ASSERT(!DB_ERROR(query("REMOVE RELATION hright;")));
+
+  /* With ordered indexes on both join attributes, the relations are
+     merged. */
+  UNIT_TEST_ASSERT(!DB_ERROR(create_join_relations("mleft", "mright", 1)));
+  UNIT_TEST_ASSERT(!DB_ERROR(query("JOIN mleft, mright ON k "
+                                   "PROJECT k, a, b;")));
+  UNIT_TEST_ASSERT(check_join(merge_rows));
+  merge_row_count = row_count;
+  /* The merge join returns the rows in the order of the key. */
+  for(i = 1; i < row_count; i++) {
+    UNIT_TEST_ASSERT(rows[i - 1][0] <= rows[i][0]);
+  }
+  UNIT_TEST_ASSERT(!DB_ERROR(query("REMOVE RELATION mleft;")));
+  UNIT_TEST_ASSERT(!DB_ERROR(query("REMOVE RELATION mright;")));
+
+  UNIT_TEST_ASSERT(merge_row_count == hash_row_count);
+  for(i = 0; i < hash_row_count; i++) {
+    UNIT_TEST_ASSERT(hash_rows[i] == merge_rows[i]);
+  }
+
+  UNIT_TEST_END();
+}
+/*---------------------------------------------------------------------------*/
+#define READINGS       100
+#define READING_PERIOD 60
+#define BUCKET_WIDTH   600
+#define BUCKETS        (READINGS * READING_PERIOD / BUCKET_WIDTH)
+
+/* The values do not fit in an INT, and are not sorted within a bucket */
+static long
+reading_value(int i)
+{
+  return 70000 + (i * 37L) % READINGS * 1000;
+}
+/*---------------------------------------------------------------------------*/
+/* Checks the last query, which returned the start of each bucket and
+   two of its aggregates. */
+static int
+check_buckets(int first, int second)
+{
+  long expected[AQL_MEAN + 1];
+  long value;
+  int bucket;
+  int i;
+
+  if(row_count != BUCKETS) {
+    printf("%d buckets, expected %d\n", row_count, BUCKETS);
+    return 0;
+  }
+
+  for(bucket = 0; bucket < BUCKETS; bucket++) {
+    expected[AQL_COUNT] = 0;
+    expected[AQL_SUM] = 0;
+    expected[AQL_MAX] = 0;
+    expected[AQL_MIN] = 0;
+    for(i = 0; i < READINGS; i++) {
+      if(i * READING_PERIOD / BUCKET_WIDTH != bucket) {
+        continue;
+      }
+      value = reading_value(i);
+      if(expected[AQL_COUNT] == 0 || value > expected[AQL_MAX]) {
+        expected[AQL_MAX] = value;
+      }
+      if(expected[AQL_COUNT] == 0 || value < expected[AQL_MIN]) {
+        expected[AQL_MIN] = value;
+      }
+      expected[AQL_SUM] += value;
+      expected[AQL_COUNT]++;
+    }
+    expected[AQL_MEAN] = expected[AQL_SUM] / expected[AQL_COUNT];
+
+    if(rows[bucket][0] != (long)bucket * BUCKET_WIDTH ||
+       rows[bucket][1] != expected[first] ||
+       rows[bucket][2] != expected[second]) {
+      printf("Bad bucket (%ld, %ld, %ld)\n",
+             rows[bucket][0], rows[bucket][1], rows[bucket][2]);
+      return 0;
+    }
+  }
+  return 1;
+}
+/*---------------------------------------------------------------------------*/
+UNIT_TEST_REGISTER(group_by, "Aggregates with GROUP BY");
+UNIT_TEST(group_by)
+{
+  long sum;
+  int i;
+
+  UNIT_TEST_BEGIN();
+
+  UNIT_TEST_ASSERT(!DB_ERROR(query("CREATE RELATION readings;")));
+  UNIT_TEST_ASSERT(!DB_ERROR(query("CREATE ATTRIBUTE ts DOMAIN LONG "
+                                   "IN readings;")));
+  UNIT_TEST_ASSERT(!DB_ERROR(query("CREATE ATTRIBUTE light DOMAIN LONG "
+                                   "IN readings;")));
+  for(i = 0; i < READINGS; i++) {
+    UNIT_TEST_ASSERT(!DB_ERROR(query("INSERT (%ld, %ld) INTO readings;",
+                                     (long)i * READING_PERIOD,
+                                     reading_value(i))));
+  }
+
+  /* Without GROUP BY, the whole selection is one group. */
+  UNIT_TEST_ASSERT(!DB_ERROR(query("SELECT COUNT(light), MEAN(light), "
+                                   "SUM(light) FROM readings;")));
+  for(sum = 0, i = 0; i < READINGS; i++) {
+    sum += reading_value(i);
+  }
+  UNIT_TEST_ASSERT(row_count == 1);
+  UNIT_TEST_ASSERT(rows[0][0] == READINGS);
+  UNIT_TEST_ASSERT(rows[0][1] == sum / READINGS);
+  UNIT_TEST_ASSERT(rows[0][2] == sum);
+
+  /* There are more buckets than groups, so the first buckets are
+     returned before all tuples have been read. */
+  UNIT_TEST_ASSERT(BUCKETS > DB_GROUP_LIMIT);
+  UNIT_TEST_ASSERT(!DB_ERROR(query("SELECT ts, COUNT(light), MEAN(light) "
+                                   "FROM readings GROUP BY ts / %d;",
+                                   BUCKET_WIDTH)));
+  UNIT_TEST_ASSERT(check_buckets(AQL_COUNT, AQL_MEAN));
+  UNIT_TEST_ASSERT(!DB_ERROR(query("SELECT ts, MAX(light), SUM(light) "
+                                   "FROM readings GROUP BY ts / %d;",
+                                   BUCKET_WIDTH)));
+  UNIT_TEST_ASSERT(check_buckets(AQL_MAX, AQL_SUM));
+  UNIT_TEST_ASSERT(!DB_ERROR(query("SELECT ts, MIN(light), COUNT(light) "
+                                   "FROM readings WHERE ts >= 0 "
+                                   "GROUP BY ts / %d;", BUCKET_WIDTH)));
+  UNIT_TEST_ASSERT(check_buckets(AQL_MIN, AQL_COUNT));
+
+  /* A tuple of a bucket that has already been returned fails the
+     query instead of giving a wrong result. */
+  UNIT_TEST_ASSERT(!DB_ERROR(query("INSERT (0, 0) INTO readings;")));
+  UNIT_TEST_ASSERT(query("SELECT ts, COUNT(light) FROM readings "
+                         "GROUP BY ts / %d;", BUCKET_WIDTH) == DB_LIMIT_ERROR);
+
+  UNIT_TEST_ASSERT(!DB_ERROR(query("REMOVE RELATION readings;")));
+
+  UNIT_TEST_END();
+}
+/*---------------------------------------------------------------------------*/
+#if LVM_COMPILE_PREDICATES
+#define GRID        12
+#define GRID_TUPLES (GRID * GRID)
+
+/* Tuple t of the grid relation is (t / GRID, t % GRID). AND and OR
+   have the same precedence and are applied from left to right. */
+static const char *predicates[] = {
+  "a > 3 AND a < 9",
+  "a >= 5 AND a <= 5",
+  "2 < a AND 7 >= b",
+  "a < 2 OR b > 9",
+  "a > 2 AND b < 6 OR a = 10",
+  "b < 3 OR b > 8 AND a > 1",
+  "a > 6 AND a <= 8 OR b <> 4",
+  "a + b > 12 AND a - b < 2",
+  "a * 2 = b OR a = 11",
+  "a > 4 AND 3 > 4",
+  "b = 7 OR 2 < 3",
+};
+
+/* The results of the interpreted predicate for the grid tuples */
+static uint8_t interpreted[GRID_TUPLES];
+static int interpreted_count;
+/*---------------------------------------------------------------------------*/
+static lvm_instance_t *
+parse_predicate(const char *predicate)
+{
+  static aql_adt_t adt;
+  static char buf[AQL_MAX_QUERY_LENGTH];
+
+  snprintf(buf, sizeof(buf), "SELECT a, b FROM grid WHERE %s;", predicate);
+  if(aql_parse(&adt, buf) != OK) {
+    printf("Cannot parse \"%s\"\n", buf);
+    return NULL;
+  }
+  return adt.lvm_instance;
+}
+/*---------------------------------------------------------------------------*/
+static void
+interpret(lvm_instance_t *p)
+{
+  static char name_a[] = "a";
+  static char name_b[] = "b";
+  operand_value_t value;
+  int t;
+
+  interpreted_count = 0;
+  for(t = 0; t < GRID_TUPLES; t++) {
+    value.l = t / GRID;
+    lvm_set_variable_value(name_a, value);
+    value.l = t % GRID;
+    lvm_set_variable_value(name_b, value);
+    interpreted[t] = lvm_execute(p) == LVM_TRUE;
+    interpreted_count += interpreted[t];
+  }
+}
+/*---------------------------------------------------------------------------*/
+/* Checks that the compiled predicate, or its negation, selects the same
+   grid tuples as the interpreted one. */
+static int
+check_compiled(lvm_instance_t *p, int inverse)
+{
+  static char name_a[] = "a";
+  static char name_b[] = "b";
+  uint8_t selection[LVM_BATCH_SIZE];
+  long *column_a;
+  long *column_b;
+  unsigned selected;
+  unsigned count;
+  unsigned i, j;
+  int base;
+
+  if(LVM_ERROR(lvm_compile(p, inverse))) {
+    printf("The predicate was not compiled\n");
+    return 0;
+  }
+  column_a = lvm_get_column(name_a);
+  column_b = lvm_get_column(name_b);
+
+  for(base = 0; base < GRID_TUPLES; base += count) {
+    count = GRID_TUPLES - base;
+    if(count > LVM_BATCH_SIZE) {
+      count = LVM_BATCH_SIZE;
+    }
+    for(i = 0; i < count; i++) {
+      if(column_a != NULL) {
+        column_a[i] = (base + i) / GRID;
+      }
+      if(column_b != NULL) {
+        column_b[i] = (base + i) % GRID;
+      }
+    }
+
+    selected = lvm_execute_batch(count, selection);
+    for(i = j = 0; i < count; i++) {
+      if(j < selected && selection[j] == i) {
+        j++;
+        if(interpreted[base + i] == inverse) {
+          printf("Tuple %u selected by the compiled predicate\n", base + i);
+          return 0;
+        }
+      } else if(interpreted[base + i] != inverse) {
+        printf("Tuple %u not selected by the compiled predicate\n", base + i);
+        return 0;
+      }
+    }
+    if(j != selected) {
+      printf("Bad selection vector\n");
+      return 0;
+    }
+  }
+  return 1;
+}
+/*---------------------------------------------------------------------------*/
+/* Checks that the last query returned the grid tuples of the
+   interpreted predicate. */
+static int
+check_grid_rows(void)
+{
+  int i;
+
+  if(row_count != interpreted_count) {
+    printf("%d rows, expected %d\n", row_count, interpreted_count);
+    return 0;
+  }
+  for(i = 0; i < row_count; i++) {
+    if(rows[i][0] < 0 || rows[i][0] >= GRID ||
+       rows[i][1] < 0 || rows[i][1] >= GRID ||
+       !interpreted[rows[i][0] * GRID + rows[i][1]]) {
+      printf("Bad row (%ld, %ld)\n", rows[i][0], rows[i][1]);
+      return 0;
+    }
+  }
+  return 1;
+}
+/*---------------------------------------------------------------------------*/
+UNIT_TEST_REGISTER(predicates, "Compiled and interpreted predicates");
+UNIT_TEST(predicates)
+{
+  lvm_instance_t *p;
+  unsigned i;
+  int t;
+
+  UNIT_TEST_BEGIN();
+
+  UNIT_TEST_ASSERT(GRID_TUPLES <= MAX_ROWS);
+  UNIT_TEST_ASSERT(!DB_ERROR(query("CREATE RELATION grid;")));
+  UNIT_TEST_ASSERT(!DB_ERROR(query("CREATE ATTRIBUTE a DOMAIN INT "
+                                   "IN grid;")));
+  UNIT_TEST_ASSERT(!DB_ERROR(query("CREATE ATTRIBUTE b DOMAIN INT "
+                                   "IN grid;")));
+  for(t = 0; t < GRID_TUPLES; t++) {
+    UNIT_TEST_ASSERT(!DB_ERROR(query("INSERT (%d, %d) INTO grid;",
+                                     t / GRID, t % GRID)));
+  }
+
+  for(i = 0; i < sizeof(predicates) / sizeof(predicates[0]); i++) {
+    printf("WHERE %s\n", predicates[i]);
+    p = parse_predicate(predicates[i]);
+    UNIT_TEST_ASSERT(p != NULL);
+    interpret(p);
+
+    /* Both the predicate and its negation, as used by REMOVE */
+    UNIT_TEST_ASSERT(check_compiled(p, 0));
+    UNIT_TEST_ASSERT(check_compiled(p, 1));
+
+    /* Selections without an index evaluate the compiled predicate
+       over batches of rows. */
+    UNIT_TEST_ASSERT(!DB_ERROR(query("SELECT a, b FROM grid WHERE %s;",
+                                     predicates[i])));
+    UNIT_TEST_ASSERT(check_grid_rows());
+  }
+
+  /* The tuples left by REMOVE are those of the negated predicate. */
+  p = parse_predicate("a < 2 OR b > 9");
+  UNIT_TEST_ASSERT(p != NULL);
+  interpret(p);
+  UNIT_TEST_ASSERT(!DB_ERROR(query("REMOVE FROM grid WHERE a < 2 OR b > 9;")));
+  UNIT_TEST_ASSERT(!DB_ERROR(query("SELECT a, b FROM grid;")));
+  UNIT_TEST_ASSERT(row_count == GRID_TUPLES - interpreted_count);
+  for(t = 0; t < row_count; t++) {
+    UNIT_TEST_ASSERT(!interpreted[rows[t][0] * GRID + rows[t][1]]);
+  }
+
+  UNIT_TEST_ASSERT(!DB_ERROR(query("REMOVE RELATION grid;")));
+
+  UNIT_TEST_END();
+}
+#endif /* LVM_COMPILE_PREDICATES */
+/*---------------------------------------------------------------------------*/
+PROCESS_THREAD(test_process, ev, data)
+{
+  PROCESS_BEGIN();
+
+  printf("Run unit-test\n");
+  printf("---\n");
+
+  cfs_coffee_format();
+  db_init();
+
+  UNIT_TEST_RUN(btree_index);
+  UNIT_TEST_RUN(joins);
+  UNIT_TEST_RUN(group_by);
+#if LVM_COMPILE_PREDICATES
+  UNIT_TEST_RUN(predicates);
+  if(!UNIT_TEST_PASSED(predicates)) {
+    printf("=check-me= FAILED\n");
+    printf("---\n");
+  }
+#endif /* LVM_COMPILE_PREDICATES */
+
+  if(!UNIT_TEST_PASSED(btree_index) || !UNIT_TEST_PASSED(joins) ||
+     !UNIT_TEST_PASSED(group_by)) {
+    printf("=check-me= FAILED\n");
+    printf("---\n");
+  }
+
+  printf("=check-me= DONE\n");
+  printf("---\n");
+
+  PROCESS_END();
+}
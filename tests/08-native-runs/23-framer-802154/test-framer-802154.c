@@ -0,0 +1,249 @@
+/*
+ * Copyright (c) 2026, agent <agent@local>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+ * OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+ * Tests the frame descriptor that framer_802154 keeps for the frame in
+ * packetbuf. Frames are built with framer_802154.create() and parsed
+ * back, either by the framer itself or after being handed over with
+ * framer_802154_set_rx_frame(), as TSCH does.
+ */
+
+#include "contiki.h"
+#include "unit-test.h"
+#include "net/packetbuf.h"
+#include "net/linkaddr.h"
+#include "net/mac/framer/framer.h"
+#include "net/mac/framer/framer-802154.h"
+
+#include <stdio.h>
+#include <string.h>
+
+PROCESS(test_process, "test");
+AUTOSTART_PROCESSES(&test_process);
+
+static const char payload[] = "hello";
+static const linkaddr_t receiver = { { 0x02, 0x00, 0x00, 0x00,
+                                       0x00, 0x00, 0x00, 0x02 } };
+
+static uint8_t frame_buf[PACKETBUF_SIZE];
+static int frame_len;
+/*---------------------------------------------------------------------------*/
+/* Build a data frame in frame_buf and return its header length */
+static int
+build_frame(const linkaddr_t *dest, uint8_t seqno)
+{
+  int hdr_len;
+
+  packetbuf_clear();
+  packetbuf_copyfrom(payload, sizeof(payload) - 1);
+  packetbuf_set_attr(PACKETBUF_ATTR_FRAME_TYPE, FRAME802154_DATAFRAME);
+  packetbuf_set_attr(PACKETBUF_ATTR_MAC_SEQNO, seqno);
+  packetbuf_set_addr(PACKETBUF_ADDR_SENDER, &linkaddr_node_addr);
+  packetbuf_set_addr(PACKETBUF_ADDR_RECEIVER, dest);
+
+  hdr_len = framer_802154.create();
+  if(hdr_len <= 0) {
+    return hdr_len;
+  }
+  frame_len = packetbuf_totlen();
+  memcpy(frame_buf, packetbuf_hdrptr(), frame_len);
+  return hdr_len;
+}
+/*---------------------------------------------------------------------------*/
+/* Load frame_buf into packetbuf, as a radio driver does */
+static void
+receive_frame(void)
+{
+  packetbuf_clear();
+  packetbuf_copyfrom(frame_buf, frame_len);
+}
+/*---------------------------------------------------------------------------*/
+UNIT_TEST_REGISTER(unicast_fields, "Descriptor of a parsed unicast frame");
+UNIT_TEST(unicast_fields)
+{
+  const frame802154_t *rx;
+  int hdr_len;
+
+  UNIT_TEST_BEGIN();
+
+  hdr_len = build_frame(&receiver, 42);
+  UNIT_TEST_ASSERT(hdr_len > 0);
+
+  receive_frame();
+  UNIT_TEST_ASSERT(framer_802154_get_rx_frame() == NULL);
+  UNIT_TEST_ASSERT(framer_802154.parse() == hdr_len);
+
+  rx = framer_802154_get_rx_frame();
+  UNIT_TEST_ASSERT(rx != NULL);
+  UNIT_TEST_ASSERT(packetbuf_attr(PACKETBUF_ATTR_MAC_HDR_LEN) == hdr_len);
+  UNIT_TEST_ASSERT(rx->fcf.frame_type == FRAME802154_DATAFRAME);
+  UNIT_TEST_ASSERT(rx->fcf.dest_addr_mode == FRAME802154_LONGADDRMODE);
+  UNIT_TEST_ASSERT(rx->fcf.src_addr_mode == FRAME802154_LONGADDRMODE);
+  UNIT_TEST_ASSERT(rx->seq == 42);
+  UNIT_TEST_ASSERT(rx->dest_pid == frame802154_get_pan_id());
+  UNIT_TEST_ASSERT(linkaddr_cmp((const linkaddr_t *)rx->dest_addr,
+                                &receiver));
+  UNIT_TEST_ASSERT(linkaddr_cmp((const linkaddr_t *)rx->src_addr,
+                                &linkaddr_node_addr));
+
+  /* The payload is the one in packetbuf, past the reduced header */
+  UNIT_TEST_ASSERT(rx->payload == packetbuf_dataptr());
+  UNIT_TEST_ASSERT(rx->payload_len == sizeof(payload) - 1);
+  UNIT_TEST_ASSERT(packetbuf_datalen() == sizeof(payload) - 1);
+  UNIT_TEST_ASSERT(memcmp(rx->payload, payload, sizeof(payload) - 1) == 0);
+
+  /* The attributes are derived from the same descriptor */
+  UNIT_TEST_ASSERT(packetbuf_attr(PACKETBUF_ATTR_MAC_SEQNO) == 42);
+  UNIT_TEST_ASSERT(linkaddr_cmp(packetbuf_addr(PACKETBUF_ADDR_RECEIVER),
+                                &receiver));
+  UNIT_TEST_ASSERT(linkaddr_cmp(packetbuf_addr(PACKETBUF_ADDR_SENDER),
+                                &linkaddr_node_addr));
+
+  /* Loading another packet invalidates the descriptor */
+  packetbuf_clear();
+  UNIT_TEST_ASSERT(framer_802154_get_rx_frame() == NULL);
+
+  UNIT_TEST_END();
+}
+/*---------------------------------------------------------------------------*/
+UNIT_TEST_REGISTER(broadcast_fields, "Descriptor of a parsed broadcast frame");
+UNIT_TEST(broadcast_fields)
+{
+  const frame802154_t *rx;
+  int hdr_len;
+
+  UNIT_TEST_BEGIN();
+
+  hdr_len = build_frame(&linkaddr_null, 7);
+  UNIT_TEST_ASSERT(hdr_len > 0);
+
+  receive_frame();
+  UNIT_TEST_ASSERT(framer_802154.parse() == hdr_len);
+
+  rx = framer_802154_get_rx_frame();
+  UNIT_TEST_ASSERT(rx != NULL);
+  UNIT_TEST_ASSERT(rx->fcf.dest_addr_mode == FRAME802154_SHORTADDRMODE);
+  UNIT_TEST_ASSERT(rx->fcf.ack_required == 0);
+  UNIT_TEST_ASSERT(frame802154_is_broadcast_addr(rx->fcf.dest_addr_mode,
+                                                 rx->dest_addr));
+  UNIT_TEST_ASSERT(linkaddr_cmp(packetbuf_addr(PACKETBUF_ADDR_RECEIVER),
+                                &linkaddr_null));
+  UNIT_TEST_ASSERT(rx->payload == packetbuf_dataptr());
+  UNIT_TEST_ASSERT(rx->payload_len == sizeof(payload) - 1);
+
+  UNIT_TEST_END();
+}
+/*---------------------------------------------------------------------------*/
+UNIT_TEST_REGISTER(handed_over, "Descriptor handed over by the MAC layer");
+UNIT_TEST(handed_over)
+{
+  frame802154_t frame;
+  const frame802154_t *rx;
+  int hdr_len;
+
+  UNIT_TEST_BEGIN();
+
+  UNIT_TEST_ASSERT(build_frame(&receiver, 99) > 0);
+
+  /* Parse into a local descriptor, as TSCH does before copying */
+  hdr_len = frame802154_parse(frame_buf, frame_len, &frame);
+  UNIT_TEST_ASSERT(hdr_len > 0);
+
+  receive_frame();
+  framer_802154_set_rx_frame(&frame, hdr_len);
+  UNIT_TEST_ASSERT(packetbuf_attr(PACKETBUF_ATTR_MAC_HDR_LEN) == hdr_len);
+
+  /*
+   * Overwrite the sequence number in packetbuf: parse() must take it
+   * from the handed-over descriptor instead of parsing it again.
+   */
+  ((uint8_t *)packetbuf_dataptr())[2] = 0;
+  UNIT_TEST_ASSERT(framer_802154.parse() == hdr_len);
+
+  rx = framer_802154_get_rx_frame();
+  UNIT_TEST_ASSERT(rx != NULL);
+  UNIT_TEST_ASSERT(rx->seq == 99);
+  UNIT_TEST_ASSERT(packetbuf_attr(PACKETBUF_ATTR_MAC_SEQNO) == 99);
+  UNIT_TEST_ASSERT(linkaddr_cmp((const linkaddr_t *)rx->dest_addr,
+                                &receiver));
+  UNIT_TEST_ASSERT(rx->payload == packetbuf_dataptr());
+  UNIT_TEST_ASSERT(rx->payload_len == sizeof(payload) - 1);
+
+  /* A header that does not fit in packetbuf is not taken over */
+  packetbuf_clear();
+  framer_802154_set_rx_frame(&frame, hdr_len);
+  UNIT_TEST_ASSERT(framer_802154_get_rx_frame() == NULL);
+
+  UNIT_TEST_END();
+}
+/*---------------------------------------------------------------------------*/
+UNIT_TEST_REGISTER(foreign_pan, "Frame for another PAN");
+UNIT_TEST(foreign_pan)
+{
+  uint16_t pan_id;
+
+  UNIT_TEST_BEGIN();
+
+  pan_id = frame802154_get_pan_id();
+  frame802154_set_pan_id(pan_id + 1);
+  UNIT_TEST_ASSERT(build_frame(&receiver, 1) > 0);
+  frame802154_set_pan_id(pan_id);
+
+  receive_frame();
+  UNIT_TEST_ASSERT(framer_802154.parse() == FRAMER_FAILED);
+
+  UNIT_TEST_END();
+}
+/*---------------------------------------------------------------------------*/
+PROCESS_THREAD(test_process, ev, data)
+{
+  PROCESS_BEGIN();
+
+  printf("Run unit-test\n");
+  printf("---\n");
+
+  UNIT_TEST_RUN(unicast_fields);
+  UNIT_TEST_RUN(broadcast_fields);
+  UNIT_TEST_RUN(handed_over);
+  UNIT_TEST_RUN(foreign_pan);
+
+  if(!UNIT_TEST_PASSED(unicast_fields) ||
+     !UNIT_TEST_PASSED(broadcast_fields) ||
+     !UNIT_TEST_PASSED(handed_over) ||
+     !UNIT_TEST_PASSED(foreign_pan)) {
+    printf("=check-me= FAILED\n");
+    printf("---\n");
+  }
+
+  printf("=check-me= DONE\n");
+  printf("---\n");
+
+  PROCESS_END();
+}
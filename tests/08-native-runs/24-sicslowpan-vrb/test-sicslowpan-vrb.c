@@ -0,0 +1,301 @@
+/*
+ * Copyright (c) 2026, agent <agent@local>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+ * OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+ * Tests the relaying of 6LoWPAN fragments through virtual reassembly
+ * buffers. A datagram is fragmented by sicslowpan output, and the
+ * fragments are fed back to sicslowpan input as if they came from a
+ * neighbor, for a destination reached through another neighbor. The
+ * frames sent in return are captured by a test MAC driver.
+ */
+
+#include "contiki.h"
+#include "unit-test.h"
+#include "net/ipv6/uip.h"
+#include "net/ipv6/uip-ds6.h"
+#include "net/ipv6/uip-ds6-nbr.h"
+#include "net/ipv6/uip-ds6-route.h"
+#include "net/ipv6/sicslowpan.h"
+#include "net/packetbuf.h"
+#include "net/mac/mac.h"
+
+#include <stdio.h>
+#include <string.h>
+
+PROCESS(test_process, "test");
+AUTOSTART_PROCESSES(&test_process);
+
+#define MAC_PAYLOAD   96
+#define DATAGRAM_SIZE 300
+#define MAX_FRAMES    8
+
+/* The neighbor the fragments come from, and the next hop */
+static const linkaddr_t prev_hop = { { 0x02, 0x00, 0x00, 0x00,
+                                       0x00, 0x00, 0x00, 0x01 } };
+static const linkaddr_t next_hop = { { 0x02, 0x00, 0x00, 0x00,
+                                       0x00, 0x00, 0x00, 0x03 } };
+
+static struct frame {
+  uint8_t data[PACKETBUF_SIZE];
+  uint16_t len;
+  linkaddr_t receiver;
+} sent[MAX_FRAMES], datagram[MAX_FRAMES];
+static int sent_count;
+static int datagram_count;
+/*---------------------------------------------------------------------------*/
+static void
+mac_init(void)
+{
+}
+/*---------------------------------------------------------------------------*/
+static void
+mac_send(mac_callback_t sent_callback, void *ptr)
+{
+  if(sent_count < MAX_FRAMES) {
+    memcpy(sent[sent_count].data, packetbuf_dataptr(), packetbuf_datalen());
+    sent[sent_count].len = packetbuf_datalen();
+    linkaddr_copy(&sent[sent_count].receiver,
+                  packetbuf_addr(PACKETBUF_ADDR_RECEIVER));
+  }
+  sent_count++;
+  mac_call_sent_callback(sent_callback, ptr, MAC_TX_OK, 1);
+}
+/*---------------------------------------------------------------------------*/
+static void
+mac_input(void)
+{
+}
+/*---------------------------------------------------------------------------*/
+static int
+mac_on(void)
+{
+  return 1;
+}
+/*---------------------------------------------------------------------------*/
+static int
+mac_off(void)
+{
+  return 1;
+}
+/*---------------------------------------------------------------------------*/
+static int
+mac_max_payload(void)
+{
+  return MAC_PAYLOAD;
+}
+/*---------------------------------------------------------------------------*/
+const struct mac_driver test_mac_driver = {
+  "test-mac",
+  mac_init,
+  mac_send,
+  mac_input,
+  mac_on,
+  mac_off,
+  mac_max_payload,
+};
+/*---------------------------------------------------------------------------*/
+/*
+ * Fragment a datagram from 2001:db8::1 to 2001:db8::3 and keep its
+ * fragments in datagram[]. proto is the next header of the IPv6
+ * header; everything after the IPv6 header is filler.
+ */
+static int
+make_datagram(uint8_t proto)
+{
+  int i;
+
+  uipbuf_clear();
+  memset(uip_buf, 0, DATAGRAM_SIZE);
+  UIP_IP_BUF->vtc = 0x60;
+  UIP_IP_BUF->len[0] = (DATAGRAM_SIZE - UIP_IPH_LEN) >> 8;
+  UIP_IP_BUF->len[1] = (DATAGRAM_SIZE - UIP_IPH_LEN) & 0xff;
+  UIP_IP_BUF->proto = proto;
+  UIP_IP_BUF->ttl = 64;
+  uip_ip6addr(&UIP_IP_BUF->srcipaddr, 0x2001, 0xdb8, 0, 0, 0, 0, 0, 1);
+  uip_ip6addr(&UIP_IP_BUF->destipaddr, 0x2001, 0xdb8, 0, 0, 0, 0, 0, 3);
+  for(i = UIP_IPH_LEN; i < DATAGRAM_SIZE; i++) {
+    uip_buf[i] = i;
+  }
+  if(proto == UIP_PROTO_UDP) {
+    UIP_UDP_BUF->udplen = UIP_HTONS(DATAGRAM_SIZE - UIP_IPH_LEN);
+  } else if(proto == UIP_PROTO_HBHO) {
+    /* A hop-by-hop header with a PadN option, followed by UDP */
+    uip_buf[UIP_IPH_LEN] = UIP_PROTO_UDP;
+    uip_buf[UIP_IPH_LEN + 1] = 0;
+    uip_buf[UIP_IPH_LEN + 2] = UIP_EXT_HDR_OPT_PADN;
+    uip_buf[UIP_IPH_LEN + 3] = 4;
+    memset(&uip_buf[UIP_IPH_LEN + 4], 0, 4);
+  }
+  uip_len = DATAGRAM_SIZE;
+
+  sent_count = 0;
+  sicslowpan_driver.output(&linkaddr_node_addr);
+  if(sent_count < 2 || sent_count > MAX_FRAMES) {
+    return 0;
+  }
+  memcpy(datagram, sent, sizeof(sent));
+  datagram_count = sent_count;
+  sent_count = 0;
+  return 1;
+}
+/*---------------------------------------------------------------------------*/
+/* Pass a frame to sicslowpan as if it was received from prev_hop */
+static void
+receive(const uint8_t *data, uint16_t len)
+{
+  packetbuf_clear();
+  packetbuf_copyfrom(data, len);
+  packetbuf_set_addr(PACKETBUF_ADDR_SENDER, &prev_hop);
+  packetbuf_set_addr(PACKETBUF_ADDR_RECEIVER, &linkaddr_node_addr);
+  sicslowpan_driver.input();
+}
+/*---------------------------------------------------------------------------*/
+static uint16_t
+frag_tag(const struct frame *f)
+{
+  return (f->data[2] << 8) | f->data[3];
+}
+/*---------------------------------------------------------------------------*/
+UNIT_TEST_REGISTER(relay, "Relay a fragmented datagram");
+UNIT_TEST(relay)
+{
+  uint16_t out_tag;
+  int payload_len;
+  int i;
+
+  UNIT_TEST_BEGIN();
+
+  UNIT_TEST_ASSERT(make_datagram(UIP_PROTO_UDP));
+  UNIT_TEST_ASSERT((datagram[0].data[0] & 0xf8) == SICSLOWPAN_DISPATCH_FRAG1);
+
+  for(i = 0; i < datagram_count; i++) {
+    receive(datagram[i].data, datagram[i].len);
+    UNIT_TEST_ASSERT(sent_count == i + 1);
+    UNIT_TEST_ASSERT(linkaddr_cmp(&sent[i].receiver, &next_hop));
+  }
+
+  /*
+   * The first fragment is recompressed with a new tag. Its hop limit
+   * drops from 64 to 63, which IPHC carries inline, and it keeps the
+   * datagram size and the payload after the IPv6 and UDP headers.
+   */
+  out_tag = frag_tag(&sent[0]);
+  UNIT_TEST_ASSERT(out_tag != frag_tag(&datagram[0]));
+  UNIT_TEST_ASSERT(memcmp(sent[0].data, datagram[0].data, 2) == 0);
+  UNIT_TEST_ASSERT(sent[0].len == datagram[0].len + 1);
+  payload_len = (datagram[1].data[4] << 3) - UIP_IPUDPH_LEN;
+  UNIT_TEST_ASSERT(payload_len > 0);
+  UNIT_TEST_ASSERT(memcmp(sent[0].data + sent[0].len - payload_len,
+                          datagram[0].data + datagram[0].len - payload_len,
+                          payload_len) == 0);
+
+  /* The following fragments are relayed as they are, with the new tag */
+  for(i = 1; i < datagram_count; i++) {
+    UNIT_TEST_ASSERT(sent[i].len == datagram[i].len);
+    UNIT_TEST_ASSERT(frag_tag(&sent[i]) == out_tag);
+    UNIT_TEST_ASSERT(memcmp(sent[i].data, datagram[i].data, 2) == 0);
+    UNIT_TEST_ASSERT(memcmp(sent[i].data + 4, datagram[i].data + 4,
+                            sent[i].len - 4) == 0);
+  }
+
+  UNIT_TEST_END();
+}
+/*---------------------------------------------------------------------------*/
+UNIT_TEST_REGISTER(out_of_bounds, "Fragment beyond the datagram size");
+UNIT_TEST(out_of_bounds)
+{
+  struct frame *bad;
+
+  UNIT_TEST_BEGIN();
+
+  UNIT_TEST_ASSERT(make_datagram(UIP_PROTO_UDP));
+  UNIT_TEST_ASSERT(datagram_count >= 3);
+
+  receive(datagram[0].data, datagram[0].len);
+  UNIT_TEST_ASSERT(sent_count == 1);
+
+  /* Move the last fragment so that it ends past the datagram */
+  bad = &datagram[datagram_count - 1];
+  bad->data[4] = DATAGRAM_SIZE >> 3;
+  receive(bad->data, bad->len);
+  UNIT_TEST_ASSERT(sent_count == 1);
+
+  /* The packet is no longer relayed */
+  receive(datagram[1].data, datagram[1].len);
+  UNIT_TEST_ASSERT(sent_count == 1);
+
+  UNIT_TEST_END();
+}
+/*---------------------------------------------------------------------------*/
+UNIT_TEST_REGISTER(extension_header, "Datagram with an extension header");
+UNIT_TEST(extension_header)
+{
+  UNIT_TEST_BEGIN();
+
+  /* Left to the IP layer, so the fragments are reassembled locally */
+  UNIT_TEST_ASSERT(make_datagram(UIP_PROTO_HBHO));
+  receive(datagram[0].data, datagram[0].len);
+  UNIT_TEST_ASSERT(sent_count == 0);
+
+  UNIT_TEST_END();
+}
+/*---------------------------------------------------------------------------*/
+PROCESS_THREAD(test_process, ev, data)
+{
+  uip_ipaddr_t router;
+
+  PROCESS_BEGIN();
+
+  printf("Run unit-test\n");
+  printf("---\n");
+
+  /* Route 2001:db8::3 through next_hop */
+  uip_ip6addr(&router, 0xfe80, 0, 0, 0, 0, 0, 0, 0);
+  uip_ds6_set_addr_iid(&router, (uip_lladdr_t *)&next_hop);
+  uip_ds6_nbr_add(&router, (uip_lladdr_t *)&next_hop, 1, NBR_REACHABLE,
+                  NBR_TABLE_REASON_UNDEFINED, NULL);
+  uip_ds6_defrt_add(&router, 0);
+
+  UNIT_TEST_RUN(relay);
+  UNIT_TEST_RUN(out_of_bounds);
+  UNIT_TEST_RUN(extension_header);
+
+  if(!UNIT_TEST_PASSED(relay) ||
+     !UNIT_TEST_PASSED(out_of_bounds) ||
+     !UNIT_TEST_PASSED(extension_header)) {
+    printf("=check-me= FAILED\n");
+    printf("---\n");
+  }
+
+  printf("=check-me= DONE\n");
+  printf("---\n");
+
+  PROCESS_END();
+}
@@ -0,0 +1,330 @@
+/*
+ * Copyright (c) 2026, agent <agent@local>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+ * OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+ * Tests IPHC context learning. UDP datagrams between two prefixes are
+ * sent through sicslowpan output until both prefixes get a context,
+ * and the frames compressed with these contexts are passed back to
+ * sicslowpan input. The frames are captured by a test MAC driver, and
+ * the decompressed datagrams are received on a UDP connection.
+ */
+
+#include "contiki.h"
+#include "unit-test.h"
+#include "net/ipv6/uip.h"
+#include "net/ipv6/uip-ds6.h"
+#include "net/ipv6/sicslowpan.h"
+#include "net/ipv6/simple-udp.h"
+#include "net/packetbuf.h"
+#include "net/mac/mac.h"
+
+#include <stdio.h>
+#include <string.h>
+
+PROCESS(test_process, "test");
+AUTOSTART_PROCESSES(&test_process);
+
+#define LOCAL_PORT  5678
+#define REMOTE_PORT 1234
+
+static const char message[] = "context";
+static const linkaddr_t neighbor = { { 0x02, 0x00, 0x00, 0x00,
+                                       0x00, 0x00, 0x00, 0x01 } };
+
+/* The remote prefix, and the prefix of this node */
+static const uint8_t remote_prefix[8] = { 0x20, 0x01, 0x0d, 0xb8,
+                                          0x00, 0x01, 0x00, 0x00 };
+static const uint8_t local_prefix[8] = { 0x20, 0x01, 0x0d, 0xb8,
+                                         0x00, 0x00, 0x00, 0x00 };
+static uip_ipaddr_t remote_addr;
+static uip_ipaddr_t local_addr;
+
+static uint8_t frame[PACKETBUF_SIZE];
+static uint16_t frame_len;
+static int sent_count;
+
+static struct simple_udp_connection conn;
+static uip_ipaddr_t received_src;
+static uip_ipaddr_t received_dest;
+static int received_count;
+/*---------------------------------------------------------------------------*/
+static void
+mac_init(void)
+{
+}
+/*---------------------------------------------------------------------------*/
+static void
+mac_send(mac_callback_t sent_callback, void *ptr)
+{
+  memcpy(frame, packetbuf_dataptr(), packetbuf_datalen());
+  frame_len = packetbuf_datalen();
+  sent_count++;
+  mac_call_sent_callback(sent_callback, ptr, MAC_TX_OK, 1);
+}
+/*---------------------------------------------------------------------------*/
+static void
+mac_input(void)
+{
+}
+/*---------------------------------------------------------------------------*/
+static int
+mac_on(void)
+{
+  return 1;
+}
+/*---------------------------------------------------------------------------*/
+static int
+mac_off(void)
+{
+  return 1;
+}
+/*---------------------------------------------------------------------------*/
+static int
+mac_max_payload(void)
+{
+  return 100;
+}
+/*---------------------------------------------------------------------------*/
+const struct mac_driver test_mac_driver = {
+  "test-mac",
+  mac_init,
+  mac_send,
+  mac_input,
+  mac_on,
+  mac_off,
+  mac_max_payload,
+};
+/*---------------------------------------------------------------------------*/
+static void
+udp_rx_callback(struct simple_udp_connection *c,
+                const uip_ipaddr_t *sender_addr, uint16_t sender_port,
+                const uip_ipaddr_t *receiver_addr, uint16_t receiver_port,
+                const uint8_t *data, uint16_t datalen)
+{
+  if(sender_port == REMOTE_PORT && datalen == sizeof(message) &&
+     memcmp(data, message, sizeof(message)) == 0) {
+    uip_ipaddr_copy(&received_src, sender_addr);
+    uip_ipaddr_copy(&received_dest, receiver_addr);
+    received_count++;
+  }
+}
+/*---------------------------------------------------------------------------*/
+/* Compress a datagram from remote_addr to local_addr into frame[] */
+static int
+send_datagram(void)
+{
+  uint16_t checksum;
+
+  uipbuf_clear();
+  memset(uip_buf, 0, UIP_IPUDPH_LEN);
+  UIP_IP_BUF->vtc = 0x60;
+  UIP_IP_BUF->len[1] = UIP_UDPH_LEN + sizeof(message);
+  UIP_IP_BUF->proto = UIP_PROTO_UDP;
+  UIP_IP_BUF->ttl = 64;
+  uip_ipaddr_copy(&UIP_IP_BUF->srcipaddr, &remote_addr);
+  uip_ipaddr_copy(&UIP_IP_BUF->destipaddr, &local_addr);
+  uip_len = UIP_IPUDPH_LEN + sizeof(message);
+  UIP_UDP_BUF->srcport = UIP_HTONS(REMOTE_PORT);
+  UIP_UDP_BUF->destport = UIP_HTONS(LOCAL_PORT);
+  UIP_UDP_BUF->udplen = UIP_HTONS(UIP_UDPH_LEN + sizeof(message));
+  memcpy(&uip_buf[UIP_IPUDPH_LEN], message, sizeof(message));
+  checksum = ~uip_udpchksum();
+  UIP_UDP_BUF->udpchksum = checksum == 0 ? 0xffff : checksum;
+
+  sent_count = 0;
+  sicslowpan_driver.output(&linkaddr_node_addr);
+  return sent_count == 1 ? frame_len : 0;
+}
+/*---------------------------------------------------------------------------*/
+/* Pass frame[] back to sicslowpan, and return 1 if it was delivered */
+static int
+receive_frame(void)
+{
+  received_count = 0;
+  packetbuf_clear();
+  packetbuf_copyfrom(frame, frame_len);
+  packetbuf_set_addr(PACKETBUF_ADDR_SENDER, &neighbor);
+  packetbuf_set_addr(PACKETBUF_ADDR_RECEIVER, &linkaddr_node_addr);
+  sicslowpan_driver.input();
+  return received_count == 1 &&
+    uip_ipaddr_cmp(&received_src, &remote_addr) &&
+    uip_ipaddr_cmp(&received_dest, &local_addr);
+}
+/*---------------------------------------------------------------------------*/
+static const struct sicslowpan_addr_context *
+find_context(const uint8_t *prefix)
+{
+  const struct sicslowpan_addr_context *context;
+  int i;
+
+  for(i = 1; i < 16; i++) {
+    context = sicslowpan_context_get(i);
+    if(context != NULL && memcmp(context->prefix, prefix, 8) == 0) {
+      return context;
+    }
+  }
+  return NULL;
+}
+/*---------------------------------------------------------------------------*/
+static uint8_t compressed[PACKETBUF_SIZE];
+static uint16_t compressed_len;
+static int inline_len;
+/*---------------------------------------------------------------------------*/
+UNIT_TEST_REGISTER(learn, "Learn contexts for inline prefixes");
+UNIT_TEST(learn)
+{
+  const struct sicslowpan_addr_context *context;
+  int i;
+
+  UNIT_TEST_BEGIN();
+
+  /*
+   * Both prefixes are carried inline until they reach the threshold.
+   * They are counted when a datagram is sent and when it is received.
+   */
+  inline_len = send_datagram();
+  UNIT_TEST_ASSERT(inline_len > 0);
+  UNIT_TEST_ASSERT(receive_frame());
+  for(i = 2; i < SICSLOWPAN_CONF_CONTEXT_LEARN_THRESHOLD; i++) {
+    UNIT_TEST_ASSERT(find_context(remote_prefix) == NULL);
+    UNIT_TEST_ASSERT(send_datagram() == inline_len);
+  }
+
+  context = find_context(remote_prefix);
+  UNIT_TEST_ASSERT(context != NULL);
+  UNIT_TEST_ASSERT(context->learned);
+  UNIT_TEST_ASSERT(context->length == 64);
+  UNIT_TEST_ASSERT(sicslowpan_context_lifetime(context) > 0 &&
+                   sicslowpan_context_lifetime(context) != 0xffff);
+  context = find_context(local_prefix);
+  UNIT_TEST_ASSERT(context != NULL);
+  UNIT_TEST_ASSERT(context->learned);
+
+  UNIT_TEST_END();
+}
+/*---------------------------------------------------------------------------*/
+UNIT_TEST_REGISTER(compress, "Compress and decompress with learned contexts");
+UNIT_TEST(compress)
+{
+  UNIT_TEST_BEGIN();
+
+  /*
+   * The 64-bit prefixes are elided and the context identifiers take
+   * one byte, so the frame is 15 bytes shorter.
+   */
+  UNIT_TEST_ASSERT(send_datagram() == inline_len - 15);
+  UNIT_TEST_ASSERT(find_context(remote_prefix)->compress);
+  UNIT_TEST_ASSERT(find_context(local_prefix)->compress);
+  memcpy(compressed, frame, frame_len);
+  compressed_len = frame_len;
+
+  UNIT_TEST_ASSERT(receive_frame());
+
+  UNIT_TEST_END();
+}
+/*---------------------------------------------------------------------------*/
+UNIT_TEST_REGISTER(advertised, "Context received without the C flag");
+UNIT_TEST(advertised)
+{
+  uint8_t remote_number;
+  uint8_t local_number;
+
+  UNIT_TEST_BEGIN();
+
+  /*
+   * Replace the learned contexts with the ones a neighbor would
+   * install from the 6CO options of an RA, before the compression
+   * delay has passed.
+   */
+  remote_number = find_context(remote_prefix)->number;
+  local_number = find_context(local_prefix)->number;
+  UNIT_TEST_ASSERT(sicslowpan_context_set(remote_number, NULL, 0, 0, 0));
+  UNIT_TEST_ASSERT(sicslowpan_context_set(local_number, NULL, 0, 0, 0));
+  UNIT_TEST_ASSERT(sicslowpan_context_get(remote_number) == NULL);
+  UNIT_TEST_ASSERT(sicslowpan_context_set(remote_number, remote_prefix,
+                                          64, 0, 10));
+  UNIT_TEST_ASSERT(sicslowpan_context_set(local_number, local_prefix,
+                                          64, 0, 10));
+  UNIT_TEST_ASSERT(!sicslowpan_context_get(remote_number)->learned);
+
+  /* Such contexts are only used for decompression */
+  memcpy(frame, compressed, compressed_len);
+  frame_len = compressed_len;
+  UNIT_TEST_ASSERT(receive_frame());
+  UNIT_TEST_ASSERT(send_datagram() == inline_len);
+
+  /* With the C flag set, they are used for compression too */
+  UNIT_TEST_ASSERT(sicslowpan_context_set(remote_number, remote_prefix,
+                                          64, 1, 10));
+  UNIT_TEST_ASSERT(sicslowpan_context_set(local_number, local_prefix,
+                                          64, 1, 10));
+  UNIT_TEST_ASSERT(send_datagram() == compressed_len);
+  UNIT_TEST_ASSERT(memcmp(frame, compressed, compressed_len) == 0);
+
+  UNIT_TEST_END();
+}
+/*---------------------------------------------------------------------------*/
+PROCESS_THREAD(test_process, ev, data)
+{
+  uip_ds6_addr_t *addr;
+
+  PROCESS_BEGIN();
+
+  printf("Run unit-test\n");
+  printf("---\n");
+
+  memset(&remote_addr, 0, sizeof(remote_addr));
+  memcpy(&remote_addr, remote_prefix, 8);
+  remote_addr.u8[15] = 1;
+  memset(&local_addr, 0, sizeof(local_addr));
+  memcpy(&local_addr, local_prefix, 8);
+  local_addr.u8[15] = 3;
+  addr = uip_ds6_addr_add(&local_addr, 0, ADDR_MANUAL);
+  if(addr != NULL) {
+    addr->state = ADDR_PREFERRED;
+  }
+  simple_udp_register(&conn, LOCAL_PORT, NULL, REMOTE_PORT, udp_rx_callback);
+
+  UNIT_TEST_RUN(learn);
+  UNIT_TEST_RUN(compress);
+  UNIT_TEST_RUN(advertised);
+
+  if(!UNIT_TEST_PASSED(learn) ||
+     !UNIT_TEST_PASSED(compress) ||
+     !UNIT_TEST_PASSED(advertised)) {
+    printf("=check-me= FAILED\n");
+    printf("---\n");
+  }
+
+  printf("=check-me= DONE\n");
+  printf("---\n");
+
+  PROCESS_END();
+}
@@ -0,0 +1,285 @@
+/*
+ * Copyright (c) 2026, agent <agent@local>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+ * OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+ * Tests CoAP observe notifications. Two clients observe a resource and
+ * one of them also observes another resource. Registrations are passed
+ * to coap_receive(), and the notifications sent by
+ * coap_notify_observers() are captured before they reach the network.
+ */
+
+#include "contiki.h"
+#include "unit-test.h"
+#include "coap-engine.h"
+#include "coap-observe.h"
+#include "net/ipv6/uip.h"
+#include "net/netstack.h"
+
+#include <stdio.h>
+#include <string.h>
+
+PROCESS(test_process, "test");
+AUTOSTART_PROCESSES(&test_process);
+
+#define MAX_SENT 4
+
+static coap_endpoint_t client[2];
+static uint16_t mid = 1;
+
+static struct {
+  uint8_t data[COAP_MAX_PACKET_SIZE];
+  uint16_t len;
+  uint8_t client;
+} sent[MAX_SENT];
+static coap_message_t sent_message[MAX_SENT];
+static int sent_count;
+
+static int value;
+static int value_calls;
+static int other_calls;
+/*---------------------------------------------------------------------------*/
+/* An observable resource, with a representation that changes on every
+   event */
+static void
+value_get_handler(coap_message_t *request, coap_message_t *response,
+                  uint8_t *buffer, uint16_t preferred_size, int32_t *offset)
+{
+  int len;
+
+  value_calls++;
+  len = snprintf((char *)buffer, preferred_size,
+                 "value %d, rendered for all observers", value);
+  coap_set_header_content_format(response, TEXT_PLAIN);
+  coap_set_payload(response, buffer, len);
+}
+static void value_event_handler(void);
+EVENT_RESOURCE(res_value, "obs", value_get_handler, NULL, NULL, NULL,
+               value_event_handler);
+static void
+value_event_handler(void)
+{
+  value++;
+  coap_notify_observers(&res_value);
+}
+/*---------------------------------------------------------------------------*/
+static void
+other_get_handler(coap_message_t *request, coap_message_t *response,
+                  uint8_t *buffer, uint16_t preferred_size, int32_t *offset)
+{
+  other_calls++;
+  coap_set_payload(response, "other", 5);
+}
+EVENT_RESOURCE(res_other, "obs", other_get_handler, NULL, NULL, NULL, NULL);
+/*---------------------------------------------------------------------------*/
+/* Keeps the CoAP messages sent to the clients */
+static enum netstack_ip_action
+capture_output(const linkaddr_t *localdest)
+{
+  uint16_t len;
+
+  if(UIP_IP_BUF->proto == UIP_PROTO_UDP && uip_len > UIP_IPUDPH_LEN
+     && sent_count < MAX_SENT) {
+    len = uip_len - UIP_IPUDPH_LEN;
+    memcpy(sent[sent_count].data, uip_buf + UIP_IPUDPH_LEN, len);
+    sent[sent_count].len = len;
+    sent[sent_count].client = UIP_IP_BUF->destipaddr.u8[15] - 1;
+    sent_count++;
+  }
+  return NETSTACK_IP_DROP;
+}
+static struct netstack_ip_packet_processor capture = {
+  .process_output = capture_output
+};
+/*---------------------------------------------------------------------------*/
+static int
+parse_sent(void)
+{
+  int i;
+
+  for(i = 0; i < sent_count; i++) {
+    if(coap_parse_message(&sent_message[i], sent[i].data, sent[i].len)
+       != NO_ERROR) {
+      return 0;
+    }
+  }
+  return 1;
+}
+/*---------------------------------------------------------------------------*/
+/* Registers client c as an observer of path, with a one-byte token */
+static int
+observe(int c, const char *path, uint8_t token)
+{
+  static uint8_t packet[COAP_MAX_PACKET_SIZE];
+  coap_message_t request[1];
+  size_t len;
+
+  coap_init_message(request, COAP_TYPE_NON, COAP_GET, mid++);
+  coap_set_token(request, &token, 1);
+  coap_set_header_uri_path(request, path);
+  coap_set_header_observe(request, 0);
+
+  len = coap_serialize_message(request, packet);
+  if(len == 0) {
+    return 0;
+  }
+  sent_count = 0;
+  coap_receive(&client[c], packet, len);
+  return sent_count == 1 && parse_sent() &&
+    sent_message[0].code == CONTENT_2_05 &&
+    coap_is_option(&sent_message[0], COAP_OPTION_OBSERVE);
+}
+/*---------------------------------------------------------------------------*/
+/* Finds the notification sent to client c with the given token */
+static coap_message_t *
+find_sent(int c, uint8_t token)
+{
+  int i;
+
+  for(i = 0; i < sent_count; i++) {
+    if(sent[i].client == c && sent_message[i].token_len == 1 &&
+       sent_message[i].token[0] == token) {
+      return &sent_message[i];
+    }
+  }
+  return NULL;
+}
+/*---------------------------------------------------------------------------*/
+/* Checks that a notification carries the current value */
+static int
+is_value_notification(coap_message_t *message)
+{
+  char expected[64];
+  int len;
+
+  len = snprintf(expected, sizeof(expected),
+                 "value %d, rendered for all observers", value);
+  return message != NULL && message->code == CONTENT_2_05 &&
+    coap_is_option(message, COAP_OPTION_OBSERVE) &&
+    message->payload_len == len &&
+    memcmp(message->payload, expected, len) == 0;
+}
+/*---------------------------------------------------------------------------*/
+UNIT_TEST_REGISTER(notify_all, "Notify all observers of a resource");
+UNIT_TEST(notify_all)
+{
+  coap_message_t *n0;
+  coap_message_t *n1;
+  uint32_t observe0;
+  int round;
+
+  UNIT_TEST_BEGIN();
+
+  UNIT_TEST_ASSERT(observe(0, "value", 0x10));
+  UNIT_TEST_ASSERT(observe(1, "value", 0x20));
+  UNIT_TEST_ASSERT(observe(0, "other", 0x30));
+  observe0 = sent_message[0].observe;
+
+  for(round = 0; round < 2; round++) {
+    value_calls = 0;
+    other_calls = 0;
+    sent_count = 0;
+    res_value.trigger();
+    UNIT_TEST_ASSERT(parse_sent());
+
+    /* The representation is rendered once, and sent to both observers
+       with their own token and MID */
+    UNIT_TEST_ASSERT(value_calls == 1);
+    UNIT_TEST_ASSERT(other_calls == 0);
+    UNIT_TEST_ASSERT(sent_count == 2);
+    n0 = find_sent(0, 0x10);
+    n1 = find_sent(1, 0x20);
+    UNIT_TEST_ASSERT(is_value_notification(n0));
+    UNIT_TEST_ASSERT(is_value_notification(n1));
+    UNIT_TEST_ASSERT(n0->mid != n1->mid);
+    UNIT_TEST_ASSERT(find_sent(0, 0x30) == NULL);
+  }
+
+  /* The observer of the other resource only gets its own notifications */
+  sent_count = 0;
+  coap_notify_observers(&res_other);
+  UNIT_TEST_ASSERT(parse_sent());
+  UNIT_TEST_ASSERT(other_calls == 1);
+  UNIT_TEST_ASSERT(value_calls == 1);
+  UNIT_TEST_ASSERT(sent_count == 1);
+  UNIT_TEST_ASSERT(find_sent(0, 0x30) != NULL);
+  UNIT_TEST_ASSERT(sent_message[0].payload_len == 5);
+  UNIT_TEST_ASSERT(sent_message[0].observe > observe0);
+
+  UNIT_TEST_END();
+}
+/*---------------------------------------------------------------------------*/
+UNIT_TEST_REGISTER(no_observer, "Notify a resource without observers");
+UNIT_TEST(no_observer)
+{
+  UNIT_TEST_BEGIN();
+
+  UNIT_TEST_ASSERT(coap_remove_observer_by_uri(&client[0], "value") == 1);
+  UNIT_TEST_ASSERT(coap_remove_observer_by_uri(&client[1], "value") == 1);
+  value_calls = 0;
+  sent_count = 0;
+  res_value.trigger();
+  UNIT_TEST_ASSERT(value_calls == 0);
+  UNIT_TEST_ASSERT(sent_count == 0);
+
+  UNIT_TEST_END();
+}
+/*---------------------------------------------------------------------------*/
+PROCESS_THREAD(test_process, ev, data)
+{
+  static const char *ep[2] = {
+    "coap://[fe80::1]:5683", "coap://[fe80::2]:5683"
+  };
+
+  PROCESS_BEGIN();
+
+  printf("Run unit-test\n");
+  printf("---\n");
+
+  coap_engine_init();
+  coap_activate_resource(&res_value, "value");
+  coap_activate_resource(&res_other, "other");
+  coap_endpoint_parse(ep[0], strlen(ep[0]), &client[0]);
+  coap_endpoint_parse(ep[1], strlen(ep[1]), &client[1]);
+  netstack_ip_packet_processor_add(&capture);
+
+  UNIT_TEST_RUN(notify_all);
+  UNIT_TEST_RUN(no_observer);
+
+  if(!UNIT_TEST_PASSED(notify_all) ||
+     !UNIT_TEST_PASSED(no_observer)) {
+    printf("=check-me= FAILED\n");
+    printf("---\n");
+  }
+
+  printf("=check-me= DONE\n");
+  printf("---\n");
+
+  PROCESS_END();
+}
@@ -0,0 +1,221 @@
+/*
+ * Copyright (c) 2026, agent <agent@local>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+ * OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+ * Tests the dispatching of CoAP requests to resources: exact paths,
+ * parent resources with sub-resources, overlapping parents, and
+ * resources activated again under another path. Requests are passed
+ * to coap_receive(), and the responses are captured before they reach
+ * the network.
+ */
+
+#include "contiki.h"
+#include "unit-test.h"
+#include "coap-engine.h"
+#include "net/ipv6/uip.h"
+#include "net/netstack.h"
+
+#include <stdio.h>
+#include <string.h>
+
+PROCESS(test_process, "test");
+AUTOSTART_PROCESSES(&test_process);
+
+static coap_endpoint_t client;
+static uint16_t mid = 1;
+
+/* The resource that handled the last request */
+static const char *handled_by;
+
+static uint8_t response_data[COAP_MAX_PACKET_SIZE];
+static uint16_t response_len;
+static coap_message_t response[1];
+
+/* Each resource records its name when it handles a request */
+#define DISPATCH_RESOURCE(name, type)                                   \
+  static void                                                           \
+  name##_handler(coap_message_t *request, coap_message_t *response,     \
+                 uint8_t *buffer, uint16_t preferred_size,              \
+                 int32_t *offset)                                       \
+  {                                                                     \
+    handled_by = #name;                                                 \
+  }                                                                     \
+  type(name, "", name##_handler, NULL, NULL, NULL)
+
+DISPATCH_RESOURCE(res_a, RESOURCE);
+DISPATCH_RESOURCE(res_a_b, RESOURCE);
+DISPATCH_RESOURCE(res_p, PARENT_RESOURCE);
+DISPATCH_RESOURCE(res_p_q, PARENT_RESOURCE);
+DISPATCH_RESOURCE(res_p_q_r, RESOURCE);
+DISPATCH_RESOURCE(res_s_t, PARENT_RESOURCE);
+DISPATCH_RESOURCE(res_s, PARENT_RESOURCE);
+DISPATCH_RESOURCE(res_moved, RESOURCE);
+/*---------------------------------------------------------------------------*/
+/* Keeps the response sent to the client */
+static enum netstack_ip_action
+capture_output(const linkaddr_t *localdest)
+{
+  if(UIP_IP_BUF->proto == UIP_PROTO_UDP && uip_len > UIP_IPUDPH_LEN) {
+    response_len = uip_len - UIP_IPUDPH_LEN;
+    memcpy(response_data, uip_buf + UIP_IPUDPH_LEN, response_len);
+  }
+  return NETSTACK_IP_DROP;
+}
+static struct netstack_ip_packet_processor capture = {
+  .process_output = capture_output
+};
+/*---------------------------------------------------------------------------*/
+/* Sends a request for path, and returns the name of the resource that
+   handled it, or NULL if none did */
+static const char *
+dispatch(coap_method_t method, const char *path)
+{
+  static uint8_t packet[COAP_MAX_PACKET_SIZE];
+  coap_message_t request[1];
+  size_t len;
+
+  coap_init_message(request, COAP_TYPE_NON, method, mid++);
+  coap_set_header_uri_path(request, path);
+  len = coap_serialize_message(request, packet);
+
+  handled_by = NULL;
+  response_len = 0;
+  coap_receive(&client, packet, len);
+  if(response_len == 0 ||
+     coap_parse_message(response, response_data, response_len) != NO_ERROR) {
+    response->code = 0;
+  }
+  return handled_by;
+}
+/*---------------------------------------------------------------------------*/
+static int
+dispatched_to(const char *path, const char *name)
+{
+  const char *r = dispatch(COAP_GET, path);
+
+  if(name == NULL) {
+    return r == NULL && response->code == NOT_FOUND_4_04;
+  }
+  return r != NULL && strcmp(r, name) == 0;
+}
+/*---------------------------------------------------------------------------*/
+UNIT_TEST_REGISTER(exact, "Resources without sub-resources");
+UNIT_TEST(exact)
+{
+  UNIT_TEST_BEGIN();
+
+  UNIT_TEST_ASSERT(dispatched_to("a", "res_a"));
+  UNIT_TEST_ASSERT(dispatched_to("a/b", "res_a_b"));
+  UNIT_TEST_ASSERT(dispatched_to("a/c", NULL));
+  UNIT_TEST_ASSERT(dispatched_to("ab", NULL));
+  UNIT_TEST_ASSERT(dispatched_to("a/b/c", NULL));
+  UNIT_TEST_ASSERT(dispatched_to("p/q/r", "res_p"));
+  UNIT_TEST_ASSERT(dispatched_to("", NULL));
+
+  /* A resource without a handler for the method */
+  UNIT_TEST_ASSERT(dispatch(COAP_POST, "a") == NULL);
+  UNIT_TEST_ASSERT(response->code >= BAD_REQUEST_4_00);
+
+  UNIT_TEST_END();
+}
+/*---------------------------------------------------------------------------*/
+UNIT_TEST_REGISTER(parents, "Resources with sub-resources");
+UNIT_TEST(parents)
+{
+  UNIT_TEST_BEGIN();
+
+  UNIT_TEST_ASSERT(dispatched_to("p", "res_p"));
+  UNIT_TEST_ASSERT(dispatched_to("p/x", "res_p"));
+  UNIT_TEST_ASSERT(dispatched_to("p/x/y/z", "res_p"));
+  UNIT_TEST_ASSERT(dispatched_to("px", NULL));
+
+  /* The resource activated first takes precedence, whether it is the
+     shorter or the longer match */
+  UNIT_TEST_ASSERT(dispatched_to("p/q", "res_p"));
+  UNIT_TEST_ASSERT(dispatched_to("p/q/x", "res_p"));
+  UNIT_TEST_ASSERT(dispatched_to("s/t", "res_s_t"));
+  UNIT_TEST_ASSERT(dispatched_to("s/t/x", "res_s_t"));
+  UNIT_TEST_ASSERT(dispatched_to("s/x", "res_s"));
+  UNIT_TEST_ASSERT(dispatched_to("s", "res_s"));
+
+  UNIT_TEST_END();
+}
+/*---------------------------------------------------------------------------*/
+UNIT_TEST_REGISTER(moved, "Resource activated under another path");
+UNIT_TEST(moved)
+{
+  UNIT_TEST_BEGIN();
+
+  UNIT_TEST_ASSERT(dispatched_to("old", "res_moved"));
+  coap_activate_resource(&res_moved, "new/path");
+  UNIT_TEST_ASSERT(dispatched_to("old", NULL));
+  UNIT_TEST_ASSERT(dispatched_to("new/path", "res_moved"));
+  UNIT_TEST_ASSERT(dispatched_to("new", NULL));
+
+  UNIT_TEST_END();
+}
+/*---------------------------------------------------------------------------*/
+PROCESS_THREAD(test_process, ev, data)
+{
+  static const char *ep = "coap://[fe80::1]:5683";
+
+  PROCESS_BEGIN();
+
+  printf("Run unit-test\n");
+  printf("---\n");
+
+  coap_engine_init();
+  coap_activate_resource(&res_a, "a");
+  coap_activate_resource(&res_a_b, "a/b");
+  coap_activate_resource(&res_p, "p");
+  coap_activate_resource(&res_p_q, "p/q");
+  coap_activate_resource(&res_p_q_r, "p/q/r");
+  coap_activate_resource(&res_s_t, "s/t");
+  coap_activate_resource(&res_s, "s");
+  coap_activate_resource(&res_moved, "old");
+  coap_endpoint_parse(ep, strlen(ep), &client);
+  netstack_ip_packet_processor_add(&capture);
+
+  UNIT_TEST_RUN(exact);
+  UNIT_TEST_RUN(parents);
+  UNIT_TEST_RUN(moved);
+
+  if(!UNIT_TEST_PASSED(exact) ||
+     !UNIT_TEST_PASSED(parents) ||
+     !UNIT_TEST_PASSED(moved)) {
+    printf("=check-me= FAILED\n");
+    printf("---\n");
+  }
+
+  printf("=check-me= DONE\n");
+  printf("---\n");
+
+  PROCESS_END();
+}
@@ -0,0 +1,355 @@
+/*
+ * Copyright (c) 2026, agent <agent@local>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+ * OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+ * Tests the object index of the LwM2M engine. Objects are registered
+ * out of order, then found by lookups, listed in the registration text
+ * (read whole and block-wise). The index and the cached registration
+ * text must follow objects that are added or removed.
+ */
+
+#include "contiki.h"
+#include "unit-test.h"
+#include "lwm2m-engine.h"
+#include "lwm2m-object.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+PROCESS(test_process, "test");
+AUTOSTART_PROCESSES(&test_process);
+
+/* With a smaller index the engine walks the object lists, which keep
+   the order of registration. */
+#if defined(LWM2M_ENGINE_CONF_INDEX_SIZE) && LWM2M_ENGINE_CONF_INDEX_SIZE < 7
+#define SORTED 0
+#else
+#define SORTED 1
+#endif
+
+#define MAX_LINKS 16
+#define RD_BLOCK_SIZE 64
+
+static const lwm2m_resource_id_t resources[] = { RO(5700) };
+
+static char rd[256];
+/*---------------------------------------------------------------------------*/
+static lwm2m_status_t
+instance_callback(lwm2m_object_instance_t *object, lwm2m_context_t *ctx)
+{
+  return LWM2M_STATUS_OK;
+}
+/*---------------------------------------------------------------------------*/
+#define SIMPLE_INSTANCE(object, instance) \
+  { NULL, object, instance, resources, 1, instance_callback, NULL }
+
+/* Registered in this order */
+static lwm2m_object_instance_t simple[] = {
+  SIMPLE_INSTANCE(3303, 1),
+  SIMPLE_INSTANCE(3, 0),
+  SIMPLE_INSTANCE(3303, 0),
+  SIMPLE_INSTANCE(1, 0),
+  SIMPLE_INSTANCE(3311, 0),
+  /* Gets the next free instance id, 2 */
+  SIMPLE_INSTANCE(3303, LWM2M_OBJECT_INSTANCE_NONE),
+  SIMPLE_INSTANCE(2, 0),
+};
+static lwm2m_object_instance_t duplicate = SIMPLE_INSTANCE(3303, 1);
+static lwm2m_object_instance_t shadowed = SIMPLE_INSTANCE(3200, 7);
+/*---------------------------------------------------------------------------*/
+/* A generic object with instances 0 and 5 */
+static lwm2m_object_instance_t generic_instances[] = {
+  SIMPLE_INSTANCE(3200, 0),
+  SIMPLE_INSTANCE(3200, 5),
+};
+#define GENERIC_INSTANCES \
+  (sizeof(generic_instances) / sizeof(generic_instances[0]))
+
+static lwm2m_object_instance_t *
+generic_get_first(lwm2m_status_t *status)
+{
+  return &generic_instances[0];
+}
+static lwm2m_object_instance_t *
+generic_get_next(lwm2m_object_instance_t *instance, lwm2m_status_t *status)
+{
+  if(instance < &generic_instances[GENERIC_INSTANCES - 1]) {
+    return instance + 1;
+  }
+  return NULL;
+}
+static lwm2m_object_instance_t *
+generic_get_by_id(uint16_t instance_id, lwm2m_status_t *status)
+{
+  unsigned i;
+
+  for(i = 0; i < GENERIC_INSTANCES; i++) {
+    if(generic_instances[i].instance_id == instance_id) {
+      return &generic_instances[i];
+    }
+  }
+  return NULL;
+}
+static const lwm2m_object_impl_t generic_impl = {
+  .object_id = 3200,
+  .get_first = generic_get_first,
+  .get_next = generic_get_next,
+  .get_by_id = generic_get_by_id,
+};
+static lwm2m_object_t generic = { NULL, &generic_impl };
+
+/* A generic object with the id of a simple object instance */
+static const lwm2m_object_impl_t clashing_impl = {
+  .object_id = 3,
+  .get_first = generic_get_first,
+  .get_next = generic_get_next,
+  .get_by_id = generic_get_by_id,
+};
+static lwm2m_object_t clashing = { NULL, &clashing_impl };
+/*---------------------------------------------------------------------------*/
+static int
+compare_links(const void *a, const void *b)
+{
+  return strcmp(*(char * const *)a, *(char * const *)b);
+}
+/*---------------------------------------------------------------------------*/
+static int
+split_links(char *text, char **links)
+{
+  char *link;
+  int count;
+
+  count = 0;
+  for(link = strtok(text, ","); link != NULL; link = strtok(NULL, ",")) {
+    if(count == MAX_LINKS) {
+      return -1;
+    }
+    links[count++] = link;
+  }
+  qsort(links, count, sizeof(links[0]), compare_links);
+  return count;
+}
+/*---------------------------------------------------------------------------*/
+/* Checks a list of links against the expected one. Without the index,
+   only the set of links is checked. */
+static int
+check_links(const char *text, size_t len, const char *expected)
+{
+  static char copy[2][256];
+  char *links[2][MAX_LINKS];
+  int count[2];
+  int i;
+
+  if(len >= sizeof(copy[0]) || strlen(expected) >= sizeof(copy[1])) {
+    return 0;
+  }
+  if(SORTED || len == 0) {
+    if(len != strlen(expected) || memcmp(text, expected, len) != 0) {
+      printf("Got \"%.*s\", expected \"%s\"\n", (int)len, text, expected);
+      return 0;
+    }
+    return 1;
+  }
+
+  memcpy(copy[0], text, len);
+  copy[0][len] = '\0';
+  strcpy(copy[1], expected);
+  count[0] = split_links(copy[0], links[0]);
+  count[1] = split_links(copy[1], links[1]);
+  if(count[0] != count[1]) {
+    printf("Got \"%.*s\", expected the links of \"%s\"\n",
+           (int)len, text, expected);
+    return 0;
+  }
+  for(i = 0; i < count[0]; i++) {
+    if(strcmp(links[0][i], links[1][i]) != 0) {
+      printf("Got \"%.*s\", expected the links of \"%s\"\n",
+             (int)len, text, expected);
+      return 0;
+    }
+  }
+  return 1;
+}
+/*---------------------------------------------------------------------------*/
+/* Reads the registration text in blocks of the given size */
+static int
+read_rd(int block_size)
+{
+  uint8_t block[RD_BLOCK_SIZE];
+  lwm2m_buffer_t outbuf;
+  size_t len;
+  int num;
+  int more;
+
+  len = 0;
+  num = 0;
+  do {
+    memset(&outbuf, 0, sizeof(outbuf));
+    outbuf.buffer = block;
+    outbuf.size = block_size;
+    more = lwm2m_engine_set_rd_data(&outbuf, num++);
+    if(outbuf.len > block_size || len + outbuf.len >= sizeof(rd)) {
+      return -1;
+    }
+    memcpy(&rd[len], block, outbuf.len);
+    len += outbuf.len;
+  } while(more);
+
+  return len;
+}
+/*---------------------------------------------------------------------------*/
+/* Checks the registration text, read whole and in small blocks */
+static int
+check_rd(const char *expected)
+{
+  int len;
+
+  len = read_rd(RD_BLOCK_SIZE);
+  if(len < 0 || !check_links(rd, len, expected)) {
+    return 0;
+  }
+  /* The second time, the simple object instances come from the cache */
+  len = read_rd(16);
+  return len >= 0 && check_links(rd, len, expected);
+}
+/*---------------------------------------------------------------------------*/
+UNIT_TEST_REGISTER(lookup, "Lookups after out-of-order registration");
+UNIT_TEST(lookup)
+{
+  int i;
+
+  UNIT_TEST_BEGIN();
+
+  for(i = 0; i < 6; i++) {
+    UNIT_TEST_ASSERT(lwm2m_engine_add_object(&simple[i]));
+  }
+  UNIT_TEST_ASSERT(simple[5].instance_id == 2);
+  UNIT_TEST_ASSERT(lwm2m_engine_add_generic_object(&generic));
+
+  /* Simple object instances */
+  UNIT_TEST_ASSERT(lwm2m_engine_has_instance(1, 0));
+  UNIT_TEST_ASSERT(lwm2m_engine_has_instance(3, 0));
+  UNIT_TEST_ASSERT(lwm2m_engine_has_instance(3303, 0));
+  UNIT_TEST_ASSERT(lwm2m_engine_has_instance(3303, 1));
+  UNIT_TEST_ASSERT(lwm2m_engine_has_instance(3303, 2));
+  UNIT_TEST_ASSERT(lwm2m_engine_has_instance(3311, 0));
+  UNIT_TEST_ASSERT(lwm2m_engine_has_instance(3303,
+                                             LWM2M_OBJECT_INSTANCE_NONE));
+  UNIT_TEST_ASSERT(!lwm2m_engine_has_instance(3303, 3));
+  UNIT_TEST_ASSERT(!lwm2m_engine_has_instance(3, 1));
+  UNIT_TEST_ASSERT(!lwm2m_engine_has_instance(2, 0));
+  UNIT_TEST_ASSERT(!lwm2m_engine_has_instance(0, 0));
+  UNIT_TEST_ASSERT(!lwm2m_engine_has_instance(3312, 0));
+  UNIT_TEST_ASSERT(!lwm2m_engine_has_instance(0xfffe, 0));
+
+  /* Instances of the generic object */
+  UNIT_TEST_ASSERT(lwm2m_engine_has_instance(3200, 0));
+  UNIT_TEST_ASSERT(lwm2m_engine_has_instance(3200, 5));
+  UNIT_TEST_ASSERT(lwm2m_engine_has_instance(3200,
+                                             LWM2M_OBJECT_INSTANCE_NONE));
+  UNIT_TEST_ASSERT(!lwm2m_engine_has_instance(3200, 1));
+
+  /* Registrations that clash with registered objects */
+  UNIT_TEST_ASSERT(!lwm2m_engine_add_object(&duplicate));
+  UNIT_TEST_ASSERT(!lwm2m_engine_add_object(&shadowed));
+  UNIT_TEST_ASSERT(!lwm2m_engine_add_generic_object(&clashing));
+  UNIT_TEST_ASSERT(!lwm2m_engine_add_generic_object(&generic));
+
+  UNIT_TEST_END();
+}
+/*---------------------------------------------------------------------------*/
+UNIT_TEST_REGISTER(registration, "Registration text");
+UNIT_TEST(registration)
+{
+  int i;
+
+  UNIT_TEST_BEGIN();
+
+  UNIT_TEST_ASSERT(check_rd("</1/0>,</3/0>,</3303/0>,</3303/1>,</3303/2>,"
+                            "</3311/0>,</3200/0>,</3200/5>"));
+
+  /* The text is built again after objects are removed or added */
+  lwm2m_engine_remove_object(&simple[1]);
+  UNIT_TEST_ASSERT(!lwm2m_engine_has_instance(3, 0));
+  UNIT_TEST_ASSERT(check_rd("</1/0>,</3303/0>,</3303/1>,</3303/2>,"
+                            "</3311/0>,</3200/0>,</3200/5>"));
+  UNIT_TEST_ASSERT(lwm2m_engine_add_object(&simple[6]));
+  UNIT_TEST_ASSERT(lwm2m_engine_has_instance(2, 0));
+  UNIT_TEST_ASSERT(check_rd("</1/0>,</2/0>,</3303/0>,</3303/1>,</3303/2>,"
+                            "</3311/0>,</3200/0>,</3200/5>"));
+
+  lwm2m_engine_remove_generic_object(&generic);
+  UNIT_TEST_ASSERT(!lwm2m_engine_has_instance(3200, 0));
+  UNIT_TEST_ASSERT(lwm2m_engine_add_object(&shadowed));
+  UNIT_TEST_ASSERT(check_rd("</1/0>,</2/0>,</3200/7>,</3303/0>,</3303/1>,"
+                            "</3303/2>,</3311/0>"));
+
+  /* Only the generic object */
+  lwm2m_engine_remove_object(&shadowed);
+  for(i = 0; i < sizeof(simple) / sizeof(simple[0]); i++) {
+    if(i != 1) {
+      lwm2m_engine_remove_object(&simple[i]);
+    }
+  }
+  UNIT_TEST_ASSERT(lwm2m_engine_add_generic_object(&generic));
+  UNIT_TEST_ASSERT(!lwm2m_engine_has_instance(3303, 0));
+  UNIT_TEST_ASSERT(check_rd("</3200/0>,</3200/5>"));
+
+  /* No objects at all */
+  lwm2m_engine_remove_generic_object(&generic);
+  UNIT_TEST_ASSERT(read_rd(RD_BLOCK_SIZE) == 0);
+
+  UNIT_TEST_END();
+}
+/*---------------------------------------------------------------------------*/
+PROCESS_THREAD(test_process, ev, data)
+{
+  PROCESS_BEGIN();
+
+  printf("Run unit-test\n");
+  printf("---\n");
+
+  lwm2m_engine_init();
+
+  UNIT_TEST_RUN(lookup);
+  UNIT_TEST_RUN(registration);
+
+  if(!UNIT_TEST_PASSED(lookup) || !UNIT_TEST_PASSED(registration)) {
+    printf("=check-me= FAILED\n");
+    printf("---\n");
+  }
+
+  printf("=check-me= DONE\n");
+  printf("---\n");
+
+  PROCESS_END();
+}
+/*---------------------------------------------------------------------------*/
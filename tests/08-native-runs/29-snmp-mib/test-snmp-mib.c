@@ -0,0 +1,314 @@
+/*
+ * Copyright (c) 2026, agent <agent@local>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+ * OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+ * Tests the SNMP MIB and the request handling of the SNMP engine.
+ * Resources are added out of OID order, then found directly and by
+ * GETNEXT, and walked by GETBULK requests that ask for more varbinds
+ * than a response can hold. The requests are encoded with the message
+ * encoder of the SNMP module and passed to snmp_engine().
+ */
+
+#include "contiki.h"
+#include "unit-test.h"
+#include "snmp-api.h"
+#include "snmp-ber.h"
+#include "snmp-engine.h"
+#include "snmp-message.h"
+
+#include <stdio.h>
+#include <string.h>
+
+PROCESS(test_process, "test");
+AUTOSTART_PROCESSES(&test_process);
+
+static void
+resource_handler(snmp_varbind_t *varbind, snmp_oid_t *oid)
+{
+  memcpy(&varbind->oid, oid, sizeof(snmp_oid_t));
+  varbind->value_type = BER_DATA_TYPE_INTEGER;
+  varbind->value.integer = oid->length;
+}
+
+MIB_RESOURCE(sys_group, resource_handler, 1, 3, 6, 1, 2, 1, 1);
+MIB_RESOURCE(sys_descr, resource_handler, 1, 3, 6, 1, 2, 1, 1, 1, 0);
+MIB_RESOURCE(sys_object_id, resource_handler, 1, 3, 6, 1, 2, 1, 1, 2, 0);
+MIB_RESOURCE(sys_up_time, resource_handler, 1, 3, 6, 1, 2, 1, 1, 3, 0);
+MIB_RESOURCE(sys_contact, resource_handler, 1, 3, 6, 1, 2, 1, 1, 4, 0);
+MIB_RESOURCE(sys_name, resource_handler, 1, 3, 6, 1, 2, 1, 1, 5, 0);
+MIB_RESOURCE(sys_location, resource_handler, 1, 3, 6, 1, 2, 1, 1, 6, 0);
+MIB_RESOURCE(sys_services, resource_handler, 1, 3, 6, 1, 2, 1, 1, 7, 0);
+MIB_RESOURCE(if_number, resource_handler, 1, 3, 6, 1, 2, 1, 2, 1, 0);
+
+/* In OID order */
+static snmp_mib_resource_t *const sorted[] = {
+  &sys_group, &sys_descr, &sys_object_id, &sys_up_time, &sys_contact,
+  &sys_name, &sys_location, &sys_services, &if_number
+};
+#define RESOURCES (sizeof(sorted) / sizeof(sorted[0]))
+
+/* In the order they are added */
+static snmp_mib_resource_t *const added[] = {
+  &sys_up_time, &sys_descr, &if_number, &sys_services, &sys_object_id,
+  &sys_name, &sys_group, &sys_contact, &sys_location
+};
+
+static uint8_t request[256];
+static uint8_t reply[256];
+static snmp_packet_t packet;
+static snmp_header_t header;
+static snmp_varbind_t varbinds[SNMP_MAX_NR_VALUES];
+static uint32_t request_id;
+/*---------------------------------------------------------------------------*/
+static int
+same_oid(const snmp_oid_t *oid1, const snmp_oid_t *oid2)
+{
+  return oid1->length == oid2->length &&
+         !memcmp(oid1->data, oid2->data, oid1->length * sizeof(uint32_t));
+}
+/*---------------------------------------------------------------------------*/
+/* Encodes a request for the given OIDs and lets the engine answer it */
+static int
+send_request(uint8_t pdu_type, uint32_t version,
+             snmp_oid_t *const oids[], int count,
+             uint32_t non_repeaters, uint32_t max_repetitions)
+{
+  int i;
+
+  memset(&header, 0, sizeof(header));
+  memset(varbinds, 0, sizeof(varbinds));
+  header.version = version;
+  header.community.community = SNMP_COMMUNITY;
+  header.community.length = strlen(SNMP_COMMUNITY);
+  header.pdu_type = pdu_type;
+  header.request_id = ++request_id;
+  header.non_repeaters = non_repeaters;
+  header.max_repetitions = max_repetitions;
+  for(i = 0; i < count; i++) {
+    memcpy(&varbinds[i].oid, oids[i], sizeof(snmp_oid_t));
+    varbinds[i].value_type = BER_DATA_TYPE_NULL;
+  }
+
+  /* The encoder writes backwards from the end of the buffer */
+  packet.out = &request[sizeof(request) - 1];
+  packet.used = 0;
+  packet.max = sizeof(request);
+  if(!snmp_message_encode(&packet, &header, varbinds)) {
+    return 0;
+  }
+
+  packet.in = packet.out;
+  packet.out = &reply[sizeof(reply) - 1];
+  packet.max = sizeof(reply);
+  return snmp_engine(&packet);
+}
+/*---------------------------------------------------------------------------*/
+/* Decodes the response and returns the number of varbinds in it */
+static int
+read_response(void)
+{
+  int count;
+
+  packet.in = packet.out;
+  memset(&header, 0, sizeof(header));
+  memset(varbinds, 0, sizeof(varbinds));
+  if(!snmp_message_decode(&packet, &header, varbinds) ||
+     header.pdu_type != BER_DATA_TYPE_PDU_GET_RESPONSE ||
+     header.request_id != request_id) {
+    return -1;
+  }
+
+  count = 0;
+  while(count < SNMP_MAX_NR_VALUES &&
+        varbinds[count].value_type != BER_DATA_TYPE_EOC) {
+    count++;
+  }
+  return count;
+}
+/*---------------------------------------------------------------------------*/
+/* Checks that the varbinds of the response hold the resources from the
+   given position in OID order */
+static int
+check_varbinds(int first, int count)
+{
+  int i;
+
+  for(i = 0; i < count; i++) {
+    if(first + i >= RESOURCES ||
+       varbinds[i].value_type != BER_DATA_TYPE_INTEGER ||
+       !same_oid(&varbinds[i].oid, &sorted[first + i]->oid)) {
+      printf("Unexpected varbind %d\n", i);
+      return 0;
+    }
+  }
+  return 1;
+}
+/*---------------------------------------------------------------------------*/
+/* The message decoder does not read endOfMibView, which always comes
+   last in the response: check its encoding at the end of the packet */
+static int
+ends_with_end_of_mib_view(void)
+{
+  return packet.used >= 2 &&
+         reply[sizeof(reply) - 2] == BER_DATA_TYPE_END_OF_MIB_VIEW &&
+         reply[sizeof(reply) - 1] == 0;
+}
+/*---------------------------------------------------------------------------*/
+UNIT_TEST_REGISTER(mib, "MIB lookups");
+UNIT_TEST(mib)
+{
+  OID(root, 1);
+  OID(unknown, 1, 3, 6, 1, 2, 1, 1, 8, 0);
+  OID(mib_2, 1, 3, 6, 1, 2, 1);
+  OID(before_up_time, 1, 3, 6, 1, 2, 1, 1, 3);
+  OID(after_system, 1, 3, 6, 1, 2, 1, 1, 9);
+  snmp_mib_resource_t *resource;
+  int i;
+
+  UNIT_TEST_BEGIN();
+
+  for(i = 0; i < RESOURCES; i++) {
+    snmp_api_add_resource(added[i]);
+  }
+
+  /* Walk the MIB */
+  resource = snmp_mib_find_next(&root);
+  for(i = 0; i < RESOURCES; i++) {
+    UNIT_TEST_ASSERT(resource == sorted[i]);
+    resource = snmp_mib_find_next(&resource->oid);
+  }
+  UNIT_TEST_ASSERT(resource == NULL);
+
+  for(i = 0; i < RESOURCES; i++) {
+    UNIT_TEST_ASSERT(snmp_mib_find(&sorted[i]->oid) == sorted[i]);
+  }
+  UNIT_TEST_ASSERT(snmp_mib_find(&unknown) == NULL);
+  UNIT_TEST_ASSERT(snmp_mib_find(&mib_2) == NULL);
+  UNIT_TEST_ASSERT(snmp_mib_find(&root) == NULL);
+
+  /* OIDs between resources */
+  UNIT_TEST_ASSERT(snmp_mib_find_next(&mib_2) == &sys_group);
+  UNIT_TEST_ASSERT(snmp_mib_find_next(&before_up_time) == &sys_up_time);
+  UNIT_TEST_ASSERT(snmp_mib_find_next(&unknown) == &if_number);
+  UNIT_TEST_ASSERT(snmp_mib_find_next(&after_system) == &if_number);
+  UNIT_TEST_ASSERT(snmp_mib_find_next(&if_number.oid) == NULL);
+
+  UNIT_TEST_END();
+}
+/*---------------------------------------------------------------------------*/
+UNIT_TEST_REGISTER(get_next, "GETNEXT requests");
+UNIT_TEST(get_next)
+{
+  snmp_oid_t *const oids[] = { &sys_up_time.oid, &sys_services.oid };
+  snmp_oid_t *const last[] = { &if_number.oid };
+
+  UNIT_TEST_BEGIN();
+
+  UNIT_TEST_ASSERT(send_request(BER_DATA_TYPE_PDU_GET_NEXT_REQUEST,
+                                SNMP_VERSION_2C, oids, 2, 0, 0));
+  UNIT_TEST_ASSERT(read_response() == 2);
+  UNIT_TEST_ASSERT(header.error_status == 0);
+  UNIT_TEST_ASSERT(same_oid(&varbinds[0].oid, &sys_contact.oid));
+  UNIT_TEST_ASSERT(same_oid(&varbinds[1].oid, &if_number.oid));
+
+  /* Past the end of the MIB */
+  UNIT_TEST_ASSERT(send_request(BER_DATA_TYPE_PDU_GET_NEXT_REQUEST,
+                                SNMP_VERSION_2C, last, 1, 0, 0));
+  UNIT_TEST_ASSERT(ends_with_end_of_mib_view());
+
+  UNIT_TEST_ASSERT(send_request(BER_DATA_TYPE_PDU_GET_NEXT_REQUEST,
+                                SNMP_VERSION_1, last, 1, 0, 0));
+  UNIT_TEST_ASSERT(read_response() == 1);
+  UNIT_TEST_ASSERT(header.error_status == SNMP_STATUS_NO_SUCH_NAME);
+  UNIT_TEST_ASSERT(header.error_index == 1);
+
+  UNIT_TEST_END();
+}
+/*---------------------------------------------------------------------------*/
+UNIT_TEST_REGISTER(get_bulk, "GETBULK requests");
+UNIT_TEST(get_bulk)
+{
+  OID(mib_2, 1, 3, 6, 1, 2, 1);
+  snmp_oid_t *const walk[] = { &mib_2 };
+  snmp_oid_t *const mixed[] = { &sys_group.oid, &sys_name.oid };
+  snmp_oid_t *const end[] = { &sys_services.oid };
+  int count;
+
+  UNIT_TEST_BEGIN();
+
+  /* More repetitions than fit: the response holds the ones that do */
+  UNIT_TEST_ASSERT(send_request(BER_DATA_TYPE_PDU_GET_BULK,
+                                SNMP_VERSION_2C, walk, 1,
+                                0, SNMP_MAX_NR_VALUES + 2));
+  UNIT_TEST_ASSERT(read_response() == SNMP_MAX_NR_VALUES);
+  UNIT_TEST_ASSERT(check_varbinds(0, SNMP_MAX_NR_VALUES));
+
+  /* One non-repeater, then the repetitions that fit */
+  UNIT_TEST_ASSERT(send_request(BER_DATA_TYPE_PDU_GET_BULK,
+                                SNMP_VERSION_2C, mixed, 2, 1, 3));
+  count = read_response();
+  UNIT_TEST_ASSERT(count == MIN(SNMP_MAX_NR_VALUES, 4));
+  UNIT_TEST_ASSERT(same_oid(&varbinds[0].oid, &sys_descr.oid));
+  memmove(&varbinds[0], &varbinds[1], (count - 1) * sizeof(varbinds[0]));
+  UNIT_TEST_ASSERT(check_varbinds(6, count - 1));
+
+  /* The walk stops at the end of the MIB */
+  UNIT_TEST_ASSERT(send_request(BER_DATA_TYPE_PDU_GET_BULK,
+                                SNMP_VERSION_2C, end, 1, 0, 3));
+  UNIT_TEST_ASSERT(ends_with_end_of_mib_view());
+
+  UNIT_TEST_END();
+}
+/*---------------------------------------------------------------------------*/
+PROCESS_THREAD(test_process, ev, data)
+{
+  PROCESS_BEGIN();
+
+  printf("Run unit-test\n");
+  printf("---\n");
+
+  snmp_mib_init();
+
+  UNIT_TEST_RUN(mib);
+  UNIT_TEST_RUN(get_next);
+  UNIT_TEST_RUN(get_bulk);
+
+  if(!UNIT_TEST_PASSED(mib) || !UNIT_TEST_PASSED(get_next) ||
+     !UNIT_TEST_PASSED(get_bulk)) {
+    printf("=check-me= FAILED\n");
+    printf("---\n");
+  }
+
+  printf("=check-me= DONE\n");
+  printf("---\n");
+
+  PROCESS_END();
+}
+/*---------------------------------------------------------------------------*/
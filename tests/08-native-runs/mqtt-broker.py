@@ -0,0 +1,210 @@
+#!/usr/bin/env python3
+"""Scripted MQTT broker for the native MQTT client tests.
+
+Usage: mqtt-broker.py <script> <port>
+
+The broker plays the broker side of one of the scripts below and checks
+every PUBLISH it receives. It speaks MQTT 3.1, 3.1.1 and 5, following the
+protocol level of the CONNECT packet. It prints "broker OK" when the whole
+script has run, and exits with an error as soon as the client deviates
+from it.
+"""
+
+import socket
+import sys
+import time
+
+TIMEOUT = 60
+
+PAYLOAD_LEN = 80
+
+CBOR = bytes([0x9f, 0x00, 0x17, 0x18, 0x18, 0x20, 0x38, 0x18, 0x18, 0xff,
+              0x19, 0x01, 0x00, 0x1a, 0x00, 0x01, 0x00, 0x00,
+              0x3a, 0x00, 0x01, 0x86, 0x9f, 0xff])
+
+
+def fail(msg):
+    print("broker FAILED: " + msg, flush=True)
+    sys.exit(1)
+
+
+def payload(idx):
+    return bytes([ord('0') + idx] +
+                 [ord('a') + (idx + j) % 26 for j in range(1, PAYLOAD_LEN)])
+
+
+class Client:
+    def __init__(self, sock):
+        self.sock = sock
+        self.sock.settimeout(TIMEOUT)
+        self.buf = b''
+        self.level = 3
+
+    def read(self, n):
+        while len(self.buf) < n:
+            data = self.sock.recv(4096)
+            if not data:
+                fail("connection closed by the client")
+            self.buf += data
+        data, self.buf = self.buf[:n], self.buf[n:]
+        return data
+
+    @staticmethod
+    def varint(data, pos):
+        value = 0
+        shift = 0
+        while True:
+            b = data[pos]
+            pos += 1
+            value |= (b & 0x7f) << shift
+            shift += 7
+            if not b & 0x80:
+                return value, pos
+
+    def packet(self):
+        """Read the next packet, answering PINGREQs on the way."""
+        while True:
+            fhdr = self.read(1)[0]
+            length = 0
+            shift = 0
+            while True:
+                b = self.read(1)[0]
+                length |= (b & 0x7f) << shift
+                shift += 7
+                if not b & 0x80:
+                    break
+            body = self.read(length)
+            if fhdr >> 4 == 12:
+                self.sock.sendall(bytes([0xd0, 0x00]))
+                continue
+            return fhdr, body
+
+    def connect(self):
+        fhdr, body = self.packet()
+        if fhdr >> 4 != 1:
+            fail("expected CONNECT, got 0x%02x" % fhdr)
+        # The protocol level follows the protocol name
+        self.level = body[2 + ((body[0] << 8) | body[1])]
+        if self.level == 5:
+            self.sock.sendall(bytes([0x20, 0x03, 0x00, 0x00, 0x00]))
+        else:
+            self.sock.sendall(bytes([0x20, 0x02, 0x00, 0x00]))
+        print("CONNECT level %d" % self.level, flush=True)
+
+    def publish(self, topic, qos, data, dup=False):
+        fhdr, body = self.packet()
+        if fhdr >> 4 != 3:
+            fail("expected PUBLISH, got 0x%02x" % fhdr)
+        if (fhdr >> 1) & 3 != qos:
+            fail("expected QoS %d, got 0x%02x" % (qos, fhdr))
+        if bool(fhdr & 0x08) != dup:
+            fail("expected DUP %d, got 0x%02x" % (dup, fhdr))
+        tlen = (body[0] << 8) | body[1]
+        pos = 2 + tlen
+        if body[2:pos] != topic.encode():
+            fail("unexpected topic %r" % body[2:pos])
+        mid = None
+        if qos > 0:
+            mid = (body[pos] << 8) | body[pos + 1]
+            pos += 2
+        if self.level == 5:
+            plen, pos = self.varint(body, pos)
+            pos += plen
+        if body[pos:] != data:
+            fail("unexpected payload on %s: %r" % (topic, body[pos:]))
+        print("PUBLISH %s qos %d mid %s%s: %r" %
+              (topic, qos, mid, " dup" if dup else "", data), flush=True)
+        return mid
+
+    def puback(self, mid):
+        self.sock.sendall(bytes([0x40, 0x02, mid >> 8, mid & 0xff]))
+
+    def disconnect(self):
+        fhdr, _ = self.packet()
+        if fhdr != 0xe0:
+            fail("expected DISCONNECT, got 0x%02x" % fhdr)
+        print("DISCONNECT", flush=True)
+
+
+def inflight(srv):
+    """19-mqtt-inflight: the in-flight window of QoS 0 and 1 publishes."""
+    # First connection: fill the window, ack out of order, then drop the
+    # connection with two publishes unacknowledged.
+    sock, _ = srv.accept()
+    c = Client(sock)
+    c.connect()
+    mids = [c.publish("test/data", 1, payload(i)) for i in range(4)]
+    c.puback(mids[2])
+    c.puback(mids[0])
+    c.publish("test/next", 0, b"go")
+    c.puback(mids[1])
+    c.puback(mids[3])
+    c.publish("test/data", 0, payload(4))
+    c.publish("test/data", 0, payload(5))
+    c.publish("test/data", 1, payload(6))
+    c.publish("test/data", 1, payload(7))
+    sock.close()
+
+    # Second connection: the client starts over with an empty window.
+    sock, _ = srv.accept()
+    c = Client(sock)
+    c.connect()
+    c.puback(c.publish("test/data", 1, payload(8)))
+
+    # Leave two publishes unacknowledged: the client must send them again
+    # with the same IDs and DUP set, then give up on the second one.
+    mids = [c.publish("test/data", 1, payload(i)) for i in (9, 10)]
+    if c.publish("test/data", 1, payload(9), True) != mids[0]:
+        fail("retransmission with another message ID")
+    c.puback(mids[0])
+    if c.publish("test/data", 1, payload(10), True) != mids[1]:
+        fail("retransmission with another message ID")
+    c.disconnect()
+    sock.close()
+
+
+def batch(srv):
+    """20-mqtt-batch: the payloads of batched publishes, in order."""
+    sock, _ = srv.accept()
+    c = Client(sock)
+    c.connect()
+
+    c.publish("test/json", 0, b"[1,2,3,4,5,6,7]")
+    c.publish("test/json", 0, b"[8]")
+
+    # The client must hold its next message back until this PUBACK
+    mid = c.publish("test/cbor", 1, CBOR)
+    time.sleep(2)
+    c.puback(mid)
+    c.puback(c.publish("test/cbor", 1, bytes([0x9f, 0x01, 0xff])))
+
+    c.publish("test/raw", 0, b"abcdefg")
+    c.publish("test/raw", 0, b"hi")
+
+    c.disconnect()
+    sock.close()
+
+
+SCRIPTS = {
+    "inflight": inflight,
+    "batch": batch,
+}
+
+
+def main():
+    if len(sys.argv) != 3 or sys.argv[1] not in SCRIPTS:
+        fail("usage: %s {%s} <port>" % (sys.argv[0], "|".join(SCRIPTS)))
+
+    srv = socket.socket(socket.AF_INET6, socket.SOCK_STREAM)
+    srv.setsockopt(socket.SOL_SOCKET, socket.SO_REUSEADDR, 1)
+    srv.bind(('::', int(sys.argv[2])))
+    srv.listen(1)
+    srv.settimeout(TIMEOUT)
+
+    SCRIPTS[sys.argv[1]](srv)
+
+    print("broker OK", flush=True)
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,5 @@
+#!/bin/bash
+
+export TEST_PROTOCOL=ieee802154
+
+source packet-injector.sh
@@ -0,0 +1,19 @@
+#!/bin/bash
+
+# Replay the 802.15.4 corpus through framer, sicslowpan and uIP
+# repeatedly and report the receive-path throughput. CI runs a few
+# rounds only, as a smoke test of the benchmark mode; set
+# TEST_BENCHMARK_ROUNDS for a real measurement.
+export TEST_PROTOCOL=ieee802154
+export TEST_BENCHMARK_ROUNDS=${TEST_BENCHMARK_ROUNDS:-100}
+BENCHMARK_TIMEOUT=${BENCHMARK_TIMEOUT:-60s}
+
+CODE_DIR=packet-injector
+CODE=packet-injector
+
+timeout -k 1s $BENCHMARK_TIMEOUT "$CODE_DIR/$CODE.native" $CODE_DIR/$TEST_PROTOCOL-data/*
+if [ $? -ne 0 ]; then
+  printf "%-32s TEST FAIL\n" "$CODE-$TEST_PROTOCOL-benchmark"
+  exit 1
+fi
+printf "%-32s TEST OK\n" "$CODE-$TEST_PROTOCOL-benchmark"
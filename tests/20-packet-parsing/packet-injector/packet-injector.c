@@ -44,7 +44,12 @@
 #include <sys/stat.h>
 #include <errno.h>
 #include <fcntl.h>
+#include <time.h>
 #include <unistd.h>
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define HAVE_CYCLE_COUNTER 1
+#endif
 
 /* Contiki-NG headers. */
 #include <dev/ble-hal.h>
@@ -53,6 +58,7 @@
 #include <net/mac/ble/ble-l2cap.h>
 #include <net/netstack.h>
 #include <net/packetbuf.h>
+#include <net/mac/framer/framer.h>
 #include <net/ipv6/sicslowpan.h>
 #include <net/app-layer/coap/coap.h>
 #include <net/app-layer/coap/coap-engine.h>
@@ -68,11 +74,37 @@
 #define TEST_COAP_ENDPOINT "fdfd::100"
 #define TEST_COAP_PORT 8293
 
+/* Magic numbers and link types of the pcap file format. */
+#define PCAP_MAGIC_USEC              0xa1b2c3d4
+#define PCAP_MAGIC_NSEC              0xa1b23c4d
+#define PCAP_GLOBAL_HEADER_LEN       24
+#define PCAP_RECORD_HEADER_LEN       16
+#define LINKTYPE_IEEE802_15_4_WITHFCS 195
+#define LINKTYPE_IEEE802_15_4_NOFCS   230
+
 extern int contiki_argc;
 extern char **contiki_argv;
 
 typedef bool (*protocol_function_t)(char *, int);
 
+/*
+ * Statistics collected in benchmark mode, which is enabled by setting
+ * TEST_BENCHMARK_ROUNDS in the environment. The time spent is split
+ * between the framer and the layers above it (sicslowpan and uIP).
+ */
+static struct {
+  unsigned long rounds;
+  unsigned long packets;
+  unsigned long bytes;
+  unsigned long framer_ok;
+  unsigned long framer_failed;
+  uint64_t framer_ns;
+  uint64_t upper_ns;
+  uint64_t total_ns;
+  uint64_t total_cycles;
+} bench;
+static bool bench_enabled;
+
 /*---------------------------------------------------------------------------*/
 PROCESS(packet_injector_process, "Packet injector process");
 AUTOSTART_PROCESSES(&packet_injector_process);
@@ -114,6 +146,25 @@ set_uip_buf(char *data, int len)
   memcpy(uip_buf, data, len);
 }
 /*---------------------------------------------------------------------------*/
+static uint64_t
+bench_now_ns(void)
+{
+  struct timespec ts;
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+/*---------------------------------------------------------------------------*/
+static uint64_t
+bench_cycles(void)
+{
+#if HAVE_CYCLE_COUNTER
+  return __rdtsc();
+#else
+  return 0;
+#endif
+}
+/*---------------------------------------------------------------------------*/
 static bool
 inject_coap_packet(char *data, int len)
 {
@@ -172,6 +223,31 @@ inject_sicslowpan_packet(char *data, int len)
   return true;
 }
 /*---------------------------------------------------------------------------*/
+static bool
+inject_ieee802154_packet(char *data, int len)
+{
+  uint64_t start;
+  uint64_t parsed;
+
+  /* A complete 802.15.4 frame without FCS: run it through the framer
+     and hand the payload to sicslowpan, which passes it on to uIP. */
+  start = bench_now_ns();
+  packetbuf_copyfrom(data, len);
+  if(NETSTACK_FRAMER.parse() < 0) {
+    bench.framer_failed++;
+    bench.framer_ns += bench_now_ns() - start;
+    return true;
+  }
+  parsed = bench_now_ns();
+  bench.framer_ok++;
+  bench.framer_ns += parsed - start;
+
+  sicslowpan_driver.input();
+  bench.upper_ns += bench_now_ns() - parsed;
+
+  return true;
+}
+/*---------------------------------------------------------------------------*/
 protocol_function_t
 select_protocol(const char *protocol_name)
 {
@@ -182,6 +258,7 @@ select_protocol(const char *protocol_name)
   struct proto_mapper map[] = {
     {"coap", inject_coap_packet},
     {"ble-l2cap", inject_ble_l2cap_packet},
+    {"ieee802154", inject_ieee802154_packet},
     {"sicslowpan", inject_sicslowpan_packet},
     {"tcpip", inject_tcpip_packet},
     {"uip", inject_uip_packet}
@@ -201,12 +278,123 @@ select_protocol(const char *protocol_name)
   return NULL;
 }
 /*---------------------------------------------------------------------------*/
+static bool
+inject_packet(protocol_function_t protocol_input, char *data, int len)
+{
+  uint64_t start_ns;
+  uint64_t start_cycles;
+  bool result;
+
+  if(!bench_enabled) {
+    return protocol_input(data, len);
+  }
+
+  start_cycles = bench_cycles();
+  start_ns = bench_now_ns();
+  result = protocol_input(data, len);
+  bench.total_ns += bench_now_ns() - start_ns;
+  bench.total_cycles += bench_cycles() - start_cycles;
+  bench.packets++;
+  bench.bytes += len;
+
+  return result;
+}
+/*---------------------------------------------------------------------------*/
+static uint32_t
+pcap_read32(const uint8_t *p, bool swapped)
+{
+  if(swapped) {
+    return ((uint32_t)p[0] << 24) | ((uint32_t)p[1] << 16) |
+      ((uint32_t)p[2] << 8) | p[3];
+  }
+  return ((uint32_t)p[3] << 24) | ((uint32_t)p[2] << 16) |
+    ((uint32_t)p[1] << 8) | p[0];
+}
+/*---------------------------------------------------------------------------*/
+static bool
+process_pcap(FILE *fp, const char *protocol_name,
+             protocol_function_t protocol_input)
+{
+  static char record_buf[TEST_BUFFER_SIZE];
+  uint8_t hdr[PCAP_GLOBAL_HEADER_LEN];
+  uint32_t magic;
+  uint32_t linktype;
+  uint32_t caplen;
+  bool swapped;
+  unsigned records;
+
+  if(fread(hdr, 1, sizeof(hdr), fp) != sizeof(hdr)) {
+    LOG_ERR("truncated pcap header\n");
+    return false;
+  }
+
+  magic = pcap_read32(hdr, false);
+  swapped = magic != PCAP_MAGIC_USEC && magic != PCAP_MAGIC_NSEC;
+  linktype = pcap_read32(hdr + 20, swapped);
+
+  for(records = 0;; records++) {
+    if(fread(hdr, 1, PCAP_RECORD_HEADER_LEN, fp) != PCAP_RECORD_HEADER_LEN) {
+      break;
+    }
+    caplen = pcap_read32(hdr + 8, swapped);
+    if(caplen > sizeof(record_buf)) {
+      LOG_ERR("pcap record %u too large (%lu bytes)\n",
+              records, (unsigned long)caplen);
+      return false;
+    }
+    if(fread(record_buf, 1, caplen, fp) != caplen) {
+      LOG_ERR("truncated pcap record %u\n", records);
+      return false;
+    }
+    if(linktype == LINKTYPE_IEEE802_15_4_WITHFCS && caplen >= 2) {
+      /* The framer expects frames without the FCS. */
+      caplen -= 2;
+    }
+
+    LOG_DBG("Injecting pcap record %u of %lu bytes into %s\n",
+            records, (unsigned long)caplen, protocol_name);
+    if(inject_packet(protocol_input, record_buf, caplen) == false) {
+      return false;
+    }
+  }
+
+  LOG_DBG("Injected %u pcap records\n", records);
+  return true;
+}
+/*---------------------------------------------------------------------------*/
 void
 process_packet(const char *filename, const char *protocol_name, protocol_function_t protocol_input) {
   static char file_buf[TEST_BUFFER_SIZE];
   static int len;
+  FILE *fp;
+  uint8_t magic[4];
+  bool is_pcap;
 
-  LOG_INFO("Using input file \"%s\"\n", filename);
+  if(!bench_enabled) {
+    LOG_INFO("Using input file \"%s\"\n", filename);
+  }
+
+  /* Packet capture files may contain any number of packets. */
+  fp = fopen(filename, "rb");
+  if(fp == NULL) {
+    LOG_ERR("Unable to open %s: %s\n", filename, strerror(errno));
+    exit(EXIT_FAILURE);
+  }
+  is_pcap = fread(magic, 1, sizeof(magic), fp) == sizeof(magic) &&
+    (pcap_read32(magic, false) == PCAP_MAGIC_USEC ||
+     pcap_read32(magic, true) == PCAP_MAGIC_USEC ||
+     pcap_read32(magic, false) == PCAP_MAGIC_NSEC ||
+     pcap_read32(magic, true) == PCAP_MAGIC_NSEC);
+  if(is_pcap) {
+    rewind(fp);
+    if(process_pcap(fp, protocol_name, protocol_input) == false) {
+      fclose(fp);
+      exit(EXIT_FAILURE);
+    }
+    fclose(fp);
+    return;
+  }
+  fclose(fp);
 
   len = read_packet(filename, file_buf, TEST_BUFFER_SIZE);
   if(len < 0) {
@@ -214,13 +402,73 @@ process_packet(const char *filename, const char *protocol_name, protocol_functio
     exit(EXIT_FAILURE);
   }
 
-  LOG_INFO("Injecting a packet of %d bytes into %s\n", len, protocol_name);
+  if(!bench_enabled) {
+    LOG_INFO("Injecting a packet of %d bytes into %s\n", len, protocol_name);
+  }
 
-  if(protocol_input(file_buf, len) == false) {
+  if(inject_packet(protocol_input, file_buf, len) == false) {
     exit(EXIT_FAILURE);
   }
 }
 /*---------------------------------------------------------------------------*/
+static void
+print_benchmark_report(const char *protocol_name)
+{
+  double seconds;
+
+  if(bench.packets == 0) {
+    LOG_WARN("Benchmark: no packets injected\n");
+    return;
+  }
+
+  seconds = bench.total_ns / 1e9;
+  printf("Benchmark %s: %lu rounds, %lu packets, %lu bytes\n",
+         protocol_name, bench.rounds, bench.packets, bench.bytes);
+  printf("  packets/s: %.0f\n",
+         seconds > 0 ? bench.packets / seconds : 0.0);
+  printf("  ns/packet: %.1f\n", (double)bench.total_ns / bench.packets);
+#if HAVE_CYCLE_COUNTER
+  printf("  cycles/packet: %.1f\n",
+         (double)bench.total_cycles / bench.packets);
+#endif /* HAVE_CYCLE_COUNTER */
+  if(bench.framer_ok + bench.framer_failed > 0) {
+    printf("  framer: %lu parsed, %lu rejected, %.1f ns/packet\n",
+           bench.framer_ok, bench.framer_failed,
+           (double)bench.framer_ns / (bench.framer_ok + bench.framer_failed));
+    printf("  sicslowpan+uip: %.1f ns/packet\n",
+           bench.framer_ok ? (double)bench.upper_ns / bench.framer_ok : 0.0);
+  }
+#if UIP_STATISTICS
+  printf("  uip: %lu ip recv, %lu ip drop, %lu icmp recv, %lu nd6 recv\n",
+         (unsigned long)uip_stat.ip.recv, (unsigned long)uip_stat.ip.drop,
+         (unsigned long)uip_stat.icmp.recv, (unsigned long)uip_stat.nd6.recv);
+#if UIP_UDP
+  printf("  udp: %lu recv, %lu drop\n",
+         (unsigned long)uip_stat.udp.recv, (unsigned long)uip_stat.udp.drop);
+#endif /* UIP_UDP */
+#endif /* UIP_STATISTICS */
+}
+/*---------------------------------------------------------------------------*/
+#if PACKET_INJECTOR_FUZZ
+static protocol_function_t fuzz_protocol_input;
+
+int LLVMFuzzerRunDriver(int *argc, char ***argv,
+                        int (*callback)(const uint8_t *data, size_t size));
+/*---------------------------------------------------------------------------*/
+static int
+fuzz_one_input(const uint8_t *data, size_t size)
+{
+  static char fuzz_buf[TEST_BUFFER_SIZE];
+
+  if(size > sizeof(fuzz_buf)) {
+    size = sizeof(fuzz_buf);
+  }
+  memcpy(fuzz_buf, data, size);
+  fuzz_protocol_input(fuzz_buf, size);
+  return 0;
+}
+#endif /* PACKET_INJECTOR_FUZZ */
+/*---------------------------------------------------------------------------*/
 PROCESS_THREAD(packet_injector_process, ev, data)
 {
   static const char *filename;
@@ -241,10 +489,35 @@ PROCESS_THREAD(packet_injector_process, ev, data)
     exit(EXIT_FAILURE);
   }
 
-  for(int i = 1; i < contiki_argc; i++) {
-    filename = contiki_argv[i];
-    process_packet(filename, protocol_name, protocol_input);
+#if PACKET_INJECTOR_FUZZ
+  /* Let libFuzzer drive the selected protocol input function. */
+  log_set_level("all", LOG_LEVEL_NONE);
+  fuzz_protocol_input = protocol_input;
+  exit(LLVMFuzzerRunDriver(&contiki_argc, &contiki_argv, fuzz_one_input));
+#endif /* PACKET_INJECTOR_FUZZ */
+
+  if(getenv("TEST_BENCHMARK_ROUNDS") != NULL) {
+    bench.rounds = strtoul(getenv("TEST_BENCHMARK_ROUNDS"), NULL, 10);
+    bench_enabled = bench.rounds > 0;
+  }
+
+  if(!bench_enabled) {
+    for(int i = 1; i < contiki_argc; i++) {
+      filename = contiki_argv[i];
+      process_packet(filename, protocol_name, protocol_input);
+    }
+    exit(EXIT_SUCCESS);
+  }
+
+  /* Logging would dominate the measurements. */
+  log_set_level("all", LOG_LEVEL_NONE);
+  for(unsigned long round = 0; round < bench.rounds; round++) {
+    for(int i = 1; i < contiki_argc; i++) {
+      filename = contiki_argv[i];
+      process_packet(filename, protocol_name, protocol_input);
+    }
   }
+  print_benchmark_report(protocol_name);
 
   exit(EXIT_SUCCESS);
 
@@ -8,3 +8,6 @@
 #ifndef CONTIKI_TARGET_SIMPLELINK
 #define LOG_CONF_LEVEL_FRAMER                      LOG_LEVEL_DBG
 #endif
+
+/* Count packets per layer for the benchmark report. */
+#define UIP_CONF_STATISTICS                        1